@@ -15,6 +15,13 @@ import os
 import threading
 import cPickle as pickle
 import csv
+import binascii
+import log_dictionary
+import sample_batch
+import packet_time
+import payload_codec
+import command_batch
+import rpc
 
 DEFAULT_COMPORT  = 'COM1'
 DEFAULT_BAUDRATE = 230400
@@ -22,22 +29,38 @@ CSV_HEADER = ['MCU Timestamp (sec)', 'PC Timestamp (sec)', 'Time Since Epoch (se
 MAGIC_START_STRING = '\xa5\xa5\xa5\xa5'
 MAGIC_END_STRING   = '\xb6\xb6\xb6\xb6'
 
+#Packet tail: uint16 sequence number, CRC over header+timestamp+payload+sequence, MAGIC_END_STRING
+PACKET_CRC_BITS       = 16 # must match PACKET_CRC_BITS in knobs.h: 16 = CRC-16/CCITT-FALSE, 32 = CRC-32
+PACKET_SEQUENCE_BYTES = 2
+
 TX_NEXT_IS_CHAR  = chr(5)  # 0x05
 TX_NEXT_IS_FLOAT = chr(6)  # 0x06
+TX_NEXT_IS_CREDIT     = chr(7) # 0x07, followed by uint16 number of packets we can take
+TX_NEXT_IS_LINK_STATS = chr(8) # 0x08, followed by uint16 report period in ms, 0 = off
+TX_NEXT_IS_LOG_DICTIONARY = chr(9) # 0x09, followed by uint16 CRC of the log dictionary, 0 = ASCII logs
 TX_CHARFLAG_TEST = chr(10) #0x0A
+TX_NEXT_IS_CODEC = chr(11) # 0x0B, followed by uint8 mask of payload codecs we decode, 0 = uncompressed
+TX_NEXT_IS_BATCH = chr(12) # 0x0C, followed by uint16 length and a batched command frame, see command_batch.py
+TX_NEXT_IS_RPC   = chr(13) # 0x0D, followed by uint16 length and a request, see rpc.py
 
 MESSAGE_TYPES_TOASCII = {
                 1:'LOG',
                 2:'ASCII_DATA',
                 3:'BINARY_FLOAT',
-                4:'FLAG'}
+                4:'FLAG',
+                5:'LOG_DEFERRED',
+                6:'SAMPLE_BATCH',
+                7:'COMMAND_STATUS',
+                8:'RPC_RESPONSE'}
 
 
 MESSAGE_FLAGS_TOASCII ={
 						11:'MESSAGE_FLAG_NO_FLAG',
                         99:'TIMESTAMP',
                         100:'MESSAGE_FLAG_LOP_DETECTED',
-                        101:'MESSAGE_FLAG_LOP_COUNTER'
+                        101:'MESSAGE_FLAG_LOP_COUNTER',
+                        102:'MESSAGE_FLAG_LINK_STATS',
+                        103:'MESSAGE_FLAG_EIG_STATS'
                         }
 
 FLOAT_FLAGS_TOASCII = { 65:'FLOAT_FLAG_NEW_MODE',
@@ -51,7 +74,19 @@ FLOAT_FLAGS_TONUM = dict( (v,k) for k,v in FLOAT_FLAGS_TOASCII.iteritems() )
 MESSAGE_FLAGS_TONUM = dict( (v,k) for k,v in MESSAGE_FLAGS_TOASCII.iteritems() )
 
 DONT_PRINT_PACKETS = [ MESSAGE_FLAGS_TONUM['TIMESTAMP'], MESSAGE_FLAGS_TONUM['MESSAGE_FLAG_LOP_COUNTER'] ]
-PACKET_TIMESTAMP_TO_SECONDS = 100.0 
+PACKET_TIMESTAMP_HZ = packet_time.PACKET_TIMESTAMP_HZ # must match TIMEBASE_WIRE_HZ in timebase.h
+
+#Flow control: the PSoC sends back to back while it holds credits and falls back to
+#its fixed 1 ms pacing when it runs out, so granting nothing is always safe
+CREDIT_GRANT_BATCH      = 64   # credits per grant
+CREDIT_LOW_WATER        = 16   # grant again once this few are left
+CREDIT_GRANT_PERIOD_SEC = 0.5  # top up at least this often, covers packets lost to bad checksums
+MAX_PARSE_BACKLOG       = 256  # stop granting while packetParserThread is this far behind
+LINK_STATS_PERIOD_MS    = 0    # >0 asks the PSoC for packets/s and bytes/s every period
+LOG_DICTIONARY_FILE     = log_dictionary.DEFAULT_DICTIONARY_FILE # from 'python log_dictionary.py <firmware .elf>', without it the PSoC sends ASCII logs
+PAYLOAD_CODECS          = payload_codec.ACCEPTED_CODECS # compressed BINARY_FLOAT and LOG payloads, 0 = ask for none
+RPC_MAX_IN_FLIGHT       = 8    # requests sent before the first answer, PACKET_QUEUE_NUM_SLOTS on the PSoC
+RPC_TIMEOUT_SEC         = 2.0  # calls not answered by then complete with rpc.STATUS_TIMEOUT
 
 
 def printUsage():
@@ -90,6 +125,7 @@ class packetParserThread(QtCore.QThread):
         self.daemon = True
         self.PACKETTHREAD_RUNNING = True
         self.manager = manager
+        self.badSampleBatchCount = 0 #decode failed, dropped
 
     def run(self):
         while(self.PACKETTHREAD_RUNNING):
@@ -98,8 +134,30 @@ class packetParserThread(QtCore.QThread):
 
     def parsePacket(self, aPacket):
         #print aPacket
+        if aPacket.messageType == 6:
+            if aPacket.sampleBatch is None:
+                self.badSampleBatchCount = self.badSampleBatchCount + 1 #already reported by _readSampleBatchPayload
+                return
+            timesSec = aPacket.sampleBatch.timesSec( aPacket.timeSec ) #same clock as the packet, unwrapped next to it
+            self.manager.sampleStreams.add( aPacket.sampleBatch, timesSec )
+            return
+        if aPacket.messageType == 7:
+            self.manager.reportCommandStatus( aPacket.commandStatus )
+            return
+        if aPacket.messageType == 8:
+            try:
+                self.manager.rpc.handleResponse( aPacket.rawPayload )
+            except ValueError as e:
+                print 'Bad RPC response: ' + str(e)
+            return
+        if aPacket.messageFlag == MESSAGE_FLAGS_TONUM['MESSAGE_FLAG_LINK_STATS']:
+            self.manager.reportLinkStats( aPacket.payload )
+            return
+        if aPacket.messageFlag == MESSAGE_FLAGS_TONUM['MESSAGE_FLAG_EIG_STATS']:
+            self.manager.reportEigStats( aPacket.payload )
+            return
         if MESSAGE_FLAGS_TOASCII[aPacket.messageFlag] == 'MESSAGE_FLAG_LOP_DETECTED':
-            self.manager.addLopRecord( aPacket.messageTimeStampMS/PACKET_TIMESTAMP_TO_SECONDS )
+            self.manager.addLopRecord( aPacket.timeSec )
             self.manager.reportLop()
 
 class Packet(object):
@@ -108,16 +166,24 @@ class Packet(object):
         self.headerMagicNumber = []
         self.tailMagicNumber   = []
         self.messageType = []
+        self.codec = payload_codec.CODEC_NONE #top bits of the message type byte
         self.messageFlag = []
         self.messageLengthBytes = []
-        self.messageTimeStampMS = 0
+        self.messageTimeStampMS = 0 #32-bit wire form, in PACKET_TIMESTAMP_HZ units despite the name
+        self.timeSec = None #unwrapped by comPortBufferThread once the checksum passed
         self.payload = [] #will be list of 4-Byte packets
         self.tail = []
         self.checkSum = False #initialize to failed
+        self.codecFailed = False #CRC passed but the payload codec could not decode it, dropped
         self.headerLengthBytes = 8 #header magic number (4 bytes) and header data (4 bytes)
         self.headMagicNumberLengthBytes = 4
         self.tailMagicNumberLengthBytes = 4
-        self.tailLengthBytes = 0
+        self.tailLengthBytes = PACKET_SEQUENCE_BYTES + PACKET_CRC_BITS / 8 #sequence number and CRC, before the tail magic number
+        self.rawHeader = ''
+        self.rawPayload = ''
+        self.sequenceNumber = None
+        self.sampleBatch = None #MESSAGE_TYPE_SAMPLE_BATCH only
+        self.commandStatus = None #MESSAGE_TYPE_COMMAND_STATUS only
         self._readHeader()
 
     def __str__(self):
@@ -131,8 +197,9 @@ class Packet(object):
         except KeyError:
             print 'Message Type Not Understood with self.Message Flag: ' + str(self.messageFlag)
         messageString = messageString + '*\t' + 'Message Length Bytes: ' + str(self.messageLengthBytes) + '\n'
-        messageString = messageString + '*\t' + 'TimeStamp (ms): ' + str(self.messageTimeStampMS) + '\n'
+        messageString = messageString + '*\t' + 'TimeStamp: ' + str(self.messageTimeStampMS) + ' (' + str(self.timeSec) + ' sec)' + '\n'
         messageString = messageString + '*\t' + 'Payload: '  + str(self.payload)  + '\n'
+        messageString = messageString + '*\t' + 'Sequence: ' + str(self.sequenceNumber) + '\n'
         messageString = messageString + '*\t' + 'Checksum: ' + str(self.checkSum) + '\n'
         return messageString
 
@@ -141,35 +208,88 @@ class Packet(object):
         del odict['manager']
         return odict
     def _readTail(self):
-        #Will probably be a 4 byte checksum and a (different) 4 byte magic number to verify termination
-        #self.tail = self.manager.comPortBuffer.popOldestBytes(self.tailLengthBytes)
+        #sequence number and CRC, then the 4 byte magic number to verify termination
+        self.tail = self.manager.comPortBuffer.popOldestBytes(self.tailLengthBytes)
         self.tailMagicNumber = self.manager.comPortBuffer.popOldestBytes(self.tailMagicNumberLengthBytes)
+        if len(self.tail) == self.tailLengthBytes:
+            self.sequenceNumber = struct.unpack('<H', self.tail[:PACKET_SEQUENCE_BYTES])[0]
 
     def _verifyCheckSum(self):
-        self.checkSum = ( self.tailMagicNumber == MAGIC_END_STRING )
+        if( self.tailMagicNumber != MAGIC_END_STRING or len(self.tail) != self.tailLengthBytes ):
+            self.checkSum = False
+            return self.checkSum
+        covered = self.rawHeader + self.rawPayload + self.tail[:PACKET_SEQUENCE_BYTES]
+        if PACKET_CRC_BITS == 32:
+            received = struct.unpack('<L', self.tail[PACKET_SEQUENCE_BYTES:])[0]
+            computed = binascii.crc32(covered) & 0xFFFFFFFF
+        else:
+            received = struct.unpack('<H', self.tail[PACKET_SEQUENCE_BYTES:])[0]
+            computed = binascii.crc_hqx(covered, 0xFFFF)
+        self.checkSum = ( received == computed )
         return self.checkSum
 
     def _readHeader(self):
         #globalThreadLock.acquire()
         self.headerMagicNumber = self.manager.comPortBuffer.buffer[0] + self.manager.comPortBuffer.buffer[1] + self.manager.comPortBuffer.buffer[2] + self.manager.comPortBuffer.buffer[3]
-        self.messageType = ord( self.manager.comPortBuffer.buffer[4] )
+        self.messageType, self.codec = payload_codec.splitMessageType( ord( self.manager.comPortBuffer.buffer[4] ) )
         self.messageFlag = ord( self.manager.comPortBuffer.buffer[5] )
         self.messageLengthBytes = struct.unpack('=H',self.manager.comPortBuffer.buffer[6] + self.manager.comPortBuffer.buffer[7] )[0]
         self.messageTimeStampMS   = struct.unpack('=L',self.manager.comPortBuffer.buffer[8] + self.manager.comPortBuffer.buffer[9] + self.manager.comPortBuffer.buffer[10] + self.manager.comPortBuffer.buffer[11])[0]
+        self.rawHeader = ''.join( self.manager.comPortBuffer.buffer[i] for i in range(4, 12) ) #covered by the CRC
         #globalThreadLock.release()
 
     def _readLogPayload(self):
         #globalThreadLock.acquire()
-        self.payload = self.manager.comPortBuffer.popOldestBytes(self.messageLengthBytes)
+        self.rawPayload = self.manager.comPortBuffer.popOldestBytes(self.messageLengthBytes)
+        self.payload = str( self._decodePayload() )
         #globalThreadLock.release()
 
+    def _readDeferredLogPayload(self):
+        #format ID + raw arguments, expanded to the text an ASCII log would have carried
+        self.rawPayload = self.manager.comPortBuffer.popOldestBytes(self.messageLengthBytes)
+        if self.manager.logDictionary is None:
+            self.payload = '<deferred log without dictionary: ' + binascii.hexlify(self.rawPayload) + '>'
+        else:
+            self.payload = log_dictionary.expand(self.manager.logDictionary, self.rawPayload)
+
+    def _readSampleBatchPayload(self):
+        #channel, base timestamp, delta ticks and packed samples, see sample_batcher.h
+        self.rawPayload = self.manager.comPortBuffer.popOldestBytes(self.messageLengthBytes)
+        try:
+            self.sampleBatch = sample_batch.decode(self.rawPayload)
+            self.payload = np.array(self.sampleBatch.values, dtype = float)
+        except ValueError as e:
+            print 'Bad sample batch: ' + str(e)
+            self.payload = np.zeros(0)
+
+    def _readCommandStatusPayload(self):
+        #frame id, then one status per entry of a batched command frame, see command_table.h
+        self.rawPayload = self.manager.comPortBuffer.popOldestBytes(self.messageLengthBytes)
+        try:
+            self.commandStatus = command_batch.decodeStatus(self.rawPayload)
+            self.payload = self.commandStatus.statuses
+        except ValueError as e:
+            print 'Bad command status: ' + str(e)
+            self.payload = []
+
     def _readFloatArrayPayload(self):
-        self.payload = np.zeros( self.messageLengthBytes / 4 )
+        self.rawPayload = self.manager.comPortBuffer.popOldestBytes(self.messageLengthBytes)
+        floatBytes = str( self._decodePayload() )
+        self.payload = np.zeros( len(floatBytes) / 4 )
         for i in range(len(self.payload)):
-            #self.manager.updateHardwareCOMBufferLength()
-            #globalThreadLock.acquire()
-            self.payload[i] = struct.unpack('=f',self.manager.comPortBuffer.popOldestBytes(4) )[0]
-            #globalThreadLock.release()
+            self.payload[i] = struct.unpack('=f', floatBytes[4*i:4*i+4] )[0]
+
+    def _decodePayload(self):
+        #payload as the PSoC built it; rawPayload stays what was on the wire, for the CRC
+        if self.codec == payload_codec.CODEC_NONE:
+            return self.rawPayload
+        try:
+            return self.manager.payloadDecoder.decode(self.codec, self.rawPayload)
+        except ValueError as e:
+            #the CRC covers the wire bytes, so it passes: comPortBufferThread drops the packet
+            print 'Bad ' + payload_codec.CODEC_NAMES.get(self.codec, str(self.codec)) + ' payload: ' + str(e)
+            self.codecFailed = True
+            return ''
 
     def readPacket(self):
         #pop magic number and header off com port buffer
@@ -184,6 +304,15 @@ class Packet(object):
             pass #Not implemented, will need to search for end-of-line etc. probably don't need anymore since we can add floats to log messages 
         elif self.messageType == 4:
             pass #don't read payload, there is no payload for FLAG messages
+        elif self.messageType == 5:
+            self._readDeferredLogPayload()
+        elif self.messageType == 6:
+            self._readSampleBatchPayload()
+        elif self.messageType == 7:
+            self._readCommandStatusPayload()
+        elif self.messageType == 8:
+            self.rawPayload = self.manager.comPortBuffer.popOldestBytes(self.messageLengthBytes) #matched to its call by manager.rpc
+            self.payload = self.rawPayload
         self._readTail()
         self._verifyCheckSum()
 
@@ -194,12 +323,21 @@ class comPortBufferThread(threading.Thread):
         self.manager = manager
         self.comPort = manager.PSoC
         self.failedPacketCount = 0
+        self.codecFailedPacketCount = 0 #passed the CRC, payload did not decode
+        self.receivedPacketCount = 0
+        self.lostPacketCount = 0   #from gaps in the sequence numbers, includes packets that failed the CRC
+        self.latePacketCount = 0   #sequence number behind the last one seen
+        self.lastSequenceNumber = None
+        self.timestampUnwrapper = packet_time.TimestampUnwrapper()
         self.buffer = deque()
         self.daemon = True
         self.COMTHREAD_RUNNING = True
+        self.creditsOutstanding = 0 #granted but not yet seen as packets
+        self.lastGrantTime = 0.0
 
     def run(self):
         while(self.COMTHREAD_RUNNING):
+            self._grantCredits()
             numBytesReady = self.comPort.inWaiting()
             if numBytesReady > 0:
                 line = self.comPort.read( numBytesReady )
@@ -211,8 +349,14 @@ class comPortBufferThread(threading.Thread):
                                                  # does populate header information
                 if( len(self.buffer) >= (newPacket.headMagicNumberLengthBytes + newPacket.headerLengthBytes + newPacket.messageLengthBytes + newPacket.tailLengthBytes + newPacket.tailMagicNumberLengthBytes) ):
                     newPacket.readPacket() #pops all of this packet off comPort buffer deque (including head and tail magic numbers, header, payload and tail. 
+                    self.creditsOutstanding = max(0, self.creditsOutstanding - 1)
                     if( newPacket.checkSum == True ):
-                        self.manager.packetQueue.put( newPacket )
+                        self._trackSequence( newPacket.sequenceNumber )
+                        newPacket.timeSec = self.timestampUnwrapper.unwrapSec( newPacket.messageTimeStampMS )
+                        if( newPacket.codecFailed ):
+                            self.codecFailedPacketCount = self.codecFailedPacketCount + 1 #already reported by _decodePayload
+                        else:
+                            self.manager.packetQueue.put( newPacket )
                     else:
                         #Todo: raise an exception to be caught by main thread 
                         #self.manager.packetQueue.put( newPacket )
@@ -232,6 +376,38 @@ class comPortBufferThread(threading.Thread):
                     #could add>> while(( (len(self.buffer) >= 4) and (not self._headIsMagicNumber())):
                     #                self.buffer.popleft()
 
+    def _trackSequence(self, sequenceNumber):
+        self.receivedPacketCount = self.receivedPacketCount + 1
+        if self.lastSequenceNumber is not None:
+            gap = (sequenceNumber - self.lastSequenceNumber - 1) & 0xFFFF
+            if gap >= 0x8000:
+                self.latePacketCount = self.latePacketCount + 1
+                return #keep counting from the newest one
+            if gap > 0:
+                self.lostPacketCount = self.lostPacketCount + gap
+                print 'LINK: %d packet(s) lost before sequence %d' % (gap, sequenceNumber)
+        self.lastSequenceNumber = sequenceNumber
+
+    def linkReport(self):
+        total = self.receivedPacketCount + self.lostPacketCount
+        lossPercent = 100.0 * self.lostPacketCount / total if total > 0 else 0.0
+        return 'LINK: %d received, %d lost (%.3f%%), %d failed CRC, %d failed codec, %d late' % \
+               (self.receivedPacketCount, self.lostPacketCount, lossPercent, self.failedPacketCount,
+                self.codecFailedPacketCount, self.latePacketCount)
+
+    def _grantCredits(self):
+        #grant in batches as packets come in, and periodically in case some were lost
+        if self.manager.packetQueue.qsize() > MAX_PARSE_BACKLOG:
+            return #parser is behind, let the PSoC fall back to paced sending
+        now = time.time()
+        if( self.creditsOutstanding > CREDIT_LOW_WATER and (now - self.lastGrantTime) < CREDIT_GRANT_PERIOD_SEC ):
+            return
+        grant = CREDIT_GRANT_BATCH - min(self.creditsOutstanding, CREDIT_GRANT_BATCH)
+        if grant > 0:
+            self.manager.TX_Uart_Driver.sendCredits(grant)
+            self.creditsOutstanding = self.creditsOutstanding + grant
+        self.lastGrantTime = now
+
     def popNewestBytes(self,N):
         byteList = ''
         for _ in xrange(N):
@@ -257,22 +433,60 @@ class TX_Uart_Driver():
     def __init__(self, comPort, manager):
         self.comPort = comPort
         self.manager = manager
+        self.txLock = threading.Lock() #credits are sent from comPortBufferThread
+        self.nextFrameId = 0
 
     def sendChar(self, charMessage):
-        self.comPort.write( TX_NEXT_IS_CHAR )
-        self.comPort.write( str(charMessage) )
+        with self.txLock:
+            self.comPort.write( TX_NEXT_IS_CHAR )
+            self.comPort.write( str(charMessage) )
 
     def sendFloat(self, aFloat, floatFlag):
-        self.comPort.write( TX_NEXT_IS_FLOAT )
-        self.comPort.write( str(floatFlag) )
-        floatAsChars = np.float32(aFloat).tostring()
-        for c in floatAsChars:
-            self.comPort.write( str(c) )
+        with self.txLock:
+            self.comPort.write( TX_NEXT_IS_FLOAT )
+            self.comPort.write( str(floatFlag) )
+            floatAsChars = np.float32(aFloat).tostring()
+            for c in floatAsChars:
+                self.comPort.write( str(c) )
+
+    def sendCredits(self, numPackets):
+        with self.txLock:
+            self.comPort.write( TX_NEXT_IS_CREDIT + struct.pack('<H', min(numPackets, 0xFFFF)) )
+
+    def sendLinkStatsPeriod(self, periodMs):
+        with self.txLock:
+            self.comPort.write( TX_NEXT_IS_LINK_STATS + struct.pack('<H', min(periodMs, 0xFFFF)) )
+
+    def sendLogDictionary(self, dictionaryCrc):
+        with self.txLock:
+            self.comPort.write( TX_NEXT_IS_LOG_DICTIONARY + struct.pack('<H', dictionaryCrc & 0xFFFF) )
+
+    def sendPayloadCodecs(self, codecMask):
+        with self.txLock:
+            self.comPort.write( TX_NEXT_IS_CODEC + chr(codecMask & 0xFF) )
+
+    def write(self, rawBytes):
+        with self.txLock:
+            self.comPort.write( rawBytes )
+
+    def sendBatch(self, entries):
+        #entries: (flag, command_batch.VALUE_*, value), as many frames as it takes;
+        #returns the frame ids, each comes back in one COMMAND_STATUS packet
+        frameIds = []
+        with self.txLock:
+            for batch in command_batch.splitEntries(entries):
+                frameIds.append(self.nextFrameId)
+                self.comPort.write( str(command_batch.encodeFrame(self.nextFrameId, batch)) )
+                self.nextFrameId = (self.nextFrameId + 1) & 0xFF
+        return frameIds
 
 class LOP_CL_Manager():
     def __init__(self,comPort = DEFAULT_COMPORT, baudRate = DEFAULT_BAUDRATE):
         self.packetQueue = Queue.Queue()
         self._initPSoC(comPort,baudRate)
+        self.logDictionary = self._loadLogDictionary()
+        self.sampleStreams = sample_batch.SampleStreams() #sampleStreams.timesSec(channel) on the packet timebase, .values(channel)
+        self.payloadDecoder = payload_codec.PayloadDecoder()
         
         self.LOP_Records = []
         self.LOPFileOpen = 0
@@ -280,6 +494,7 @@ class LOP_CL_Manager():
         self._initFiles()
         
         self.TX_Uart_Driver = TX_Uart_Driver(self.PSoC, self)
+        self.rpc = rpc.RpcClient(self.TX_Uart_Driver.write, maxInFlight = RPC_MAX_IN_FLIGHT) #self.rpc.call(method, arguments) does not wait
         self.comPortBuffer = comPortBufferThread(self)
         self.packetParser  = packetParserThread(self)
         
@@ -319,6 +534,28 @@ class LOP_CL_Manager():
 
         
 
+    def reportLinkStats(self, stats):
+        #payload of MESSAGE_FLAG_LINK_STATS, see flow_control.h
+        print 'LINK: %.0f packets/s %.0f bytes/s credits %d throttled %d dropped %d' % \
+              (stats[0], stats[1], int(stats[2]), int(stats[3]), int(stats[4]))
+        if len(stats) >= 8:
+            print 'LINK: TX ring %d bytes, peak %d, full %d times' % \
+                  (int(stats[5]), int(stats[6]), int(stats[7]))
+
+    def reportEigStats(self, stats):
+        #payload of MESSAGE_FLAG_EIG_STATS, see eig_telemetry.h
+        print 'EIG: converged mask 0x%X worst |phi_i . phi_j| %.2g' % (int(stats[0]), stats[1])
+        for i in range((len(stats) - 2) / 3):
+            print 'EIG: component %d %d iterations residual %.3g %.0f us' % \
+                  (i, int(stats[2 + 3*i]), stats[3 + 3*i], stats[4 + 3*i])
+
+    def reportCommandStatus(self, status):
+        #one per batched command frame sent with TX_Uart_Driver.sendBatch
+        if status is None:
+            return
+        for index, reason in status.failed():
+            print 'COMMAND: frame %d entry %d failed: %s' % (status.frameId, index, reason)
+
     def go(self):
         """ Does not return until LOP_CL_Manager:: self.RUNNING = 0 """
         self.RUNNING = True
@@ -330,14 +567,33 @@ class LOP_CL_Manager():
         self.packetParser.start()
         time.sleep(.5) # give threads a chance to startup
         #print 'All helper threads started'
+        if LINK_STATS_PERIOD_MS > 0:
+            self.TX_Uart_Driver.sendLinkStatsPeriod( LINK_STATS_PERIOD_MS )
+        if self.logDictionary is not None:
+            self.TX_Uart_Driver.sendLogDictionary( self.logDictionary['crc'] ) #PSoC ignores it unless it matches its build
+        if PAYLOAD_CODECS:
+            self.TX_Uart_Driver.sendPayloadCodecs( PAYLOAD_CODECS )
 
         while(self.RUNNING):
             time.sleep(1)
+            self.rpc.expire( RPC_TIMEOUT_SEC )
             print '.'
 
         self.RUNNING = 0
         self.closeEvent()
     
+    def _loadLogDictionary(self):
+        if not os.path.exists(LOG_DICTIONARY_FILE):
+            print 'No ' + LOG_DICTIONARY_FILE + ', PSoC logs stay ASCII'
+            return None
+        try:
+            dictionary = log_dictionary.load(LOG_DICTIONARY_FILE)
+        except (IOError, ValueError, KeyError):
+            print 'Could not read ' + LOG_DICTIONARY_FILE + ', PSoC logs stay ASCII'
+            return None
+        print 'Log dictionary: %d formats, CRC 0x%04X' % (len(dictionary['formats']), dictionary['crc'])
+        return dictionary
+
     def _makeTodayString(self):
         now = datetime.datetime.now()
         todayString = str(now.year).zfill(4) + '_' + str(now.month).zfill(2) + '_' + str(now.day).zfill(2)
@@ -368,6 +624,9 @@ class LOP_CL_Manager():
         self._closeAllFiles()
         print '\tSTOPPING comPortBuffer'
         self.comPortBuffer.COMTHREAD_RUNNING   = False
+        print '\t' + self.comPortBuffer.linkReport()
+        print '\t' + str(self.payloadDecoder)
+        print '\tSAMPLES: %d bad batches dropped' % self.packetParser.badSampleBatchCount
         print '\tSTOPPING packetParser'
         self.packetParser.PACKETTHREAD_RUNNING = False
         print '\tSTOPPING Manager'   
@@ -166,27 +166,8 @@ CY_ISR(isr_rx_Interrupt)
     /*  Place your Interrupt code here. */
     /* `#START isr_rx_Interrupt` */
     #include "isr_rx_helper.h"
-    #include "MessageHandler.h"
     
-    extern uint8 rxbuf[RX_SOFTWARE_BUFFER_LENGTH];
-    extern uint8 rxWriteIndex;
-    uint8 UART_Rx_Status;
-    uint8 Data_Available;
-    
-    while (1)
-	{
-        CyDelayUs(10);
-        UART_Rx_Status = UART_1_ReadRxStatus();
-        Data_Available = (UART_Rx_Status & UART_1_RX_STS_FIFO_NOTEMPTY);
-        if (!Data_Available)
-        	break; //breaks out of while(1) loop
-    	rxbuf[rxWriteIndex] =  UART_1_GetChar();
-        constructAndSendPacket(MESSAGE_TYPE_LOG, MESSAGE_FLAG_CHAR_RECIEVED, 4, (void*)&rxbuf[rxWriteIndex]);
-        
-        rxWriteIndex++;
-        rxWriteIndex %= RX_SOFTWARE_BUFFER_LENGTH;
-        
-    }
+    rxRing_putFromUart(); //FIFO into the receive ring, parsed by the main loop
 
     /* `#END` */
 }
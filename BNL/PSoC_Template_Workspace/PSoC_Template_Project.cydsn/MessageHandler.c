@@ -22,150 +22,435 @@
 #define MAGIC_HEAD_NUMBER (uint8)165 //165 = 0xA5 in hex
 #define MAGIC_TAIL_NUMBER (uint8)182 //182 = 0xB6 in hex
 
+#if (PACKET_CRC_BITS == 32)
+    #define PACKET_CRC_INIT             CRC32_INIT
+    #define PACKET_CRC_UPDATE(c, d, n)  crc32_update((uint32)(c), (d), (n))
+    #define PACKET_CRC_FINAL(c)         CRC32_FINAL(c)
+#elif (PACKET_CRC_BITS == 16)
+    #define PACKET_CRC_INIT             CRC16_INIT
+    #define PACKET_CRC_UPDATE(c, d, n)  crc16_update((uint16)(c), (d), (n))
+    #define PACKET_CRC_FINAL(c)         (c)
+#else
+    #error "PACKET_CRC_BITS must be 16 or 32"
+#endif
+
 //define private functions here
-static void _sendHeader();
-static void _sendPayload();
-static void _sendTail();
-static void _sendHeadMagicNumber();
-static void _sendTailMagicNumber();
-    
-static uint8  _headerBuff[4] = {0};
-static uint8  _tailBuff[4]   = {0};
-static uint8  _timestampBuff[4] = {0};
-static uint8*  _payload; 
-static uint16 _numBytes; 
-static uint8  _messageType;
-static uint8  _messageFlag;
+static void _packHead(uint8* head, uint8 messageType, uint8 messageFlag, uint16 payloadBytes);
+static uint32 _crcOf(const uint8* head, const uint8* payload, uint16 wirePayloadBytes);
+static void _packTail(uint8* tail, uint32 crc);
+static packetQueueSlot* _reservePacket(uint8 messageType, uint8 messageFlag, uint16 payloadBytes);
+static void _commitPacket(packetQueueSlot* slot, uint16 wirePayloadBytes);
+static void _sendDirect(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payload);
+static uint8 _queuePacket(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payload, uint8 encode);
+
+#if (ENABLE_UART_TX_DMA)
+    //DMA reads straight from these, so they live in SRAM. _directHead is only
+    //rewritten once the previous direct transfer has left (see _startDirectDma)
+    static uint8 _directHead[PACKET_HEAD_BYTES];
+    static uint8 _directTail[PACKET_TAIL_BYTES];
+    static volatile uartTxDmaCallback _directOnComplete;
+    static volatile uint16            _directNumBytes;
+    static void* volatile             _directContext;
+    static uint8 _startDirectDma(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payload, uartTxDmaCallback onComplete, void* context);
+    static void  _onDirectSent(void* context);
+    static void  _putDirect(const uint8* payload, uint16 payloadBytes);
+#endif
+
+static volatile uint32 _txSequence; //low 16 bits go in every tail, in wire order
 
 extern uint32 SysTicksMS; 
 
+uint8 queuePacket(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payload)
+{
+    //Safe from any context, ISRs included: copies the packet into a queue slot
+    //and returns without touching the UART. Sent by the next packetQueue_drain().
+    //Never compressed, so the time an ISR spends in here stays bounded by the copy
+    return _queuePacket(messageType, messageFlag, payloadBytes, payload, 0);
+}
+
+static uint8 _queuePacket(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payload, uint8 encode)
+{
+    packetQueueSlot* slot;
+    uint8 codec = PAYLOAD_CODEC_NONE;
+    
+    if( payloadBytes > PACKET_MAX_PAYLOAD_BYTES )
+    {
+        return PACKET_ERR_TOO_LONG;
+    }
+    slot = _reservePacket(messageType, messageFlag, payloadBytes);
+    if( slot == NULL )
+    {
+        return PACKET_ERR_QUEUE_FULL;
+    }
+    if( messageType == MESSAGE_TYPE_FLAG )
+    {
+        payloadBytes = 0; //flags carry no payload on the wire
+    }
+    if( encode )
+    {
+        payloadBytes = payloadCodec_encode(messageType, payload, payloadBytes, PACKET_PAYLOAD(slot), &codec);
+    }
+    else
+    {
+        memcpy(PACKET_PAYLOAD(slot), payload, payloadBytes);
+    }
+    if( codec != PAYLOAD_CODEC_NONE )
+    {
+        slot->data[4] |= (uint8)(codec << PAYLOAD_CODEC_SHIFT);
+        commitReservedPacket(slot, payloadBytes); //patches the length, the CRC covers what goes on the wire
+        return PACKET_OK;
+    }
+    _commitPacket(slot, payloadBytes);
+    return PACKET_OK;
+}
+
 void constructHeader(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payload)
+{
+    //Kept for existing callers: builds the complete packet in a queue slot, 
+    //sendPacket() puts it on the wire. Main loop only, it runs the payload
+    //codec the host negotiated (see payload_codec.h)
+    _queuePacket(messageType, messageFlag, payloadBytes, payload, 1);
+}
+
+static void _packHead(uint8* head, uint8 messageType, uint8 messageFlag, uint16 payloadBytes)
 {
     uint8* bytePtr = (uint8*) &payloadBytes;
-    //Populate Header Buffer
     
-    _headerBuff[0] = messageType; 
-    _headerBuff[1] = messageFlag;
+    head[0] = MAGIC_HEAD_NUMBER;
+    head[1] = MAGIC_HEAD_NUMBER;
+    head[2] = MAGIC_HEAD_NUMBER;
+    head[3] = MAGIC_HEAD_NUMBER;
+    
+    //Populate Header
+    head[4] = messageType; 
+    head[5] = messageFlag;
     
     //pack payloadBytes (lenght of payload in bytes)
-    _headerBuff[2] = *bytePtr++;
-    _headerBuff[3] = *bytePtr;
+    head[6] = *bytePtr++;
+    head[7] = *bytePtr;
     
     //update global timestamp
     #if(UPDATE_TIMESTAMP_FOR_EACH_PACKET)
-        //SysTicksMS = SysTimers_GetSysTickValue();
-        SysTicksMS = 1; 
+        SysTicksMS = timebase_getWireTimestamp(); //TIMEBASE_WIRE_HZ units despite the name, see timebase.h
     #endif 
     //pack timestamp 
     bytePtr = (uint8*)&SysTicksMS; 
-    _timestampBuff[0] = *bytePtr++;
-    _timestampBuff[1] = *bytePtr++;
-    _timestampBuff[2] = *bytePtr++;
-    _timestampBuff[3] = *bytePtr;
-    
-    //record message descriptors
-    _messageType = messageType; 
-    _messageFlag = messageFlag;   
-    _numBytes = payloadBytes;
+    head[8]  = *bytePtr++;
+    head[9]  = *bytePtr++;
+    head[10] = *bytePtr++;
+    head[11] = *bytePtr;
 }
 
-static void _sendHeader()
+static uint32 _crcOf(const uint8* head, const uint8* payload, uint16 wirePayloadBytes)
 {
-    UART_1_PutChar( _headerBuff[0] ); 
-    UART_1_PutChar( _headerBuff[1] ); 
-    UART_1_PutChar( _headerBuff[2] ); 
-    UART_1_PutChar( _headerBuff[3] ); 
-    
-    UART_1_PutChar( _timestampBuff[0] ); 
-    UART_1_PutChar( _timestampBuff[1] ); 
-    UART_1_PutChar( _timestampBuff[2] ); 
-    UART_1_PutChar( _timestampBuff[3] );
+    //running CRC over header, timestamp and payload, the magic numbers are not covered
+    uint32 crc = PACKET_CRC_UPDATE(PACKET_CRC_INIT, &head[4], PACKET_HEAD_BYTES - 4u);
+    return PACKET_CRC_UPDATE(crc, payload, wirePayloadBytes);
 }
 
-static void _sendPayload()
+static void _packTail(uint8* tail, uint32 crc)
 {
-       
-    uint8* bytePty = (uint8*) _payload;
-    uint16 byteCounter;    
-   
-    for(byteCounter = 0; byteCounter < _numBytes; byteCounter++)
+    //sequence number, CRC (which also covers the sequence number), tail magic
+    uint16 sequence = (uint16)__sync_fetch_and_add(&_txSequence, 1u);
+    uint8  byteCounter;
+    
+    tail[0] = LO8(sequence);
+    tail[1] = HI8(sequence);
+    crc = PACKET_CRC_FINAL( PACKET_CRC_UPDATE(crc, tail, PACKET_SEQUENCE_BYTES) );
+    for(byteCounter = 0; byteCounter < PACKET_CRC_BYTES; byteCounter++)
     {
-        UART_1_PutChar( *bytePty++ );
+        tail[PACKET_SEQUENCE_BYTES + byteCounter] = (uint8)(crc >> (8u * byteCounter)); //little endian
     }
+    tail[PACKET_TAIL_BYTES - 4u] = MAGIC_TAIL_NUMBER;
+    tail[PACKET_TAIL_BYTES - 3u] = MAGIC_TAIL_NUMBER;
+    tail[PACKET_TAIL_BYTES - 2u] = MAGIC_TAIL_NUMBER;
+    tail[PACKET_TAIL_BYTES - 1u] = MAGIC_TAIL_NUMBER;
 }
 
-static void _sendTail()
-{     
-    //Todo: add meaningful tail. will need to adjust tailsize in Packet.__init__()
+static packetQueueSlot* _reservePacket(uint8 messageType, uint8 messageFlag, uint16 payloadBytes)
+{
+    //reserves a slot and writes the head, the caller fills in the payload
+    packetQueueSlot* slot = packetQueue_reserve();
     
-    /*
-    UART_1_PutChar( _tailBuff[0] );
-    UART_1_PutChar( _tailBuff[1] );
-    UART_1_PutChar( _tailBuff[2] );
-    UART_1_PutChar( _tailBuff[3] );   
-    */
-    _sendTailMagicNumber();
+    if( slot == NULL )
+    {
+        return NULL;
+    }
+    _packHead(slot->data, messageType, messageFlag, payloadBytes);
+    return slot;
 }
 
-static void _sendHeadMagicNumber()
-{        
-    UART_1_PutChar( MAGIC_HEAD_NUMBER );
-    UART_1_PutChar( MAGIC_HEAD_NUMBER );
-    UART_1_PutChar( MAGIC_HEAD_NUMBER );
-    UART_1_PutChar( MAGIC_HEAD_NUMBER );
-}   
+static void _commitPacket(packetQueueSlot* slot, uint16 wirePayloadBytes)
+{
+    //CRC work is done here by the producer; finishPacket() only folds in the
+    //sequence number once the slot's place on the wire is known
+    slot->crc      = _crcOf(slot->data, &slot->data[PACKET_HEAD_BYTES], wirePayloadBytes);
+    slot->numBytes = PACKET_HEAD_BYTES + wirePayloadBytes + PACKET_TAIL_BYTES;
+    packetQueue_commit(slot);
+}
 
-static void _sendTailMagicNumber()
+void finishPacket(packetQueueSlot* slot)
 {
-    UART_1_PutChar( MAGIC_TAIL_NUMBER );
-    UART_1_PutChar( MAGIC_TAIL_NUMBER );
-    UART_1_PutChar( MAGIC_TAIL_NUMBER );
-    UART_1_PutChar( MAGIC_TAIL_NUMBER );
+    _packTail(&slot->data[slot->numBytes - PACKET_TAIL_BYTES], slot->crc);
 }
 
 void sendPacket()
 {
-    //sends 4 byte header to UART
-    //only if message is not a flag (ie it is log message, binary or float data) sends payload
+    //pushes every queued packet (including ones queued from interrupts) to UART
     
 #if (1 == ENABLE_RATTLESNAKE_COMMUNICATION)
     CyDelayUs( UART_PACKET_DELAY_MS ); // short delay to throttle absolute maximum number of packets sent per second
-    _sendHeadMagicNumber();
-    _sendHeader();
-    if( _messageType != MESSAGE_TYPE_FLAG )
+    packetQueue_drain();
+#endif
+}
+
+static void _sendDirect(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payload)
+{
+    //main loop only: packets too big for a queue slot go out straight from the
+    //caller's buffer once everything queued before them has left
+#if (1 == ENABLE_RATTLESNAKE_COMMUNICATION)
+  #if (ENABLE_UART_TX_DMA)
+    _startDirectDma(messageType, messageFlag, payloadBytes, payload, NULL, NULL);
+    packetQueue_flush();
+    uartTxDma_waitIdle(); //caller owns the payload, so it has to be on the wire before returning
+  #elif (ENABLE_UART_TX_RING)
+    uint8 head[PACKET_HEAD_BYTES];
+    uint8 tail[PACKET_TAIL_BYTES];
+    uartTxDmaSegment segments[3];
+    
+    _packHead(head, messageType, messageFlag, payloadBytes);
+    if( messageType == MESSAGE_TYPE_FLAG )
+    {
+        payloadBytes = 0; //flags carry no payload on the wire
+    }
+    packetQueue_flush(); //into the ring, not onto the wire: returns as soon as it fits
+    _packTail(tail, _crcOf(head, (const uint8*) payload, payloadBytes));
+    
+    //copied into the ring, so the caller gets its buffer back at once
+    segments[0].data = head;
+    segments[0].numBytes = PACKET_HEAD_BYTES;
+    segments[1].data = (const uint8*) payload;
+    segments[1].numBytes = payloadBytes;
+    segments[2].data = tail;
+    segments[2].numBytes = PACKET_TAIL_BYTES;
+    uartTxRing_writeBlocking(segments, 3);
+    flowControl_recordSent(PACKET_HEAD_BYTES + payloadBytes + PACKET_TAIL_BYTES);
+  #else
+    uint8  head[PACKET_HEAD_BYTES];
+    uint8  tail[PACKET_TAIL_BYTES];
+    uint8* bytePtr = (uint8*) payload;
+    uint16 byteCounter;
+    
+    _packHead(head, messageType, messageFlag, payloadBytes);
+    if( messageType == MESSAGE_TYPE_FLAG )
+    {
+        payloadBytes = 0; //flags carry no payload on the wire
+    }
+    packetQueue_flush();
+    _packTail(tail, _crcOf(head, bytePtr, payloadBytes));
+    
+    for(byteCounter = 0; byteCounter < PACKET_HEAD_BYTES; byteCounter++)
+    {
+        UART_1_PutChar( head[byteCounter] );
+    }
+    for(byteCounter = 0; byteCounter < payloadBytes; byteCounter++)
+    {
+        UART_1_PutChar( *bytePtr++ );
+    }
+    for(byteCounter = 0; byteCounter < PACKET_TAIL_BYTES; byteCounter++)
     {
-        _sendPayload();
+        UART_1_PutChar( tail[byteCounter] );
     }
-    _sendTail();  
+    flowControl_recordSent(PACKET_HEAD_BYTES + payloadBytes + PACKET_TAIL_BYTES);
+  #endif
 #endif
 }
 
-void constructTail()
+#if (ENABLE_UART_TX_DMA)
+static uint8 _startDirectDma(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payload, uartTxDmaCallback onComplete, void* context)
+{
+    //same wire layout as a queue slot: magic + header + timestamp, payload, tail
+    uartTxDmaSegment segments[3];
+    uint8 numSegments = 0;
+    uint8 status;
+    
+    packetQueue_flush();  //keep packets in order, queued ones go first
+    packetQueue_hold(1);  //an ISR's drain cannot take the engine from here on, _onDirectSent() releases it
+    uartTxDma_waitIdle(); //a slot an ISR started since the flush, or the previous direct transfer
+    _packHead(_directHead, messageType, messageFlag, payloadBytes);
+    if( messageType == MESSAGE_TYPE_FLAG )
+    {
+        payloadBytes = 0; //flags carry no payload on the wire
+    }
+    _packTail(_directTail, _crcOf(_directHead, (const uint8*) payload, payloadBytes));
+    
+    segments[numSegments].data = _directHead;
+    segments[numSegments].numBytes = sizeof(_directHead);
+    numSegments++;
+    if( payloadBytes > 0 )
+    {
+        segments[numSegments].data = (const uint8*) payload; //zero copy, see constructAndSendPacketAsync
+        segments[numSegments].numBytes = payloadBytes;
+        numSegments++;
+    }
+    segments[numSegments].data = _directTail;
+    segments[numSegments].numBytes = sizeof(_directTail);
+    numSegments++;
+    
+    _directOnComplete = onComplete;
+    _directContext    = context;
+    _directNumBytes   = PACKET_HEAD_BYTES + payloadBytes + PACKET_TAIL_BYTES;
+    status = uartTxDma_send(segments, numSegments, _onDirectSent, NULL);
+    if( status != UART_TX_DMA_OK )
+    {
+        //uartTxDma_init() not called, or more descriptors than the engine owns.
+        //The tail already holds a sequence number, so send it byte by byte
+        _putDirect((const uint8*) payload, payloadBytes);
+        _onDirectSent(NULL);
+    }
+    return UART_TX_DMA_OK; //on the wire one way or the other, nothing for the caller to retry
+}
+
+static void _putDirect(const uint8* payload, uint16 payloadBytes)
+{
+    uint16 byteCounter;
+    
+    for(byteCounter = 0; byteCounter < PACKET_HEAD_BYTES; byteCounter++)
+    {
+        UART_1_PutChar( _directHead[byteCounter] );
+    }
+    for(byteCounter = 0; byteCounter < payloadBytes; byteCounter++)
+    {
+        UART_1_PutChar( payload[byteCounter] );
+    }
+    for(byteCounter = 0; byteCounter < PACKET_TAIL_BYTES; byteCounter++)
+    {
+        UART_1_PutChar( _directTail[byteCounter] );
+    }
+}
+
+static void _onDirectSent(void* context)
 {
-    uint8* bytePtr = (uint8*)&SysTicksMS;
-    _tailBuff[0] = *bytePtr++;
-    _tailBuff[1] = *bytePtr++;
-    _tailBuff[2] = *bytePtr++;
-    _tailBuff[3] = *bytePtr;
+    uartTxDmaCallback onComplete = _directOnComplete;
+    
+    (void)context;
+    _directOnComplete = NULL;
+    flowControl_recordSent(_directNumBytes);
+    if( onComplete != NULL )
+    {
+        onComplete(_directContext);
+    }
+    packetQueue_hold(0);
+    packetQueue_drain(); //packets queued while the direct transfer owned the engine
 }
+#endif
 
 void constructAndSendPacket(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* thePayload)
 {
-    constructHeader(messageType,messageFlag,payloadBytes,thePayload);
-    _payload  = (uint8*) thePayload;
-    constructTail(); 
-    sendPacket();
-    CyDelay(UART_PACKET_DELAY_MS); // throttles maximum speed that packets individual packets can be dumped
+    uint8 credited = flowControl_takeCredit(); //host granted room for this packet, no need to pace it
+    
+    if( payloadBytes > PACKET_MAX_PAYLOAD_BYTES )
+    {
+        _sendDirect(messageType, messageFlag, payloadBytes, thePayload);
+    }
+    else if( credited )
+    {
+        constructHeader(messageType,messageFlag,payloadBytes,thePayload);
+        packetQueue_drain();
+    }
+    else
+    {
+        constructHeader(messageType,messageFlag,payloadBytes,thePayload);
+        sendPacket();
+    }
+    if( !credited )
+    {
+        CyDelay(UART_PACKET_DELAY_MS); // throttles maximum speed that packets individual packets can be dumped
+    }
+}
+
+uint8 constructAndSendPacketAsync(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* thePayload, uartTxDmaCallback onComplete, void* context)
+{
+    //Main loop only. Returns as soon as the packet is started on the DMA engine.
+    //thePayload is not copied and must stay valid until onComplete runs. Without
+    //DMA this falls back to the blocking path and calls onComplete before returning,
+    //and so does a packet the engine refuses (not initialised, too long for its
+    //descriptors).
+#if (ENABLE_UART_TX_DMA && (1 == ENABLE_RATTLESNAKE_COMMUNICATION))
+    return _startDirectDma(messageType, messageFlag, payloadBytes, thePayload, onComplete, context);
+#else
+    constructAndSendPacket(messageType, messageFlag, payloadBytes, thePayload);
+    if( onComplete != NULL )
+    {
+        onComplete(context);
+    }
+    return UART_TX_DMA_OK;
+#endif
 }
     
 
+packetQueueSlot* reservePacket(uint8 messageType, uint8 messageFlag)
+{
+    //For producers that build their payload in place: write up to
+    //PACKET_MAX_PAYLOAD_BYTES at PACKET_PAYLOAD(slot), then commitReservedPacket()
+    //or sendReservedPacket().
+    //NULL (counted as a drop) when the queue is full
+    return _reservePacket(messageType, messageFlag, 0);
+}
+
+void commitReservedPacket(packetQueueSlot* slot, uint16 payloadBytes)
+{
+    //Safe from any context: hands the packet to the queue without touching the
+    //UART, like queuePacket(). Length is only known now: patch the header before
+    //the CRC is taken
+    slot->data[6] = LO8(payloadBytes);
+    slot->data[7] = HI8(payloadBytes);
+    _commitPacket(slot, payloadBytes);
+}
+
+void sendReservedPacket(packetQueueSlot* slot, uint16 payloadBytes)
+{
+    //main loop: commit, then send with the same pacing as constructAndSendPacket()
+    commitReservedPacket(slot, payloadBytes);
+    
+#if (1 == ENABLE_RATTLESNAKE_COMMUNICATION)
+    if( flowControl_takeCredit() )
+    {
+        packetQueue_drain();
+    }
+    else
+    {
+        sendPacket();
+        CyDelay(UART_PACKET_DELAY_MS);
+    }
+#endif
+}
+
 void sendLogMessage(const char* format, ...)
 {
     va_list args; 
-    size_t formatLen;
-    char messageBuf[256];
+    
     va_start(args, format);
-    formatLen = vsnprintf(messageBuf, 256, format, args);
+    sendLogMessageV(format, args);
     va_end(args); 
-    constructAndSendPacket(MESSAGE_TYPE_LOG, MESSAGE_FLAG_NO_FLAG, formatLen, (void*)messageBuf);    
-}
\ No newline at end of file
+}
+
+void sendLogMessageV(const char* format, va_list args)
+{
+    //main loop only, see MessageHandler.h. Formats straight into a queue slot;
+    //the message is dropped (and counted) when the queue is full
+    packetQueueSlot* slot;
+    size_t formatLen;
+    uint8 codec;
+    
+    slot = reservePacket(MESSAGE_TYPE_LOG, MESSAGE_FLAG_NO_FLAG);
+    if( slot == NULL )
+    {
+        return;
+    }
+    formatLen = vsnprintf((char*)PACKET_PAYLOAD(slot), LOG_MESSAGE_MAX_BYTES, format, args);
+    if( formatLen >= LOG_MESSAGE_MAX_BYTES ) { formatLen = LOG_MESSAGE_MAX_BYTES - 1; } //vsnprintf reports untruncated length
+    formatLen = payloadCodec_encodeInPlace(MESSAGE_TYPE_LOG, PACKET_PAYLOAD(slot), (uint16)formatLen, &codec);
+    slot->data[4] |= (uint8)(codec << PAYLOAD_CODEC_SHIFT);
+    sendReservedPacket(slot, formatLen);
+}
@@ -9,11 +9,27 @@
     #include "stdlib.h"
     #include "CyLib.h"
     #include "UART_1.h"
+    #include "uart_tx_dma.h"
+    #include "uart_tx_ring.h"
+    #include "packet_queue.h"
+    #include "flow_control.h"
+    #include "crc.h"
+    #include "log_deferred.h"
+    #include "sample_batcher.h"
+    #include "timebase.h"
+    #include "payload_codec.h"
+    #include <stdarg.h>
     
     #define UART_PACKET_DELAY_MS 1 // small delay before sending packet to not overwhelm python software
 
     #define RX_NEXT_IS_CHAR               0x05
     #define RX_NEXT_IS_FLAG_AND_FLOAT     0x06
+    #define RX_NEXT_IS_CREDIT             0x07 //followed by uint16 number of packets the host can take
+    #define RX_NEXT_IS_LINK_STATS         0x08 //followed by uint16 report period in ms, 0 = off
+    #define RX_NEXT_IS_LOG_DICTIONARY     0x09 //followed by uint16 CRC of the host's log dictionary, 0 = ASCII logs
+    #define RX_NEXT_IS_CODEC              0x0B //followed by uint8 mask of payload codecs the host decodes, see payload_codec.h
+    #define RX_NEXT_IS_BATCH              0x0C //followed by uint16 frame length and a batched command frame, see command_table.h
+    #define RX_NEXT_IS_RPC                0x0D //followed by uint16 frame length and a request id, method and arguments, see rpc.h
     #define RX_FLAG_SET_MODE_1            0xc8 //200
     #define RX_FLAG_SET_MODE_2            0xc9 //201
     #define RX_FLAG_SET_MODE_3            0xca //202
@@ -25,6 +41,10 @@
     //#define MESSAGE_TYPE_ASCII_DATA   (uint8)2 //Todo: implement in Python? Probably not needed
     #define MESSAGE_TYPE_BINARY_FLOAT   (uint8)3
     #define MESSAGE_TYPE_FLAG           (uint8)4
+    #define MESSAGE_TYPE_LOG_DEFERRED   (uint8)5 //uint16 format ID + raw arguments, see log_deferred.h
+    #define MESSAGE_TYPE_SAMPLE_BATCH   (uint8)6 //timestamped run of samples from one channel, see sample_batcher.h
+    #define MESSAGE_TYPE_COMMAND_STATUS (uint8)7 //one status per RX_NEXT_IS_BATCH frame, see command_table.h
+    #define MESSAGE_TYPE_RPC_RESPONSE   (uint8)8 //answer to one RX_NEXT_IS_RPC request, see rpc.h
     
     //Message Flags to Indicate State Change or Alert
 
@@ -35,11 +55,42 @@
     #define MESSAGE_FLAG_CHAR_PARSED            (uint8)161
     #define MESSAGE_FLAG_ALIGNMENT_SENSORS      (uint8)100
     #define MESSAGE_FLAG_PGA_SETTINGS           (uint8)101
+    #define MESSAGE_FLAG_LINK_STATS             (uint8)102
+    #define MESSAGE_FLAG_EIG_STATS              (uint8)103
 
     #define UPDATE_TIMESTAMP_FOR_EACH_PACKET 1
+    #define LOG_MESSAGE_MAX_BYTES            256
 
+    //Wire layout: 4 byte head magic, 4 byte header, 4 byte timestamp, payload, tail
+    //Header: message type (top 2 bits: payload codec), flag, uint16 payload length on the wire
+    //Timestamp: low 32 bits of the monotonic time in TIMEBASE_WIRE_HZ units (timebase.h)
+    //Tail: uint16 sequence number, CRC over header+timestamp+payload+sequence
+    //(PACKET_CRC_BITS wide, little endian), 4 byte tail magic
+    #define PACKET_HEAD_BYTES                12u
+    #define PACKET_SEQUENCE_BYTES            2u
+    #define PACKET_CRC_BYTES                 (PACKET_CRC_BITS / 8u)
+    #define PACKET_TAIL_BYTES                (PACKET_SEQUENCE_BYTES + PACKET_CRC_BYTES + 4u)
+    #define PACKET_MAX_PAYLOAD_BYTES         (PACKET_QUEUE_SLOT_BYTES - PACKET_HEAD_BYTES - PACKET_TAIL_BYTES)
+    #define PACKET_PAYLOAD(slot)             (&(slot)->data[PACKET_HEAD_BYTES])
+    #if (LOG_MESSAGE_MAX_BYTES > PACKET_MAX_PAYLOAD_BYTES)
+        #error "a log message must fit in a packet queue slot"
+    #endif
+
+    //queuePacket() return codes
+    #define PACKET_OK                        (uint8)0
+    #define PACKET_ERR_QUEUE_FULL            (uint8)1
+    #define PACKET_ERR_TOO_LONG              (uint8)2
+
+    //Log calls are main loop only: they pace like constructAndSendPacket() and
+    //run the payload codec. From an ISR, reservePacket() + commitReservedPacket().
     void sendLogMessage(const char* format, ...);
+    void sendLogMessageV(const char* format, va_list args);
+    packetQueueSlot* reservePacket(uint8 messageType, uint8 messageFlag);
+    void commitReservedPacket(packetQueueSlot* slot, uint16 payloadBytes);
+    void sendReservedPacket(packetQueueSlot* slot, uint16 payloadBytes);
+    uint8 queuePacket(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payLoad);
     void constructHeader(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payLoad);
     void sendPacket();
     void constructAndSendPacket(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payLoad);
+    uint8 constructAndSendPacketAsync(uint8 messageType, uint8 messageFlag, uint16 payloadBytes, void* payLoad, uartTxDmaCallback onComplete, void* context);
 #endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "command_table.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+
+#include <string.h>
+
+// Most entries are at least 2 bytes, so a frame from the RX parser never holds
+// more than half its length in entries
+#define COMMAND_MAX_ENTRIES (RX_BATCH_MAX_BYTES / 2u)
+
+static commandHandler _handlers[256];
+
+void commandTable_register(uint8 flag, commandHandler handler)
+{
+    _handlers[flag] = handler; //NULL unregisters
+}
+
+commandHandler commandTable_get(uint8 flag)
+{
+    return _handlers[flag];
+}
+
+void commandTable_clear()
+{
+    memset(_handlers, 0, sizeof(_handlers));
+}
+
+uint8 commandTable_dispatch(uint8 flag, const commandValue* value)
+{
+    commandHandler handler = _handlers[flag];
+
+    if( handler == NULL )
+    {
+        return COMMAND_ERR_NO_HANDLER;
+    }
+    return handler(flag, value);
+}
+
+uint8 commandTable_runBatch(packetQueueSlot* response, const uint8* frame, uint16 numBytes)
+{
+    //Runs every entry of one frame and commits its status packet to response,
+    //a slot from reservePacket(MESSAGE_TYPE_COMMAND_STATUS, ...). Returns the
+    //number of entries that failed.
+    uint8* status = PACKET_PAYLOAD(response);
+    uint8  numEntries = 0;
+    uint8  numFailed = 0;
+    uint16 offset = 1; //after the frame id
+    uint8  valueBytes;
+    commandValue value;
+
+    if( numBytes == 0 )
+    {
+        packetQueue_commit(response); //left empty, the drain skips it
+        return 0;
+    }
+    while( offset < numBytes && numEntries < COMMAND_MAX_ENTRIES )
+    {
+        if( (uint16)(numBytes - offset) < 2u )
+        {
+            status[COMMAND_STATUS_HEAD_BYTES + numEntries] = COMMAND_ERR_TRUNCATED;
+            numEntries++;
+            numFailed++;
+            break;
+        }
+        value.type         = frame[offset + 1u];
+        value.value.asUint = 0;
+        valueBytes         = commandTable_valueBytes(value.type);
+        if( valueBytes == COMMAND_VALUE_INVALID || valueBytes > (uint16)(numBytes - offset - 2u) )
+        {
+            status[COMMAND_STATUS_HEAD_BYTES + numEntries] = (valueBytes == COMMAND_VALUE_INVALID) ? COMMAND_ERR_BAD_TYPE : COMMAND_ERR_TRUNCATED;
+            numEntries++;
+            numFailed++;
+            break; //the rest of the frame cannot be found
+        }
+        memcpy(&value.value, &frame[offset + 2u], valueBytes); //little endian, like the target
+        status[COMMAND_STATUS_HEAD_BYTES + numEntries] = commandTable_dispatch(frame[offset], &value);
+        if( status[COMMAND_STATUS_HEAD_BYTES + numEntries] != COMMAND_OK )
+        {
+            numFailed++;
+        }
+        numEntries++;
+        offset += 2u + valueBytes;
+    }
+
+    status[0] = frame[0];
+    status[1] = numEntries;
+    status[2] = numFailed;
+    commitReservedPacket(response, COMMAND_STATUS_HEAD_BYTES + numEntries);
+    return numFailed;
+}
+
+uint8 commandTable_valueBytes(uint8 type)
+{
+    //value bytes after the type byte, COMMAND_VALUE_INVALID for an unknown type
+    switch( type )
+    {
+        case COMMAND_VALUE_NONE:    return 0;
+        case COMMAND_VALUE_UINT8:   return 1;
+        case COMMAND_VALUE_UINT16:  return 2;
+        case COMMAND_VALUE_INT32:   return 4;
+        case COMMAND_VALUE_FLOAT32: return 4;
+        default:                    return COMMAND_VALUE_INVALID;
+    }
+}
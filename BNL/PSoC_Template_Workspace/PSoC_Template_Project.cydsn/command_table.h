@@ -0,0 +1,75 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef COMMAND_TABLE_H
+    #define COMMAND_TABLE_H
+
+    #include <cytypes.h>
+    #include "packet_queue.h"
+
+    // Batched command frames. The host sends many (flag, typed value) settings
+    // in one frame and gets one MESSAGE_TYPE_COMMAND_STATUS packet back:
+    //
+    //   RX_NEXT_IS_BATCH, uint16 frame length, then the frame:
+    //     uint8 frame id, echoed in the status packet
+    //     entries: uint8 flag, uint8 COMMAND_VALUE_* type, value (little endian)
+    //
+    //   status payload: uint8 frame id, uint8 entries run, uint8 entries failed,
+    //                   then one COMMAND_* status byte per entry run
+    //
+    // Every flag is dispatched through a 256 entry table of handlers, filled by
+    // commandTable_register() at init. Handlers run in the main loop (from
+    // rxParser_poll()). An entry with an unknown value type ends the frame, as
+    // the entries after it cannot be found.
+    //
+    // The parser reserves the status packet's queue slot before the frame
+    // runs, so an interrupt queuing packets meanwhile cannot leave a frame
+    // that took effect without its status.
+
+    #define COMMAND_VALUE_NONE           (uint8)0 // no value bytes
+    #define COMMAND_VALUE_UINT8          (uint8)1
+    #define COMMAND_VALUE_UINT16         (uint8)2
+    #define COMMAND_VALUE_INT32          (uint8)3
+    #define COMMAND_VALUE_FLOAT32        (uint8)4
+    #define COMMAND_VALUE_INVALID        (uint8)0xFF // commandTable_valueBytes() of an unknown type
+
+    #define COMMAND_OK                   (uint8)0
+    #define COMMAND_ERR_NO_HANDLER       (uint8)1 // nothing registered for the flag
+    #define COMMAND_ERR_BAD_TYPE         (uint8)2 // unknown value type, or not one the handler takes
+    #define COMMAND_ERR_RANGE            (uint8)3 // value out of range for the flag
+    #define COMMAND_ERR_TRUNCATED        (uint8)4 // frame ends inside the entry
+
+    #define COMMAND_STATUS_HEAD_BYTES    3u
+
+    typedef struct
+    {
+        uint8 type;   // COMMAND_VALUE_*
+        union
+        {
+            uint32 asUint;  // UINT8, UINT16
+            int32  asInt;   // INT32
+            float  asFloat; // FLOAT32
+        } value;
+    } commandValue;
+
+    // returns a COMMAND_* status, reported back to the host
+    typedef uint8 (*commandHandler)(uint8 flag, const commandValue* value);
+
+    void           commandTable_register(uint8 flag, commandHandler handler);
+    commandHandler commandTable_get(uint8 flag);
+    void           commandTable_clear();
+    uint8          commandTable_dispatch(uint8 flag, const commandValue* value);
+    uint8          commandTable_runBatch(packetQueueSlot* response, const uint8* frame, uint16 numBytes);
+    uint8          commandTable_valueBytes(uint8 type);
+#endif
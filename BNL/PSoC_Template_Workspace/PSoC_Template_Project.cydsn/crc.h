@@ -0,0 +1,31 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef CRC_H
+    #define CRC_H
+
+    #include <cytypes.h>
+
+    // Table driven CRCs for the packet trailer. Both can be fed in pieces:
+    //   crc = crc16_update(CRC16_INIT, a, n); crc = crc16_update(crc, b, m);
+    //   crc = CRC32_FINAL( crc32_update(crc32_update(CRC32_INIT, a, n), b, m) );
+    // Check values over "123456789": CRC-16 0x29B1, CRC-32 0xCBF43926.
+
+    #define CRC16_INIT         (uint16)0xFFFF
+    #define CRC32_INIT         (uint32)0xFFFFFFFF
+    #define CRC32_FINAL(crc)   ((uint32)(crc) ^ 0xFFFFFFFFu)
+
+    uint16 crc16_update(uint16 crc, const uint8* data, uint16 numBytes);
+    uint32 crc32_update(uint32 crc, const uint8* data, uint16 numBytes);
+#endif
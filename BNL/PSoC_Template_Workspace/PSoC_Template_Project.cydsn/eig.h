@@ -23,9 +23,35 @@
     #define PRINCIPLE_COMPONENTS 4
     #define MAT_SIZE 32
     
+    // eig_decomp_all(): QL sweeps allowed per eigenvalue before giving up, which
+    // bounds the worst case at MAT_SIZE * EIG_QL_MAX_ITERATIONS sweeps
+    #ifndef EIG_QL_MAX_ITERATIONS
+        #define EIG_QL_MAX_ITERATIONS 30
+    #endif
+    #define EIG_QL_NOT_CONVERGED 0xFFFF
+    
+    // eig_decomp_tol(): what one call did, per principal component. cycles are
+    // timebase_getCycles32() counts including the deflation before the
+    // component. residual is ||Sigma phi - lambda phi|| against the undeflated
+    // Sigma, and orthogonality the largest |phi_i . phi_j| (0 when exact): both
+    // grow when errors in the early components leak through deflation.
+    typedef struct
+    {
+        uint16 iterations[PRINCIPLE_COMPONENTS];    // Power plus Rayleigh Iterations run
+        float  residual[PRINCIPLE_COMPONENTS];
+        uint32 cycles[PRINCIPLE_COMPONENTS];
+        float  orthogonality;
+        uint8  converged;                           // bit i set when component i reached tol
+    } eig_stats;
+    #define EIG_ALL_CONVERGED ((uint8)((1u << PRINCIPLE_COMPONENTS) - 1u))
+    
     void eig_decomp(float lambda[PRINCIPLE_COMPONENTS], float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE], float Sigma[MAT_SIZE][MAT_SIZE], float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE], const uint8 p_iter, const uint8 r_iter);
     float dot(float a[MAT_SIZE], float b[MAT_SIZE]);
     void invert_matrix(float Sigma[MAT_SIZE][MAT_SIZE], float SigmaInverse[MAT_SIZE][MAT_SIZE]);
+    void eig_decomp_subspace(float lambda[PRINCIPLE_COMPONENTS], float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE], float Sigma[MAT_SIZE][MAT_SIZE], float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE], const uint8 p_iter, const uint8 r_iter);
+    uint16 eig_decomp_all(float d[MAT_SIZE], float V[MAT_SIZE][MAT_SIZE], float Sigma[MAT_SIZE][MAT_SIZE]);
+    uint8 eig_decomp_tol(float lambda[PRINCIPLE_COMPONENTS], float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE], float Sigma[MAT_SIZE][MAT_SIZE], float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE], const uint8 p_iter, const uint8 r_iter, float tol, eig_stats * stats);
+    uint8 shifted_solve(float Sigma[MAT_SIZE][MAT_SIZE], float shift, float b[MAT_SIZE], float x[MAT_SIZE]);
     
 #endif
 
@@ -0,0 +1,563 @@
+/**************************************************************************//**
+ *
+ * @file   eig_packed.c
+ *
+ * @brief eig_decomp() on the packed upper triangle of Sigma. Same power
+ * iteration, Rayleigh quotient iteration and deflation, but every kernel
+ * reads the MAT_SIZE * (MAT_SIZE + 1) / 2 stored elements once, and the
+ * only scratch is the caller's eig_workspace, so two decompositions can run
+ * side by side and none of W1, W2 or W3 is touched.
+ *
+ *****************************************************************************/
+
+#include "knobs.h"
+#include "eig_packed.h"
+#include "math.h"
+#include "float.h"
+
+// static function prototypes
+static void packed_power_iteration(float Phi_row[MAT_SIZE],
+  const float Sigma[EIG_PACKED_SIZE], float eig_vec[MAT_SIZE], const uint8 p_iter);
+static float packed_rayleigh_quotient_iteration(float Phi_row[MAT_SIZE],
+  const float Sigma[EIG_PACKED_SIZE], float eig_vec[MAT_SIZE], const uint8 r_iter,
+  float factor[EIG_PACKED_SIZE]);
+static uint8 packed_factor(const float A[EIG_PACKED_SIZE], float shift,
+  float factor[EIG_PACKED_SIZE]);
+static void packed_solve(const float factor[EIG_PACKED_SIZE], float x[MAT_SIZE],
+  const uint8 first);
+
+/**************************************************************************//**
+ * eig_decomp_packed
+ *
+ * @brief Primary public function, eig_decomp() for a packed Sigma with a
+ * caller supplied workspace. Arguments and results as for eig_decomp().
+ *
+ * @param[out] lambda Array that gets updated with PRINCIPLE_COMPONENTS number of
+ * eigenvalues.
+ *
+ * @param[out] Phi 2D array that gets updated with the eigenvectors.
+ *
+ * @param[in] Sigma Packed symmetric matrix to be decomposed, see eig_pack().
+ *
+ * @param[in] Eig_vecs_init 2D array of initial eigenvector guesses.
+ *
+ * @param[in] p_iter Number of Power Iterations for eigen decomp.
+ *
+ * @param[in] r_iter Number of Rayleigh Iterations for eigen decomp.
+ *
+ * @param[in,out] workspace Scratch for this decomposition only.
+ *
+ * @return Nothing, void function.
+ *
+ *****************************************************************************/
+
+void eig_decomp_packed(float lambda[PRINCIPLE_COMPONENTS],
+  float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE], const float Sigma[EIG_PACKED_SIZE],
+  float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE], const uint8 p_iter,
+  const uint8 r_iter, eig_workspace * workspace)
+{
+  uint8 i = 0;
+  const float * A = Sigma;
+
+  for (i = 0; i < PRINCIPLE_COMPONENTS; ++i) // loop for each PC
+  {
+    if (i > 0)
+    {
+      // deflated holds Sigma less every eigenpair found so far
+      packed_deflation(workspace->deflated, A, Phi[i-1], lambda[i-1]);
+      A = workspace->deflated;
+    }
+
+    if (p_iter > 0)
+    {
+      // computing dominant eigenvector
+      packed_power_iteration(Phi[i], A, Eig_vecs_init[i], p_iter);
+      if (0 == r_iter)
+      {
+        lambda[i] = packed_rayleigh_quotient(A, Phi[i]);
+      }
+      else
+      { /* r_iter > 0 */
+        lambda[i] = packed_rayleigh_quotient_iteration(Phi[i], A, Phi[i], r_iter,
+          workspace->factor);
+      }
+    }
+    else if (r_iter > 0)
+    {
+      lambda[i] = packed_rayleigh_quotient_iteration(Phi[i], A, Eig_vecs_init[i],
+        r_iter, workspace->factor);
+    } /* else, p_it == 0 and r_it == 0 and Phi won't be updated */
+  }
+  return;
+}
+
+/**************************************************************************//**
+ * eig_pack
+ *
+ * @brief Public function that copies the upper triangle of a symmetric 2D
+ * array into packed storage.
+ *
+ * @param[in] Sigma 2D array of dimension MAT_SIZE x MAT_SIZE.
+ *
+ * @param[out] Sigma_packed Array of EIG_PACKED_SIZE.
+ *
+ * @return Nothing, void function.
+ *
+ *****************************************************************************/
+
+void eig_pack(float Sigma[MAT_SIZE][MAT_SIZE], float Sigma_packed[EIG_PACKED_SIZE])
+{
+  uint8 i = 0, j = 0;
+  uint16 n = 0;
+
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    for (j = i; j < MAT_SIZE; ++j)
+    {
+      Sigma_packed[n++] = Sigma[i][j];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * packed_matvec
+ *
+ * @brief Public function for y = A * x with A packed. Each stored element is
+ * used for both of its positions, (i, j) and (j, i).
+ *
+ * @param[in] A Packed symmetric matrix.
+ *
+ * @param[in] x Array of length MAT_SIZE.
+ *
+ * @param[out] y Array of length MAT_SIZE, not x.
+ *
+ * @return Nothing, void function.
+ *
+ *****************************************************************************/
+
+void packed_matvec(const float A[EIG_PACKED_SIZE], const float x[MAT_SIZE],
+  float y[MAT_SIZE])
+{
+  uint8 i = 0, j = 0;
+  float xi = 0, sum = 0;
+  const float * row = A;
+
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    y[i] = 0;
+  }
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    xi = x[i];
+    sum = row[0] * xi;
+    for (j = i + 1; j < MAT_SIZE; ++j)
+    {
+      sum += row[j - i] * x[j];
+      y[j] += row[j - i] * xi;
+    }
+    y[i] += sum;
+    row += MAT_SIZE - i;
+  }
+}
+
+/**************************************************************************//**
+ * packed_rayleigh_quotient
+ *
+ * @brief Public function for the Rayleigh Quotient x' A x of a unit vector,
+ * A packed.
+ *
+ * @param[in] A Packed symmetric matrix.
+ *
+ * @param[in] x Array of length MAT_SIZE.
+ *
+ * @return lambda_l Scalar value representing Rayleigh Quotient.
+ *
+ *****************************************************************************/
+
+float packed_rayleigh_quotient(const float A[EIG_PACKED_SIZE], const float x[MAT_SIZE])
+{
+  uint8 i = 0, j = 0;
+  float lambda_l = 0, temp = 0;
+  const float * row = A;
+
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    temp = 0;
+    for (j = i + 1; j < MAT_SIZE; ++j)
+    {
+      temp += row[j - i] * x[j];
+    }
+    lambda_l += (row[0] * x[i] + 2 * temp) * x[i];
+    row += MAT_SIZE - i;
+  }
+  return lambda_l;
+}
+
+/**************************************************************************//**
+ * packed_deflation
+ *
+ * @brief Public function for Hotelling's Deflation of a packed matrix,
+ * Deflated = A - lambda * eig_vec * eig_vec'. The two may be the same array.
+ *
+ * @param[out] Deflated Packed result.
+ *
+ * @param[in] A Packed symmetric matrix.
+ *
+ * @param[in] eig_vec Array representing the dominant eigenvector of A.
+ *
+ * @param[in] lambda Scalar representing the dominant eigenvalue of A.
+ *
+ * @return Nothing.
+ *
+ *****************************************************************************/
+
+void packed_deflation(float Deflated[EIG_PACKED_SIZE], const float A[EIG_PACKED_SIZE],
+  const float eig_vec[MAT_SIZE], float lambda)
+{
+  uint8 i = 0, j = 0;
+  uint16 n = 0;
+  float lambda_v = 0;
+
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    lambda_v = lambda * eig_vec[i];
+    for (j = i; j < MAT_SIZE; ++j, ++n)
+    {
+      Deflated[n] = A[n] - lambda_v * eig_vec[j];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * packed_rank1_update
+ *
+ * @brief Public function for A = beta * A + alpha * v * v', A packed, in one
+ * pass. A sample added to a covariance, or removed with alpha < 0.
+ *
+ * @param[in,out] A Packed symmetric matrix.
+ *
+ * @param[in] beta Scalar A is multiplied by, 1 to only add.
+ *
+ * @param[in] alpha Scalar weight of v * v'.
+ *
+ * @param[in] v Array of length MAT_SIZE.
+ *
+ * @return Nothing.
+ *
+ *****************************************************************************/
+
+void packed_rank1_update(float A[EIG_PACKED_SIZE], float beta, float alpha,
+  const float v[MAT_SIZE])
+{
+  uint8 i = 0, j = 0;
+  uint16 n = 0;
+  float alpha_v = 0;
+
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    alpha_v = alpha * v[i];
+    for (j = i; j < MAT_SIZE; ++j, ++n)
+    {
+      A[n] = beta * A[n] + alpha_v * v[j];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * packed_shifted_solve
+ *
+ * @brief Solves (A - shift * I) x = b for a packed A by the symmetric
+ * factorization U' D U (U unit upper triangular), into a packed factor the
+ * same size as A: half the storage and half the multiply-adds of
+ * shifted_solve().
+ *
+ * There is no pivoting. Rayleigh iteration shifts by an approximation of
+ * the largest eigenvalue left after deflation, so A - shift * I is close to
+ * negative semi-definite and its pivots are too. Pivots smaller than
+ * FLT_EPSILON times the largest element are clamped to that size, as in
+ * shifted_solve(), for the shift landing on the eigenvalue.
+ *
+ * @param[in] A Packed symmetric matrix, not modified.
+ *
+ * @param[in] shift Scalar subtracted from the diagonal of A.
+ *
+ * @param[in] b Right hand side of length MAT_SIZE.
+ *
+ * @param[out] x Solution of length MAT_SIZE, may be b.
+ *
+ * @param[out] factor Packed U' D U, D on the diagonal.
+ *
+ * @return 1 if a pivot was clamped, 0 otherwise.
+ *
+ *****************************************************************************/
+
+uint8 packed_shifted_solve(const float A[EIG_PACKED_SIZE], float shift,
+  const float b[MAT_SIZE], float x[MAT_SIZE], float factor[EIG_PACKED_SIZE])
+{
+  uint8 i = 0;
+  uint8 clamped = 0;
+
+  clamped = packed_factor(A, shift, factor);
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    x[i] = b[i];
+  }
+  packed_solve(factor, x, 0);
+  return clamped;
+}
+
+/**************************************************************************//**
+ * packed_invert
+ *
+ * @brief Public function for the inverse of a packed symmetric matrix: one
+ * U' D U factorization as in packed_shifted_solve(), then a solve for each
+ * column of the identity, MAT_SIZE^3 / 2 multiply-adds in all. Unlike
+ * invert_matrix() the input is kept. Meant for positive definite matrices
+ * such as a covariance; a singular A gets clamped pivots and a very large
+ * but finite inverse.
+ *
+ * @param[in] A Packed symmetric matrix, not modified.
+ *
+ * @param[out] A_inv Packed inverse of A. Must not be A.
+ *
+ * @param[out] factor Packed U' D U of A, scratch.
+ *
+ * @return 1 if a pivot was clamped, 0 otherwise.
+ *
+ *****************************************************************************/
+
+uint8 packed_invert(const float A[EIG_PACKED_SIZE], float A_inv[EIG_PACKED_SIZE],
+  float factor[EIG_PACKED_SIZE])
+{
+  uint8 i = 0, k = 0;
+  uint8 clamped = 0;
+  float x[MAT_SIZE];
+
+  clamped = packed_factor(A, 0, factor);
+  for (k = 0; k < MAT_SIZE; ++k)
+  {
+    for (i = 0; i < MAT_SIZE; ++i)
+    {
+      x[i] = (i == k) ? 1.0f : 0.0f;
+    }
+    /* column k, of which the upper triangle keeps rows 0..k */
+    packed_solve(factor, x, k);
+    for (i = 0; i <= k; ++i)
+    {
+      A_inv[EIG_PACKED_INDEX(i, k)] = x[i];
+    }
+  }
+  return clamped;
+}
+
+/**************************************************************************//**
+ * packed_power_iteration
+ *
+ * @brief Static function, power_iteration() of eig.c on a packed matrix.
+ * Phi_row is left as it is if Sigma maps it to 0, which a warm-started
+ * tracker with too few samples for a component can run into.
+ *
+ * @param[out] Phi_row Array of length MAT_SIZE that gets updated with the
+ * computed dominant eigenvector for Sigma.
+ *
+ * @param[in] Sigma Packed symmetric matrix.
+ *
+ * @param[in] eig_vec MAT_SIZE-length initial eigenvector guess for iteration.
+ *
+ * @param[in] p_iter Number of Power Iterations for eigen decomp.
+ *
+ * @return Nothing, void function.
+ *
+ *****************************************************************************/
+
+static void packed_power_iteration(float Phi_row[MAT_SIZE],
+  const float Sigma[EIG_PACKED_SIZE], float eig_vec[MAT_SIZE], const uint8 p_iter)
+{
+  uint8 i = 0, j = 0;
+  float norm_v = 0;
+  float temp_vec[MAT_SIZE];
+
+  for (i = 0; i < p_iter; ++i)
+  {
+    /* first time start with eig_vec initial guess, then feedback the previous result */
+    packed_matvec(Sigma, (0 == i) ? eig_vec : Phi_row, temp_vec);
+    norm_v = sqrtf(dot(temp_vec, temp_vec));
+    if (!(norm_v > 0))
+    {
+      break; /* Sigma * v is 0, nothing to normalize */
+    }
+    for (j = 0; j < MAT_SIZE; ++j)
+    {
+      Phi_row[j] = temp_vec[j] / norm_v;
+    }
+  }
+  return;
+}
+
+/**************************************************************************//**
+ * packed_rayleigh_quotient_iteration
+ *
+ * @brief Static function, rayleigh_quotient_iteration() of eig.c on a packed
+ * matrix, each solve by packed_shifted_solve().
+ *
+ * @param[out] Phi_row Array of length MAT_SIZE that gets updated with the
+ * final computed dominant eigenvector result.
+ *
+ * @param[in] Sigma Packed symmetric matrix.
+ *
+ * @param[in] eig_vec MAT_SIZE-length initial eigenvector guess for iteration.
+ *
+ * @param[in] r_iter Number of Rayleigh Quotient Iterations for eigen decomp.
+ *
+ * @param[out] factor Packed scratch for packed_shifted_solve().
+ *
+ * @return lambda_l Dominant computed eigenvalue.
+ *
+ *****************************************************************************/
+
+static float packed_rayleigh_quotient_iteration(float Phi_row[MAT_SIZE],
+  const float Sigma[EIG_PACKED_SIZE], float eig_vec[MAT_SIZE], const uint8 r_iter,
+  float factor[EIG_PACKED_SIZE])
+{
+  uint8 i = 0, j = 0;
+  float lambda_l = 0, norm_v = 0;
+  float temp_vec[MAT_SIZE];
+
+  /* compute Rayleigh's quotient initial time */
+  lambda_l = packed_rayleigh_quotient(Sigma, eig_vec);
+
+  for (i = 0; i < r_iter; ++i)
+  {
+    /* temp_vec = (Sigma - lambda_l * I)^-1 * v */
+    packed_shifted_solve(Sigma, lambda_l, (0 == i) ? eig_vec : Phi_row, temp_vec, factor);
+
+    norm_v = sqrtf(dot(temp_vec, temp_vec));
+    for (j = 0; j < MAT_SIZE; ++j)
+    {
+      Phi_row[j] = temp_vec[j] / norm_v;
+    }
+
+    lambda_l = packed_rayleigh_quotient(Sigma, Phi_row);
+  }
+  return lambda_l;
+}
+
+/**************************************************************************//**
+ * packed_factor
+ *
+ * @brief Static function for the U' D U factorization of A - shift * I used
+ * by packed_shifted_solve() and packed_invert(), pivots clamped as described
+ * there.
+ *
+ * @param[in] A Packed symmetric matrix, not modified.
+ *
+ * @param[in] shift Scalar subtracted from the diagonal of A.
+ *
+ * @param[out] factor Packed U' D U, D on the diagonal.
+ *
+ * @return 1 if a pivot was clamped, 0 otherwise.
+ *
+ *****************************************************************************/
+
+static uint8 packed_factor(const float A[EIG_PACKED_SIZE], float shift,
+  float factor[EIG_PACKED_SIZE])
+{
+  uint8 i = 0, j = 0, k = 0;
+  uint8 clamped = 0;
+  uint16 n = 0;
+  float largest = 0, tiny = 0, pivot = 0, inv_pivot = 0, l = 0;
+  float * row_k = factor;
+  float * row_i = factor;
+
+  /* factor = A - shift * I */
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    for (j = i; j < MAT_SIZE; ++j, ++n)
+    {
+      factor[n] = (i == j) ? A[n] - shift : A[n];
+      if (fabsf(factor[n]) > largest)
+      {
+        largest = fabsf(factor[n]);
+      }
+    }
+  }
+  tiny = (largest > 0) ? largest * FLT_EPSILON : FLT_MIN;
+
+  /* right-looking, row k of U scaled once the rows below are updated */
+  for (k = 0; k < MAT_SIZE; ++k)
+  {
+    pivot = row_k[0];
+    if (fabsf(pivot) < tiny)
+    {
+      pivot = (pivot < 0) ? -tiny : tiny;
+      row_k[0] = pivot;
+      clamped = 1;
+    }
+    inv_pivot = 1.0f / pivot;
+    row_i = row_k + (MAT_SIZE - k);
+    for (i = k + 1; i < MAT_SIZE; ++i)
+    {
+      l = row_k[i - k] * inv_pivot;
+      for (j = i; j < MAT_SIZE; ++j)
+      {
+        row_i[j - i] -= l * row_k[j - k];
+      }
+      row_i += MAT_SIZE - i;
+    }
+    for (j = k + 1; j < MAT_SIZE; ++j)
+    {
+      row_k[j - k] *= inv_pivot;
+    }
+    row_k += MAT_SIZE - k;
+  }
+  return clamped;
+}
+
+/**************************************************************************//**
+ * packed_solve
+ *
+ * @brief Static function that solves U' D U x = b in place with a factor
+ * from packed_factor().
+ *
+ * @param[in] factor Packed U' D U.
+ *
+ * @param[in,out] x Right hand side b in, solution out, length MAT_SIZE.
+ *
+ * @param[in] first Index of the first nonzero element of b, 0 if unknown.
+ * U' is lower triangular, so the forward solve starts there.
+ *
+ * @return Nothing.
+ *
+ *****************************************************************************/
+
+static void packed_solve(const float factor[EIG_PACKED_SIZE], float x[MAT_SIZE],
+  const uint8 first)
+{
+  uint8 i = 0, j = 0, k = 0;
+  float sum = 0;
+  const float * row_k = &factor[EIG_PACKED_INDEX(first, first)];
+  const float * row_i = factor;
+
+  /* U' z = b, z = D^-1 z, then U x = z */
+  for (k = first; k < MAT_SIZE; ++k)
+  {
+    for (i = k + 1; i < MAT_SIZE; ++i)
+    {
+      x[i] -= row_k[i - k] * x[k];
+    }
+    x[k] /= row_k[0];
+    row_k += MAT_SIZE - k;
+  }
+  for (i = MAT_SIZE; i-- > 0; )
+  {
+    row_i = &factor[EIG_PACKED_INDEX(i, i)];
+    sum = x[i];
+    for (j = i + 1; j < MAT_SIZE; ++j)
+    {
+      sum -= row_i[j - i] * x[j];
+    }
+    x[i] = sum;
+  }
+}
+
+/* [] END OF FILE */
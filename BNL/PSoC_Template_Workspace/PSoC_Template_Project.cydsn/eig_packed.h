@@ -0,0 +1,45 @@
+/**************************************************************************//**
+ *
+ * @file   eig_packed.h
+ *
+ * @brief Reentrant eig_decomp() on packed symmetric storage, with the
+ * workspace supplied by the caller instead of the W1, W2 and W3 globals.
+ *
+ *****************************************************************************/
+
+
+#ifndef EIG_PACKED_H
+    #define EIG_PACKED_H
+
+    // eig_packed includes
+    #include "eig.h"
+
+    // Upper triangle of a symmetric MAT_SIZE x MAT_SIZE matrix, row by row:
+    // row i holds columns i..MAT_SIZE-1. Element (i, j) for i <= j.
+    #define EIG_PACKED_SIZE (MAT_SIZE * (MAT_SIZE + 1) / 2)
+    #define EIG_PACKED_INDEX(i, j) ((i) * MAT_SIZE - ((i) * ((i) - 1)) / 2 + (j) - (i))
+
+    // Everything eig_decomp_packed() writes besides its outputs, 4.1 KB where
+    // eig_decomp() uses 12 KB of globals. One per decomposition that may run
+    // at the same time, e.g. a static one each for the ADC channels and the
+    // accelerometer.
+    typedef struct
+    {
+        float deflated[EIG_PACKED_SIZE];    // Sigma less the eigenpairs found so far
+        float factor[EIG_PACKED_SIZE];      // U' D U of (Sigma - lambda I), Rayleigh iteration
+    } eig_workspace;
+
+    // Function prototypes
+    void eig_decomp_packed(float lambda[PRINCIPLE_COMPONENTS], float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE], const float Sigma[EIG_PACKED_SIZE], float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE], const uint8 p_iter, const uint8 r_iter, eig_workspace * workspace);
+    void eig_pack(float Sigma[MAT_SIZE][MAT_SIZE], float Sigma_packed[EIG_PACKED_SIZE]);
+    void packed_matvec(const float A[EIG_PACKED_SIZE], const float x[MAT_SIZE], float y[MAT_SIZE]);
+    float packed_rayleigh_quotient(const float A[EIG_PACKED_SIZE], const float x[MAT_SIZE]);
+    void packed_deflation(float Deflated[EIG_PACKED_SIZE], const float A[EIG_PACKED_SIZE], const float eig_vec[MAT_SIZE], float lambda);
+    void packed_rank1_update(float A[EIG_PACKED_SIZE], float beta, float alpha, const float v[MAT_SIZE]);
+    uint8 packed_shifted_solve(const float A[EIG_PACKED_SIZE], float shift, const float b[MAT_SIZE], float x[MAT_SIZE], float factor[EIG_PACKED_SIZE]);
+    uint8 packed_invert(const float A[EIG_PACKED_SIZE], float A_inv[EIG_PACKED_SIZE], float factor[EIG_PACKED_SIZE]);
+
+#endif
+
+
+/* [] END OF FILE */
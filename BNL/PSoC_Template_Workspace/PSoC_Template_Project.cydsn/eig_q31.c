@@ -0,0 +1,444 @@
+/**************************************************************************//**
+ *
+ * @file   eig_q31.c
+ *
+ * @brief Fixed-point version of the eig.c power iteration with deflation.
+ * Matrix and vectors are Q31, every product goes into a 64-bit accumulator
+ * (one SMLAL on the Cortex-M3 instead of a soft-float multiply and add), and
+ * each power step renormalizes with a shared block exponent so small
+ * deflated eigenvalues keep their 31 bits.
+ *
+ *****************************************************************************/
+
+#include "knobs.h"
+#include "eig_q31.h"
+#include "math.h"
+
+// external globals
+extern int32 W1_q31[MAT_SIZE][MAT_SIZE];            // deflated Sigma workspace
+
+// static function prototypes
+static void power_iteration_q31(int32 Phi_row[MAT_SIZE],
+  int32 Sigma[MAT_SIZE][MAT_SIZE], int32 eig_vec[MAT_SIZE], const uint16 p_iter);
+static int32 compute_rayleigh_quotient_q31(int32 Sigma[MAT_SIZE][MAT_SIZE],
+  int32 eig_vec[MAT_SIZE]);
+static void deflation_q31(int32 Deflated_Sigma[MAT_SIZE][MAT_SIZE],
+  int32 Sigma[MAT_SIZE][MAT_SIZE], int32 eig_vec[MAT_SIZE], int32 lambda);
+static void multiply_q62(int64 acc[MAT_SIZE], int32 Sigma[MAT_SIZE][MAT_SIZE],
+  int32 v[MAT_SIZE]);
+static uint8 normalize_q62(int32 v[MAT_SIZE], int64 acc[MAT_SIZE]);
+static int32 q62_to_q31(int64 x);
+static uint32 isqrt64(uint64 x);
+
+/**************************************************************************//**
+ * eig_decomp_q31
+ *
+ * @brief Primary public function, eig_decomp() on Q31 data. Power iteration
+ * for each of the PRINCIPLE_COMPONENTS dominant eigenvectors, deflating
+ * Sigma into W1_q31 between them.
+ *
+ * Rayleigh quotient iteration is not available: (Sigma - lambda I) is
+ * singular to working precision near convergence and its solution does not
+ * fit in Q31. r_iter iterations are run as further power iterations instead,
+ * p_iter + r_iter in all.
+ *
+ * @param[out] lambda Array that gets updated with PRINCIPLE_COMPONENTS Q31
+ * eigenvalues, on the scale of Sigma.
+ *
+ * @param[out] Phi 2D array that gets updated with the Q31 unit eigenvectors.
+ *
+ * @param[in] Sigma 2D Q31 array representing the symmetric matrix to be
+ * decomposed, scaled as by eig_q31_from_float().
+ *
+ * @param[in] Eig_vecs_init 2D Q31 array of initial eigenvector guesses, any
+ * non-zero length.
+ *
+ * @param[in] p_iter Number of Power Iterations for eigen decomp.
+ *
+ * @param[in] r_iter Number of Rayleigh Iterations asked for, see above. When
+ * both are 0 Phi won't be updated.
+ *
+ * @return Nothing, void function.
+ *
+ *****************************************************************************/
+
+void eig_decomp_q31(int32 lambda[PRINCIPLE_COMPONENTS],
+  int32 Phi[PRINCIPLE_COMPONENTS][MAT_SIZE], int32 Sigma[MAT_SIZE][MAT_SIZE],
+  int32 Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE], const uint8 p_iter,
+  const uint8 r_iter)
+{
+  uint8 i = 0;
+  uint16 num_iter = (uint16)p_iter + r_iter;
+
+  if (0 == num_iter)
+  {
+    return;
+  }
+
+  // computing dominant eigenvector
+  power_iteration_q31(Phi[0], Sigma, Eig_vecs_init[0], num_iter);
+  lambda[0] = compute_rayleigh_quotient_q31(Sigma, Phi[0]);
+
+  for (i = 1; i < PRINCIPLE_COMPONENTS; ++i) // loop for each remaining PC
+  {
+    // W1_q31 holds Sigma deflated by every eigenvector found so far
+    deflation_q31(W1_q31, (1 == i) ? Sigma : W1_q31, Phi[i-1], lambda[i-1]);
+    power_iteration_q31(Phi[i], W1_q31, Eig_vecs_init[i], num_iter);
+    lambda[i] = compute_rayleigh_quotient_q31(W1_q31, Phi[i]);
+  }
+  return;
+}
+
+/**************************************************************************//**
+ * power_iteration_q31
+ *
+ * @brief Static function for Power Iteration on a Q31 symmetric matrix. The
+ * initial guess is normalized first, so it only needs to be non-zero.
+ *
+ * @param[out] Phi_row Array of length MAT_SIZE that gets updated with the
+ * computed dominant unit eigenvector.
+ *
+ * @param[in] Sigma 2D Q31 array representing the symmetric matrix.
+ *
+ * @param[in] eig_vec MAT_SIZE-length initial eigenvector guess.
+ *
+ * @param[in] p_iter Number of Power Iterations.
+ *
+ * @return Nothing, void function.
+ *
+ *****************************************************************************/
+
+static void power_iteration_q31(int32 Phi_row[MAT_SIZE],
+  int32 Sigma[MAT_SIZE][MAT_SIZE], int32 eig_vec[MAT_SIZE], const uint16 p_iter)
+{
+  uint16 i = 0;
+  uint8 j = 0;
+  int64 acc[MAT_SIZE];
+
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    acc[j] = eig_vec[j];
+    Phi_row[j] = eig_vec[j];
+  }
+  normalize_q62(Phi_row, acc);
+
+  for (i = 0; i < p_iter; ++i)
+  {
+    multiply_q62(acc, Sigma, Phi_row);
+    if (!normalize_q62(Phi_row, acc))
+    {
+      break; /* Sigma * Phi_row is 0, an eigenvector with eigenvalue 0 */
+    }
+  }
+  return;
+}
+
+/**************************************************************************//**
+ * multiply_q62
+ *
+ * @brief Static function for acc = Sigma * v with Q62 results. The sums are
+ * taken modulo 2^64, so a partial sum may wrap as long as the result fits,
+ * which |Sigma * v| < 1 for a unit v guarantees.
+ *
+ * @param[out] acc Array of MAT_SIZE Q62 products.
+ *
+ * @param[in] Sigma 2D Q31 array of dimension MAT_SIZE x MAT_SIZE.
+ *
+ * @param[in] v Q31 array of length MAT_SIZE.
+ *
+ * @return Nothing, void function.
+ *
+ *****************************************************************************/
+
+static void multiply_q62(int64 acc[MAT_SIZE], int32 Sigma[MAT_SIZE][MAT_SIZE],
+  int32 v[MAT_SIZE])
+{
+  uint8 j = 0, k = 0;
+  uint64 sum = 0;
+
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    sum = 0;
+    for (k = 0; k < MAT_SIZE; ++k)
+    {
+      sum += (uint64)((int64)Sigma[j][k] * v[k]);
+    }
+    acc[j] = (int64)sum;
+  }
+}
+
+/**************************************************************************//**
+ * normalize_q62
+ *
+ * @brief Static function for the block-floating-point normalization of the
+ * power step: acc is shifted by one exponent for the whole vector so its
+ * largest element has 31 significant bits, then divided by its length.
+ *
+ * @param[out] v Q31 unit vector, left as it is when acc is 0.
+ *
+ * @param[in] acc Array of MAT_SIZE fixed-point values, any common scale.
+ *
+ * @return 1 if v was updated, 0 if acc is 0.
+ *
+ *****************************************************************************/
+
+static uint8 normalize_q62(int32 v[MAT_SIZE], int64 acc[MAT_SIZE])
+{
+  uint8 j = 0;
+  int8 shift = 0;
+  uint64 max_abs = 0, sum = 0;
+  uint32 norm_8 = 0, inv_norm = 0;
+  int32 y[MAT_SIZE];
+  int64 x = 0;
+
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    sum = (acc[j] < 0) ? (uint64)(-acc[j]) : (uint64)acc[j];
+    max_abs = (sum > max_abs) ? sum : max_abs;
+  }
+  if (0 == max_abs)
+  {
+    return 0;
+  }
+
+  // block exponent: largest |y| in [2^30, 2^31)
+  shift = -31;
+  while (max_abs != 0)
+  {
+    max_abs >>= 1;
+    ++shift;
+  }
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    y[j] = (int32)((shift >= 0) ? (acc[j] >> shift) : (acc[j] * ((int64)1 << -shift)));
+  }
+
+  /* |y|^2 / 64 fits in 62 bits, so norm_8 = |y| / 8 with |y| >= 2^30 */
+  sum = 0;
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    sum += (uint64)((int64)y[j] * y[j]) >> 6;
+  }
+  norm_8 = isqrt64(sum);
+  inv_norm = (uint32)(((uint64)1 << 58) / norm_8); /* 2^31 / |y| in Q30 */
+
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    x = ((int64)y[j] * inv_norm) >> 30;
+    v[j] = (x > Q31_MAX) ? Q31_MAX : ((x < -Q31_MAX) ? -Q31_MAX : (int32)x);
+  }
+  return 1;
+}
+
+/**************************************************************************//**
+ * dot_q31
+ *
+ * @brief Public function for the dot product of two Q31 MAT_SIZE-length
+ * arrays, for instance two unit vectors, accumulated in 64 bits.
+ *
+ * @param[in] a One Q31 array of length MAT_SIZE.
+ *
+ * @param[in] b One Q31 array of length MAT_SIZE.
+ *
+ * @return Q31 dot product, saturated to +-1.
+ *
+ *****************************************************************************/
+
+int32 dot_q31(int32 a[MAT_SIZE], int32 b[MAT_SIZE])
+{
+  uint8 i = 0;
+  uint64 c = 0;
+
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    c += (uint64)((int64)a[i] * b[i]);
+  }
+  return q62_to_q31((int64)c);
+}
+
+/**************************************************************************//**
+ * compute_rayleigh_quotient_q31
+ *
+ * @brief Static function for the Rayleigh Quotient v' Sigma v of a Q31 unit
+ * vector.
+ *
+ * @param[in] Sigma 2D Q31 array of dimension MAT_SIZE x MAT_SIZE.
+ *
+ * @param[in] eig_vec Q31 unit vector of length MAT_SIZE.
+ *
+ * @return lambda_l Q31 Rayleigh Quotient.
+ *
+ *****************************************************************************/
+
+static int32 compute_rayleigh_quotient_q31(int32 Sigma[MAT_SIZE][MAT_SIZE],
+  int32 eig_vec[MAT_SIZE])
+{
+  uint8 j = 0;
+  int64 acc[MAT_SIZE];
+  int32 temp_vec[MAT_SIZE];
+
+  multiply_q62(acc, Sigma, eig_vec);
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    temp_vec[j] = q62_to_q31(acc[j]);
+  }
+  return dot_q31(eig_vec, temp_vec);
+}
+
+/**************************************************************************//**
+ * deflation_q31
+ *
+ * @brief Static function for Deflated_Sigma = Sigma - lambda v v'. The two
+ * may be the same array. Only the upper triangle is computed and mirrored,
+ * so the result stays exactly symmetric.
+ *
+ * @param[out] Deflated_Sigma 2D Q31 array that gets updated.
+ *
+ * @param[in] Sigma 2D Q31 array of dimension MAT_SIZE x MAT_SIZE.
+ *
+ * @param[in] eig_vec Q31 unit eigenvector to remove.
+ *
+ * @param[in] lambda Q31 eigenvalue that goes with it.
+ *
+ * @return Nothing, void function.
+ *
+ *****************************************************************************/
+
+static void deflation_q31(int32 Deflated_Sigma[MAT_SIZE][MAT_SIZE],
+  int32 Sigma[MAT_SIZE][MAT_SIZE], int32 eig_vec[MAT_SIZE], int32 lambda)
+{
+  uint8 i = 0, j = 0;
+  int32 lambda_v = 0;
+
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    lambda_v = q62_to_q31((int64)lambda * eig_vec[i]);
+    for (j = i; j < MAT_SIZE; ++j)
+    {
+      Deflated_Sigma[i][j] = Sigma[i][j] - q62_to_q31((int64)lambda_v * eig_vec[j]);
+      Deflated_Sigma[j][i] = Deflated_Sigma[i][j];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * q62_to_q31
+ *
+ * @brief Static function that rounds a Q62 value to Q31, saturated to +-1.
+ *
+ * @param[in] x Q62 value.
+ *
+ * @return Q31 value.
+ *
+ *****************************************************************************/
+
+static int32 q62_to_q31(int64 x)
+{
+  x = (x + ((int64)1 << 30)) >> 31;
+  return (x > Q31_MAX) ? Q31_MAX : ((x < -Q31_MAX) ? -Q31_MAX : (int32)x);
+}
+
+/**************************************************************************//**
+ * isqrt64
+ *
+ * @brief Static function for the integer square root, floor(sqrt(x)), one
+ * result bit per step with shifts and subtractions only.
+ *
+ * @param[in] x Value below 2^64.
+ *
+ * @return floor(sqrt(x)).
+ *
+ *****************************************************************************/
+
+static uint32 isqrt64(uint64 x)
+{
+  uint64 res = 0;
+  uint64 bit = (uint64)1 << 62;
+
+  while (bit > x)
+  {
+    bit >>= 2;
+  }
+  while (bit != 0)
+  {
+    if (x >= res + bit)
+    {
+      x -= res + bit;
+      res = (res >> 1) + bit;
+    }
+    else
+    {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32)res;
+}
+
+/**************************************************************************//**
+ * eig_q31_from_float
+ *
+ * @brief Public function that converts a float matrix to Q31 for
+ * eig_decomp_q31(), scaled by the power of two that brings the largest row
+ * sum of |Sigma| below 1. Float arithmetic, meant for the host or for a
+ * one-off conversion; a covariance accumulated on target in fixed point only
+ * needs the same bound.
+ *
+ * @param[in] Sigma 2D float array of dimension MAT_SIZE x MAT_SIZE.
+ *
+ * @param[out] Sigma_q31 2D Q31 array, Sigma * 2^-exponent.
+ *
+ * @return exponent, for eig_q31_to_float().
+ *
+ *****************************************************************************/
+
+int8 eig_q31_from_float(float Sigma[MAT_SIZE][MAT_SIZE],
+  int32 Sigma_q31[MAT_SIZE][MAT_SIZE])
+{
+  uint8 i = 0, j = 0;
+  int exponent = 0;
+  float row = 0, norm_inf = 0;
+  double x = 0;
+
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    row = 0;
+    for (j = 0; j < MAT_SIZE; ++j)
+    {
+      row += fabsf(Sigma[i][j]);
+    }
+    norm_inf = (row > norm_inf) ? row : norm_inf;
+  }
+  (void)frexpf(norm_inf, &exponent); /* norm_inf < 2^exponent */
+
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    for (j = 0; j < MAT_SIZE; ++j)
+    {
+      x = ldexp((double)Sigma[i][j], 31 - exponent);
+      x = (x > 0) ? x + 0.5 : x - 0.5;
+      Sigma_q31[i][j] = (x >= Q31_MAX) ? Q31_MAX : ((x <= -Q31_MAX) ? -Q31_MAX : (int32)x);
+    }
+  }
+  return (int8)exponent;
+}
+
+/**************************************************************************//**
+ * eig_q31_to_float
+ *
+ * @brief Public function that scales a Q31 result of eig_decomp_q31() back.
+ *
+ * @param[in] x Q31 value, for instance an eigenvalue.
+ *
+ * @param[in] exponent As returned by eig_q31_from_float(), 0 for vectors.
+ *
+ * @return x / 2^31 * 2^exponent.
+ *
+ *****************************************************************************/
+
+float eig_q31_to_float(int32 x, int8 exponent)
+{
+  return ldexpf((float)x, exponent - 31);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,32 @@
+/**************************************************************************//**
+ *
+ * @file   eig_q31.h
+ *
+ * @brief Fixed-point eigen decomposition for the FPU-less Cortex-M3, the Q31
+ * counterpart of eig_decomp() in eig.h.
+ *
+ *****************************************************************************/
+
+
+#ifndef EIG_Q31_H
+    #define EIG_Q31_H
+
+    // eig_q31 includes
+    #include "eig.h"
+
+    // Sigma, Phi and lambda are Q31 (int32, value / 2^31). eig_q31_from_float()
+    // scales Sigma by a power of two so that no row sum of |Sigma| reaches 1,
+    // which keeps every eigenvalue and every product Sigma * v below 1.
+    // Eigenvalues come back on that scale: eig_q31_to_float(lambda[i], exponent).
+    #define Q31_MAX ((int32)0x7FFFFFFF)
+
+    // Function prototypes
+    void eig_decomp_q31(int32 lambda[PRINCIPLE_COMPONENTS], int32 Phi[PRINCIPLE_COMPONENTS][MAT_SIZE], int32 Sigma[MAT_SIZE][MAT_SIZE], int32 Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE], const uint8 p_iter, const uint8 r_iter);
+    int32 dot_q31(int32 a[MAT_SIZE], int32 b[MAT_SIZE]);
+    int8 eig_q31_from_float(float Sigma[MAT_SIZE][MAT_SIZE], int32 Sigma_q31[MAT_SIZE][MAT_SIZE]);
+    float eig_q31_to_float(int32 x, int8 exponent);
+
+#endif
+
+
+/* [] END OF FILE */
@@ -0,0 +1,67 @@
+/**************************************************************************//**
+ *
+ * @file   eig_telemetry.c
+ *
+ * @brief Packs eig_stats into the MESSAGE_FLAG_EIG_STATS payload and queues
+ * it. Kept out of eig.c so the decomposition builds without MessageHandler.
+ *
+ *****************************************************************************/
+
+#include "knobs.h"
+#include "eig_telemetry.h"
+#include "timebase.h"
+
+/**************************************************************************//**
+ * eig_stats_pack
+ *
+ * @brief Public function that lays eig_stats out as the float payload
+ * described in eig_telemetry.h.
+ *
+ * @param[in] stats Stats filled in by eig_decomp_tol().
+ *
+ * @param[out] payload Array of EIG_STATS_FLOATS floats.
+ *
+ * @return Nothing.
+ *
+ *****************************************************************************/
+
+void eig_stats_pack(const eig_stats * stats, float payload[EIG_STATS_FLOATS])
+{
+  uint8 i = 0;
+
+  payload[0] = (float)stats->converged;
+  payload[1] = stats->orthogonality;
+  for (i = 0; i < PRINCIPLE_COMPONENTS; ++i)
+  {
+    payload[2 + 3 * i] = (float)stats->iterations[i];
+    payload[3 + 3 * i] = stats->residual[i];
+    payload[4 + 3 * i] = (float)stats->cycles[i] / (float)TIMEBASE_CYCLES_PER_US;
+  }
+}
+
+/**************************************************************************//**
+ * eig_stats_send
+ *
+ * @brief Public function that queues one MESSAGE_FLAG_EIG_STATS packet and
+ * drains the queue, like the link statistics in flow_control.c. Call it from
+ * the main loop after eig_decomp_tol(), not from an ISR.
+ *
+ * @param[in] stats Stats filled in by eig_decomp_tol().
+ *
+ * @return queuePacket() return code.
+ *
+ *****************************************************************************/
+
+uint8 eig_stats_send(const eig_stats * stats)
+{
+  uint8 result = 0;
+  float payload[EIG_STATS_FLOATS];
+
+  eig_stats_pack(stats, payload);
+  result = queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_EIG_STATS, sizeof(payload), payload);
+  packetQueue_drain();
+
+  return result;
+}
+
+/* [] END OF FILE */
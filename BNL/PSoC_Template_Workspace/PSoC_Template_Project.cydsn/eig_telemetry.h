@@ -0,0 +1,29 @@
+/**************************************************************************//**
+ *
+ * @file   eig_telemetry.h
+ *
+ * @brief eig_stats from eig_decomp_tol() sent to the host as a
+ * MESSAGE_FLAG_EIG_STATS float packet.
+ *
+ *****************************************************************************/
+
+
+#ifndef EIG_TELEMETRY_H
+    #define EIG_TELEMETRY_H
+
+    // eig_telemetry includes
+    #include "eig.h"
+
+    // Payload, all float: converged bit mask, orthogonality, then per principal
+    // component iterations, residual and microseconds (cycles divided by
+    // TIMEBASE_CYCLES_PER_US). reportEigStats() in LOD.py reads the same layout.
+    #define EIG_STATS_FLOATS (2 + 3 * PRINCIPLE_COMPONENTS)
+
+    // Function prototypes
+    void eig_stats_pack(const eig_stats * stats, float payload[EIG_STATS_FLOATS]);
+    uint8 eig_stats_send(const eig_stats * stats);
+
+#endif
+
+
+/* [] END OF FILE */
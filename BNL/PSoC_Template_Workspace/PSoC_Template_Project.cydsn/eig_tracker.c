@@ -0,0 +1,195 @@
+/**************************************************************************//**
+ *
+ * @file   eig_tracker.c
+ *
+ * @brief Online covariance, one packed rank-1 update per sample vector, and
+ * eigenpairs warm-started from the previous estimate by eig_decomp_packed().
+ *
+ *****************************************************************************/
+
+#include "knobs.h"
+#include "eig_tracker.h"
+
+/**************************************************************************//**
+ * eig_tracker_init
+ *
+ * @brief Public function that empties a tracker.
+ *
+ * @param[out] tracker Tracker to set up.
+ *
+ * @param[in] forget Weight of each new sample for exponential forgetting, 0
+ * for a sliding window, see eig_tracker.h.
+ *
+ * @param[in] p_iter Power Iterations per eig_tracker_update(), 1 or 2; with
+ * 0 eig_tracker_update() never updates.
+ *
+ * @param[in] Eig_vecs_init 2D array of initial eigenvector guesses, copied.
+ *
+ * @return Nothing.
+ *
+ *****************************************************************************/
+
+void eig_tracker_init(eig_tracker * tracker, float forget, uint8 p_iter,
+  float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE])
+{
+  uint8 i = 0, j = 0;
+  uint16 n = 0;
+
+  tracker->forget = forget;
+  tracker->p_iter = p_iter;
+  tracker->count = 0;
+  tracker->weight = 1.0f;
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    tracker->mean[j] = 0;
+  }
+  for (n = 0; n < EIG_PACKED_SIZE; ++n)
+  {
+    tracker->Sigma[n] = 0;
+  }
+  for (i = 0; i < PRINCIPLE_COMPONENTS; ++i)
+  {
+    tracker->lambda[i] = 0;
+    for (j = 0; j < MAT_SIZE; ++j)
+    {
+      tracker->Phi[i][j] = Eig_vecs_init[i][j];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * eig_tracker_add
+ *
+ * @brief Public function that adds one sample vector to the covariance, a
+ * single rank-1 update of the packed Sigma (MAT_SIZE * (MAT_SIZE + 1) / 2
+ * multiply-adds).
+ *
+ * Exponential, with a = max(forget, 1 / count) and d = x - mean:
+ *   mean += a d, Sigma = (1 - a) (Sigma + a d d')
+ * Window, the running sums of Welford's method with weight = count:
+ *   mean += d / count, Sigma += (count - 1) / count d d'
+ *
+ * @param[in,out] tracker Tracker.
+ *
+ * @param[in] x Sample vector of length MAT_SIZE.
+ *
+ * @return Nothing.
+ *
+ *****************************************************************************/
+
+void eig_tracker_add(eig_tracker * tracker, const float x[MAT_SIZE])
+{
+  uint8 j = 0;
+  float a = 0;
+  float d[MAT_SIZE];
+
+  ++tracker->count;
+  a = 1.0f / (float)tracker->count;
+  if (tracker->forget > a)
+  {
+    a = tracker->forget;
+  }
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    d[j] = x[j] - tracker->mean[j];
+    tracker->mean[j] += a * d[j];
+  }
+
+  if (tracker->forget > 0)
+  {
+    packed_rank1_update(tracker->Sigma, 1.0f - a, (1.0f - a) * a, d);
+  }
+  else
+  {
+    packed_rank1_update(tracker->Sigma, 1.0f, 1.0f - a, d);
+    tracker->weight = (float)tracker->count;
+  }
+}
+
+/**************************************************************************//**
+ * eig_tracker_remove
+ *
+ * @brief Public function that takes a sample added earlier back out of a
+ * sliding window tracker (forget == 0), the reverse of eig_tracker_add():
+ *   mean -= d / (count - 1), Sigma -= count / (count - 1) d d'
+ * Ignored by exponential trackers, which forget on their own.
+ *
+ * @param[in,out] tracker Tracker.
+ *
+ * @param[in] x Sample vector of length MAT_SIZE leaving the window.
+ *
+ * @return Nothing.
+ *
+ *****************************************************************************/
+
+void eig_tracker_remove(eig_tracker * tracker, const float x[MAT_SIZE])
+{
+  uint8 j = 0;
+  uint16 n = 0;
+  float a = 0;
+  float d[MAT_SIZE];
+
+  if (tracker->forget > 0 || 0 == tracker->count)
+  {
+    return;
+  }
+  if (1 == tracker->count)
+  {
+    /* the window is empty again, no rounding left behind */
+    tracker->count = 0;
+    tracker->weight = 1.0f;
+    for (j = 0; j < MAT_SIZE; ++j)
+    {
+      tracker->mean[j] = 0;
+    }
+    for (n = 0; n < EIG_PACKED_SIZE; ++n)
+    {
+      tracker->Sigma[n] = 0;
+    }
+    return;
+  }
+
+  a = 1.0f / (float)(tracker->count - 1);
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    d[j] = x[j] - tracker->mean[j];
+    tracker->mean[j] -= a * d[j];
+  }
+  packed_rank1_update(tracker->Sigma, 1.0f, -(float)tracker->count * a, d);
+  --tracker->count;
+  tracker->weight = (float)tracker->count;
+}
+
+/**************************************************************************//**
+ * eig_tracker_update
+ *
+ * @brief Public function that refreshes lambda and Phi for the covariance so
+ * far, starting power iteration from the current Phi instead of cold.
+ *
+ * @param[in,out] tracker Tracker.
+ *
+ * @return 1 if updated, 0 while the tracker holds PRINCIPLE_COMPONENTS
+ * samples or fewer and the covariance cannot have that many components, or
+ * if p_iter is 0. No iteration would leave lambda as it was, and scaling it
+ * by the weight again would shrink it on every call.
+ *
+ *****************************************************************************/
+
+uint8 eig_tracker_update(eig_tracker * tracker)
+{
+  uint8 i = 0;
+
+  if (tracker->count <= PRINCIPLE_COMPONENTS || 0 == tracker->p_iter)
+  {
+    return 0;
+  }
+  eig_decomp_packed(tracker->lambda, tracker->Phi, tracker->Sigma, tracker->Phi,
+    tracker->p_iter, 0, &tracker->workspace);
+  for (i = 0; i < PRINCIPLE_COMPONENTS; ++i)
+  {
+    tracker->lambda[i] /= tracker->weight;
+  }
+  return 1;
+}
+
+/* [] END OF FILE */
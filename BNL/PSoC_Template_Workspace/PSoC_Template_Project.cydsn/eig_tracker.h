@@ -0,0 +1,55 @@
+/**************************************************************************//**
+ *
+ * @file   eig_tracker.h
+ *
+ * @brief Streaming covariance of MAT_SIZE channel sample vectors with its
+ * PRINCIPLE_COMPONENTS eigenpairs tracked as the samples arrive.
+ *
+ *****************************************************************************/
+
+
+#ifndef EIG_TRACKER_H
+    #define EIG_TRACKER_H
+
+    // eig_tracker includes
+    #include "eig_packed.h"
+
+    // Two ways to forget old samples, chosen by forget at eig_tracker_init():
+    //
+    //   0 < forget < 1   exponential: each sample has weight forget, older ones
+    //                    decay by (1 - forget) per sample, about 1 / forget
+    //                    samples of memory. Until 1 / forget samples have come
+    //                    in, every sample so far counts equally.
+    //   forget == 0      sliding window (or cumulative): eig_tracker_add() and
+    //                    eig_tracker_remove() with the samples leaving the
+    //                    window, kept by the caller. Removing subtracts in
+    //                    float, so rounding builds up over very long runs.
+    //
+    // eig_tracker_update() runs p_iter power iterations per component from the
+    // previous Phi, so between updates only the drift of the covariance has to
+    // be caught up with. One or two iterations per sample follow a slowly
+    // turning principal axis; the first update starts from Eig_vecs_init.
+
+    typedef struct
+    {
+        float  forget;
+        uint8  p_iter;
+        uint32 count;                           // samples in the estimate (window mode) or seen
+        float  weight;                          // Sigma holds the covariance times weight
+        float  mean[MAT_SIZE];
+        float  Sigma[EIG_PACKED_SIZE];
+        float  lambda[PRINCIPLE_COMPONENTS];    // eigenvalues of the covariance, after eig_tracker_update()
+        float  Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+        eig_workspace workspace;
+    } eig_tracker;
+
+    // Function prototypes
+    void eig_tracker_init(eig_tracker * tracker, float forget, uint8 p_iter, float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE]);
+    void eig_tracker_add(eig_tracker * tracker, const float x[MAT_SIZE]);
+    void eig_tracker_remove(eig_tracker * tracker, const float x[MAT_SIZE]);
+    uint8 eig_tracker_update(eig_tracker * tracker);
+
+#endif
+
+
+/* [] END OF FILE */
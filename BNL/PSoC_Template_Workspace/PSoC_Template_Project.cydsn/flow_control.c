@@ -0,0 +1,121 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "flow_control.h"
+#include "knobs.h"
+#include "SysTimers.h"
+
+#define FLOW_CONTROL_TICKS_PER_MS (SysTimers_TICKS_PER_SECOND / 1000u)
+
+// Credits are granted from the RX parser and taken by whichever context sends
+// a packet, ISRs included, so both sides use atomic read-modify-write.
+static volatile uint32 _credits;
+static volatile uint32 _packetsSent;
+static volatile uint32 _bytesSent;
+static volatile uint32 _throttled;
+static uint16          _statsPeriodMs;
+static uint32          _windowStartTicks;
+
+void flowControl_grant(uint16 credits)
+{
+    uint32 current;
+    uint32 updated;
+
+    do
+    {
+        current = _credits;
+        updated = current + credits;
+        if( updated > FLOW_CONTROL_MAX_CREDITS )
+        {
+            updated = FLOW_CONTROL_MAX_CREDITS;
+        }
+    } while( !__sync_bool_compare_and_swap(&_credits, current, updated) );
+}
+
+uint8 flowControl_takeCredit()
+{
+    //returns 1 if the caller may send without throttling
+#if (ENABLE_FLOW_CONTROL_CREDITS)
+    uint32 current;
+
+    do
+    {
+        current = _credits;
+        if( current == 0 )
+        {
+            __sync_fetch_and_add(&_throttled, 1u);
+            return 0;
+        }
+    } while( !__sync_bool_compare_and_swap(&_credits, current, current - 1u) );
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+uint16 flowControl_getCredits()
+{
+    return (uint16)_credits;
+}
+
+void flowControl_recordSent(uint16 numBytes)
+{
+    //called once per packet that has actually been put on the wire
+    __sync_fetch_and_add(&_packetsSent, 1u);
+    __sync_fetch_and_add(&_bytesSent, numBytes);
+}
+
+void flowControl_setStatsPeriod(uint16 periodMs)
+{
+    _statsPeriodMs    = periodMs;
+    _windowStartTicks = SysTimers_GetSysTickValue();
+    //start the first window clean
+    __sync_fetch_and_and(&_packetsSent, 0u);
+    __sync_fetch_and_and(&_bytesSent, 0u);
+    __sync_fetch_and_and(&_throttled, 0u);
+}
+
+void flowControl_poll()
+{
+    //main loop: sends the link statistics once per report period
+    float  stats[FLOW_CONTROL_STATS_FLOATS];
+    uint32 now;
+    uint32 elapsedTicks;
+    float  elapsedSec;
+
+    if( _statsPeriodMs == 0 )
+    {
+        return;
+    }
+    now = SysTimers_GetSysTickValue();
+    elapsedTicks = now - _windowStartTicks;
+    if( elapsedTicks < (uint32)_statsPeriodMs * FLOW_CONTROL_TICKS_PER_MS )
+    {
+        return;
+    }
+    _windowStartTicks = now;
+
+    elapsedSec = (float)elapsedTicks / (float)SysTimers_TICKS_PER_SECOND;
+    stats[0] = (float)__sync_fetch_and_and(&_packetsSent, 0u) / elapsedSec;
+    stats[1] = (float)__sync_fetch_and_and(&_bytesSent, 0u) / elapsedSec;
+    stats[2] = (float)_credits;
+    stats[3] = (float)__sync_fetch_and_and(&_throttled, 0u);
+    stats[4] = (float)packetQueue_getDropCount();
+    stats[5] = (float)uartTxRing_getUsed();
+    stats[6] = (float)uartTxRing_takeHighWater();
+    stats[7] = (float)uartTxRing_getOverflowCount();
+
+    queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_LINK_STATS, sizeof(stats), stats);
+    packetQueue_drain();
+}
@@ -0,0 +1,41 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef FLOW_CONTROL_H
+    #define FLOW_CONTROL_H
+
+    #include <cytypes.h>
+
+    // Credit based transmit flow control. The host grants credits over RX
+    // (RX_NEXT_IS_CREDIT + uint16), one credit lets one packet go out back to
+    // back. Without credits MessageHandler falls back to the fixed
+    // UART_PACKET_DELAY_MS pacing, so a host that never grants sees the old rate.
+    //
+    // Link statistics: with a report period set (RX_NEXT_IS_LINK_STATS + uint16
+    // period in ms, 0 = off) flowControl_poll() sends a MESSAGE_FLAG_LINK_STATS
+    // float packet: packets/s, bytes/s, credits left, throttled packets, drops,
+    // then the TX ring (uart_tx_ring.h): bytes in it now, its peak since the
+    // last report and the writes that found it full. The ring figures stay 0
+    // unless ENABLE_UART_TX_RING is set.
+
+    #define FLOW_CONTROL_MAX_CREDITS     (uint16)1024 // cap so a confused host cannot wind us up forever
+    #define FLOW_CONTROL_STATS_FLOATS    8
+
+    void   flowControl_grant(uint16 credits);
+    uint8  flowControl_takeCredit();
+    uint16 flowControl_getCredits();
+    void   flowControl_recordSent(uint16 numBytes);
+    void   flowControl_setStatsPeriod(uint16 periodMs);
+    void   flowControl_poll();
+#endif
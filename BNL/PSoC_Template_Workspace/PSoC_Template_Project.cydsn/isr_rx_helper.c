@@ -16,79 +16,370 @@
 //#include <device.h>
 #include "MessageHandler.h"
 #include "isr_rx_helper.h"
-extern uint8 rxbuf[RX_SOFTWARE_BUFFER_LENGTH];
-extern uint8 rxReadIndex;
-extern uint8 rxWriteIndex;
+#include "command_table.h"
+#include "rpc.h"
+#include "UART_1.h"
+
+#include <string.h>
+
+#define RX_RING_MASK (RX_SOFTWARE_BUFFER_LENGTH - 1u)
+
+#if (RX_SOFTWARE_BUFFER_LENGTH & RX_RING_MASK)
+    #error "RX_SOFTWARE_BUFFER_LENGTH must be a power of two"
+#endif
+
+#define RX_COMMAND_MASK (RX_COMMAND_QUEUE_LENGTH - 1u)
+
+#if (RX_COMMAND_QUEUE_LENGTH & RX_COMMAND_MASK)
+    #error "RX_COMMAND_QUEUE_LENGTH must be a power of two"
+#endif
+
+//define private functions here
+static void _copyOut(uint8* data, uint16 start, uint16 numBytes);
+static uint8 _argumentBytes(uint8 command);
+static uint8 _dispatch(packetQueueSlot* response);
+
 extern uint8 rxReadChar; 
 extern float rxReadFloat; 
-uint8 _getBytesAvailable()
+
+static uint8           _rxRing[RX_SOFTWARE_BUFFER_LENGTH];
+static volatile uint16 _rxHead;          // written by the producer only
+static volatile uint16 _rxTail;          // written by the consumer only
+static volatile uint32 _rxOverrunCount;  // bytes dropped because the ring was full, producer only
+static uint32          _rxOverrunBase;   // _rxOverrunCount at the last rxRing_reset(), consumer only
+
+//parser state, main loop only: the command being received and its arguments so far
+static uint8     _frameCommand = RX_NO_PACKETES;
+static uint16    _frameNeeded;
+static uint16    _frameHave;
+static uint16    _frameSkip;     // bytes of an oversized batch frame still to throw away
+static uint8     _frameArguments[RX_COMMAND_MAX_ARGUMENT_BYTES];
+static rxCommand _commands[RX_COMMAND_QUEUE_LENGTH];
+static uint8     _commandRead;
+static uint8     _commandWrite;
+static uint32    _ignoredCount;
+
+uint8 rxRing_put(uint8 value)
+{
+    uint16 head = _rxHead;
+    
+    if( (uint16)(head - _rxTail) >= RX_SOFTWARE_BUFFER_LENGTH )
+    {
+        _rxOverrunCount++;
+        return 0;
+    }
+    _rxRing[head & RX_RING_MASK] = value;
+    __sync_synchronize(); //byte visible before the index that publishes it
+    _rxHead = head + 1u;
+    return 1;
+}
+
+void rxRing_putFromUart()
+{
+    //isr_rx body: moves whatever is in the UART_1 RX FIFO into the ring. Nothing
+    //is queued for transmission per byte, a batch or RPC frame is answered once
+    //by the parser
+    while( UART_1_ReadRxStatus() & UART_1_RX_STS_FIFO_NOTEMPTY )
+    {
+        rxRing_put(UART_1_GetChar()); //dropped and counted when the ring is full, see rxRing_getOverrunCount()
+    }
+}
+
+uint16 rxRing_write(const uint8* data, uint16 numBytes)
+{
+    //bulk put, whatever does not fit is dropped and counted
+    uint16 head   = _rxHead;
+    uint16 room   = RX_SOFTWARE_BUFFER_LENGTH - (uint16)(head - _rxTail);
+    uint16 offset = head & RX_RING_MASK;
+    uint16 first;
+    
+    if( numBytes > room )
+    {
+        _rxOverrunCount += numBytes - room;
+        numBytes = room;
+    }
+    first = RX_SOFTWARE_BUFFER_LENGTH - offset;
+    if( first > numBytes )
+    {
+        first = numBytes;
+    }
+    memcpy(&_rxRing[offset], data, first);
+    memcpy(&_rxRing[0], data + first, numBytes - first);
+    __sync_synchronize();
+    _rxHead = head + numBytes;
+    return numBytes;
+}
+
+uint16 rxRing_getFree()
+{
+    return RX_SOFTWARE_BUFFER_LENGTH - (uint16)(_rxHead - _rxTail);
+}
+
+uint16 rxRing_getAvailable()
+{
+    uint16 available = (uint16)(_rxHead - _rxTail);
+    
+    __sync_synchronize(); //bytes counted here are read after this point
+    return available;
+}
+
+uint16 rxRing_peek(uint8* data, uint16 offset, uint16 numBytes)
+{
+    //copies up to numBytes starting offset bytes into the ring, consumes nothing
+    uint16 available = rxRing_getAvailable();
+    
+    if( offset >= available )
+    {
+        return 0;
+    }
+    if( numBytes > available - offset )
+    {
+        numBytes = available - offset;
+    }
+    _copyOut(data, _rxTail + offset, numBytes);
+    return numBytes;
+}
+
+void rxRing_consume(uint16 numBytes)
+{
+    uint16 available = rxRing_getAvailable();
+    
+    if( numBytes > available )
+    {
+        numBytes = available;
+    }
+    __sync_synchronize(); //done reading before the producer may overwrite
+    _rxTail = _rxTail + numBytes;
+}
+
+uint16 rxRing_read(uint8* data, uint16 numBytes)
+{
+    numBytes = rxRing_peek(data, 0, numBytes);
+    rxRing_consume(numBytes);
+    return numBytes;
+}
+
+void rxRing_reset()
 {
-    uint8 step = 0;
-    uint8 numBytesAvailable = 0; 
-    if( rxReadIndex < rxWriteIndex ) {step = RX_SOFTWARE_BUFFER_LENGTH; }
-    numBytesAvailable = rxWriteIndex + step - rxReadIndex;
-    return numBytesAvailable; 
+    //consumer side: discards what is buffered, the producer may keep going
+    _rxTail = _rxHead;
+    _rxOverrunBase = _rxOverrunCount; //the ISR owns the count, a write here could lose its increment
+}
+
+uint32 rxRing_getOverrunCount()
+{
+    //since the last rxRing_reset(), unsigned difference so the count may wrap
+    return _rxOverrunCount - _rxOverrunBase;
+}
+
+static void _copyOut(uint8* data, uint16 start, uint16 numBytes)
+{
+    //at most two memcpy: up to the end of the buffer, then from the start
+    uint16 offset = start & RX_RING_MASK;
+    uint16 first  = RX_SOFTWARE_BUFFER_LENGTH - offset;
+    
+    if( first > numBytes )
+    {
+        first = numBytes;
+    }
+    memcpy(data, &_rxRing[offset], first);
+    memcpy(data + first, &_rxRing[0], numBytes - first);
 }
 
 void parseRxBuffer()
 {
-    //Determine how many bytes available
-    //uint8 numBytesAvailable = 0;
+    //Kept for the main loop's rxReadChar/handleRx() pattern: parses what has
+    //arrived, then hands out one application command per call
+    rxCommand command;
+    
     rxReadChar = RX_NO_PACKETES; 
     rxReadFloat = 0.0;
+    
+    rxParser_poll();
+    if( rxCommand_pop(&command) )
+    {
+        rxReadChar  = command.value;
+        rxReadFloat = command.argument;
+    }
+}
 
-    if( rxWriteIndex != rxReadIndex )
+uint8 rxParser_poll()
+{
+    //returns the number of application commands queued by this call
+    uint8  byte;
+    uint8  numQueued = 0;
+    uint16 numRead;
+    packetQueueSlot* response;
+    
+    while( (uint8)(_commandWrite - _commandRead) < RX_COMMAND_QUEUE_LENGTH )
     {
-        rxReadIndex++;
-        
-        if( rxbuf[rxReadIndex-1] == RX_NEXT_IS_CHAR )
+        if( _frameSkip > 0 )
+        {
+            numRead = rxRing_getAvailable();
+            numRead = (numRead < _frameSkip) ? numRead : _frameSkip;
+            if( numRead == 0 )
+            {
+                break;
+            }
+            rxRing_consume(numRead);
+            _frameSkip -= numRead;
+            continue;
+        }
+        if( _frameCommand == RX_NO_PACKETES )
+        {
+            if( rxRing_read(&byte, 1) == 0 )
+            {
+                break;
+            }
+            _frameNeeded = _argumentBytes(byte);
+            if( _frameNeeded == 0 )
+            {
+                _ignoredCount++; //not a command byte: skip it and resync on the next one
+                continue;
+            }
+            _frameCommand = byte;
+            _frameHave    = 0;
+            continue;
+        }
+        if( _frameHave < _frameNeeded )
         {
-            rxbuf[rxReadIndex-1] = 0x0;
-            while(_getBytesAvailable() < 1)
+            //arguments come in as one block, a batch frame can be a few hundred bytes
+            numRead = rxRing_read(&_frameArguments[_frameHave], _frameNeeded - _frameHave);
+            if( numRead == 0 )
             {
-                CyDelayUs(10);
-                sendLogMessage("parseRxBuffer() RX_NEXT_IS_CHAR: waiting for _getBytesAvailable() < 1");
+                break;
+            }
+            _frameHave += numRead;
+            if( _frameHave < _frameNeeded )
+            {
+                continue;
+            }
+            if( (_frameCommand == RX_NEXT_IS_BATCH || _frameCommand == RX_NEXT_IS_RPC) && _frameNeeded == 2 )
+            {
+                //length is in, now the frame itself
+                numRead = (uint16)(_frameArguments[0] | ((uint16)_frameArguments[1] << 8));
+                if( numRead > RX_BATCH_MAX_BYTES )
+                {
+                    _ignoredCount++;
+                    _frameSkip    = numRead;
+                    _frameCommand = RX_NO_PACKETES;
+                    continue;
+                }
+                _frameNeeded = 2u + numRead;
+                if( numRead > 0 )
+                {
+                    continue;
+                }
             }
-            rxReadChar = parseChar();
         }
-        else if( rxbuf[rxReadIndex-1] == RX_NEXT_IS_FLAG_AND_FLOAT )
+        if( (_frameCommand == RX_NEXT_IS_BATCH || _frameCommand == RX_NEXT_IS_RPC) && !rpc_canRespond() )
         {
-            rxbuf[rxReadIndex-1] = 0x0;
-            while(_getBytesAvailable() < 5)
+            break; //complete, but it waits here until its answer has a packet queue slot
+        }
+        response = NULL;
+        if( _frameCommand == RX_NEXT_IS_BATCH || _frameCommand == RX_NEXT_IS_RPC )
+        {
+            //an interrupt may have queued into the last slot since the check
+            response = reservePacket((_frameCommand == RX_NEXT_IS_BATCH) ? MESSAGE_TYPE_COMMAND_STATUS : MESSAGE_TYPE_RPC_RESPONSE,
+                                     MESSAGE_FLAG_NO_FLAG);
+            if( response == NULL )
             {
-                CyDelayUs(10);
-                sendLogMessage("parseRxBuffer() RX_NEXT_IS_FLAG_AND_FLOAT: waiting for _getBytesAvailable() < 5");
+                break;
             }
-            rxReadChar  = parseChar();  //increments rxReadIndex by 1
-            rxReadFloat = parseFloat(); //increments rxReadIndex by 4
         }
+        numQueued += _dispatch(response);
+        _frameCommand = RX_NO_PACKETES;
     }
+    return numQueued;
+}
+
+uint8 rxCommand_pop(rxCommand* command)
+{
+    if( _commandRead == _commandWrite )
+    {
+        return 0;
+    }
+    *command = _commands[_commandRead & RX_COMMAND_MASK];
+    _commandRead++;
+    return 1;
+}
+
+uint8 rxCommand_getPending()
+{
+    return (uint8)(_commandWrite - _commandRead);
 }
-uint8 parseChar()
+
+uint32 rxParser_getIgnoredCount()
 {
-    // rxReadIndex Points AT location of char
-    uint8 rxChar;
-    rxChar = rxbuf[rxReadIndex];
-    //rxbuf[rxReadIndex] = 0x0; 
-    rxReadIndex++; 
-    rxReadIndex %= RX_SOFTWARE_BUFFER_LENGTH;
-    return rxChar;
+    return _ignoredCount;
 }
 
-float parseFloat()
+void rxParser_reset()
 {
-    // rxReadIndex Points AT start of float
-    float aFloat; 
-    uint8* dataPtr = (uint8*)&aFloat;
+    //drops a partly received command and everything queued
+    _frameCommand = RX_NO_PACKETES;
+    _frameHave    = 0;
+    _frameSkip    = 0;
+    _commandRead  = _commandWrite;
+    _ignoredCount = 0;
+}
+
+static uint8 _argumentBytes(uint8 command)
+{
+    //bytes following each command byte, 0 for anything that is not a command
+    switch( command )
+    {
+        case RX_NEXT_IS_CHAR:           return 1;
+        case RX_NEXT_IS_FLAG_AND_FLOAT: return 5;
+        case RX_NEXT_IS_CREDIT:         return 2;
+        case RX_NEXT_IS_LINK_STATS:     return 2;
+        case RX_NEXT_IS_LOG_DICTIONARY: return 2;
+        case RX_NEXT_IS_CODEC:          return 1;
+        case RX_NEXT_IS_BATCH:          return 2; //the length, the frame follows
+        case RX_NEXT_IS_RPC:            return 2;
+        default:                        return 0;
+    }
+}
+
+static uint8 _dispatch(packetQueueSlot* response)
+{
+    //complete frame in _frameCommand/_frameArguments, returns 1 if it was queued.
+    //response is the reserved slot for a frame that answers
+    rxCommand* command;
+    uint16 value = (uint16)(_frameArguments[0] | ((uint16)_frameArguments[1] << 8)); //little endian uint16 commands
     
-    uint8 byteCounter = 0; 
-    for(byteCounter = 0; byteCounter < 4; byteCounter++)
+    switch( _frameCommand )
     {
-        *dataPtr++ = rxbuf[rxReadIndex];          //read first byte of float
-        //rxbuf[rxReadIndex] = 0x0; 
-        rxReadIndex++;
-        rxReadIndex %=RX_SOFTWARE_BUFFER_LENGTH;
+        case RX_NEXT_IS_CREDIT:
+            //link level commands, handled here rather than passed up to the application
+            flowControl_grant(value);
+            return 0;
+        case RX_NEXT_IS_LINK_STATS:
+            flowControl_setStatsPeriod(value);
+            return 0;
+        case RX_NEXT_IS_LOG_DICTIONARY:
+            logDeferred_setDictionary(value);
+            return 0;
+        case RX_NEXT_IS_CODEC:
+            payloadCodec_setAccepted(_frameArguments[0]);
+            return 0;
+        case RX_NEXT_IS_BATCH:
+            commandTable_runBatch(response, &_frameArguments[2], value);
+            return 0;
+        case RX_NEXT_IS_RPC:
+            rpc_handleRequest(response, &_frameArguments[2], value);
+            return 0;
+        default:
+            break;
     }
     
-    return aFloat;
-}
\ No newline at end of file
+    command = &_commands[_commandWrite & RX_COMMAND_MASK];
+    command->value    = _frameArguments[0];
+    command->argument = 0.0f;
+    if( _frameCommand == RX_NEXT_IS_FLAG_AND_FLOAT )
+    {
+        memcpy(&command->argument, &_frameArguments[1], 4);
+    }
+    _commandWrite++;
+    return 1;
+}
@@ -16,12 +16,58 @@
 #ifndef ISR_RX_HELPER
     #define ISR_RX_HELPER
     
-    #define RX_SOFTWARE_BUFFER_LENGTH (uint8) 32
     #include <cytypes.h>
     //#include <device.h>
-    uint8 _getBytesAvailable();
-    uint8  parseChar();
-    float parseFloat();
+
+    // Receive ring between isr_rx (single producer) and the main loop parser
+    // (single consumer). Indices are free running and masked on access, each
+    // side only writes its own index, and the barriers order the data against
+    // the index that publishes it, so no critical section is needed.
+    #ifndef RX_SOFTWARE_BUFFER_LENGTH
+        #define RX_SOFTWARE_BUFFER_LENGTH 256u // power of two, at most 32768
+    #endif
+
+    //producer side, isr_rx (or uart_rx_dma.c) only
+    uint8  rxRing_put(uint8 value);
+    void   rxRing_putFromUart();   // the whole isr_rx handler
+    uint16 rxRing_write(const uint8* data, uint16 numBytes);
+    uint16 rxRing_getFree();
+    //consumer side, main loop only
+    uint16 rxRing_getAvailable();
+    uint16 rxRing_peek(uint8* data, uint16 offset, uint16 numBytes);
+    void   rxRing_consume(uint16 numBytes);
+    uint16 rxRing_read(uint8* data, uint16 numBytes);
+    void   rxRing_reset();
+    uint32 rxRing_getOverrunCount();
+
+    // Command parser, main loop only. rxParser_poll() takes whatever bytes are
+    // in the ring, keeps a partly received command between calls and never
+    // waits for the rest. Link level commands (credits, link stats, log
+    // dictionary, codecs), batched command frames (command_table.h) and RPC
+    // requests (rpc.h) take effect at once; RX_NEXT_IS_CHAR and
+    // RX_NEXT_IS_FLAG_AND_FLOAT are queued for the application. When the queue
+    // is full, or a batch or RPC frame has no packet queue slot for its
+    // answer, parsing stops and the bytes wait in the ring. A batch or RPC
+    // frame longer than RX_BATCH_MAX_BYTES is skipped and counted as ignored.
+    #ifndef RX_COMMAND_QUEUE_LENGTH
+        #define RX_COMMAND_QUEUE_LENGTH 8u // power of two, at most 128
+    #endif
+    #ifndef RX_BATCH_MAX_BYTES
+        #define RX_BATCH_MAX_BYTES 250u // longest RX_NEXT_IS_BATCH or RX_NEXT_IS_RPC frame, after the length
+    #endif
+    #define RX_COMMAND_MAX_ARGUMENT_BYTES (2u + RX_BATCH_MAX_BYTES) // RX_NEXT_IS_BATCH/RPC: length + frame
+
+    typedef struct
+    {
+        uint8 value;    // the char, or the flag of RX_NEXT_IS_FLAG_AND_FLOAT
+        float argument; // the float of RX_NEXT_IS_FLAG_AND_FLOAT, else 0
+    } rxCommand;
+
+    uint8  rxParser_poll();
+    uint8  rxCommand_pop(rxCommand* command);
+    uint8  rxCommand_getPending();
+    uint32 rxParser_getIgnoredCount();
+    void   rxParser_reset();
     
     void parseRxBuffer();
 #endif
\ No newline at end of file
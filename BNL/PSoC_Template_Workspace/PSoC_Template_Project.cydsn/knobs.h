@@ -24,5 +24,72 @@
     
     
     #define ENABLE_RATTLESNAKE_COMMUNICATION 1
+
+    // 1: packets go out through the CyDmac transmit engine (uart_tx_dma.c)
+    // 0: packets go out byte by byte through blocking UART_1_PutChar
+    // Requires a DMA channel with its DRQ routed from UART_1 tx_interrupt in TopDesign.
+    #ifndef ENABLE_UART_TX_DMA
+        #define ENABLE_UART_TX_DMA 0
+    #endif
+
+    // 1: packets are copied into the uart_tx_ring.c software ring and leave from
+    //    the TX FIFO interrupt, the main loop only waits when the ring is full
+    // 0: as selected by ENABLE_UART_TX_DMA
+    // Requires an isr on UART_1 tx_interrupt calling uartTxRing_isr() in TopDesign.
+    #ifndef ENABLE_UART_TX_RING
+        #define ENABLE_UART_TX_RING 0
+    #endif
+    #if (ENABLE_UART_TX_DMA && ENABLE_UART_TX_RING)
+        #error "pick one UART transmit backend: ENABLE_UART_TX_DMA or ENABLE_UART_TX_RING"
+    #endif
+
+    // 1: UART_1 RX bytes are moved by CyDmac into the uart_rx_dma.c circular buffer,
+    //    the CPU wakes once per half buffer or when the line goes idle
+    // 0: isr_rx takes an interrupt for every received byte
+    // Requires a DMA channel with its DRQ routed from UART_1 rx_interrupt in TopDesign.
+    #ifndef ENABLE_UART_RX_DMA
+        #define ENABLE_UART_RX_DMA 0
+    #endif
+
+    // 1: packets sent with a host granted credit skip the UART_PACKET_DELAY_MS pacing
+    // 0: every packet is paced, credits from the host are ignored
+    #ifndef ENABLE_FLOW_CONTROL_CREDITS
+        #define ENABLE_FLOW_CONTROL_CREDITS 1
+    #endif
+
+    // CRC in the packet tail: 16 (CRC-16/CCITT-FALSE) or 32 (CRC-32).
+    // Must match PACKET_CRC_BITS in LOD.py.
+    #ifndef PACKET_CRC_BITS
+        #define PACKET_CRC_BITS 16
+    #endif
+    // 1: BINARY_FLOAT and LOG payloads are compressed once the host asks for it
+    //    (RX_NEXT_IS_CODEC, see payload_codec.h)
+    // 0: payloads always go out as they are
+    #ifndef ENABLE_PAYLOAD_CODEC
+        #define ENABLE_PAYLOAD_CODEC 1
+    #endif
+    // Rayleigh quotient iteration in eig.c solves (Sigma - lambda I) x = v with
+    // 1: LU with partial pivoting of W2, factored once per iteration (n^3/3 multiply-adds)
+    // 0: the Gauss-Jordan inverse of W2 into W3, no pivoting (2n^3), then W3 * v
+    #ifndef EIG_RQI_LU_SOLVE
+        #define EIG_RQI_LU_SOLVE 1
+    #endif
+    // eig_decomp() engine:
+    // 1: Householder reduction to tridiagonal form, then implicit-shift QL for
+    //    every eigenpair; bounded work, the initial guesses and iteration counts
+    //    are ignored
+    // 0: power iteration and Rayleigh quotient iteration with deflation
+    #ifndef EIG_TRIDIAGONAL_QL
+        #define EIG_TRIDIAGONAL_QL 0
+    #endif
+    // 1: block (subspace) iteration, Sigma times all PRINCIPLE_COMPONENTS vectors
+    //    in one pass, Gram-Schmidt and a Rayleigh-Ritz projection instead of deflation
+    // 0: as selected by EIG_TRIDIAGONAL_QL
+    #ifndef EIG_SUBSPACE_ITERATION
+        #define EIG_SUBSPACE_ITERATION 0
+    #endif
+    #if (EIG_TRIDIAGONAL_QL && EIG_SUBSPACE_ITERATION)
+        #error "pick one eig_decomp engine: EIG_TRIDIAGONAL_QL or EIG_SUBSPACE_ITERATION"
+    #endif
     //#define NUM_ADC_SAMPLES ((uint16)4096)
 #endif
\ No newline at end of file
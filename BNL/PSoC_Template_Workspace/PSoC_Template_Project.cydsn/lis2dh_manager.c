@@ -73,6 +73,24 @@ void lis2dh_init()
  *
  ******************************************************************************/ 
 void lis2dh_getAccelerationOutputs( float accelerations[3])
+{
+    int16_t raw[3];
+
+    lis2dh_getRawOutputs(raw);
+    accelerations[0] = (float)raw[0];
+    accelerations[1] = (float)raw[1];
+    accelerations[2] = (float)raw[2];
+}
+
+/******************************************************************************
+ *
+ * lis2dh_getRawOutputs
+ *
+ * Same reading as lis2dh_getAccelerationOutputs() as the sensor's own int16,
+ * half the bytes of floats for a SAMPLE_FORMAT_INT16 sampleBatcher
+ *
+ ******************************************************************************/ 
+void lis2dh_getRawOutputs( int16_t raw[3])
 {
     
  /*   while( ! (i2cReadReg( LIS2DH_STATUS_REG) & (0x8)) ) //wait until bit4 (XYZDA) data ready is high
@@ -97,10 +115,10 @@ void lis2dh_getAccelerationOutputs( float accelerations[3])
     mzl = i2cReadReg( (uint8_t)LIS2DH_OUT_Z_L) ;
     mzh = i2cReadReg( (uint8_t)LIS2DH_OUT_Z_H) ;
 
-    // Combine high and low bytes and write into data structure
-    accelerations[0] = (float)(  (int16_t)((mxh <<8) | mxl));
-    accelerations[1] = (float)(  (int16_t)((myh <<8) | myl));
-    accelerations[2] = (float)(  (int16_t)((mzh <<8) | mzl));
+    // Combine high and low bytes
+    raw[0] = (int16_t)((mxh <<8) | mxl);
+    raw[1] = (int16_t)((myh <<8) | myl);
+    raw[2] = (int16_t)((mzh <<8) | mzl);
 }
 
 /******************************************************************************
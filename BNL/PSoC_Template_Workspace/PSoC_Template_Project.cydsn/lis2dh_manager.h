@@ -78,6 +78,7 @@
 
 void lis2dh_init();
 void lis2dh_getAccelerationOutputs(float accelerations[3]) ;
+void lis2dh_getRawOutputs(int16_t raw[3]);
 
 #endif /*#ifndef _LIS2DH_MANAGER_H*/
  
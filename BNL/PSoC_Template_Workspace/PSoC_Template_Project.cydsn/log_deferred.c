@@ -0,0 +1,253 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "log_deferred.h"
+#include "MessageHandler.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LOG_DEFERRED_ID_BYTES 2u
+
+// Bounds of the log_fmt section, provided by the linker. Weak so a build
+// without any LOG_MESSAGE call still links (empty dictionary).
+extern const char __start_log_fmt[] __attribute__((weak));
+extern const char __stop_log_fmt[]  __attribute__((weak));
+
+typedef enum
+{
+    LOG_ARG_INT,        // no length modifier, h, hh
+    LOG_ARG_LONG,
+    LOG_ARG_LONG_LONG,
+    LOG_ARG_SIZE,
+    LOG_ARG_PTRDIFF,
+    LOG_ARG_INTMAX,
+    LOG_ARG_LONG_DOUBLE
+} logArgLength;
+
+//define private functions here
+static uint16 _packArgs(const char* format, va_list args, uint8* out, uint16 numBytes);
+static uint16 _putWord(uint8* out, uint16 numBytes, uint32 value);
+static uint16 _putLongLong(uint8* out, uint16 numBytes, uint64 value);
+
+static volatile uint8 _enabled;
+static uint16         _dictionaryCrc;
+static uint8          _dictionaryCrcValid;
+
+void sendLogDeferred(const char* format, ...)
+{
+    //main loop only; same queueing, pacing and drop behaviour as sendLogMessage(),
+    //only the payload differs
+    packetQueueSlot* slot;
+    uint16  formatId;
+    uint16  numBytes;
+    va_list args;
+
+    va_start(args, format);
+    if( !_enabled )
+    {
+        sendLogMessageV(format, args);
+        va_end(args);
+        return;
+    }
+    slot = reservePacket(MESSAGE_TYPE_LOG_DEFERRED, MESSAGE_FLAG_NO_FLAG);
+    if( slot == NULL )
+    {
+        va_end(args);
+        return;
+    }
+    formatId = (uint16)(format - __start_log_fmt);
+    PACKET_PAYLOAD(slot)[0] = LO8(formatId);
+    PACKET_PAYLOAD(slot)[1] = HI8(formatId);
+    numBytes = _packArgs(format, args, PACKET_PAYLOAD(slot), LOG_DEFERRED_ID_BYTES);
+    va_end(args);
+    sendReservedPacket(slot, numBytes);
+}
+
+uint8 logDeferred_setDictionary(uint16 dictionaryCrc)
+{
+    //called from the RX parser; 0 (or a dictionary from another build) means ASCII logs
+    uint16 firmwareCrc = logDeferred_getDictionaryCrc();
+
+    _enabled = (dictionaryCrc != 0) && (dictionaryCrc == firmwareCrc);
+    if( dictionaryCrc != 0 && !_enabled )
+    {
+        sendLogMessage("log dictionary CRC 0x%04X does not match firmware 0x%04X, sending ASCII logs",
+                       dictionaryCrc, firmwareCrc);
+    }
+    return _enabled;
+}
+
+uint8 logDeferred_isEnabled()
+{
+    return _enabled;
+}
+
+uint16 logDeferred_getDictionaryCrc()
+{
+    //CRC-16/CCITT-FALSE over the whole log_fmt section, what log_dictionary.py computes from the .elf
+    const uint8* sectionPtr = (const uint8*) __start_log_fmt;
+    uint32 remaining = (uint32)(__stop_log_fmt - __start_log_fmt);
+    uint16 crc = CRC16_INIT;
+    uint16 chunk;
+
+    if( !_dictionaryCrcValid )
+    {
+        while( remaining > 0 )
+        {
+            chunk = (remaining > 0x8000u) ? 0x8000u : (uint16)remaining;
+            crc = crc16_update(crc, sectionPtr, chunk);
+            sectionPtr += chunk;
+            remaining  -= chunk;
+        }
+        _dictionaryCrc      = crc;
+        _dictionaryCrcValid = 1;
+    }
+    return _dictionaryCrc;
+}
+
+static uint16 _packArgs(const char* format, va_list args, uint8* out, uint16 numBytes)
+{
+    //Walks the conversion specifications just far enough to know each argument's
+    //type. Stops at the first argument that does not fit, or at a conversion it
+    //does not know (its size, and so everything after it, is unknown).
+    const char*  p = format;
+    const char*  string;
+    logArgLength length;
+    uint16 stringBytes;
+    uint32 word;
+    uint64 longWord;
+    float  aFloat;
+
+    while( *p != '\0' )
+    {
+        if( *p++ != '%' )
+        {
+            continue;
+        }
+        while( *p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' )
+        {
+            p++;
+        }
+        //width and precision, '*' takes an int argument
+        if( *p == '*' )
+        {
+            if( numBytes + 4u > PACKET_MAX_PAYLOAD_BYTES ) { break; }
+            numBytes = _putWord(out, numBytes, (uint32)va_arg(args, int));
+            p++;
+        }
+        while( *p >= '0' && *p <= '9' ) { p++; }
+        if( *p == '.' )
+        {
+            p++;
+            if( *p == '*' )
+            {
+                if( numBytes + 4u > PACKET_MAX_PAYLOAD_BYTES ) { break; }
+                numBytes = _putWord(out, numBytes, (uint32)va_arg(args, int));
+                p++;
+            }
+            while( *p >= '0' && *p <= '9' ) { p++; }
+        }
+
+        length = LOG_ARG_INT;
+        switch( *p )
+        {
+            case 'h': p++; if( *p == 'h' ) { p++; } break;
+            case 'l': p++; length = LOG_ARG_LONG; if( *p == 'l' ) { p++; length = LOG_ARG_LONG_LONG; } break;
+            case 'z': p++; length = LOG_ARG_SIZE;        break;
+            case 't': p++; length = LOG_ARG_PTRDIFF;     break;
+            case 'j': p++; length = LOG_ARG_INTMAX;      break;
+            case 'L': p++; length = LOG_ARG_LONG_DOUBLE; break;
+            default: break;
+        }
+
+        switch( *p )
+        {
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+                if( length == LOG_ARG_LONG_LONG || length == LOG_ARG_INTMAX )
+                {
+                    if( numBytes + 8u > PACKET_MAX_PAYLOAD_BYTES ) { return numBytes; }
+                    longWord = (length == LOG_ARG_INTMAX) ? (uint64)va_arg(args, intmax_t) : (uint64)va_arg(args, long long);
+                    numBytes = _putLongLong(out, numBytes, longWord);
+                    break;
+                }
+                if( numBytes + 4u > PACKET_MAX_PAYLOAD_BYTES ) { return numBytes; }
+                switch( length )
+                {
+                    case LOG_ARG_LONG:    word = (uint32)va_arg(args, long);      break;
+                    case LOG_ARG_SIZE:    word = (uint32)va_arg(args, size_t);    break;
+                    case LOG_ARG_PTRDIFF: word = (uint32)va_arg(args, ptrdiff_t); break;
+                    default:              word = (uint32)va_arg(args, int);       break;
+                }
+                numBytes = _putWord(out, numBytes, word);
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                if( numBytes + 4u > PACKET_MAX_PAYLOAD_BYTES ) { return numBytes; }
+                aFloat = (length == LOG_ARG_LONG_DOUBLE) ? (float)va_arg(args, long double) : (float)va_arg(args, double);
+                memcpy(&word, &aFloat, sizeof(word));
+                numBytes = _putWord(out, numBytes, word);
+                break;
+            case 'c':
+                if( numBytes + 1u > PACKET_MAX_PAYLOAD_BYTES ) { return numBytes; }
+                out[numBytes++] = (uint8)va_arg(args, int);
+                break;
+            case 's':
+                string = va_arg(args, const char*);
+                if( string == NULL )
+                {
+                    string = "(null)";
+                }
+                if( numBytes + 1u > PACKET_MAX_PAYLOAD_BYTES ) { return numBytes; }
+                stringBytes = 0;
+                while( string[stringBytes] != '\0' && numBytes + stringBytes + 1u < PACKET_MAX_PAYLOAD_BYTES )
+                {
+                    stringBytes++;
+                }
+                memcpy(&out[numBytes], string, stringBytes);
+                numBytes += stringBytes;
+                out[numBytes++] = 0; //truncated strings are still terminated
+                break;
+            case 'p':
+                if( numBytes + 4u > PACKET_MAX_PAYLOAD_BYTES ) { return numBytes; }
+                numBytes = _putWord(out, numBytes, (uint32)(uintptr_t)va_arg(args, void*));
+                break;
+            case 'n':
+                (void)va_arg(args, void*); //nothing is written back, the host does the formatting
+                break;
+            case '%':
+                break;
+            default:
+                return numBytes;
+        }
+        p++;
+    }
+    return numBytes;
+}
+
+static uint16 _putWord(uint8* out, uint16 numBytes, uint32 value)
+{
+    out[numBytes++] = (uint8)(value);
+    out[numBytes++] = (uint8)(value >> 8);
+    out[numBytes++] = (uint8)(value >> 16);
+    out[numBytes++] = (uint8)(value >> 24);
+    return numBytes;
+}
+
+static uint16 _putLongLong(uint8* out, uint16 numBytes, uint64 value)
+{
+    numBytes = _putWord(out, numBytes, (uint32)value);
+    return _putWord(out, numBytes, (uint32)(value >> 32));
+}
@@ -0,0 +1,56 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef LOG_DEFERRED_H
+    #define LOG_DEFERRED_H
+
+    #include <cytypes.h>
+
+    // Deferred (binary) logging.
+    //
+    // LOG_MESSAGE(format, ...) keeps its format string in the log_fmt section
+    // and the string's offset in that section is its ID. Once the host has the
+    // matching dictionary (log_dictionary.py extracts the section from the .elf,
+    // LOD.py sends RX_NEXT_IS_LOG_DICTIONARY + the section's CRC-16) a call
+    // sends MESSAGE_TYPE_LOG_DEFERRED: uint16 ID followed by the raw arguments,
+    // with no vsnprintf on target. Until then, or if the CRC does not match this
+    // build, it falls back to sendLogMessage() and the host gets ASCII LOG packets.
+    //
+    // format must be a string literal. Arguments are packed little endian in
+    // format order; log_dictionary.py walks the format the same way:
+    //   d i u o x X p, '*' width/precision  4 bytes (hh h l z t are 32 bit on the M3)
+    //   ll j                                8 bytes
+    //   f F e E g G a A                     4 byte float
+    //   c                                   1 byte
+    //   s                                   the string and its terminating 0
+    //   %% n                                nothing
+    // Arguments that do not fit in one packet are left off, the host shows them
+    // as missing.
+    //
+    // Main loop only, like sendLogMessage(): both pace the link and may block.
+
+    #define LOG_DEFERRED_SECTION "log_fmt"
+
+    #define LOG_MESSAGE(format, ...)                                                            \
+        do                                                                                      \
+        {                                                                                       \
+            static const char _logFormat[] __attribute__((section(LOG_DEFERRED_SECTION), used)) = format; \
+            sendLogDeferred(_logFormat, ##__VA_ARGS__);                                         \
+        } while(0)
+
+    void   sendLogDeferred(const char* format, ...);
+    uint8  logDeferred_setDictionary(uint16 dictionaryCrc);
+    uint8  logDeferred_isEnabled();
+    uint16 logDeferred_getDictionaryCrc();
+#endif
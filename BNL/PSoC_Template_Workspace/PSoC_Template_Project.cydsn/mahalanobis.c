@@ -0,0 +1,191 @@
+/**************************************************************************//**
+ *
+ * @file   mahalanobis.c
+ *
+ * @brief Online covariance and its inverse, one Sherman-Morrison update per
+ * sample vector, for Mahalanobis distance anomaly scores.
+ *
+ *****************************************************************************/
+
+#include "knobs.h"
+#include "mahalanobis.h"
+
+/**************************************************************************//**
+ * mahalanobis_init
+ *
+ * @brief Public function that empties a tracker.
+ *
+ * @param[out] tracker Tracker to set up.
+ *
+ * @param[in] forget Weight of each new sample for exponential forgetting,
+ * below 1, or 0 to weigh all samples equally, see mahalanobis.h.
+ *
+ * @param[in] ridge Prior variance of every channel, greater than 0.
+ *
+ * @param[in] refactor_period Samples between full inversions, 0 for never.
+ *
+ * @return Nothing.
+ *
+ *****************************************************************************/
+
+void mahalanobis_init(mahalanobis_tracker * tracker, float forget, float ridge,
+  uint16 refactor_period)
+{
+  uint8 i = 0, j = 0;
+  uint16 n = 0;
+
+  tracker->forget = forget;
+  tracker->refactor_period = refactor_period;
+  tracker->since_refactor = 0;
+  tracker->count = 0;
+  tracker->weight = 1.0f;
+  for (i = 0; i < MAT_SIZE; ++i)
+  {
+    tracker->mean[i] = 0;
+    for (j = i; j < MAT_SIZE; ++j, ++n)
+    {
+      tracker->Sigma[n] = (i == j) ? ridge : 0;
+      tracker->Sigma_inv[n] = (i == j) ? 1.0f / ridge : 0;
+    }
+  }
+}
+
+/**************************************************************************//**
+ * mahalanobis_add
+ *
+ * @brief Public function that scores a sample vector against the covariance
+ * so far, then adds it. With d = x - mean and a = max(forget, 1 / count):
+ *
+ *   Sigma = beta (Sigma + alpha d d'), beta = 1 - a, alpha = a (exponential)
+ *                                      beta = 1, alpha = 1 - a (forget == 0)
+ *
+ * and by Sherman-Morrison, with u = Sigma_inv d:
+ *
+ *   Sigma_inv = (Sigma_inv - alpha u u' / (1 + alpha d' u)) / beta
+ *
+ * d' u is the score as well, so scoring is free. Every refactor_period
+ * samples, or if rounding has left 1 + alpha d' u not positive, Sigma_inv is
+ * recomputed by mahalanobis_refactor() instead.
+ *
+ * @param[in,out] tracker Tracker.
+ *
+ * @param[in] x Sample vector of length MAT_SIZE.
+ *
+ * @return Squared Mahalanobis distance of x before it was added, 0 for the
+ * first sample, which has no mean to be compared with.
+ *
+ *****************************************************************************/
+
+float mahalanobis_add(mahalanobis_tracker * tracker, const float x[MAT_SIZE])
+{
+  uint8 j = 0;
+  float a = 0, alpha = 0, beta = 0, s = 0, denominator = 0, score = 0;
+  float d[MAT_SIZE];
+  float u[MAT_SIZE];
+
+  ++tracker->count;
+  if (1 == tracker->count)
+  {
+    /* Sigma stays the prior, nothing to spread yet */
+    for (j = 0; j < MAT_SIZE; ++j)
+    {
+      tracker->mean[j] = x[j];
+    }
+    return 0;
+  }
+
+  a = 1.0f / (float)tracker->count;
+  if (tracker->forget > a)
+  {
+    a = tracker->forget;
+  }
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    d[j] = x[j] - tracker->mean[j];
+    tracker->mean[j] += a * d[j];
+  }
+  packed_matvec(tracker->Sigma_inv, d, u);
+  s = dot(d, u);
+  score = tracker->weight * s;
+
+  if (tracker->forget > 0)
+  {
+    beta = 1.0f - a;
+    alpha = a;
+  }
+  else
+  {
+    beta = 1.0f;
+    alpha = 1.0f - a;
+    tracker->weight = (float)tracker->count;
+  }
+  packed_rank1_update(tracker->Sigma, beta, beta * alpha, d);
+
+  denominator = 1.0f + alpha * s;
+  ++tracker->since_refactor;
+  if (!(denominator > 0) ||
+    (tracker->refactor_period > 0 && tracker->since_refactor >= tracker->refactor_period))
+  {
+    (void)mahalanobis_refactor(tracker);
+  }
+  else
+  {
+    packed_rank1_update(tracker->Sigma_inv, 1.0f / beta, -alpha / (beta * denominator), u);
+  }
+  return score;
+}
+
+/**************************************************************************//**
+ * mahalanobis_score
+ *
+ * @brief Public function for the squared Mahalanobis distance of a sample
+ * vector from the current estimate, without adding it. MAT_SIZE^2 / 2
+ * multiply-adds.
+ *
+ * @param[in] tracker Tracker.
+ *
+ * @param[in] x Sample vector of length MAT_SIZE.
+ *
+ * @return d' C^-1 d, with d = x - mean and C the covariance, 0 while the
+ * tracker is empty.
+ *
+ *****************************************************************************/
+
+float mahalanobis_score(const mahalanobis_tracker * tracker, const float x[MAT_SIZE])
+{
+  uint8 j = 0;
+  float d[MAT_SIZE];
+
+  if (0 == tracker->count)
+  {
+    return 0;
+  }
+  for (j = 0; j < MAT_SIZE; ++j)
+  {
+    d[j] = x[j] - tracker->mean[j];
+  }
+  return tracker->weight * packed_rayleigh_quotient(tracker->Sigma_inv, d);
+}
+
+/**************************************************************************//**
+ * mahalanobis_refactor
+ *
+ * @brief Public function that recomputes Sigma_inv from Sigma, dropping the
+ * rounding the rank-1 updates have built up. Called by mahalanobis_add()
+ * every refactor_period samples; about MAT_SIZE^3 / 2 multiply-adds, so a
+ * caller short of time in the sample path can set refactor_period to 0 and
+ * call this from the main loop instead.
+ *
+ * @param[in,out] tracker Tracker.
+ *
+ * @return 1 if Sigma was singular to working precision, 0 otherwise.
+ *
+ *****************************************************************************/
+
+uint8 mahalanobis_refactor(mahalanobis_tracker * tracker)
+{
+  tracker->since_refactor = 0;
+  return packed_invert(tracker->Sigma, tracker->Sigma_inv, tracker->factor);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,62 @@
+/**************************************************************************//**
+ *
+ * @file   mahalanobis.h
+ *
+ * @brief Streaming inverse covariance of MAT_SIZE channel sample vectors,
+ * kept up to date by Sherman-Morrison rank-1 updates, and the Mahalanobis
+ * distance of each new sample from it as an anomaly score.
+ *
+ *****************************************************************************/
+
+
+#ifndef MAHALANOBIS_H
+    #define MAHALANOBIS_H
+
+    // mahalanobis includes
+    #include "eig_packed.h"
+
+    // Sigma follows the samples as in eig_tracker.h: forget between 0 and 1
+    // for exponential forgetting, equal weights until 1 / forget samples are
+    // in, or forget == 0 for the covariance of every sample so far. There is
+    // no sliding window: a removed sample is a downdate that can lose
+    // definiteness.
+    //
+    // Sigma starts as ridge * I so it can be inverted before MAT_SIZE samples
+    // are in. The prior fades like the weight of a single sample, down to
+    // ridge / count while the weights are equal and then by (1 - forget) per
+    // sample. Pick ridge around the noise variance of one channel.
+    //
+    // Each sample costs O(MAT_SIZE^2): a packed matrix-vector product and two
+    // rank-1 updates, where inverting from scratch is O(MAT_SIZE^3). Rounding
+    // in the updates builds up, so every refactor_period samples
+    // Sigma_inv is recomputed from Sigma by packed_invert().
+    //
+    // The score of a sample is d' C^-1 d, d the distance from the mean and C
+    // the covariance before the sample is added, so a sample never hides
+    // itself. For Gaussian samples it averages MAT_SIZE (chi-squared with
+    // MAT_SIZE degrees of freedom); a quench precursor shows as scores far
+    // above that.
+
+    typedef struct
+    {
+        float  forget;
+        uint16 refactor_period;                 // samples between full inversions, 0 for never
+        uint16 since_refactor;
+        uint32 count;                           // samples seen
+        float  weight;                          // Sigma holds the covariance times weight
+        float  mean[MAT_SIZE];
+        float  Sigma[EIG_PACKED_SIZE];
+        float  Sigma_inv[EIG_PACKED_SIZE];
+        float  factor[EIG_PACKED_SIZE];         // packed_invert() scratch
+    } mahalanobis_tracker;
+
+    // Function prototypes
+    void mahalanobis_init(mahalanobis_tracker * tracker, float forget, float ridge, uint16 refactor_period);
+    float mahalanobis_add(mahalanobis_tracker * tracker, const float x[MAT_SIZE]);
+    float mahalanobis_score(const mahalanobis_tracker * tracker, const float x[MAT_SIZE]);
+    uint8 mahalanobis_refactor(mahalanobis_tracker * tracker);
+
+#endif
+
+
+/* [] END OF FILE */
@@ -18,12 +18,12 @@ FTDI Cable Black  (USB/UART RX) Ground
 
 #include "MessageHandler.h"
 #include "isr_rx_helper.h"
+#include "uart_rx_dma.h"
+#include "command_table.h"
+#include "rpc.h"
 void init();
 uint32 SysTicksMS;
 
-uint8 rxbuf[RX_SOFTWARE_BUFFER_LENGTH];
-uint8 rxReadIndex  = 0;
-uint8 rxWriteIndex = 0;
 uint8 rxReadChar = RX_NO_PACKETES; 
 float rxReadFloat = 0.0; 
 void handleRx();
@@ -37,7 +37,8 @@ int main()
     uint32 counter = 0;
     while(1)
     {
-        if(rxReadIndex != rxWriteIndex)
+        uartRxDma_poll();    // ENABLE_UART_RX_DMA: hands over a finished burst
+        if(rxRing_getAvailable() > 0)
         {
             parseRxBuffer();
             while( rxReadChar != RX_NO_PACKETES )
@@ -46,9 +47,11 @@ int main()
                 parseRxBuffer();
             }
         }
+        flowControl_poll();  // link statistics, if the host asked for them
+        packetQueue_drain(); // packets queued from interrupts
         CyDelay(100);
         counter++;
-        sendLogMessage("Hello World: %i", counter); 
+        LOG_MESSAGE("Hello World: %i", counter); 
     }
     */
 }
@@ -108,9 +111,17 @@ void init()
     ADC_StartConvert();     // Start conversion    
 
 
+#if (ENABLE_UART_RX_DMA)
+    //uartRxDma_init(); isr_rx_dma_StartEx(uartRxDma_isr);
+#else
     //isr_rx_Start();
+#endif
 	//UART_1_Start();     //enable uart
+    //uartTxRing_init(); isr_tx_StartEx(uartTxRing_isr); //ENABLE_UART_TX_RING, after UART_1_Start()
+    //commandTable_register(RX_FLAG_SET_MODE_1, setMode); //one handler per flag for RX_NEXT_IS_BATCH frames
+    //rpc_register(RPC_METHOD_GET_PGA, getPgaSettings); //RX_NEXT_IS_RPC methods, answered with the request id
     
    // SysTimers_Start();
+   // timebase_init();   // after SysTimers_Start(): packet timestamps
  }
 */
\ No newline at end of file
@@ -0,0 +1,303 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "packet_queue.h"
+#include "knobs.h"
+#include "UART_1.h"
+#include "uart_tx_ring.h"
+#include "CyLib.h"
+
+#define PACKET_QUEUE_MASK    (PACKET_QUEUE_NUM_SLOTS - 1u)
+#define PACKET_QUEUE_POLL_US 10 // spin granularity of packetQueue_flush()
+
+#if (PACKET_QUEUE_NUM_SLOTS & PACKET_QUEUE_MASK)
+    #error "PACKET_QUEUE_NUM_SLOTS must be a power of two"
+#endif
+
+// Each slot carries a sequence number telling whose turn it is (Vyukov bounded
+// queue). It is stored relative to the slot index, so the zero-initialised
+// array starts out with every slot free and no init call is needed before the
+// first ISR can produce:
+//   sequence + index == pos      free, may be reserved for write position pos
+//   sequence + index == pos + 1  committed, ready for read position pos
+// Positions are free running and compared by signed difference, so wrap is fine.
+
+//define private functions here
+static packetQueueSlot* _nextReady();
+static void _release();
+static uint8 _canSend(const packetQueueSlot* slot);
+static void _drainLocked();
+#if (ENABLE_UART_TX_DMA)
+    static void _onSlotSent(void* context);
+#endif
+
+static packetQueueSlot  _slots[PACKET_QUEUE_NUM_SLOTS];
+static volatile uint32  _writePos;
+static volatile uint32  _readPos;
+static volatile uint32  _draining;      // try-lock making drain single consumer
+static volatile uint8   _inFlight;      // head slot handed to the DMA engine
+static volatile uint8   _held;          // a direct packet is about to take the transmitter
+static volatile uint32  _dropCount;
+static volatile uint32  _highWater;
+
+packetQueueSlot* packetQueue_reserve()
+{
+    packetQueueSlot* slot;
+    uint32 pos;
+    uint32 occupancy;
+    uint32 highWater;
+    int32  diff;
+
+    for(;;)
+    {
+        pos  = _writePos;
+        slot = &_slots[pos & PACKET_QUEUE_MASK];
+        diff = (int32)(slot->sequence + (pos & PACKET_QUEUE_MASK) - pos);
+        if( diff == 0 )
+        {
+            if( __sync_bool_compare_and_swap(&_writePos, pos, pos + 1u) )
+            {
+                break;
+            }
+        }
+        else if( diff < 0 )
+        {
+            //slot still holds a packet from the previous lap: queue is full
+            __sync_fetch_and_add(&_dropCount, 1u);
+            return NULL;
+        }
+        //else a preempting producer took pos first, retry with the next one
+    }
+
+    occupancy = pos + 1u - _readPos;
+    highWater = _highWater;
+    while( occupancy > highWater && !__sync_bool_compare_and_swap(&_highWater, highWater, occupancy) )
+    {
+        highWater = _highWater;
+    }
+
+    slot->numBytes = 0;
+    return slot;
+}
+
+void packetQueue_commit(packetQueueSlot* slot)
+{
+    __sync_synchronize(); //slot contents must be visible before the consumer (or DMA) sees it
+    slot->sequence = slot->sequence + 1u;
+}
+
+void packetQueue_drain()
+{
+    packetQueueSlot* slot;
+
+    //Whoever holds _draining sends everything that is committed. A context that
+    //finds it taken returns at once; the holder re-checks after unlocking so a
+    //packet committed in that window is not left behind.
+    do
+    {
+        if( !__sync_bool_compare_and_swap(&_draining, 0u, 1u) )
+        {
+            return;
+        }
+        _drainLocked();
+        __sync_synchronize();
+        _draining = 0;
+    } while( (slot = _nextReady()) != NULL && _canSend(slot) );
+}
+
+void packetQueue_flush()
+{
+    //main loop only: spins until every committed packet is on the wire (or,
+    //with ENABLE_UART_TX_RING, in the TX ring)
+    while( !packetQueue_isIdle() )
+    {
+        packetQueue_drain();
+        if( !packetQueue_isIdle() )
+        {
+            CyDelayUs(PACKET_QUEUE_POLL_US);
+        }
+    }
+}
+
+void packetQueue_hold(uint8 hold)
+{
+    //Main loop: while held nothing new is started, so a direct packet can wait
+    //for the transmitter without a drain from an ISR taking it first. The
+    //packets committed meanwhile go out on the next drain after the release
+    _held = hold;
+}
+
+uint8 packetQueue_isIdle()
+{
+    return (_readPos == _writePos) && !_inFlight;
+}
+
+uint8 packetQueue_getPending()
+{
+    return (uint8)(_writePos - _readPos);
+}
+
+uint32 packetQueue_getDropCount()
+{
+    return _dropCount;
+}
+
+uint8 packetQueue_getHighWater()
+{
+    return (uint8)_highWater;
+}
+
+void packetQueue_resetStats()
+{
+    _dropCount = 0;
+    _highWater = 0;
+}
+
+static packetQueueSlot* _nextReady()
+{
+    uint32 pos = _readPos;
+    packetQueueSlot* slot = &_slots[pos & PACKET_QUEUE_MASK];
+
+    if( (uint32)(slot->sequence + (pos & PACKET_QUEUE_MASK)) != pos + 1u )
+    {
+        return NULL; //empty, or the producer of the oldest slot has not committed yet
+    }
+    return slot;
+}
+
+static void _release()
+{
+    //hand the head slot back to producers for the next lap
+    uint32 pos = _readPos;
+    packetQueueSlot* slot = &_slots[pos & PACKET_QUEUE_MASK];
+
+    _readPos = pos + 1u;
+    __sync_synchronize();
+    slot->sequence = slot->sequence + PACKET_QUEUE_NUM_SLOTS - 1u;
+}
+
+static uint8 _canSend(const packetQueueSlot* slot)
+{
+    //whether the transmit backend takes the head slot right now. When it does
+    //not, whoever makes room drains again: _onSlotSent() for DMA, and
+    //uartTxRing_isr() once the ring is empty
+    if( _held )
+    {
+        return 0;
+    }
+#if (ENABLE_UART_TX_DMA)
+    //a direct transfer (constructAndSendPacketAsync) may own the engine, its
+    //_onDirectSent() drains again
+    (void)slot;
+    return !_inFlight && !uartTxDma_isBusy();
+#elif (ENABLE_UART_TX_RING)
+    //a packet bigger than the ring may be going in piece by piece, its
+    //uartTxRing_writeBlocking() drains again once the last piece is in
+    return !uartTxRing_isStreaming() && uartTxRing_getFree() >= slot->numBytes;
+#else
+    (void)slot;
+    return 1;
+#endif
+}
+
+static void _drainLocked()
+{
+    packetQueueSlot* slot;
+#if (ENABLE_UART_TX_DMA)
+    uartTxDmaSegment segment;
+    uint8 interruptState;
+    uint16 byteCounter;
+#elif (ENABLE_UART_TX_RING)
+    uint8 status;
+#else
+    uint16 byteCounter;
+#endif
+
+    while( (slot = _nextReady()) != NULL && _canSend(slot) )
+    {
+        if( slot->numBytes == 0 )
+        {
+            _release();
+            continue;
+        }
+#if (ENABLE_UART_TX_DMA)
+        if( uartTxDma_getChannel() == CY_DMA_INVALID_CHANNEL )
+        {
+            //uartTxDma_init() not called (yet): send byte by byte like the blocking build
+            finishPacket(slot);
+            for(byteCounter = 0; byteCounter < slot->numBytes; byteCounter++)
+            {
+                UART_1_PutChar( slot->data[byteCounter] );
+            }
+            flowControl_recordSent(slot->numBytes);
+            _release();
+            continue;
+        }
+        //one slot at a time, _onSlotSent releases it and starts the next one.
+        //The sequence number is only taken once the engine is known to be
+        //free: with interrupts off nothing can start a direct transfer between
+        //the check and the send, so the send cannot be refused
+        segment.data     = slot->data;
+        segment.numBytes = slot->numBytes;
+        interruptState = CyEnterCriticalSection();
+        if( !uartTxDma_isBusy() )
+        {
+            finishPacket(slot);
+            _inFlight = 1; //before the send, _onSlotSent() may run from inside it
+            if( uartTxDma_send(&segment, 1, _onSlotSent, NULL) != UART_TX_DMA_OK )
+            {
+                _inFlight = 0;
+            }
+        }
+        CyExitCriticalSection(interruptState);
+        break;
+#elif (ENABLE_UART_TX_RING)
+        //_canSend() found room and only the TX interrupt changes it, so the write
+        //cannot fail once finishPacket() has taken a sequence number
+        finishPacket(slot);
+        status = uartTxRing_write(slot->data, slot->numBytes);
+        if( status != UART_TX_RING_OK )
+        {
+            break;
+        }
+        flowControl_recordSent(slot->numBytes);
+        _release();
+#else
+        finishPacket(slot);
+        for(byteCounter = 0; byteCounter < slot->numBytes; byteCounter++)
+        {
+            UART_1_PutChar( slot->data[byteCounter] );
+        }
+        flowControl_recordSent(slot->numBytes);
+        _release();
+#endif
+    }
+#if (ENABLE_UART_TX_RING)
+    if( slot != NULL )
+    {
+        uartTxRing_countOverflow(); //head slot waits for the TX interrupt to make room
+    }
+#endif
+}
+
+#if (ENABLE_UART_TX_DMA)
+static void _onSlotSent(void* context)
+{
+    (void)context;
+    flowControl_recordSent(_slots[_readPos & PACKET_QUEUE_MASK].numBytes);
+    _release();
+    _inFlight = 0;
+    packetQueue_drain();
+}
+#endif
@@ -0,0 +1,66 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef PACKET_QUEUE_H
+    #define PACKET_QUEUE_H
+
+    #include <cytypes.h>
+
+    // Fixed-capacity packet queue shared by the main loop and interrupts.
+    //
+    // Producers (any context, including ISRs) call packetQueue_reserve(), write
+    // the complete wire image of their packet into slot->data and hand it over
+    // with packetQueue_commit(). Reserving is a single compare-and-swap on the
+    // write position, so a producer never waits on another producer and an ISR
+    // that preempts a half-written packet cannot corrupt it. When every slot is
+    // taken the packet is dropped and counted instead of blocking.
+    //
+    // packetQueue_drain() is the single consumer. It pushes committed slots to
+    // UART_1 in reservation order and may be called from anywhere: if another
+    // context is already draining the call returns right away and the packet is
+    // picked up by the context that owns the drain. packetQueue_hold() stops
+    // it from starting anything while a direct packet waits for the UART.
+    //
+    // Right before a slot goes on the wire the drain calls finishPacket(), which
+    // the packet layer (MessageHandler.c) provides to stamp the sequence number
+    // and CRC into the tail in the order packets actually leave.
+
+    #ifndef PACKET_QUEUE_NUM_SLOTS
+        #define PACKET_QUEUE_NUM_SLOTS  8u    // must be a power of two
+    #endif
+    #ifndef PACKET_QUEUE_SLOT_BYTES
+        #define PACKET_QUEUE_SLOT_BYTES 280u  // 12 byte head + 256 byte payload + up to 10 byte tail, word multiple
+    #endif
+
+    typedef struct
+    {
+        volatile uint32 sequence;   // owned by the queue, do not touch
+        uint32          crc;        // running packet CRC, finished by finishPacket()
+        uint16          numBytes;   // bytes of data[] to put on the wire
+        uint8           data[PACKET_QUEUE_SLOT_BYTES];
+    } packetQueueSlot;
+
+    packetQueueSlot* packetQueue_reserve();
+    void   packetQueue_commit(packetQueueSlot* slot);
+    void   packetQueue_drain();
+    void   packetQueue_flush();
+    void   packetQueue_hold(uint8 hold);
+    uint8  packetQueue_isIdle();
+    uint8  packetQueue_getPending();
+    uint32 packetQueue_getDropCount();
+    uint8  packetQueue_getHighWater();
+    void   packetQueue_resetStats();
+
+    void   finishPacket(packetQueueSlot* slot);
+#endif
@@ -0,0 +1,372 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "payload_codec.h"
+#include "MessageHandler.h"
+
+#include <string.h>
+
+#define LZ_HASH_BITS  6u
+#define LZ_HASH_SIZE  (1u << LZ_HASH_BITS)
+#define LZ_NO_ENTRY   0xFFFFu
+
+//define private functions here
+static uint32 _readWord(const uint8* bytes);
+static void   _writeWord(uint8* bytes, uint32 word);
+static uint8  _varintBytes(uint32 value);
+static uint8  _putVarint(uint8* out, uint32 value);
+static uint8  _deltaShift(const uint8* in, uint16 numWords, uint8 stride);
+static uint16 _deltaSize(const uint8* in, uint16 numWords, uint8 stride, uint8 shift);
+static uint16 _decodeDeltaVarint(const uint8* in, uint16 numBytes, uint8* out, uint16 outMax);
+static uint16 _decodeLz(const uint8* in, uint16 numBytes, uint8* out, uint16 outMax);
+
+static volatile uint8 _acceptedCodecs; //bit (1 << codec), set by the host
+
+void payloadCodec_setAccepted(uint8 codecMask)
+{
+    _acceptedCodecs = codecMask & (uint8)((1u << PAYLOAD_CODEC_DELTA_VARINT) | (1u << PAYLOAD_CODEC_LZ));
+}
+
+uint8 payloadCodec_getAccepted()
+{
+    return _acceptedCodecs;
+}
+
+uint16 payloadCodec_encode(uint8 messageType, const void* in, uint16 numBytes, uint8* out, uint8* codec)
+{
+    //Writes the payload for the wire to out (room for numBytes) and returns its
+    //length: compressed if the host takes the type's codec and it helps, else a copy
+    uint16 encodedBytes = 0;
+    
+    *codec = PAYLOAD_CODEC_NONE;
+#if (ENABLE_PAYLOAD_CODEC)
+    if( messageType == MESSAGE_TYPE_BINARY_FLOAT && (_acceptedCodecs & (1u << PAYLOAD_CODEC_DELTA_VARINT)) )
+    {
+        encodedBytes = payloadCodec_encodeDeltaVarint((const uint8*)in, numBytes, out, numBytes - 1u);
+        *codec = PAYLOAD_CODEC_DELTA_VARINT;
+    }
+    else if( messageType == MESSAGE_TYPE_LOG && (_acceptedCodecs & (1u << PAYLOAD_CODEC_LZ)) )
+    {
+        encodedBytes = payloadCodec_encodeLz((const uint8*)in, numBytes, out, numBytes - 1u);
+        *codec = PAYLOAD_CODEC_LZ;
+    }
+#else
+    (void)messageType;
+#endif
+    if( encodedBytes == 0 )
+    {
+        *codec = PAYLOAD_CODEC_NONE;
+        memcpy(out, in, numBytes);
+        encodedBytes = numBytes;
+    }
+    return encodedBytes;
+}
+
+uint16 payloadCodec_encodeInPlace(uint8 messageType, uint8* payload, uint16 numBytes, uint8* codec)
+{
+    //for payloads built in a queue slot (sendLogMessage), goes through a stack copy
+    uint8 encoded[LOG_MESSAGE_MAX_BYTES];
+    uint16 encodedBytes = 0;
+    
+    *codec = PAYLOAD_CODEC_NONE;
+#if (ENABLE_PAYLOAD_CODEC)
+    if( numBytes <= sizeof(encoded) && (_acceptedCodecs & ((1u << PAYLOAD_CODEC_DELTA_VARINT) | (1u << PAYLOAD_CODEC_LZ))) )
+    {
+        encodedBytes = payloadCodec_encode(messageType, payload, numBytes, encoded, codec);
+        if( *codec != PAYLOAD_CODEC_NONE )
+        {
+            memcpy(payload, encoded, encodedBytes);
+            return encodedBytes;
+        }
+    }
+#else
+    (void)messageType;
+    (void)payload;
+    (void)encoded;
+    (void)encodedBytes;
+#endif
+    return numBytes;
+}
+
+uint16 payloadCodec_encodeDeltaVarint(const uint8* in, uint16 numBytes, uint8* out, uint16 outMax)
+{
+    //0 when numBytes is not whole words or the result would not fit in outMax
+    uint16 numWords = numBytes / 4u;
+    uint16 bestBytes = 0xFFFFu;
+    uint16 size;
+    uint16 i;
+    uint8  bestStride = 1;
+    uint8  bestShift = 0;
+    uint8  stride;
+    uint8  shift;
+    uint8* outPtr = out;
+    
+    if( (numBytes % 4u) != 0 || numWords < 2 )
+    {
+        return 0;
+    }
+    for(stride = 1; stride <= PAYLOAD_CODEC_MAX_STRIDE && stride < numWords; stride++)
+    {
+        shift = _deltaShift(in, numWords, stride);
+        size  = _deltaSize(in, numWords, stride, shift);
+        if( size < bestBytes )
+        {
+            bestBytes  = size;
+            bestStride = stride;
+            bestShift  = shift;
+        }
+    }
+    if( bestBytes > outMax )
+    {
+        return 0;
+    }
+    
+    *outPtr++ = (uint8)(((bestStride - 1u) << 5) | bestShift);
+    memcpy(outPtr, in, 4u * bestStride);
+    outPtr += 4u * bestStride;
+    for(i = bestStride; i < numWords; i++)
+    {
+        int32 delta = (int32)(_readWord(&in[4u * i]) - _readWord(&in[4u * (i - bestStride)]));
+        delta >>= bestShift; //exact, every delta has at least bestShift trailing zeros
+        outPtr += _putVarint(outPtr, ((uint32)delta << 1) ^ (uint32)(delta >> 31));
+    }
+    return (uint16)(outPtr - out);
+}
+
+uint16 payloadCodec_encodeLz(const uint8* in, uint16 numBytes, uint8* out, uint16 outMax)
+{
+    //greedy, one candidate per hash of the next 3 bytes; 0 if it does not fit in outMax
+    uint16 table[LZ_HASH_SIZE];
+    uint16 pos = 0;
+    uint16 outBytes = 0;
+    uint16 controlAt = 0;
+    uint8  item = 8;
+    uint16 candidate;
+    uint16 length;
+    uint16 maxLength;
+    uint8  hash;
+    
+    memset(table, 0xFF, sizeof(table));
+    while( pos < numBytes )
+    {
+        if( item == 8 )
+        {
+            if( outBytes >= outMax ) { return 0; }
+            controlAt = outBytes;
+            out[outBytes++] = 0;
+            item = 0;
+        }
+        length = 0;
+        if( pos + PAYLOAD_CODEC_LZ_MIN_MATCH <= numBytes )
+        {
+            hash = (uint8)(((in[pos] * 251u) ^ (in[pos + 1] * 11u) ^ in[pos + 2]) & (LZ_HASH_SIZE - 1u));
+            candidate = table[hash];
+            table[hash] = pos;
+            if( candidate != LZ_NO_ENTRY && (uint16)(pos - candidate) <= PAYLOAD_CODEC_LZ_WINDOW )
+            {
+                maxLength = numBytes - pos;
+                if( maxLength > PAYLOAD_CODEC_LZ_MAX_MATCH ) { maxLength = PAYLOAD_CODEC_LZ_MAX_MATCH; }
+                while( length < maxLength && in[candidate + length] == in[pos + length] )
+                {
+                    length++;
+                }
+            }
+        }
+        if( length >= PAYLOAD_CODEC_LZ_MIN_MATCH )
+        {
+            if( outBytes + 2u > outMax ) { return 0; }
+            out[controlAt] |= (uint8)(1u << item);
+            out[outBytes++] = (uint8)(pos - candidate - 1u);
+            out[outBytes++] = (uint8)(length - PAYLOAD_CODEC_LZ_MIN_MATCH);
+            pos += length;
+        }
+        else
+        {
+            if( outBytes + 1u > outMax ) { return 0; }
+            out[outBytes++] = in[pos++];
+        }
+        item++;
+    }
+    return outBytes;
+}
+
+uint16 payloadCodec_decode(uint8 codec, const uint8* in, uint16 numBytes, uint8* out, uint16 outMax)
+{
+    //inverse of the encoders, for tests and a loop-back; 0xFFFF if malformed or over outMax
+    switch( codec )
+    {
+        case PAYLOAD_CODEC_NONE:
+            if( numBytes > outMax ) { return 0xFFFFu; }
+            memcpy(out, in, numBytes);
+            return numBytes;
+        case PAYLOAD_CODEC_DELTA_VARINT:
+            return _decodeDeltaVarint(in, numBytes, out, outMax);
+        case PAYLOAD_CODEC_LZ:
+            return _decodeLz(in, numBytes, out, outMax);
+        default:
+            return 0xFFFFu;
+    }
+}
+
+static uint32 _readWord(const uint8* bytes)
+{
+    return (uint32)bytes[0] | ((uint32)bytes[1] << 8) | ((uint32)bytes[2] << 16) | ((uint32)bytes[3] << 24);
+}
+
+static void _writeWord(uint8* bytes, uint32 word)
+{
+    bytes[0] = (uint8)word;
+    bytes[1] = (uint8)(word >> 8);
+    bytes[2] = (uint8)(word >> 16);
+    bytes[3] = (uint8)(word >> 24);
+}
+
+static uint8 _varintBytes(uint32 value)
+{
+    uint8 numBytes = 1;
+    while( value >= 0x80u )
+    {
+        value >>= 7;
+        numBytes++;
+    }
+    return numBytes;
+}
+
+static uint8 _putVarint(uint8* out, uint32 value)
+{
+    uint8 numBytes = 0;
+    while( value >= 0x80u )
+    {
+        out[numBytes++] = (uint8)(value | 0x80u);
+        value >>= 7;
+    }
+    out[numBytes++] = (uint8)value;
+    return numBytes;
+}
+
+static uint8 _deltaShift(const uint8* in, uint16 numWords, uint8 stride)
+{
+    //trailing zeros every delta has in common, 0 if they are all 0
+    uint32 bits = 0;
+    uint8  shift = 0;
+    uint16 i;
+    
+    for(i = stride; i < numWords; i++)
+    {
+        bits |= _readWord(&in[4u * i]) - _readWord(&in[4u * (i - stride)]);
+    }
+    if( bits == 0 )
+    {
+        return 0;
+    }
+    while( (bits & 1u) == 0 && shift < 31u )
+    {
+        bits >>= 1;
+        shift++;
+    }
+    return shift;
+}
+
+static uint16 _deltaSize(const uint8* in, uint16 numWords, uint8 stride, uint8 shift)
+{
+    uint16 size = 1u + 4u * stride;
+    uint16 i;
+    
+    for(i = stride; i < numWords; i++)
+    {
+        int32 delta = (int32)(_readWord(&in[4u * i]) - _readWord(&in[4u * (i - stride)])) >> shift;
+        size += _varintBytes(((uint32)delta << 1) ^ (uint32)(delta >> 31));
+    }
+    return size;
+}
+
+static uint16 _decodeDeltaVarint(const uint8* in, uint16 numBytes, uint8* out, uint16 outMax)
+{
+    uint16 inPos;
+    uint16 outBytes;
+    uint32 value;
+    uint32 word;
+    uint8  stride;
+    uint8  shift;
+    uint8  bitPos;
+    
+    if( numBytes < 1 )
+    {
+        return 0xFFFFu;
+    }
+    stride = (uint8)((in[0] >> 5) + 1u);
+    shift  = in[0] & 0x1Fu;
+    if( numBytes < 1u + 4u * stride || 4u * stride > outMax )
+    {
+        return 0xFFFFu;
+    }
+    memcpy(out, &in[1], 4u * stride);
+    inPos    = 1u + 4u * stride;
+    outBytes = 4u * stride;
+    while( inPos < numBytes )
+    {
+        value  = 0;
+        bitPos = 0;
+        do
+        {
+            if( inPos >= numBytes || bitPos > 28u ) { return 0xFFFFu; }
+            value |= (uint32)(in[inPos] & 0x7Fu) << bitPos;
+            bitPos += 7u;
+        } while( in[inPos++] & 0x80u );
+        if( outBytes + 4u > outMax ) { return 0xFFFFu; }
+        word = (uint32)(((int32)((value >> 1) ^ (0u - (value & 1u)))) << shift); //zigzag back, undo the shift
+        _writeWord(&out[outBytes], _readWord(&out[outBytes - 4u * stride]) + word);
+        outBytes += 4u;
+    }
+    return outBytes;
+}
+
+static uint16 _decodeLz(const uint8* in, uint16 numBytes, uint8* out, uint16 outMax)
+{
+    uint16 inPos = 0;
+    uint16 outBytes = 0;
+    uint16 offset;
+    uint16 length;
+    uint8  control = 0;
+    uint8  item = 8;
+    
+    while( inPos < numBytes )
+    {
+        if( item == 8 )
+        {
+            control = in[inPos++];
+            item = 0;
+            continue;
+        }
+        if( control & (1u << item) )
+        {
+            if( inPos + 2u > numBytes ) { return 0xFFFFu; }
+            offset = (uint16)in[inPos++] + 1u;
+            length = (uint16)in[inPos++] + PAYLOAD_CODEC_LZ_MIN_MATCH;
+            if( offset > outBytes || outBytes + length > outMax ) { return 0xFFFFu; }
+            while( length-- > 0 )
+            {
+                out[outBytes] = out[outBytes - offset]; //byte by byte: matches may overlap
+                outBytes++;
+            }
+        }
+        else
+        {
+            if( outBytes >= outMax ) { return 0xFFFFu; }
+            out[outBytes++] = in[inPos++];
+        }
+        item++;
+    }
+    return outBytes;
+}
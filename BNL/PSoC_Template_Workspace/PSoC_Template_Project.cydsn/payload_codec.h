@@ -0,0 +1,67 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef PAYLOAD_CODEC_H
+    #define PAYLOAD_CODEC_H
+
+    #include <cytypes.h>
+
+    // Payload compression for the UART link, off until the host asks for it.
+    //
+    // The host sends RX_NEXT_IS_CODEC + a uint8 mask of the codecs it can
+    // decode (bit 1 << codec, 0 = none). From then on constructAndSendPacket()
+    // and sendLogMessage() try the codec for their message type and keep the
+    // result only if it is smaller; the codec goes in the top two bits of the
+    // header's message type byte, so the length field and CRC cover the
+    // compressed bytes. payload_codec.py on the host undoes it. queuePacket()
+    // is called from interrupts and never compresses, its packets go out raw.
+    //
+    // PAYLOAD_CODEC_DELTA_VARINT, MESSAGE_TYPE_BINARY_FLOAT (whole float words):
+    //   byte 0       (stride - 1) << 5 | shift
+    //   stride words verbatim, 4 bytes each
+    //   then per word w[i]: varint( zigzag( (w[i] - w[i - stride]) >> shift ) )
+    // on the IEEE bit patterns, so it is lossless. Slowly varying readings
+    // (ADC volts, integer valued accelerations) only move the low mantissa
+    // bits, and values with few significant bits share trailing zeros that
+    // the shift removes. stride 1 to 4 covers interleaved channels; the
+    // encoder tries each and keeps the smallest.
+    //
+    // PAYLOAD_CODEC_LZ, MESSAGE_TYPE_LOG: LZSS over the payload itself, no
+    // history between packets so one lost packet never spoils the next.
+    //   control byte, then 8 items, bit i set = item i is a match
+    //   literal      1 byte
+    //   match        offset - 1 (1 byte, back up to 256), length - 3 (1 byte)
+
+    #define PAYLOAD_CODEC_NONE           (uint8)0
+    #define PAYLOAD_CODEC_DELTA_VARINT   (uint8)1
+    #define PAYLOAD_CODEC_LZ             (uint8)2
+
+    #define PAYLOAD_CODEC_SHIFT          6u     // codec bits in the message type byte
+    #define PAYLOAD_CODEC_TYPE_MASK      0x3Fu  // message type bits that are left
+
+    #define PAYLOAD_CODEC_MAX_STRIDE     4u
+    #define PAYLOAD_CODEC_LZ_MIN_MATCH   3u
+    #define PAYLOAD_CODEC_LZ_MAX_MATCH   (PAYLOAD_CODEC_LZ_MIN_MATCH + 255u)
+    #define PAYLOAD_CODEC_LZ_WINDOW      256u
+
+    void   payloadCodec_setAccepted(uint8 codecMask);
+    uint8  payloadCodec_getAccepted();
+
+    uint16 payloadCodec_encode(uint8 messageType, const void* in, uint16 numBytes, uint8* out, uint8* codec);
+    uint16 payloadCodec_encodeInPlace(uint8 messageType, uint8* payload, uint16 numBytes, uint8* codec);
+
+    uint16 payloadCodec_encodeDeltaVarint(const uint8* in, uint16 numBytes, uint8* out, uint16 outMax);
+    uint16 payloadCodec_encodeLz(const uint8* in, uint16 numBytes, uint8* out, uint16 outMax);
+    uint16 payloadCodec_decode(uint8 codec, const uint8* in, uint16 numBytes, uint8* out, uint16 outMax);
+#endif
@@ -0,0 +1,121 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "rpc.h"
+#include "command_table.h"
+
+#include <string.h>
+
+//define private functions here
+static uint8 _ping(const uint8* arguments, uint16 numArguments, uint8* result, uint16* numResult);
+static uint8 _set(const uint8* arguments, uint16 numArguments, uint8* result, uint16* numResult);
+
+static rpcMethod _methods[256] = { _ping, _set }; //RPC_METHOD_PING, RPC_METHOD_SET
+
+void rpc_init()
+{
+    //back to the built in methods only
+    memset(_methods, 0, sizeof(_methods));
+    _methods[RPC_METHOD_PING] = _ping;
+    _methods[RPC_METHOD_SET]  = _set;
+}
+
+void rpc_register(uint8 method, rpcMethod handler)
+{
+    _methods[method] = handler; //NULL unregisters
+}
+
+rpcMethod rpc_get(uint8 method)
+{
+    return _methods[method];
+}
+
+uint8 rpc_canRespond()
+{
+    return packetQueue_getPending() < PACKET_QUEUE_NUM_SLOTS;
+}
+
+uint8 rpc_handleRequest(packetQueueSlot* response, const uint8* frame, uint16 numBytes)
+{
+    //Runs one request and commits its response to response, a slot from
+    //reservePacket(MESSAGE_TYPE_RPC_RESPONSE, ...). Returns the RPC_* status.
+    uint8*    payload = PACKET_PAYLOAD(response);
+    rpcMethod method;
+    uint16    numResult = 0;
+    uint8     status;
+
+    if( numBytes < RPC_REQUEST_HEAD_BYTES )
+    {
+        packetQueue_commit(response); //no id to answer to, left empty, the drain skips it
+        return RPC_ERR_BAD_ARGUMENTS;
+    }
+    method = _methods[frame[2]];
+    if( method == NULL )
+    {
+        status = RPC_ERR_NO_METHOD;
+    }
+    else
+    {
+        status = method(&frame[RPC_REQUEST_HEAD_BYTES], numBytes - RPC_REQUEST_HEAD_BYTES,
+                        &payload[RPC_RESPONSE_HEAD_BYTES], &numResult);
+        if( numResult > RPC_MAX_RESULT_BYTES )
+        {
+            numResult = 0;
+            status = RPC_ERR_FAILED;
+        }
+    }
+    if( status != RPC_OK )
+    {
+        numResult = 0;
+    }
+
+    memcpy(payload, frame, 3); //request id and method
+    payload[3] = status;
+    commitReservedPacket(response, RPC_RESPONSE_HEAD_BYTES + numResult);
+    return status;
+}
+
+static uint8 _ping(const uint8* arguments, uint16 numArguments, uint8* result, uint16* numResult)
+{
+    if( numArguments > RPC_MAX_RESULT_BYTES )
+    {
+        return RPC_ERR_BAD_ARGUMENTS;
+    }
+    memcpy(result, arguments, numArguments);
+    *numResult = numArguments;
+    return RPC_OK;
+}
+
+static uint8 _set(const uint8* arguments, uint16 numArguments, uint8* result, uint16* numResult)
+{
+    //one batch entry: flag, COMMAND_VALUE_* type, value; the result is its COMMAND_* status
+    commandValue value;
+    uint8 valueBytes;
+
+    if( numArguments < 2u )
+    {
+        return RPC_ERR_BAD_ARGUMENTS;
+    }
+    value.type = arguments[1];
+    value.value.asUint = 0;
+    valueBytes = commandTable_valueBytes(value.type);
+    if( valueBytes == COMMAND_VALUE_INVALID || numArguments != 2u + valueBytes )
+    {
+        return RPC_ERR_BAD_ARGUMENTS;
+    }
+    memcpy(&value.value, &arguments[2], valueBytes);
+    result[0] = commandTable_dispatch(arguments[0], &value);
+    *numResult = 1;
+    return RPC_OK;
+}
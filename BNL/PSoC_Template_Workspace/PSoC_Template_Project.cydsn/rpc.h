@@ -0,0 +1,62 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef RPC_H
+    #define RPC_H
+
+    #include <cytypes.h>
+    #include "MessageHandler.h"
+
+    // Request/response calls from the host. Every request carries an id that
+    // comes back in its response, so the host can keep many requests in flight
+    // and match answers as they arrive instead of waiting for each one:
+    //
+    //   RX_NEXT_IS_RPC, uint16 frame length, then the frame:
+    //     uint16 request id, uint8 method, arguments
+    //
+    //   MESSAGE_TYPE_RPC_RESPONSE payload:
+    //     uint16 request id, uint8 method, uint8 RPC_* status, result
+    //
+    // Methods are looked up in a 256 entry table filled by rpc_register() at
+    // init and run in the main loop (from rxParser_poll()), in the order the
+    // requests arrive. The parser holds a request back until it has reserved
+    // a packet queue slot for the response, and only then runs the method, so
+    // a response is never dropped, even when interrupts queue packets while
+    // the method runs.
+    //
+    // Built in: RPC_METHOD_PING answers with its arguments, RPC_METHOD_SET runs
+    // one (flag, type, value) entry through the command_table.h handlers.
+
+    #define RPC_METHOD_PING              (uint8)0
+    #define RPC_METHOD_SET               (uint8)1
+
+    #define RPC_OK                       (uint8)0
+    #define RPC_ERR_NO_METHOD            (uint8)1 // nothing registered for the method
+    #define RPC_ERR_BAD_ARGUMENTS        (uint8)2 // wrong length or value for the method
+    #define RPC_ERR_FAILED               (uint8)3 // the method could not do it now
+
+    #define RPC_REQUEST_HEAD_BYTES       3u
+    #define RPC_RESPONSE_HEAD_BYTES      4u
+    #define RPC_MAX_RESULT_BYTES         (PACKET_MAX_PAYLOAD_BYTES - RPC_RESPONSE_HEAD_BYTES)
+
+    // Writes up to RPC_MAX_RESULT_BYTES into result and their count into
+    // numResult (0 when called). Returns an RPC_* status.
+    typedef uint8 (*rpcMethod)(const uint8* arguments, uint16 numArguments, uint8* result, uint16* numResult);
+
+    void      rpc_init();
+    void      rpc_register(uint8 method, rpcMethod handler);
+    rpcMethod rpc_get(uint8 method);
+    uint8     rpc_canRespond();
+    uint8     rpc_handleRequest(packetQueueSlot* response, const uint8* frame, uint16 numBytes);
+#endif
@@ -0,0 +1,150 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "sample_batcher.h"
+#include "MessageHandler.h"
+#include "timebase.h"
+
+#include <string.h>
+
+#if (SAMPLE_BATCH_MAX_PAYLOAD_BYTES > PACKET_MAX_PAYLOAD_BYTES)
+    #error "a sample batch must fit in a packet queue slot"
+#endif
+
+//define private functions here
+static uint8 _agedOut(const sampleBatcher* batcher, uint32 nowTicks);
+
+void sampleBatcher_init(sampleBatcher* batcher, uint8 channel, uint8 format, uint8 valuesPerSample, uint8 maxSamples, uint32 maxAgeTicks)
+{
+    uint16 bytesPerSample = (uint16)valuesPerSample * ((format == SAMPLE_FORMAT_INT16) ? 2u : 4u);
+    uint16 fit = 0;
+
+    if( bytesPerSample > 0 && bytesPerSample <= SAMPLE_BATCH_MAX_VALUE_BYTES )
+    {
+        fit = (SAMPLE_BATCH_MAX_PAYLOAD_BYTES - SAMPLE_BATCH_HEAD_BYTES) / (SAMPLE_BATCH_DELTA_BYTES + bytesPerSample);
+    }
+    if( fit > SAMPLE_BATCH_MAX_SAMPLES ) { fit = SAMPLE_BATCH_MAX_SAMPLES; }
+    if( maxSamples == 0 || maxSamples > fit ) { maxSamples = (uint8)fit; }
+
+    batcher->channel         = channel;
+    batcher->format          = format;
+    batcher->valuesPerSample = valuesPerSample;
+    batcher->bytesPerSample  = (uint8)bytesPerSample;
+    batcher->maxSamples      = maxSamples; //0 if a single sample cannot fit, every add then fails
+    batcher->maxAgeTicks     = maxAgeTicks;
+    batcher->count           = 0;
+    batcher->baseTicks       = 0;
+    batcher->lastTicks       = 0;
+    batcher->droppedSamples  = 0;
+}
+
+uint8 sampleBatcher_add(sampleBatcher* batcher, uint32 timestampTicks, const void* values)
+{
+    //values: valuesPerSample floats or int16s, copied
+    uint8  status = PACKET_OK;
+    uint32 delta;
+
+    if( batcher->maxSamples == 0 )
+    {
+        return PACKET_ERR_TOO_LONG;
+    }
+    if( batcher->count > 0 )
+    {
+        delta = timestampTicks - batcher->lastTicks;
+        if( delta > SAMPLE_BATCH_MAX_DELTA_TICKS || _agedOut(batcher, timestampTicks) )
+        {
+            status = sampleBatcher_flush(batcher); //gap too long for a delta (or clock went back), or batch aged out
+        }
+    }
+    if( batcher->count == 0 )
+    {
+        batcher->baseTicks = timestampTicks;
+        batcher->deltas[0] = 0;
+    }
+    else
+    {
+        batcher->deltas[batcher->count] = (uint16)(timestampTicks - batcher->lastTicks);
+    }
+    memcpy(&batcher->values[(uint16)batcher->count * batcher->bytesPerSample], values, batcher->bytesPerSample);
+    batcher->lastTicks = timestampTicks;
+    batcher->count++;
+
+    if( batcher->count >= batcher->maxSamples )
+    {
+        status = sampleBatcher_flush(batcher);
+    }
+    return status;
+}
+
+uint8 sampleBatcher_addNow(sampleBatcher* batcher, const void* values)
+{
+    return sampleBatcher_add(batcher, timebase_getWireTimestamp(), values);
+}
+
+uint8 sampleBatcher_poll(sampleBatcher* batcher, uint32 nowTicks)
+{
+    //age flush for channels that go quiet, call from the context that owns the batcher
+    if( batcher->count > 0 && _agedOut(batcher, nowTicks) )
+    {
+        return sampleBatcher_flush(batcher);
+    }
+    return PACKET_OK;
+}
+
+uint8 sampleBatcher_flush(sampleBatcher* batcher)
+{
+    packetQueueSlot* slot;
+    uint8* payload;
+    uint8* deltas;
+    uint16 valueBytes;
+    uint8  sampleCounter;
+
+    if( batcher->count == 0 )
+    {
+        return PACKET_OK;
+    }
+    slot = reservePacket(MESSAGE_TYPE_SAMPLE_BATCH, MESSAGE_FLAG_NO_FLAG);
+    if( slot == NULL )
+    {
+        batcher->droppedSamples += batcher->count;
+        batcher->count = 0;
+        return PACKET_ERR_QUEUE_FULL;
+    }
+    payload    = PACKET_PAYLOAD(slot);
+    valueBytes = (uint16)batcher->count * batcher->bytesPerSample;
+    payload[0] = batcher->channel;
+    payload[1] = batcher->format;
+    payload[2] = batcher->valuesPerSample;
+    payload[3] = batcher->count;
+    payload[4] = (uint8)(batcher->baseTicks);
+    payload[5] = (uint8)(batcher->baseTicks >> 8);
+    payload[6] = (uint8)(batcher->baseTicks >> 16);
+    payload[7] = (uint8)(batcher->baseTicks >> 24);
+    deltas = &payload[SAMPLE_BATCH_HEAD_BYTES];
+    for(sampleCounter = 0; sampleCounter < batcher->count; sampleCounter++)
+    {
+        deltas[2u * sampleCounter]      = LO8(batcher->deltas[sampleCounter]);
+        deltas[2u * sampleCounter + 1u] = HI8(batcher->deltas[sampleCounter]);
+    }
+    memcpy(&deltas[SAMPLE_BATCH_DELTA_BYTES * batcher->count], batcher->values, valueBytes);
+    commitReservedPacket(slot, SAMPLE_BATCH_HEAD_BYTES + SAMPLE_BATCH_DELTA_BYTES * batcher->count + valueBytes);
+    batcher->count = 0;
+    return PACKET_OK;
+}
+
+static uint8 _agedOut(const sampleBatcher* batcher, uint32 nowTicks)
+{
+    //maxAgeTicks 0: size flush only
+    return (batcher->maxAgeTicks != 0) && ((nowTicks - batcher->baseTicks) >= batcher->maxAgeTicks);
+}
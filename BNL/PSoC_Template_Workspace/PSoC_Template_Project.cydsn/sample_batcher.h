@@ -0,0 +1,77 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef SAMPLE_BATCHER_H
+    #define SAMPLE_BATCHER_H
+
+    #include <cytypes.h>
+
+    // Batches timestamped samples of one channel (an ADC voltage, the three
+    // LIS2DH axes, ...) into MESSAGE_TYPE_SAMPLE_BATCH packets, so the 12 byte
+    // head and the tail are paid once per batch instead of once per sample.
+    //
+    // Payload, little endian:
+    //   uint8  channel
+    //   uint8  format               SAMPLE_FORMAT_FLOAT32 or SAMPLE_FORMAT_INT16
+    //   uint8  values per sample
+    //   uint8  sample count N
+    //   uint32 base timestamp       ticks of the first sample
+    //   uint16 delta ticks[N]       from the previous sample, the first one is 0
+    //   values[N * values per sample]
+    // Ticks are timebase_getWireTimestamp() (TIMEBASE_WIRE_HZ, 1/3 us), the
+    // clock of the packet heads, so the host puts samples and packets on one
+    // timebase. sampleBatcher_addNow() stamps with it; callers of
+    // sampleBatcher_add() and sampleBatcher_poll() pass the same units. A
+    // delta covers up to 21.8 ms, slower channels send a batch per sample.
+    //
+    // maxSamples is clamped to what fits in one packet (40 single floats, 30
+    // int16 triplets, ...). A batch is queued once it holds maxSamples samples,
+    // once its first sample is maxAgeTicks old (0 = never; checked by
+    // sampleBatcher_add() and sampleBatcher_poll()), or when a gap does not fit
+    // in a delta. Queuing never touches the UART, the main loop's
+    // packetQueue_drain() sends it. Each batcher belongs to a single context:
+    // an ISR may own one, but must not share it with the main loop.
+
+    #define SAMPLE_FORMAT_FLOAT32          (uint8)0
+    #define SAMPLE_FORMAT_INT16            (uint8)1
+
+    #define SAMPLE_BATCH_HEAD_BYTES        8u
+    #define SAMPLE_BATCH_MAX_SAMPLES       64u
+    #define SAMPLE_BATCH_MAX_PAYLOAD_BYTES 250u   // head + deltas + values, fits a queue slot with either CRC
+    #define SAMPLE_BATCH_DELTA_BYTES       2u
+    #define SAMPLE_BATCH_MAX_VALUE_BYTES   (SAMPLE_BATCH_MAX_PAYLOAD_BYTES - SAMPLE_BATCH_HEAD_BYTES - SAMPLE_BATCH_DELTA_BYTES)
+    #define SAMPLE_BATCH_MAX_DELTA_TICKS   65535u
+
+    typedef struct
+    {
+        uint8  channel;
+        uint8  format;
+        uint8  valuesPerSample;
+        uint8  bytesPerSample;
+        uint8  maxSamples;
+        uint32 maxAgeTicks;
+        uint8  count;
+        uint32 baseTicks;
+        uint32 lastTicks;
+        uint32 droppedSamples;      // batches lost to a full packet queue
+        uint16 deltas[SAMPLE_BATCH_MAX_SAMPLES];
+        uint8  values[SAMPLE_BATCH_MAX_VALUE_BYTES];
+    } sampleBatcher;
+
+    void   sampleBatcher_init(sampleBatcher* batcher, uint8 channel, uint8 format, uint8 valuesPerSample, uint8 maxSamples, uint32 maxAgeTicks);
+    uint8  sampleBatcher_add(sampleBatcher* batcher, uint32 timestampTicks, const void* values);
+    uint8  sampleBatcher_addNow(sampleBatcher* batcher, const void* values);
+    uint8  sampleBatcher_poll(sampleBatcher* batcher, uint32 nowTicks);
+    uint8  sampleBatcher_flush(sampleBatcher* batcher);
+#endif
@@ -0,0 +1,100 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "timebase.h"
+#include "SysTimers.h"
+#include "core_cm3_psoc5.h"
+
+#define TIMEBASE_CYCLES_PER_TICK (TIMEBASE_HZ / SysTimers_TICKS_PER_SECOND)
+#define TIMEBASE_HALF_WRAP       ((int64)1 << 31)
+
+// The tick count only picks the 2^32 cycle epoch, so it may lag the cycle
+// counter by anything short of half a wrap (89 s): a pending SysTick while
+// interrupts are masked costs nothing.
+static uint32 _ticksAtInit;
+static uint32 _cyclesAtInit;
+static uint32 _lastTicks;        // relative to _ticksAtInit, to count tick wraps
+static uint32 _tickWraps;        // every 4.97 days
+static uint8  _hasCycleCounter;
+
+void timebase_init()
+{
+    uint8 interruptState;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; //DWT is off unless trace is enabled
+    DWT->CYCCNT = 0;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+    _hasCycleCounter = (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0;
+
+    interruptState = CyEnterCriticalSection();
+    _ticksAtInit  = SysTimers_GetSysTickValue();
+    _cyclesAtInit = DWT->CYCCNT;
+    _lastTicks    = 0;
+    _tickWraps    = 0;
+    CyExitCriticalSection(interruptState);
+}
+
+uint64 timebase_getCycles()
+{
+    uint8  interruptState;
+    uint32 ticks;
+    uint32 cycles;
+    uint64 estimate;
+    uint64 now;
+    int64  error;
+
+    //both counters and the wrap bookkeeping from one consistent instant
+    interruptState = CyEnterCriticalSection();
+    ticks  = SysTimers_GetSysTickValue() - _ticksAtInit;
+    cycles = DWT->CYCCNT - _cyclesAtInit;
+    if( ticks < _lastTicks )
+    {
+        _tickWraps++;
+    }
+    _lastTicks = ticks;
+    estimate = (((uint64)_tickWraps << 32) | ticks) * TIMEBASE_CYCLES_PER_TICK;
+    CyExitCriticalSection(interruptState);
+
+    if( !_hasCycleCounter )
+    {
+        return estimate; //tick resolution only
+    }
+    //the cycle count in the epoch closest to the tick estimate
+    now   = (estimate & 0xFFFFFFFF00000000ull) | cycles;
+    error = (int64)(now - estimate);
+    if( error >= TIMEBASE_HALF_WRAP && now >= ((uint64)1 << 32) )
+    {
+        now -= (uint64)1 << 32;
+    }
+    else if( error < -TIMEBASE_HALF_WRAP )
+    {
+        now += (uint64)1 << 32;
+    }
+    return now;
+}
+
+uint32 timebase_getCycles32()
+{
+    return DWT->CYCCNT;
+}
+
+uint32 timebase_getWireTimestamp()
+{
+    return (uint32)(timebase_getCycles() >> TIMEBASE_WIRE_SHIFT);
+}
+
+uint8 timebase_hasCycleCounter()
+{
+    return _hasCycleCounter;
+}
@@ -0,0 +1,46 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef TIMEBASE_H
+    #define TIMEBASE_H
+
+    #include <cytypes.h>
+    #include "CyLib.h"
+
+    // 64-bit monotonic time in BCLK cycles since timebase_init().
+    //
+    // The DWT cycle counter gives the resolution (1/24 MHz) but wraps every
+    // 179 s; the SysTimers tick (10 kHz, same clock) says which wrap we are
+    // in, so no call is needed between wraps and any context, ISRs included,
+    // can read the time. Requires SysTimers_Start() before timebase_init().
+    //
+    // On the wire every packet head carries timebase_getWireTimestamp(): the
+    // low 32 bits of the time in TIMEBASE_WIRE_HZ units (3 MHz, wraps every
+    // 23.8 minutes). LOD.py unwraps it, which only needs one packet per
+    // half wrap. PACKET_TIMESTAMP_HZ in LOD.py must match TIMEBASE_WIRE_HZ.
+    //
+    // timebase_getCycles32() is the raw counter for short latency
+    // measurements: the uint32 difference of two readings is exact up to 179 s.
+
+    #define TIMEBASE_HZ              ((uint32)BCLK__BUS_CLK__HZ)
+    #define TIMEBASE_WIRE_SHIFT      3u
+    #define TIMEBASE_WIRE_HZ         (TIMEBASE_HZ >> TIMEBASE_WIRE_SHIFT)
+    #define TIMEBASE_CYCLES_PER_US   (TIMEBASE_HZ / 1000000u)
+
+    void   timebase_init();
+    uint64 timebase_getCycles();
+    uint32 timebase_getCycles32();
+    uint32 timebase_getWireTimestamp();
+    uint8  timebase_hasCycleCounter();
+#endif
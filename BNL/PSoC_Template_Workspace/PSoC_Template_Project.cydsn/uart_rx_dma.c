@@ -0,0 +1,176 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "uart_rx_dma.h"
+#include "isr_rx_helper.h"
+#include "UART_1.h"
+#include "SysTimers.h"
+#include "CyLib.h"
+
+#define UART_RX_DMA_MASK (UART_RX_DMA_BUFFER_BYTES - 1u)
+
+#if (UART_RX_DMA_BUFFER_BYTES & UART_RX_DMA_MASK) || (UART_RX_DMA_HALF_BYTES > 4095u)
+    #error "UART_RX_DMA_BUFFER_BYTES must be a power of two of at most 8190 bytes"
+#endif
+
+//define private functions here
+static uint16 _writeOffset();
+static uint8 _publish();
+
+static uint8           _channel = CY_DMA_INVALID_CHANNEL;
+static uint8           _tds[2];
+static uint8           _buffer[UART_RX_DMA_BUFFER_BYTES];
+static uint16          _readOffset;     // first byte not yet handed to the receive ring
+static uint16          _lastSeenOffset; // DMA position at the previous uartRxDma_poll()
+static uint32          _lastChangeTicks;
+static volatile uint32 _wakeCount;      // nrq interrupts plus idle wakes that found data
+
+uint8 uartRxDma_init()
+{
+    uint8 tdCounter;
+
+    if( _channel != CY_DMA_INVALID_CHANNEL )
+    {
+        return UART_RX_DMA_OK; //already running
+    }
+
+    _channel = CyDmaChAlloc();
+    if( _channel == CY_DMA_INVALID_CHANNEL )
+    {
+        return UART_RX_DMA_ERR_NOT_READY;
+    }
+    for(tdCounter = 0; tdCounter < 2u; tdCounter++)
+    {
+        _tds[tdCounter] = CyDmaTdAllocate();
+        if( _tds[tdCounter] == CY_DMA_INVALID_TD )
+        {
+            return UART_RX_DMA_ERR_NOT_READY;
+        }
+    }
+
+    //one byte per request: a request means "RX FIFO holds a byte"
+    CyDmaChSetConfiguration(_channel, 1u, 1u, 0u, 0u, 0u);
+    //source is always the UART_1 RX FIFO, destination is always SRAM
+    CyDmaChSetExtendedAddress(_channel, HI16(CYDEV_PERIPH_BASE), HI16(CYDEV_SRAM_BASE));
+
+    //TD0 fills the first half and hands over to TD1, which hands back to TD0:
+    //the loop never ends, each half raises nrq when it is full
+    for(tdCounter = 0; tdCounter < 2u; tdCounter++)
+    {
+        CyDmaTdSetConfiguration(_tds[tdCounter], UART_RX_DMA_HALF_BYTES, _tds[1u - tdCounter],
+                                CY_DMA_TD_INC_DST_ADR | CY_DMA_TD_TERMOUT0_EN);
+#if defined(CY_DMA_MOCK)
+        CyDmaMock_TdSetPointers(_tds[tdCounter], UART_1_RXDATA_PTR, &_buffer[tdCounter * UART_RX_DMA_HALF_BYTES]);
+#else
+        CyDmaTdSetAddress(_tds[tdCounter], LO16((uint32)UART_1_RXDATA_PTR), LO16((uint32)&_buffer[tdCounter * UART_RX_DMA_HALF_BYTES]));
+#endif
+    }
+
+    _readOffset      = 0;
+    _lastSeenOffset  = 0;
+    _lastChangeTicks = SysTimers_GetSysTickValue();
+    CyDmaChSetInitialTd(_channel, _tds[0]);
+    CyDmaChEnable(_channel, 1u); //preserve the TDs so the loop can run them again
+    return UART_RX_DMA_OK;
+}
+
+uint8 uartRxDma_poll()
+{
+    //Periodic timer or main loop. Returns 1 when a burst has ended and its
+    //bytes were handed to the receive ring.
+    uint16 offset;
+    uint32 now;
+
+    if( _channel == CY_DMA_INVALID_CHANNEL )
+    {
+        return 0;
+    }
+    offset = _writeOffset();
+    now    = SysTimers_GetSysTickValue();
+    if( offset != _lastSeenOffset )
+    {
+        _lastSeenOffset  = offset; //still receiving
+        _lastChangeTicks = now;
+        return 0;
+    }
+    if( (now - _lastChangeTicks) < UART_RX_DMA_IDLE_TICKS )
+    {
+        return 0;
+    }
+    return _publish();
+}
+
+uint8 uartRxDma_getChannel()
+{
+    return _channel;
+}
+
+uint32 uartRxDma_getWakeCount()
+{
+    return _wakeCount;
+}
+
+void uartRxDma_resetStats()
+{
+    _wakeCount = 0;
+}
+
+CY_ISR(uartRxDma_isr)
+{
+    //a half is full: hand it over before the DMA comes round to it again
+    _publish();
+}
+
+static uint16 _writeOffset()
+{
+    //where the DMA writes the next byte, from the channel's working copy of the active TD
+#if defined(CY_DMA_MOCK)
+    return (uint16)(CyDmaMock_GetWorkingDestination(_channel) - _buffer) & UART_RX_DMA_MASK;
+#else
+    //PHUB CFGMEM CFG1 holds the working source and destination address, low 16 bits each
+    uint16 destination = CY_GET_REG16(&CY_DMA_CFGMEM_STRUCT_PTR[_channel].CFG1[2]);
+    return (uint16)(destination - LO16((uint32)_buffer)) & UART_RX_DMA_MASK;
+#endif
+}
+
+static uint8 _publish()
+{
+    //The nrq isr and the poller are both producers for the receive ring, so the
+    //copy runs with interrupts off. Only what fits in the ring is handed over,
+    //the rest stays in the DMA buffer for the next wake. The main loop has to
+    //keep up: once the DMA gets a whole buffer ahead, a lap looks like no data.
+    uint8  interruptState = CyEnterCriticalSection();
+    uint16 pending = (uint16)(_writeOffset() - _readOffset) & UART_RX_DMA_MASK;
+    uint16 free    = rxRing_getFree();
+    uint16 first;
+
+    if( pending > free )
+    {
+        pending = free;
+    }
+    if( pending > 0u )
+    {
+        first = UART_RX_DMA_BUFFER_BYTES - _readOffset;
+        if( first > pending )
+        {
+            first = pending;
+        }
+        rxRing_write(&_buffer[_readOffset], first);
+        rxRing_write(&_buffer[0], pending - first);
+        _readOffset = (_readOffset + pending) & UART_RX_DMA_MASK;
+        _wakeCount++;
+    }
+    CyExitCriticalSection(interruptState);
+    return (pending > 0u);
+}
@@ -0,0 +1,51 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef UART_RX_DMA_H
+    #define UART_RX_DMA_H
+
+    #include <cytypes.h>
+    #include "CyDmac.h"
+
+    // UART_1 receive without an interrupt per byte. A CyDmac channel moves every
+    // received byte into a circular buffer made of two TDs, each covering half
+    // of it and chained to the other, so the channel never stops. The CPU only
+    // hears about it when:
+    //  - a half fills up (TD termout -> nrq -> uartRxDma_isr()), and
+    //  - the line has gone idle, seen by uartRxDma_poll() when no byte came in
+    //    since the previous call and UART_RX_DMA_IDLE_TICKS have gone by. Call
+    //    it from the SysTimers tick or a main loop that runs at least as often.
+    // Either one hands the new bytes to the isr_rx_helper.c receive ring, where
+    // the parser picks them up.
+    //
+    // Hardware: the channel's DRQ must come from UART_1 rx_interrupt configured
+    // for UART_1_RX_STS_FIFO_NOTEMPTY, the channel nrq must be wired to an isr
+    // calling uartRxDma_isr(), and isr_rx must not be started.
+
+    #ifndef UART_RX_DMA_BUFFER_BYTES
+        #define UART_RX_DMA_BUFFER_BYTES 512u // power of two, at most 8190 (two 12 bit TDs)
+    #endif
+    #define UART_RX_DMA_HALF_BYTES       (UART_RX_DMA_BUFFER_BYTES / 2u)
+    #define UART_RX_DMA_IDLE_TICKS       2u   // SysTimers ticks (100 us) without a new byte that end a burst
+
+    #define UART_RX_DMA_OK               (uint8)0
+    #define UART_RX_DMA_ERR_NOT_READY    (uint8)3
+
+    uint8  uartRxDma_init();
+    uint8  uartRxDma_poll();
+    uint8  uartRxDma_getChannel();
+    uint32 uartRxDma_getWakeCount();
+    void   uartRxDma_resetStats();
+    CY_ISR_PROTO(uartRxDma_isr);
+#endif
@@ -0,0 +1,190 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "uart_tx_dma.h"
+#include "UART_1.h"
+#include "CyLib.h"
+
+#define UART_TX_DMA_POLL_US 10 // spin granularity of uartTxDma_waitIdle()
+
+//define private functions here
+static void _setTdAddress(uint8 td, const uint8* source);
+
+static uint8                      _channel = CY_DMA_INVALID_CHANNEL;
+static uint8                      _tds[UART_TX_DMA_NUM_TDS];
+static volatile uint8             _busy = 0;
+static volatile uartTxDmaCallback _onComplete;
+static void* volatile             _context;
+
+uint8 uartTxDma_init()
+{
+    uint8 tdCounter;
+
+    if( _channel != CY_DMA_INVALID_CHANNEL )
+    {
+        return UART_TX_DMA_OK; //already initialized
+    }
+
+    _channel = CyDmaChAlloc();
+    if( _channel == CY_DMA_INVALID_CHANNEL )
+    {
+        return UART_TX_DMA_ERR_NOT_READY;
+    }
+
+    for(tdCounter = 0; tdCounter < UART_TX_DMA_NUM_TDS; tdCounter++)
+    {
+        _tds[tdCounter] = CyDmaTdAllocate();
+        if( _tds[tdCounter] == CY_DMA_INVALID_TD )
+        {
+            return UART_TX_DMA_ERR_NOT_READY;
+        }
+    }
+
+    //one byte per request: a request means "TX FIFO has room for one more byte"
+    CyDmaChSetConfiguration(_channel, UART_TX_DMA_BYTES_PER_BURST, UART_TX_DMA_REQUEST_PER_BURST, 0u, 0u, 0u);
+    //source is always SRAM, destination is always the UART_1 TX FIFO
+    CyDmaChSetExtendedAddress(_channel, HI16(CYDEV_SRAM_BASE), HI16(CYDEV_PERIPH_BASE));
+    UART_1_SetTxInterruptMode(UART_1_TX_STS_FIFO_NOT_FULL);
+
+    return UART_TX_DMA_OK;
+}
+
+uint8 uartTxDma_send(const uartTxDmaSegment* segments, uint8 numSegments, uartTxDmaCallback onComplete, void* context)
+{
+    uint8  segmentCounter;
+    uint8  numTds = 0;
+    uint8  tdCounter = 0;
+    uint16 offset;
+    uint16 chunk;
+    uint8  config;
+    uint8  nextTd;
+    uint8  interruptState;
+
+    if( _channel == CY_DMA_INVALID_CHANNEL )
+    {
+        return UART_TX_DMA_ERR_NOT_READY;
+    }
+    if( numSegments > UART_TX_DMA_MAX_SEGMENTS )
+    {
+        return UART_TX_DMA_ERR_TOO_LONG;
+    }
+
+    //count descriptors needed, long segments are split into several TDs
+    for(segmentCounter = 0; segmentCounter < numSegments; segmentCounter++)
+    {
+        numTds += (uint8)((segments[segmentCounter].numBytes + UART_TX_DMA_MAX_TD_BYTES - 1u) / UART_TX_DMA_MAX_TD_BYTES);
+        if( numTds > UART_TX_DMA_NUM_TDS )
+        {
+            return UART_TX_DMA_ERR_TOO_LONG;
+        }
+    }
+
+    //Safe from any context: the busy test, the chain and the start are one
+    //critical section, so a preempting sender cannot program the TDs as well
+    interruptState = CyEnterCriticalSection();
+    if( _busy )
+    {
+        CyExitCriticalSection(interruptState);
+        return UART_TX_DMA_ERR_BUSY;
+    }
+    if( numTds == 0 )
+    {
+        //nothing to put on the wire, complete right away
+        CyExitCriticalSection(interruptState);
+        if( onComplete != NULL )
+        {
+            onComplete(context);
+        }
+        return UART_TX_DMA_OK;
+    }
+
+    //build the chain: TD[n] -> TD[n+1] -> ... -> last TD disables the channel
+    for(segmentCounter = 0; segmentCounter < numSegments; segmentCounter++)
+    {
+        for(offset = 0; offset < segments[segmentCounter].numBytes; offset += chunk)
+        {
+            chunk = segments[segmentCounter].numBytes - offset;
+            if( chunk > UART_TX_DMA_MAX_TD_BYTES )
+            {
+                chunk = UART_TX_DMA_MAX_TD_BYTES;
+            }
+
+            config = CY_DMA_TD_INC_SRC_ADR;
+            if( tdCounter == (numTds - 1u) )
+            {
+                nextTd  = CY_DMA_DISABLE_TD;
+                config |= CY_DMA_TD_TERMOUT0_EN; //raise nrq once the last byte is in the FIFO
+            }
+            else
+            {
+                nextTd = _tds[tdCounter + 1u];
+            }
+
+            CyDmaTdSetConfiguration(_tds[tdCounter], chunk, nextTd, config);
+            _setTdAddress(_tds[tdCounter], segments[segmentCounter].data + offset);
+            tdCounter++;
+        }
+    }
+
+    _onComplete = onComplete;
+    _context    = context;
+    _busy       = 1;
+
+    CyDmaChSetInitialTd(_channel, _tds[0]);
+    CyDmaChEnable(_channel, 0u);
+    CyExitCriticalSection(interruptState);
+    return UART_TX_DMA_OK;
+}
+
+uint8 uartTxDma_isBusy()
+{
+    return _busy;
+}
+
+void uartTxDma_waitIdle()
+{
+    while( _busy )
+    {
+        CyDelayUs(UART_TX_DMA_POLL_US);
+    }
+}
+
+uint8 uartTxDma_getChannel()
+{
+    return _channel;
+}
+
+CY_ISR(uartTxDma_isr)
+{
+    uartTxDmaCallback onComplete = _onComplete;
+    void* context = _context;
+
+    //clear busy first so the callback may start the next transfer
+    _onComplete = NULL;
+    _busy = 0;
+
+    if( onComplete != NULL )
+    {
+        onComplete(context);
+    }
+}
+
+static void _setTdAddress(uint8 td, const uint8* source)
+{
+#if defined(CY_DMA_MOCK)
+    CyDmaMock_TdSetPointers(td, source, UART_1_TXDATA_PTR);
+#else
+    CyDmaTdSetAddress(td, LO16((uint32)source), LO16((uint32)UART_1_TXDATA_PTR));
+#endif
+}
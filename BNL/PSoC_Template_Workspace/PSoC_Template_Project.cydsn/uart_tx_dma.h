@@ -0,0 +1,56 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef UART_TX_DMA_H
+    #define UART_TX_DMA_H
+
+    #include <cytypes.h>
+    #include "CyDmac.h"
+
+    // Non-blocking UART_1 transmit engine. A packet is handed over as a list of
+    // segments (header, payload, tail, ...), each segment becomes one or more
+    // chained transfer descriptors pointing straight at the caller's memory, so
+    // nothing is copied. The caller must keep every segment valid until the
+    // completion callback runs (or uartTxDma_isBusy() returns 0).
+    //
+    // Hardware: the channel's DRQ must come from UART_1 tx_interrupt configured
+    // for UART_1_TX_STS_FIFO_NOT_FULL, so one byte moves per free FIFO slot, and
+    // the channel nrq must be wired to an isr calling uartTxDma_isr().
+
+    #define UART_TX_DMA_MAX_SEGMENTS      (uint8)6
+    #define UART_TX_DMA_NUM_TDS           (uint8)8     // TDs owned by the engine
+    #define UART_TX_DMA_MAX_TD_BYTES      (uint16)4095 // PSoC5 TD transfer count is 12 bits
+    #define UART_TX_DMA_BYTES_PER_BURST   (uint8)1
+    #define UART_TX_DMA_REQUEST_PER_BURST (uint8)1
+
+    #define UART_TX_DMA_OK                (uint8)0
+    #define UART_TX_DMA_ERR_BUSY          (uint8)1
+    #define UART_TX_DMA_ERR_TOO_LONG      (uint8)2
+    #define UART_TX_DMA_ERR_NOT_READY     (uint8)3
+
+    typedef void (*uartTxDmaCallback)(void* context);
+
+    typedef struct
+    {
+        const uint8* data;
+        uint16       numBytes;
+    } uartTxDmaSegment;
+
+    uint8 uartTxDma_init();
+    uint8 uartTxDma_send(const uartTxDmaSegment* segments, uint8 numSegments, uartTxDmaCallback onComplete, void* context);
+    uint8 uartTxDma_isBusy();
+    void  uartTxDma_waitIdle();
+    uint8 uartTxDma_getChannel();
+    CY_ISR_PROTO(uartTxDma_isr);
+#endif
@@ -0,0 +1,273 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#include "uart_tx_ring.h"
+#include "knobs.h"
+#include "UART_1.h"
+#include "CyLib.h"
+#include "packet_queue.h"
+
+#include <string.h>
+
+#define UART_TX_RING_MASK    (UART_TX_RING_BYTES - 1u)
+#define UART_TX_RING_POLL_US 10 // spin granularity of the blocking calls
+
+#if (UART_TX_RING_BYTES & UART_TX_RING_MASK)
+    #error "UART_TX_RING_BYTES must be a power of two"
+#endif
+
+// _head and _tail are free running, used bytes = _head - _tail. Writers move
+// _head inside a critical section (ISRs produce packets too), only the TX
+// interrupt moves _tail. _streaming is set while uartTxRing_writeBlocking()
+// copies a packet longer than the ring in pieces; packetQueue_drain() leaves
+// the ring alone meanwhile so nothing lands between two pieces.
+
+//define private functions here
+static void _copyIn(uint16 head, const uint8* data, uint16 numBytes);
+static uint8 _writeLocked(const uartTxDmaSegment* segments, uint8 numSegments, uint16 numBytes);
+
+static uint8            _ring[UART_TX_RING_BYTES];
+static volatile uint16  _head;
+static volatile uint16  _tail;
+static volatile uint16  _highWater;
+static volatile uint32  _overflowCount;
+static volatile uint8   _streaming;
+
+void uartTxRing_init()
+{
+    UART_1_SetTxInterruptMode(0u); //unmasked by the first write
+    _head = 0;
+    _tail = 0;
+    _streaming = 0;
+    uartTxRing_resetStats();
+}
+
+uint8 uartTxRing_write(const uint8* data, uint16 numBytes)
+{
+    uartTxDmaSegment segment;
+
+    segment.data     = data;
+    segment.numBytes = numBytes;
+    return uartTxRing_writeSegments(&segment, 1);
+}
+
+uint8 uartTxRing_writeSegments(const uartTxDmaSegment* segments, uint8 numSegments)
+{
+    //Safe from any context. Copies every segment or nothing, a full ring is
+    //counted as an overflow and left to the caller to retry or drop.
+    uint32 numBytes = 0;
+    uint8  segmentCounter;
+    uint8  status;
+
+    for(segmentCounter = 0; segmentCounter < numSegments; segmentCounter++)
+    {
+        numBytes += segments[segmentCounter].numBytes;
+    }
+    if( numBytes > UART_TX_RING_BYTES )
+    {
+        return UART_TX_RING_ERR_TOO_LONG;
+    }
+    status = _writeLocked(segments, numSegments, (uint16)numBytes);
+    if( status == UART_TX_RING_ERR_FULL )
+    {
+        __sync_fetch_and_add(&_overflowCount, 1u);
+    }
+    return status;
+}
+
+void uartTxRing_writeBlocking(const uartTxDmaSegment* segments, uint8 numSegments)
+{
+    //Main loop only: spins while the ring is full. Anything longer than the
+    //ring is streamed in pieces as room frees up, with packets queued from
+    //ISRs held back in the packet queue until the last piece is in.
+    uartTxDmaSegment piece;
+    uint8  segmentCounter;
+    uint8  waited = 0;
+    uint8  status;
+    uint16 offset;
+    uint16 room;
+
+    status = uartTxRing_writeSegments(segments, numSegments);
+    if( status == UART_TX_RING_OK )
+    {
+        return;
+    }
+    if( status == UART_TX_RING_ERR_FULL )
+    {
+        //fits: wait for room and write it in one go (counted once as an overflow)
+        while( _writeLocked(segments, numSegments, 0) == UART_TX_RING_ERR_FULL )
+        {
+            CyDelayUs(UART_TX_RING_POLL_US);
+        }
+        return;
+    }
+    _streaming = 1;
+    for(segmentCounter = 0; segmentCounter < numSegments; segmentCounter++)
+    {
+        for(offset = 0; offset < segments[segmentCounter].numBytes; offset += piece.numBytes)
+        {
+            while( (room = uartTxRing_getFree()) == 0 )
+            {
+                waited = 1;
+                CyDelayUs(UART_TX_RING_POLL_US);
+            }
+            piece.data     = segments[segmentCounter].data + offset;
+            piece.numBytes = segments[segmentCounter].numBytes - offset;
+            if( piece.numBytes > room )
+            {
+                piece.numBytes = room;
+            }
+            _writeLocked(&piece, 1, piece.numBytes);
+        }
+    }
+    _streaming = 0;
+    packetQueue_drain(); //whatever ISRs queued in the meantime
+    if( waited )
+    {
+        __sync_fetch_and_add(&_overflowCount, 1u);
+    }
+}
+
+uint8 uartTxRing_isStreaming()
+{
+    return _streaming;
+}
+
+uint16 uartTxRing_getFree()
+{
+    return UART_TX_RING_BYTES - uartTxRing_getUsed();
+}
+
+uint16 uartTxRing_getUsed()
+{
+    return (uint16)(_head - _tail);
+}
+
+uint16 uartTxRing_takeHighWater()
+{
+    //highest occupancy since the last call, restarts from what is in the ring now
+    uint8  interruptState = CyEnterCriticalSection();
+    uint16 highWater = _highWater;
+
+    _highWater = uartTxRing_getUsed();
+    CyExitCriticalSection(interruptState);
+    return highWater;
+}
+
+uint32 uartTxRing_getOverflowCount()
+{
+    return _overflowCount;
+}
+
+void uartTxRing_countOverflow()
+{
+    //for writers that check uartTxRing_getFree() first and wait instead of writing
+    __sync_fetch_and_add(&_overflowCount, 1u);
+}
+
+void uartTxRing_resetStats()
+{
+    _highWater     = 0;
+    _overflowCount = 0;
+}
+
+uint8 uartTxRing_isIdle()
+{
+    //ring drained; up to UART_1_TX_BUFFER_SIZE bytes may still be in the FIFO
+    return _head == _tail;
+}
+
+void uartTxRing_waitIdle()
+{
+    while( !uartTxRing_isIdle() )
+    {
+        CyDelayUs(UART_TX_RING_POLL_US);
+    }
+}
+
+CY_ISR(uartTxRing_isr)
+{
+    uint16 tail = _tail;
+
+    while( (tail != _head) && (UART_1_ReadTxStatus() & UART_1_TX_STS_FIFO_NOT_FULL) )
+    {
+        UART_1_WriteTxData( _ring[tail & UART_TX_RING_MASK] );
+        tail++;
+    }
+    _tail = tail;
+    if( tail == _head )
+    {
+        //FIFO_NOT_FULL is a level: left unmasked it would fire forever
+        UART_1_SetTxInterruptMode(0u);
+        packetQueue_drain(); //packets that found the ring full
+    }
+}
+
+static uint8 _writeLocked(const uartTxDmaSegment* segments, uint8 numSegments, uint16 numBytes)
+{
+    //numBytes 0: sum it here. Space check, copy and publish are one critical
+    //section so a preempting writer cannot split the packet.
+    uint8  interruptState;
+    uint8  segmentCounter;
+    uint16 head;
+    uint16 used;
+
+    if( numBytes == 0 )
+    {
+        for(segmentCounter = 0; segmentCounter < numSegments; segmentCounter++)
+        {
+            numBytes += segments[segmentCounter].numBytes;
+        }
+    }
+
+    interruptState = CyEnterCriticalSection();
+    head = _head;
+    used = (uint16)(head - _tail);
+    if( numBytes > (uint16)(UART_TX_RING_BYTES - used) )
+    {
+        CyExitCriticalSection(interruptState);
+        return UART_TX_RING_ERR_FULL;
+    }
+    for(segmentCounter = 0; segmentCounter < numSegments; segmentCounter++)
+    {
+        _copyIn(head, segments[segmentCounter].data, segments[segmentCounter].numBytes);
+        head += segments[segmentCounter].numBytes;
+    }
+    _head = head;
+    used += numBytes;
+    if( used > _highWater )
+    {
+        _highWater = used;
+    }
+    if( numBytes > 0 )
+    {
+        UART_1_SetTxInterruptMode(UART_1_TX_STS_FIFO_NOT_FULL);
+    }
+    CyExitCriticalSection(interruptState);
+    return UART_TX_RING_OK;
+}
+
+static void _copyIn(uint16 head, const uint8* data, uint16 numBytes)
+{
+    //at most two memcpy: up to the end of the buffer, then from the start
+    uint16 offset = head & UART_TX_RING_MASK;
+    uint16 first  = UART_TX_RING_BYTES - offset;
+
+    if( first > numBytes )
+    {
+        first = numBytes;
+    }
+    memcpy(&_ring[offset], data, first);
+    memcpy(&_ring[0], data + first, numBytes - first);
+}
@@ -0,0 +1,56 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+/* [] END OF FILE */
+
+#ifndef UART_TX_RING_H
+    #define UART_TX_RING_H
+
+    #include <cytypes.h>
+    #include "uart_tx_dma.h"
+
+    // Interrupt driven UART_1 transmit. UART_1 is generated with a 4 byte TX
+    // FIFO, so UART_1_PutChar spins as soon as a packet is longer than that.
+    // Writers copy whole packets into a software ring instead and return at
+    // once; uartTxRing_isr() moves bytes from the ring into the FIFO whenever
+    // it has room. A write is all or nothing, so packets from an ISR and from
+    // the main loop never interleave on the wire. The one exception,
+    // uartTxRing_writeBlocking() of a packet longer than the ring, goes in
+    // pieces while uartTxRing_isStreaming(), and the packet queue holds its
+    // packets back until it is done.
+    //
+    // Hardware: an isr on UART_1 tx_interrupt calling uartTxRing_isr(). The
+    // FIFO_NOT_FULL source is only unmasked while the ring holds data.
+
+    #ifndef UART_TX_RING_BYTES
+        #define UART_TX_RING_BYTES    2048u // power of two, at most 32768
+    #endif
+
+    #define UART_TX_RING_OK           (uint8)0
+    #define UART_TX_RING_ERR_FULL     (uint8)1 // nothing written, try again once the ISR made room
+    #define UART_TX_RING_ERR_TOO_LONG (uint8)2 // longer than the whole ring
+
+    void   uartTxRing_init();
+    uint8  uartTxRing_write(const uint8* data, uint16 numBytes);
+    uint8  uartTxRing_writeSegments(const uartTxDmaSegment* segments, uint8 numSegments);
+    void   uartTxRing_writeBlocking(const uartTxDmaSegment* segments, uint8 numSegments);
+    uint8  uartTxRing_isStreaming();
+    uint16 uartTxRing_getFree();
+    uint16 uartTxRing_getUsed();
+    uint16 uartTxRing_takeHighWater();
+    uint32 uartTxRing_getOverflowCount();
+    void   uartTxRing_countOverflow();
+    void   uartTxRing_resetStats();
+    uint8  uartTxRing_isIdle();
+    void   uartTxRing_waitIdle();
+    CY_ISR_PROTO(uartTxRing_isr);
+#endif
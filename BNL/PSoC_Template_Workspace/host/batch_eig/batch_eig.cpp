@@ -0,0 +1,210 @@
+/*******************************************************************************
+* File Name: batch_eig.cpp
+*
+* Description:
+*  batch_eig_decomp(): picks the kernel for the ISA, cuts the batch into
+*  chunks of one matrix per lane and hands each thread a contiguous run of
+*  chunks. The kernels share nothing but the read-only job.
+*
+*******************************************************************************/
+#include "batch_eig.h"
+#include "batch_eig_internal.h"
+
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    /* one thread's run of chunks; done once the kernel had its workspace */
+    struct Share
+    {
+        size_t first;
+        size_t end;
+        bool   done;
+    };
+
+    void runShare(batch_eig_detail::RunChunks run, const batch_eig_detail::Job * job, Share * share)
+    {
+        share->done = run(*job, share->first, share->end);
+    }
+
+    int cpuHas(batch_eig_isa isa)
+    {
+        switch(isa)
+        {
+        case BATCH_EIG_ISA_SCALAR:
+            return 1;
+#if defined(BATCH_EIG_HAVE_AVX2)
+        case BATCH_EIG_ISA_AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#if defined(BATCH_EIG_HAVE_AVX512)
+        case BATCH_EIG_ISA_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return 0;
+        }
+    }
+
+    batch_eig_isa resolve(batch_eig_isa isa)
+    {
+        if(BATCH_EIG_ISA_AUTO != isa)
+        {
+            return isa;
+        }
+        if(cpuHas(BATCH_EIG_ISA_AVX512))
+        {
+            return BATCH_EIG_ISA_AVX512;
+        }
+        if(cpuHas(BATCH_EIG_ISA_AVX2))
+        {
+            return BATCH_EIG_ISA_AVX2;
+        }
+        return BATCH_EIG_ISA_SCALAR;
+    }
+
+    batch_eig_detail::RunChunks kernel(batch_eig_isa isa)
+    {
+        switch(isa)
+        {
+#if defined(BATCH_EIG_HAVE_AVX2)
+        case BATCH_EIG_ISA_AVX2:
+            return batch_eig_detail::runAvx2;
+#endif
+#if defined(BATCH_EIG_HAVE_AVX512)
+        case BATCH_EIG_ISA_AVX512:
+            return batch_eig_detail::runAvx512;
+#endif
+        default:
+            return batch_eig_detail::runScalar;
+        }
+    }
+}
+
+int batch_eig_isa_supported(batch_eig_isa isa)
+{
+    return cpuHas(resolve(isa));
+}
+
+unsigned batch_eig_lanes(batch_eig_isa isa)
+{
+    switch(resolve(isa))
+    {
+    case BATCH_EIG_ISA_AVX2:    return 8u;
+    case BATCH_EIG_ISA_AVX512:  return 16u;
+    default:                    return 1u;
+    }
+}
+
+const char * batch_eig_isa_name(batch_eig_isa isa)
+{
+    switch(isa)
+    {
+    case BATCH_EIG_ISA_AUTO:    return "auto";
+    case BATCH_EIG_ISA_SCALAR:  return "scalar";
+    case BATCH_EIG_ISA_AVX2:    return "avx2";
+    case BATCH_EIG_ISA_AVX512:  return "avx512";
+    default:                    return "unknown";
+    }
+}
+
+int batch_eig_decomp(const float * sigma, float * lambda, float * phi,
+                     size_t count, size_t stride,
+                     const float Eig_vecs_init[BATCH_EIG_COMPONENTS][BATCH_EIG_MAT_SIZE],
+                     unsigned p_iter, unsigned r_iter,
+                     unsigned threads, batch_eig_isa isa)
+{
+    batch_eig_detail::Job job;
+    batch_eig_detail::RunChunks run;
+    std::vector<std::thread> workers;
+    std::vector<Share> shares;
+    size_t chunks;
+    unsigned lanes;
+    unsigned t;
+
+    if((NULL == sigma) || (NULL == lambda) || (NULL == phi) || (NULL == Eig_vecs_init) ||
+       (stride < count) || (0u == p_iter + r_iter))
+    {
+        return BATCH_EIG_ERR_ARGS;
+    }
+    isa = resolve(isa);
+    if(!cpuHas(isa))
+    {
+        return BATCH_EIG_ERR_ISA;
+    }
+    run = kernel(isa);
+    lanes = batch_eig_lanes(isa);
+
+    job.sigma  = sigma;
+    job.lambda = lambda;
+    job.phi    = phi;
+    job.count  = count;
+    job.stride = stride;
+    job.init   = Eig_vecs_init;
+    job.p_iter = p_iter;
+    job.r_iter = r_iter;
+
+    chunks = (count + lanes - 1u) / lanes;
+    if(0u == threads)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    if(threads > chunks)
+    {
+        threads = (unsigned)chunks;
+    }
+    if(threads <= 1u)
+    {
+        return run(job, 0u, chunks) ? isa : BATCH_EIG_ERR_RESOURCES;
+    }
+    try
+    {
+        shares.resize(threads);
+        workers.reserve(threads - 1u);
+    }
+    catch(const std::bad_alloc &)
+    {
+        return run(job, 0u, chunks) ? isa : BATCH_EIG_ERR_RESOURCES;
+    }
+    for(t = 0u; t < threads; t++)
+    {
+        shares[t].first = chunks * t / threads;
+        shares[t].end   = chunks * (t + 1u) / threads;
+        shares[t].done  = false;
+    }
+    /* nothing may throw past a started worker, its std::thread would
+       terminate the process; a thread that cannot be started leaves its
+       share, and those after it, to the retry below */
+    try
+    {
+        for(t = 1u; t < threads; t++)
+        {
+            workers.push_back(std::thread(runShare, run, &job, &shares[t]));
+        }
+    }
+    catch(const std::system_error &)
+    {
+    }
+    catch(const std::bad_alloc &)
+    {
+    }
+    runShare(run, &job, &shares[0]);
+    for(t = 0u; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+    for(t = 0u; t < threads; t++)
+    {
+        if(!shares[t].done && !run(job, shares[t].first, shares[t].end))
+        {
+            return BATCH_EIG_ERR_RESOURCES;
+        }
+    }
+    return isa;
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,67 @@
+/*******************************************************************************
+* File Name: batch_eig.h
+*
+* Description:
+*  Offline PCA of many covariance matrices at once: eig_decomp()'s power and
+*  Rayleigh iterations with Hotelling deflation (the eig_decomp_packed()
+*  variant, unpivoted U'DU solves), run across SIMD lanes, one matrix per
+*  lane, and across threads. Host only, for captured data; the firmware keeps
+*  eig.c.
+*
+*  Structure of arrays, matrix m of a batch of count, stride >= count:
+*
+*    sigma   element (i, j) at sigma[(i * BATCH_EIG_MAT_SIZE + j) * stride + m],
+*            only i <= j is read
+*    lambda  component k at lambda[k * stride + m]
+*    phi     element j of component k at
+*            phi[(k * BATCH_EIG_MAT_SIZE + j) * stride + m]
+*
+*  i.e. C-contiguous float32 NumPy arrays of shape (32, 32, stride),
+*  (4, stride) and (4, 32, stride).
+*
+*******************************************************************************/
+#if !defined(BATCH_EIG_H)
+#define BATCH_EIG_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BATCH_EIG_MAT_SIZE      32      /* MAT_SIZE of eig.h */
+#define BATCH_EIG_COMPONENTS    4       /* PRINCIPLE_COMPONENTS of eig.h */
+
+typedef enum
+{
+    BATCH_EIG_ISA_AUTO = 0,             /* widest one this CPU runs */
+    BATCH_EIG_ISA_SCALAR,               /* 1 lane, any CPU */
+    BATCH_EIG_ISA_AVX2,                 /* 8 lanes, AVX2 + FMA */
+    BATCH_EIG_ISA_AVX512                /* 16 lanes, AVX-512F */
+} batch_eig_isa;
+
+/* batch_eig_decomp() errors, the ISA used otherwise */
+#define BATCH_EIG_ERR_ARGS      (-1)    /* null pointer, stride < count, p_iter + r_iter == 0 */
+#define BATCH_EIG_ERR_ISA       (-2)    /* not built in, or not on this CPU */
+#define BATCH_EIG_ERR_RESOURCES (-3)    /* no memory for a workspace, results incomplete */
+
+/* Eig_vecs_init is shared by the whole batch, as the firmware uses one set.
+   threads 0 means one per core; the calling thread takes over the share of
+   any thread that cannot be started. Returns the batch_eig_isa that ran. */
+int batch_eig_decomp(const float * sigma, float * lambda, float * phi,
+                     size_t count, size_t stride,
+                     const float Eig_vecs_init[BATCH_EIG_COMPONENTS][BATCH_EIG_MAT_SIZE],
+                     unsigned p_iter, unsigned r_iter,
+                     unsigned threads, batch_eig_isa isa);
+int batch_eig_isa_supported(batch_eig_isa isa);
+unsigned batch_eig_lanes(batch_eig_isa isa);
+const char * batch_eig_isa_name(batch_eig_isa isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATCH_EIG_H */
+
+
+/* [] END OF FILE */
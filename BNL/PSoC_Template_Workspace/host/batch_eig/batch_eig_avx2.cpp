@@ -0,0 +1,49 @@
+/*******************************************************************************
+* File Name: batch_eig_avx2.cpp
+*
+* Description:
+*  Eight lanes in a __m256. Built with -mavx2 -mfma and only called after
+*  batch_eig.cpp has checked the CPU.
+*
+*******************************************************************************/
+#include "batch_eig_kernel.h"
+
+#include <immintrin.h>
+
+namespace
+{
+    struct Lanes
+    {
+        static const unsigned width = 8;
+        __m256 v;
+
+        static Lanes make(__m256 x)         { Lanes r; r.v = x; return r; }
+        static Lanes set1(float x)          { return make(_mm256_set1_ps(x)); }
+        static Lanes load(const float * p)  { return make(_mm256_loadu_ps(p)); }
+        void store(float * p) const         { _mm256_storeu_ps(p, v); }
+    };
+    struct Mask
+    {
+        __m256 m;
+    };
+
+    inline Lanes operator+(Lanes a, Lanes b)        { return Lanes::make(_mm256_add_ps(a.v, b.v)); }
+    inline Lanes operator-(Lanes a, Lanes b)        { return Lanes::make(_mm256_sub_ps(a.v, b.v)); }
+    inline Lanes operator*(Lanes a, Lanes b)        { return Lanes::make(_mm256_mul_ps(a.v, b.v)); }
+    inline Lanes operator/(Lanes a, Lanes b)        { return Lanes::make(_mm256_div_ps(a.v, b.v)); }
+    inline Lanes fmadd(Lanes a, Lanes b, Lanes c)   { return Lanes::make(_mm256_fmadd_ps(a.v, b.v, c.v)); }
+    inline Lanes sqrtLanes(Lanes a)                 { return Lanes::make(_mm256_sqrt_ps(a.v)); }
+    inline Lanes absLanes(Lanes a)                  { return Lanes::make(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+    inline Lanes maxLanes(Lanes a, Lanes b)         { return Lanes::make(_mm256_max_ps(a.v, b.v)); }
+    inline Mask less(Lanes a, Lanes b)              { Mask r; r.m = _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); return r; }
+    inline Mask greater(Lanes a, Lanes b)           { Mask r; r.m = _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); return r; }
+    inline Lanes select(Mask m, Lanes a, Lanes b)   { return Lanes::make(_mm256_blendv_ps(b.v, a.v, m.m)); }
+}
+
+bool batch_eig_detail::runAvx2(const Job & job, size_t firstChunk, size_t endChunk)
+{
+    return runChunks<Lanes>(job, firstChunk, endChunk);
+}
+
+
+/* [] END OF FILE */
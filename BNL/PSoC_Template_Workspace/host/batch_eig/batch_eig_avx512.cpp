@@ -0,0 +1,46 @@
+/*******************************************************************************
+* File Name: batch_eig_avx512.cpp
+*
+* Description:
+*  Sixteen lanes in a __m512, selects on __mmask16. Built with -mavx512f and
+*  only called after batch_eig.cpp has checked the CPU.
+*
+*******************************************************************************/
+#include "batch_eig_kernel.h"
+
+#include <immintrin.h>
+
+namespace
+{
+    struct Lanes
+    {
+        static const unsigned width = 16;
+        __m512 v;
+
+        static Lanes make(__m512 x)         { Lanes r; r.v = x; return r; }
+        static Lanes set1(float x)          { return make(_mm512_set1_ps(x)); }
+        static Lanes load(const float * p)  { return make(_mm512_loadu_ps(p)); }
+        void store(float * p) const         { _mm512_storeu_ps(p, v); }
+    };
+    typedef __mmask16 Mask;
+
+    inline Lanes operator+(Lanes a, Lanes b)        { return Lanes::make(_mm512_add_ps(a.v, b.v)); }
+    inline Lanes operator-(Lanes a, Lanes b)        { return Lanes::make(_mm512_sub_ps(a.v, b.v)); }
+    inline Lanes operator*(Lanes a, Lanes b)        { return Lanes::make(_mm512_mul_ps(a.v, b.v)); }
+    inline Lanes operator/(Lanes a, Lanes b)        { return Lanes::make(_mm512_div_ps(a.v, b.v)); }
+    inline Lanes fmadd(Lanes a, Lanes b, Lanes c)   { return Lanes::make(_mm512_fmadd_ps(a.v, b.v, c.v)); }
+    inline Lanes sqrtLanes(Lanes a)                 { return Lanes::make(_mm512_sqrt_ps(a.v)); }
+    inline Lanes absLanes(Lanes a)                  { return Lanes::make(_mm512_abs_ps(a.v)); }
+    inline Lanes maxLanes(Lanes a, Lanes b)         { return Lanes::make(_mm512_max_ps(a.v, b.v)); }
+    inline Mask less(Lanes a, Lanes b)              { return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ); }
+    inline Mask greater(Lanes a, Lanes b)           { return _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ); }
+    inline Lanes select(Mask m, Lanes a, Lanes b)   { return Lanes::make(_mm512_mask_blend_ps(m, b.v, a.v)); }
+}
+
+bool batch_eig_detail::runAvx512(const Job & job, size_t firstChunk, size_t endChunk)
+{
+    return runChunks<Lanes>(job, firstChunk, endChunk);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,42 @@
+/*******************************************************************************
+* File Name: batch_eig_internal.h
+*
+* Description:
+*  What batch_eig.cpp hands each ISA's kernel: the job and a range of
+*  chunks, one chunk being as many matrices as the ISA has lanes.
+*
+*******************************************************************************/
+#if !defined(BATCH_EIG_INTERNAL_H)
+#define BATCH_EIG_INTERNAL_H
+
+#include "batch_eig.h"
+
+namespace batch_eig_detail
+{
+    struct Job
+    {
+        const float * sigma;
+        float *       lambda;
+        float *       phi;
+        size_t        count;
+        size_t        stride;
+        const float (*init)[BATCH_EIG_MAT_SIZE];
+        unsigned      p_iter;
+        unsigned      r_iter;
+    };
+
+    typedef bool (*RunChunks)(const Job & job, size_t firstChunk, size_t endChunk);
+
+    bool runScalar(const Job & job, size_t firstChunk, size_t endChunk);
+#if defined(BATCH_EIG_HAVE_AVX2)
+    bool runAvx2(const Job & job, size_t firstChunk, size_t endChunk);
+#endif
+#if defined(BATCH_EIG_HAVE_AVX512)
+    bool runAvx512(const Job & job, size_t firstChunk, size_t endChunk);
+#endif
+}
+
+#endif /* BATCH_EIG_INTERNAL_H */
+
+
+/* [] END OF FILE */
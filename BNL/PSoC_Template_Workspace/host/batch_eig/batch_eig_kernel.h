@@ -0,0 +1,356 @@
+/*******************************************************************************
+* File Name: batch_eig_kernel.h
+*
+* Description:
+*  eig_decomp_packed() written once over a lane type L, L::width matrices
+*  side by side. Each ISA source defines L in its own anonymous namespace
+*  with load/store/set1 members, + - * /, fmadd(), sqrtLanes(), absLanes(),
+*  maxLanes(), less(), greater() and select(), and instantiates
+*  runChunks<L>(). The control flow never depends on the data, so every
+*  lane takes the same path; where eig_packed.c branches on a value
+*  (zero norm, tiny pivot) the lanes select instead.
+*
+*******************************************************************************/
+#if !defined(BATCH_EIG_KERNEL_H)
+#define BATCH_EIG_KERNEL_H
+
+#include "batch_eig_internal.h"
+
+#include <float.h>
+#include <memory>
+#include <new>
+
+namespace batch_eig_detail
+{
+    const unsigned kSize   = BATCH_EIG_MAT_SIZE;
+    const unsigned kPacked = BATCH_EIG_MAT_SIZE * (BATCH_EIG_MAT_SIZE + 1) / 2;
+
+    /* about 70 KB with 16 lanes, stays in L2 */
+    template <class L>
+    struct Workspace
+    {
+        L a[kPacked];                               /* Sigma, deflated in place */
+        L factor[kPacked];
+        L phi[BATCH_EIG_COMPONENTS][kSize];
+        L lambda[BATCH_EIG_COMPONENTS];
+        L x[kSize];
+        L y[kSize];
+    };
+
+    /* upper triangle of matrices first..first+valid-1 into the lanes; the
+       lanes past the end of the batch repeat the last matrix */
+    template <class L>
+    void loadChunk(Workspace<L> & ws, const Job & job, size_t first, unsigned valid)
+    {
+        float lanes[L::width];
+        const float * src;
+        unsigned i, j, l, n = 0;
+
+        for(i = 0; i < kSize; i++)
+        {
+            for(j = i; j < kSize; j++, n++)
+            {
+                src = job.sigma + (i * kSize + j) * job.stride + first;
+                if(valid == L::width)
+                {
+                    ws.a[n] = L::load(src);
+                }
+                else
+                {
+                    for(l = 0; l < L::width; l++)
+                    {
+                        lanes[l] = src[(l < valid) ? l : valid - 1];
+                    }
+                    ws.a[n] = L::load(lanes);
+                }
+            }
+        }
+    }
+
+    template <class L>
+    void storeLanes(const L & value, float * dst, unsigned valid)
+    {
+        float lanes[L::width];
+        unsigned l;
+
+        if(valid == L::width)
+        {
+            value.store(dst);
+            return;
+        }
+        value.store(lanes);
+        for(l = 0; l < valid; l++)
+        {
+            dst[l] = lanes[l];
+        }
+    }
+
+    template <class L>
+    void storeChunk(const Workspace<L> & ws, const Job & job, size_t first, unsigned valid)
+    {
+        unsigned k, j;
+
+        for(k = 0; k < BATCH_EIG_COMPONENTS; k++)
+        {
+            storeLanes(ws.lambda[k], job.lambda + k * job.stride + first, valid);
+            for(j = 0; j < kSize; j++)
+            {
+                storeLanes(ws.phi[k][j], job.phi + (k * kSize + j) * job.stride + first, valid);
+            }
+        }
+    }
+
+    /* packed_matvec() */
+    template <class L>
+    void matvec(const L * a, const L * x, L * y)
+    {
+        unsigned i, j;
+        L xi, sum;
+
+        for(i = 0; i < kSize; i++)
+        {
+            y[i] = L::set1(0.0f);
+        }
+        for(i = 0; i < kSize; i++)
+        {
+            xi = x[i];
+            sum = a[0] * xi;
+            for(j = i + 1; j < kSize; j++)
+            {
+                sum = fmadd(a[j - i], x[j], sum);
+                y[j] = fmadd(a[j - i], xi, y[j]);
+            }
+            y[i] = y[i] + sum;
+            a += kSize - i;
+        }
+    }
+
+    /* packed_rayleigh_quotient() */
+    template <class L>
+    L rayleigh(const L * a, const L * x)
+    {
+        unsigned i, j;
+        L lambda = L::set1(0.0f);
+        L temp;
+
+        for(i = 0; i < kSize; i++)
+        {
+            temp = L::set1(0.0f);
+            for(j = i + 1; j < kSize; j++)
+            {
+                temp = fmadd(a[j - i], x[j], temp);
+            }
+            lambda = fmadd(fmadd(a[0], x[i], temp + temp), x[i], lambda);
+            a += kSize - i;
+        }
+        return lambda;
+    }
+
+    template <class L>
+    L norm(const L * x)
+    {
+        unsigned j;
+        L sum = L::set1(0.0f);
+
+        for(j = 0; j < kSize; j++)
+        {
+            sum = fmadd(x[j], x[j], sum);
+        }
+        return sqrtLanes(sum);
+    }
+
+    /* packed_deflation(), in place */
+    template <class L>
+    void deflate(L * a, const L * phi, const L & lambda)
+    {
+        unsigned i, j, n = 0;
+        L lambdaV;
+
+        for(i = 0; i < kSize; i++)
+        {
+            lambdaV = lambda * phi[i];
+            for(j = i; j < kSize; j++, n++)
+            {
+                a[n] = a[n] - lambdaV * phi[j];
+            }
+        }
+    }
+
+    /* packed_factor(): U' D U of a - shift I, tiny pivots clamped per lane */
+    template <class L>
+    void factorShifted(const L * a, const L & shift, L * factor)
+    {
+        unsigned i, j, k, n = 0;
+        L largest = L::set1(0.0f);
+        L tiny, pivot, invPivot, l;
+        L * rowK = factor;
+        L * rowI;
+
+        for(i = 0; i < kSize; i++)
+        {
+            for(j = i; j < kSize; j++, n++)
+            {
+                factor[n] = (i == j) ? a[n] - shift : a[n];
+                largest = maxLanes(largest, absLanes(factor[n]));
+            }
+        }
+        tiny = select(greater(largest, L::set1(0.0f)), largest * L::set1(FLT_EPSILON), L::set1(FLT_MIN));
+
+        for(k = 0; k < kSize; k++)
+        {
+            pivot = rowK[0];
+            pivot = select(less(absLanes(pivot), tiny),
+                           select(less(pivot, L::set1(0.0f)), L::set1(0.0f) - tiny, tiny),
+                           pivot);
+            rowK[0] = pivot;
+            invPivot = L::set1(1.0f) / pivot;
+            rowI = rowK + (kSize - k);
+            for(i = k + 1; i < kSize; i++)
+            {
+                l = rowK[i - k] * invPivot;
+                for(j = i; j < kSize; j++)
+                {
+                    rowI[j - i] = rowI[j - i] - l * rowK[j - k];
+                }
+                rowI += kSize - i;
+            }
+            for(j = k + 1; j < kSize; j++)
+            {
+                rowK[j - k] = rowK[j - k] * invPivot;
+            }
+            rowK += kSize - k;
+        }
+    }
+
+    /* packed_solve(), x in place */
+    template <class L>
+    void solve(const L * factor, L * x)
+    {
+        unsigned i, j, k;
+        const L * rowK = factor;
+        const L * rowI;
+        L sum;
+
+        for(k = 0; k < kSize; k++)
+        {
+            for(i = k + 1; i < kSize; i++)
+            {
+                x[i] = x[i] - rowK[i - k] * x[k];
+            }
+            x[k] = x[k] / rowK[0];
+            rowK += kSize - k;
+        }
+        for(i = kSize; i-- > 0; )
+        {
+            rowI = factor + (i * kSize - (i * (i - 1)) / 2);
+            sum = x[i];
+            for(j = i + 1; j < kSize; j++)
+            {
+                sum = sum - rowI[j - i] * x[j];
+            }
+            x[i] = sum;
+        }
+    }
+
+    /* packed_power_iteration(): phi stays put in lanes where A phi is 0 */
+    template <class L>
+    void powerIteration(Workspace<L> & ws, unsigned k, unsigned p_iter)
+    {
+        unsigned it, j;
+        L n, keep;
+
+        for(it = 0; it < p_iter; it++)
+        {
+            matvec(ws.a, ws.phi[k], ws.y);
+            n = norm(ws.y);
+            keep = select(greater(n, L::set1(0.0f)), n, L::set1(1.0f));
+            for(j = 0; j < kSize; j++)
+            {
+                ws.phi[k][j] = select(greater(n, L::set1(0.0f)), ws.y[j] / keep, ws.phi[k][j]);
+            }
+        }
+    }
+
+    /* packed_rayleigh_quotient_iteration(), starting from ws.phi[k] */
+    template <class L>
+    void rayleighIteration(Workspace<L> & ws, unsigned k, unsigned r_iter)
+    {
+        unsigned it, j;
+        L n;
+
+        ws.lambda[k] = rayleigh(ws.a, ws.phi[k]);
+        for(it = 0; it < r_iter; it++)
+        {
+            factorShifted(ws.a, ws.lambda[k], ws.factor);
+            for(j = 0; j < kSize; j++)
+            {
+                ws.x[j] = ws.phi[k][j];
+            }
+            solve(ws.factor, ws.x);
+            n = norm(ws.x);
+            for(j = 0; j < kSize; j++)
+            {
+                ws.phi[k][j] = ws.x[j] / n;
+            }
+            ws.lambda[k] = rayleigh(ws.a, ws.phi[k]);
+        }
+    }
+
+    /* eig_decomp_packed() on L::width matrices */
+    template <class L>
+    void decomposeChunk(Workspace<L> & ws, const Job & job)
+    {
+        unsigned k, j;
+
+        for(k = 0; k < BATCH_EIG_COMPONENTS; k++)
+        {
+            if(k > 0)
+            {
+                deflate(ws.a, ws.phi[k - 1], ws.lambda[k - 1]);
+            }
+            for(j = 0; j < kSize; j++)
+            {
+                ws.phi[k][j] = L::set1(job.init[k][j]);
+            }
+            powerIteration(ws, k, job.p_iter);
+            if(0 == job.r_iter)
+            {
+                ws.lambda[k] = rayleigh(ws.a, ws.phi[k]);
+            }
+            else
+            {
+                rayleighIteration(ws, k, job.r_iter);
+            }
+        }
+    }
+
+    /* false when the workspace cannot be allocated, nothing stored then;
+       this runs on worker threads, so nothing may throw out of it */
+    template <class L>
+    bool runChunks(const Job & job, size_t firstChunk, size_t endChunk)
+    {
+        std::unique_ptr< Workspace<L> > ws(new (std::nothrow) Workspace<L>);
+        size_t chunk, first;
+        unsigned valid;
+
+        if(!ws)
+        {
+            return false;
+        }
+
+        for(chunk = firstChunk; chunk < endChunk; chunk++)
+        {
+            first = chunk * L::width;
+            valid = (job.count - first < L::width) ? (unsigned)(job.count - first) : L::width;
+            loadChunk(*ws, job, first, valid);
+            decomposeChunk(*ws, job);
+            storeChunk(*ws, job, first, valid);
+        }
+        return true;
+    }
+}
+
+#endif /* BATCH_EIG_KERNEL_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,45 @@
+/*******************************************************************************
+* File Name: batch_eig_scalar.cpp
+*
+* Description:
+*  One lane, plain float: the fallback, and the reference the SIMD lanes are
+*  tested against.
+*
+*******************************************************************************/
+#include "batch_eig_kernel.h"
+
+#include <math.h>
+
+namespace
+{
+    struct Lanes
+    {
+        static const unsigned width = 1;
+        float v;
+
+        static Lanes set1(float x)          { Lanes r; r.v = x; return r; }
+        static Lanes load(const float * p)  { return set1(*p); }
+        void store(float * p) const         { *p = v; }
+    };
+    typedef bool Mask;
+
+    inline Lanes operator+(Lanes a, Lanes b)        { return Lanes::set1(a.v + b.v); }
+    inline Lanes operator-(Lanes a, Lanes b)        { return Lanes::set1(a.v - b.v); }
+    inline Lanes operator*(Lanes a, Lanes b)        { return Lanes::set1(a.v * b.v); }
+    inline Lanes operator/(Lanes a, Lanes b)        { return Lanes::set1(a.v / b.v); }
+    inline Lanes fmadd(Lanes a, Lanes b, Lanes c)   { return Lanes::set1(a.v * b.v + c.v); }
+    inline Lanes sqrtLanes(Lanes a)                 { return Lanes::set1(sqrtf(a.v)); }
+    inline Lanes absLanes(Lanes a)                  { return Lanes::set1(fabsf(a.v)); }
+    inline Lanes maxLanes(Lanes a, Lanes b)         { return (a.v > b.v) ? a : b; }
+    inline Mask less(Lanes a, Lanes b)              { return a.v < b.v; }
+    inline Mask greater(Lanes a, Lanes b)           { return a.v > b.v; }
+    inline Lanes select(Mask m, Lanes a, Lanes b)   { return m ? a : b; }
+}
+
+bool batch_eig_detail::runScalar(const Job & job, size_t firstChunk, size_t endChunk)
+{
+    return runChunks<Lanes>(job, firstChunk, endChunk);
+}
+
+
+/* [] END OF FILE */
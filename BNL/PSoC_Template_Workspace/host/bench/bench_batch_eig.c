@@ -0,0 +1,345 @@
+/*******************************************************************************
+* File Name: bench_batch_eig.c
+*
+* Description:
+*  Offline PCA throughput: BENCH_COUNT covariance matrices, eig_decomp(..., 10,
+*  3) as the firmware runs it, one at a time through eig.c and eig_packed.c,
+*  then as a batch through batch_eig_decomp() on each ISA on one thread and
+*  on every core. With LAPACK, ssyevr for the same 4 leading eigenpairs,
+*  which is also the reference for the accuracy columns.
+*
+*    us/matrix    wall time per matrix, best of BENCH_REPEATS runs
+*    speedup      against eig_decomp()
+*    lambda err   worst |lambda - reference| / reference
+*    1 - |cos|    worst misalignment of an eigenvector with the reference
+*    missed       matrices where a component converged to another eigenpair,
+*                 left out of the two columns before; the same ones for
+*                 every method but ssyevr, as they all iterate alike
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "eig.h"
+#include "eig_packed.h"
+#include "batch_eig.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_COUNT   4096u
+#define BENCH_REPEATS 3u
+#define BENCH_P_ITER  10u
+#define BENCH_R_ITER  3u
+
+#ifdef HAVE_LAPACK
+/* Fortran LAPACK, no header on most systems */
+extern void ssyevr_(const char * jobz, const char * range, const char * uplo, const int * n,
+                    float * a, const int * lda, const float * vl, const float * vu,
+                    const int * il, const int * iu, const float * abstol, int * m,
+                    float * w, float * z, const int * ldz, int * isuppz,
+                    float * work, const int * lwork, int * iwork, const int * liwork, int * info,
+                    size_t jobz_len, size_t range_len, size_t uplo_len);
+#endif
+
+/* batch layout, see batch_eig.h */
+static float * _sigma;
+static float * _lambda;
+static float * _phi;
+
+/* one matrix at a time */
+static float (*_lambdaOne)[PRINCIPLE_COMPONENTS];
+static float (*_phiOne)[PRINCIPLE_COMPONENTS][MAT_SIZE];
+static float (*_lambdaRef)[PRINCIPLE_COMPONENTS];
+static float (*_phiRef)[PRINCIPLE_COMPONENTS][MAT_SIZE];
+
+static float _init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+
+static uint32 _seed = 3u;
+
+static float _uniform(void)
+{
+    _seed = _seed * 1103515245u + 12345u;
+    return (float)((_seed >> 8) & 0xFFFFu) / 65536.0f;
+}
+
+/* Sigma = H diag(d) H, H a random reflection, a slightly different spectrum
+   per matrix, O(MAT_SIZE^2) each */
+static void _buildBatch(void)
+{
+    float v[MAT_SIZE], d[MAT_SIZE], hd[MAT_SIZE];
+    float norm2, vdv, value;
+    uint32 m;
+    uint8 i, j;
+
+    for(m = 0u; m < BENCH_COUNT; m++)
+    {
+        norm2 = 0.0f;
+        for(i = 0u; i < MAT_SIZE; i++)
+        {
+            v[i] = _uniform() - 0.5f;
+            norm2 += v[i] * v[i];
+            d[i] = (i < PRINCIPLE_COMPONENTS) ? (16.0f + _uniform()) / (float)(1u << i) : 0.3f * _uniform();
+        }
+        /* (H D H)_ij = D_ij - 2 v_i (Dv)_j / n - 2 (Dv)_i v_j / n + 4 v_i v_j v'Dv / n^2 */
+        vdv = 0.0f;
+        for(i = 0u; i < MAT_SIZE; i++)
+        {
+            hd[i] = d[i] * v[i];
+            vdv += v[i] * hd[i];
+        }
+        for(i = 0u; i < MAT_SIZE; i++)
+        {
+            for(j = 0u; j < MAT_SIZE; j++)
+            {
+                value = ((i == j) ? d[i] : 0.0f)
+                    - 2.0f * (v[i] * hd[j] + hd[i] * v[j]) / norm2
+                    + 4.0f * v[i] * v[j] * vdv / (norm2 * norm2);
+                _sigma[(i * MAT_SIZE + j) * BENCH_COUNT + m] = value;
+            }
+        }
+    }
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            _init[i][j] = 1.0f + 0.01f * (float)((i * 7u + j * 3u) % 11u);
+        }
+    }
+}
+
+static void _unpack(uint32 m, float Sigma[MAT_SIZE][MAT_SIZE])
+{
+    uint8 i, j;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            Sigma[i][j] = _sigma[(i * MAT_SIZE + j) * BENCH_COUNT + m];
+        }
+    }
+}
+
+/*******************************************************************************
+* Methods, each decomposes the whole batch
+*******************************************************************************/
+static float (*_sigmaOne)[MAT_SIZE][MAT_SIZE];
+static float (*_sigmaPacked)[EIG_PACKED_SIZE];
+
+static void _runEig(unsigned arg)
+{
+    uint32 m;
+
+    (void)arg;
+    for(m = 0u; m < BENCH_COUNT; m++)
+    {
+        eig_decomp(_lambdaOne[m], _phiOne[m], _sigmaOne[m], _init, BENCH_P_ITER, BENCH_R_ITER);
+    }
+}
+
+static void _runEigPacked(unsigned arg)
+{
+    static eig_workspace workspace;
+    uint32 m;
+
+    (void)arg;
+    for(m = 0u; m < BENCH_COUNT; m++)
+    {
+        eig_decomp_packed(_lambdaOne[m], _phiOne[m], _sigmaPacked[m], _init, BENCH_P_ITER, BENCH_R_ITER, &workspace);
+    }
+}
+
+/* arg: isa * 256 + threads */
+static void _runBatch(unsigned arg)
+{
+    (void)batch_eig_decomp(_sigma, _lambda, _phi, BENCH_COUNT, BENCH_COUNT, _init,
+        BENCH_P_ITER, BENCH_R_ITER, arg & 0xFFu, (batch_eig_isa)(arg >> 8));
+}
+
+#ifdef HAVE_LAPACK
+/* arg 1 keeps the results as the reference */
+static void _runLapack(unsigned arg)
+{
+    static float a[MAT_SIZE * MAT_SIZE];
+    static float z[MAT_SIZE * PRINCIPLE_COMPONENTS];
+    static float work[26 * MAT_SIZE];           /* the minimum ssyevr takes */
+    static int iwork[10 * MAT_SIZE];
+    const int n = MAT_SIZE, il = MAT_SIZE - PRINCIPLE_COMPONENTS + 1, iu = MAT_SIZE;
+    const int lwork = 26 * MAT_SIZE, liwork = 10 * MAT_SIZE;
+    const float zero = 0.0f;
+    float w[MAT_SIZE];
+    int isuppz[2 * PRINCIPLE_COMPONENTS];
+    int found, info;
+    uint32 m;
+    uint8 k, j;
+
+    for(m = 0u; m < BENCH_COUNT; m++)
+    {
+        /* overwritten by ssyevr; symmetric, so row-major is column-major */
+        memcpy(a, _sigmaOne[m], sizeof(a));
+        ssyevr_("V", "I", "U", &n, a, &n, &zero, &zero, &il, &iu, &zero, &found,
+            w, z, &n, isuppz, work, &lwork, iwork, &liwork, &info, 1, 1, 1);
+        if(0 != info || PRINCIPLE_COMPONENTS != found)
+        {
+            fprintf(stderr, "ssyevr failed on matrix %u: info %d\n", (unsigned)m, info);
+            exit(1);
+        }
+        if(arg)
+        {
+            /* ascending, the largest last */
+            for(k = 0u; k < PRINCIPLE_COMPONENTS; k++)
+            {
+                _lambdaRef[m][k] = w[PRINCIPLE_COMPONENTS - 1u - k];
+                for(j = 0u; j < MAT_SIZE; j++)
+                {
+                    _phiRef[m][k][j] = z[(PRINCIPLE_COMPONENTS - 1u - k) * MAT_SIZE + j];
+                }
+            }
+        }
+    }
+}
+#endif
+
+/*******************************************************************************
+* Accuracy against ssyevr, or against eig_decomp() without LAPACK. A fixed
+* start and 10 + 3 iterations now and then land on the wrong eigenpair (RQI
+* converges to whichever is nearest); those matrices are counted as missed
+* and kept out of the worst errors.
+*******************************************************************************/
+static uint32 _error(int batch, float * lambdaError, float * phiError)
+{
+    float lambda, c, phi, lambdaWorst, phiWorst;
+    uint32 m, missed = 0u;
+    uint8 k, j;
+
+    *lambdaError = 0.0f;
+    *phiError = 0.0f;
+    for(m = 0u; m < BENCH_COUNT; m++)
+    {
+        lambdaWorst = 0.0f;
+        phiWorst = 0.0f;
+        for(k = 0u; k < PRINCIPLE_COMPONENTS; k++)
+        {
+            lambda = batch ? _lambda[k * BENCH_COUNT + m] : _lambdaOne[m][k];
+            lambdaWorst = fmaxf(lambdaWorst, fabsf(lambda - _lambdaRef[m][k]) / _lambdaRef[m][k]);
+            c = 0.0f;
+            for(j = 0u; j < MAT_SIZE; j++)
+            {
+                phi = batch ? _phi[(k * MAT_SIZE + j) * BENCH_COUNT + m] : _phiOne[m][k][j];
+                c += phi * _phiRef[m][k][j];
+            }
+            phiWorst = fmaxf(phiWorst, 1.0f - fabsf(c));
+        }
+        if(!(lambdaWorst < 1e-2f))
+        {
+            missed++;
+            continue;
+        }
+        *lambdaError = fmaxf(*lambdaError, lambdaWorst);
+        *phiError = fmaxf(*phiError, phiWorst);
+    }
+    return missed;
+}
+
+static double _time(void (*run)(unsigned), unsigned arg)
+{
+    uint64 start, best = 0u, ns;
+    uint32 r;
+
+    for(r = 0u; r < BENCH_REPEATS; r++)
+    {
+        start = HalShim_MonotonicNs();
+        run(arg);
+        ns = HalShim_MonotonicNs() - start;
+        if(0u == r || ns < best)
+        {
+            best = ns;
+        }
+    }
+    return best / 1e3 / BENCH_COUNT;
+}
+
+/* batch: results in _lambda/_phi rather than _lambdaOne/_phiOne; reference
+   0 for the eig_decomp() row itself. Returns us/matrix. */
+static double _row(const char * name, void (*run)(unsigned), unsigned arg, int batch, double reference)
+{
+    float lambdaError, phiError;
+    double us = _time(run, arg);
+    uint32 missed = _error(batch, &lambdaError, &phiError);
+
+    printf("%-28s %10.2f %8.1fx %11.1e %11.1e %7u\n", name, us, (reference > 0.0) ? reference / us : 1.0,
+        (double)lambdaError, (double)phiError, (unsigned)missed);
+    return us;
+}
+
+int main(void)
+{
+    static const batch_eig_isa isas[] = {BATCH_EIG_ISA_SCALAR, BATCH_EIG_ISA_AVX2, BATCH_EIG_ISA_AVX512};
+    char name[40];
+    double reference, us;
+    uint32 m;
+    uint8 k;
+
+    _sigma = malloc(sizeof(float) * MAT_SIZE * MAT_SIZE * BENCH_COUNT);
+    _lambda = malloc(sizeof(float) * PRINCIPLE_COMPONENTS * BENCH_COUNT);
+    _phi = malloc(sizeof(float) * PRINCIPLE_COMPONENTS * MAT_SIZE * BENCH_COUNT);
+    _sigmaOne = malloc(sizeof(*_sigmaOne) * BENCH_COUNT);
+    _sigmaPacked = malloc(sizeof(*_sigmaPacked) * BENCH_COUNT);
+    _lambdaOne = malloc(sizeof(*_lambdaOne) * BENCH_COUNT);
+    _phiOne = malloc(sizeof(*_phiOne) * BENCH_COUNT);
+    _lambdaRef = malloc(sizeof(*_lambdaRef) * BENCH_COUNT);
+    _phiRef = malloc(sizeof(*_phiRef) * BENCH_COUNT);
+    if(!_sigma || !_lambda || !_phi || !_sigmaOne || !_sigmaPacked || !_lambdaOne || !_phiOne || !_lambdaRef || !_phiRef)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    _buildBatch();
+    for(m = 0u; m < BENCH_COUNT; m++)
+    {
+        _unpack(m, _sigmaOne[m]);
+        eig_pack(_sigmaOne[m], _sigmaPacked[m]);
+    }
+
+    printf("%u matrices of %ux%u, %u components, p_iter %u, r_iter %u\n\n", BENCH_COUNT,
+        MAT_SIZE, MAT_SIZE, PRINCIPLE_COMPONENTS, BENCH_P_ITER, BENCH_R_ITER);
+    printf("%-28s %10s %9s %11s %11s %7s\n", "method", "us/matrix", "speedup", "lambda err", "1 - |cos|", "missed");
+
+#ifdef HAVE_LAPACK
+    _runLapack(1u);
+#else
+    /* eig_decomp() is the reference */
+    _runEig(0u);
+    for(m = 0u; m < BENCH_COUNT; m++)
+    {
+        for(k = 0u; k < PRINCIPLE_COMPONENTS; k++)
+        {
+            _lambdaRef[m][k] = _lambdaOne[m][k];
+        }
+    }
+    memcpy(_phiRef, _phiOne, sizeof(*_phiRef) * BENCH_COUNT);
+#endif
+    reference = _row("eig_decomp", _runEig, 0u, 0, 0.0);
+    _row("eig_decomp_packed", _runEigPacked, 0u, 0, reference);
+#ifdef HAVE_LAPACK
+    us = _time(_runLapack, 0u);
+    printf("%-28s %10.2f %8.1fx\n", "ssyevr (LAPACK)", us, reference / us);
+#endif
+    for(k = 0u; k < sizeof(isas) / sizeof(isas[0]); k++)
+    {
+        if(batch_eig_isa_supported(isas[k]))
+        {
+            snprintf(name, sizeof(name), "batch_eig %s, 1 thread", batch_eig_isa_name(isas[k]));
+            _row(name, _runBatch, ((unsigned)isas[k] << 8) | 1u, 1, reference);
+        }
+    }
+    _row("batch_eig auto, every core", _runBatch, (unsigned)BATCH_EIG_ISA_AUTO << 8, 1, reference);
+    (void)us;
+#ifndef HAVE_LAPACK
+    printf("\nbuilt without LAPACK: errors are against eig_decomp()\n");
+#endif
+    return 0;
+}
+
+/* [] END OF FILE */
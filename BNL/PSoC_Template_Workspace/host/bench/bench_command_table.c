@@ -0,0 +1,100 @@
+/*******************************************************************************
+* File Name: bench_command_table.c
+*
+* Description:
+*  Time to push N float settings to the PSoC and have every one acknowledged:
+*  one RX_NEXT_IS_FLAG_AND_FLOAT per setting, acknowledged by handleRx's
+*  MESSAGE_FLAG_CHAR_PARSED packet as main.c does, against one
+*  RX_NEXT_IS_BATCH frame and its single COMMAND_STATUS packet. Simulated
+*  target time at 230400 baud from the first byte the host sends to the last
+*  acknowledgement byte on the wire, plus bytes each way.
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+#include "command_table.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_FLAG 200u
+
+static uint8 _setFloat(uint8 flag, const commandValue * value)
+{
+    (void)flag;
+    return (COMMAND_VALUE_FLOAT32 == value->type) ? COMMAND_OK : COMMAND_ERR_BAD_TYPE;
+}
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+    HalShim_BindUartRxIsr(rxRing_putFromUart);
+    rxRing_reset();
+    rxParser_reset();
+    commandTable_register(BENCH_FLAG, _setFloat);
+}
+
+static void _bench(uint8 numSettings)
+{
+    static uint8 bytes[1024];
+    float     value = 1.0f;
+    uint16    numBytes = 0u;
+    uint64    oneByOneNs;
+    uint32    oneByOneTx;
+    uint8     i;
+    rxCommand command;
+
+    /* one command per setting, handleRx echoes each one */
+    _setup();
+    for(i = 0u; i < numSettings; i++)
+    {
+        bytes[0] = RX_NEXT_IS_FLAG_AND_FLOAT;
+        bytes[1] = BENCH_FLAG;
+        memcpy(&bytes[2], &value, 4);
+        HalShim_ReceiveBytes(bytes, 6u);
+        rxParser_poll();
+        while(rxCommand_pop(&command))
+        {
+            constructAndSendPacket(MESSAGE_TYPE_FLAG, MESSAGE_FLAG_CHAR_PARSED, 4, &command.value);
+        }
+    }
+    packetQueue_flush();
+    oneByOneNs = HalShim_GetTimeNs();
+    oneByOneTx = HalShim_GetTxCount();
+
+    /* the same settings in one frame */
+    _setup();
+    bytes[numBytes++] = RX_NEXT_IS_BATCH;
+    numBytes += 2u;
+    bytes[numBytes++] = 1u;
+    for(i = 0u; i < numSettings; i++)
+    {
+        bytes[numBytes++] = BENCH_FLAG;
+        bytes[numBytes++] = COMMAND_VALUE_FLOAT32;
+        memcpy(&bytes[numBytes], &value, 4);
+        numBytes += 4u;
+    }
+    bytes[1] = (uint8)(numBytes - 3u);
+    bytes[2] = (uint8)((numBytes - 3u) >> 8);
+    HalShim_ReceiveBytes(bytes, numBytes);
+    rxParser_poll();
+    packetQueue_flush();
+
+    printf("%5u %10.2f %8u %8u %10.2f %8u %8u\n", (unsigned)numSettings,
+        oneByOneNs * 1e-6, (unsigned)(6u * numSettings), (unsigned)oneByOneTx,
+        HalShim_GetTimeNs() * 1e-6, (unsigned)numBytes, (unsigned)HalShim_GetTxCount());
+}
+
+int main(void)
+{
+    printf("       one by one                      batched\n");
+    printf("    N       ms   rx B     tx B         ms     rx B     tx B\n");
+    _bench(1u);
+    _bench(12u);
+    _bench(40u);
+    return 0;
+}
+
+/* [] END OF FILE */
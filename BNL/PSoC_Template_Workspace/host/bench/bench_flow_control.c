@@ -0,0 +1,75 @@
+/*******************************************************************************
+* File Name: bench_flow_control.c
+*
+* Description:
+*  Achieved packet rate through constructAndSendPacket() with the fixed
+*  UART_PACKET_DELAY_MS pacing against sending on host granted credits, for a
+*  few payload sizes and baud rates. Rates are in simulated target time with
+*  the blocking PutChar UART model, measured by the firmware's own link
+*  statistics (the same numbers MESSAGE_FLAG_LINK_STATS reports).
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "flow_control.h"
+
+#include <stdio.h>
+
+#define BENCH_WINDOW_MS  1000u
+
+static uint8 _payload[256];
+
+static void _measure(uint32 baud, uint16 payloadBytes, uint8 useCredits, float * packetsPerSec, float * bytesPerSec)
+{
+    const uint8 * stats;
+    uint64 endNs;
+
+    packetQueue_flush();
+    while(flowControl_takeCredit()) { }
+    HalShim_Reset();
+    HalShim_SetUartBaud(baud);
+    flowControl_setStatsPeriod(BENCH_WINDOW_MS);
+
+    endNs = (uint64)BENCH_WINDOW_MS * 1000000u;
+    while(HalShim_GetTimeNs() < endNs)
+    {
+        if(useCredits && flowControl_getCredits() < 16u)
+        {
+            flowControl_grant(64u); /* what LOD.py does as it consumes packets */
+        }
+        constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, payloadBytes, _payload);
+    }
+    HalShim_ClearTx();
+    flowControl_poll();
+    stats = HalShim_GetTxBytes();
+    *packetsPerSec = *(const float *)&stats[PACKET_HEAD_BYTES];
+    *bytesPerSec   = *(const float *)&stats[PACKET_HEAD_BYTES + 4u];
+    flowControl_setStatsPeriod(0u);
+}
+
+static void _benchSize(uint32 baud, uint16 payloadBytes)
+{
+    float pacedPackets;
+    float pacedBytes;
+    float creditPackets;
+    float creditBytes;
+
+    _measure(baud, payloadBytes, 0u, &pacedPackets, &pacedBytes);
+    _measure(baud, payloadBytes, 1u, &creditPackets, &creditBytes);
+    printf("%8u %8u %14.0f %14.0f %14.0f %14.0f\n", (unsigned)baud, (unsigned)payloadBytes,
+        pacedPackets, pacedBytes, creditPackets, creditBytes);
+}
+
+int main(void)
+{
+    printf("    baud  payload   paced pkt/s   paced byte/s  credit pkt/s  credit byte/s\n");
+    _benchSize(230400u, 4u);
+    _benchSize(230400u, 64u);
+    _benchSize(230400u, 256u);
+    _benchSize(921600u, 4u);
+    _benchSize(921600u, 64u);
+    _benchSize(921600u, 256u);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,72 @@
+/*******************************************************************************
+* File Name: bench_log_deferred.c
+*
+* Description:
+*  Cost of a log call as ASCII (sendLogMessage, vsnprintf into the queue slot)
+*  against deferred (LOG_MESSAGE with the dictionary loaded, raw arguments),
+*  for a few typical messages: host CPU time per call up to the committed
+*  slot, and bytes on the wire per message. Host time only ranks the two; the
+*  M3's soft-float vsnprintf widens the gap considerably on target.
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "log_deferred.h"
+
+#include <stdio.h>
+
+#define BENCH_CALLS 200000u
+
+typedef void (*benchLogCall)(uint32 i);
+
+static void _intOnly(uint32 i)           { LOG_MESSAGE("Hello World: %i", (int)i); }
+static void _mixed(uint32 i)             { LOG_MESSAGE("ADC channel %u: %f V, gain %d, status %s", (unsigned)(i & 7u), 1.25 + i, 16, "ok"); }
+static void _floats(uint32 i)            { LOG_MESSAGE("eig %f %f %f %f", 0.5 * i, 1.5, -2.25, 1e-3); }
+static void _textOnly(uint32 i)          { (void)i; LOG_MESSAGE("parseRxBuffer() RX_NEXT_IS_CHAR: waiting for _getBytesAvailable() < 1"); }
+
+static void _measure(const char * name, benchLogCall call)
+{
+    uint8  mode;
+    uint32 i;
+    uint64 startNs;
+    double nsPerCall[2];
+    uint32 wireBytes[2];
+
+    for(mode = 0u; mode < 2u; mode++)
+    {
+        packetQueue_flush();
+        HalShim_Reset();
+        logDeferred_setDictionary(mode ? logDeferred_getDictionaryCrc() : 0u);
+        HalShim_ClearTx();
+        call(0u);
+        wireBytes[mode] = HalShim_GetTxCount();
+
+        /* per call: formatting into the slot, committing it and draining it into the UART model */
+        startNs = HalShim_MonotonicNs();
+        for(i = 0u; i < BENCH_CALLS; i++)
+        {
+            flowControl_grant(1u);  /* no pacing delay, the UART model is not the subject */
+            call(i);
+            if(0u == (i & 1023u))
+            {
+                HalShim_ClearTx();
+            }
+        }
+        nsPerCall[mode] = (double)(HalShim_MonotonicNs() - startNs) / BENCH_CALLS;
+    }
+    printf("%-8s %12.1f %12.1f %10u %10u %8.1fx\n", name, nsPerCall[0], nsPerCall[1],
+        (unsigned)wireBytes[0], (unsigned)wireBytes[1], (double)wireBytes[0] / wireBytes[1]);
+}
+
+int main(void)
+{
+    printf("message  ascii ns/call  deferred ns/call  ascii B  deferred B  shrink\n");
+    _measure("int", _intOnly);
+    _measure("mixed", _mixed);
+    _measure("floats", _floats);
+    _measure("text", _textOnly);
+    logDeferred_setDictionary(0u);
+    return 0;
+}
+
+/* [] END OF FILE */
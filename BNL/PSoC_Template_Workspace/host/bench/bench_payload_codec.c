@@ -0,0 +1,110 @@
+/*******************************************************************************
+* File Name: bench_payload_codec.c
+*
+* Description:
+*  Effective bandwidth of the payload codecs at 230400 baud: samples per
+*  second of simulated wire time for full BINARY_FLOAT packets, with and
+*  without the host accepting compression, plus host ns per encode. Packets
+*  go out back to back on host credits, so the UART is the only limit.
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "MessageHandler.h"
+
+#include <stdio.h>
+
+#define BENCH_PACKETS 2000u
+
+static uint32 _lcg(uint32 * seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 8;
+}
+
+static void _fillAdc(float * values, uint16 count, uint32 * seed, int32 * level)
+{
+    uint16 i;
+    for(i = 0u; i < count; i++)
+    {
+        *level += (int32)(_lcg(seed) % 3u) - 1;         /* slow random walk */
+        values[i] = (float)(*level + (int32)(_lcg(seed) % 7u) - 3) * 5.0f / 4096.0f;
+    }
+}
+
+static void _fillAccelerations(float * values, uint16 count, uint32 * seed, int32 * level)
+{
+    uint16 i;
+    for(i = 0u; i + 2u < count; i += 3u)
+    {
+        values[i]      = (float)(*level + (int32)(_lcg(seed) % 9u) - 4);
+        values[i + 1u] = (float)(-340 + (int32)(_lcg(seed) % 9u) - 4);
+        values[i + 2u] = (float)(16384 + (int32)(_lcg(seed) % 9u) - 4);
+    }
+}
+
+typedef void (*fillFunction)(float * values, uint16 count, uint32 * seed, int32 * level);
+
+static double _samplesPerSec(fillFunction fill, uint16 floatsPerPacket, uint8 codecs, double * bytesPerPacket)
+{
+    float  values[PACKET_MAX_PAYLOAD_BYTES / 4u];
+    uint32 seed = 11u;
+    int32  level = 2000;
+    uint32 i;
+
+    packetQueue_flush();
+    HalShim_Reset();
+    payloadCodec_setAccepted(codecs);
+    for(i = 0u; i < BENCH_PACKETS; i++)
+    {
+        fill(values, floatsPerPacket, &seed, &level);
+        flowControl_grant(1u);
+        constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, 4u * floatsPerPacket, values);
+    }
+    *bytesPerPacket = (double)HalShim_GetTxCount() / BENCH_PACKETS;
+    payloadCodec_setAccepted(0u);
+    return (double)BENCH_PACKETS * floatsPerPacket / (HalShim_GetTimeNs() * 1e-9);
+}
+
+static double _encodeNs(fillFunction fill, uint16 floatsPerPacket)
+{
+    float  values[PACKET_MAX_PAYLOAD_BYTES / 4u];
+    uint8  out[PACKET_MAX_PAYLOAD_BYTES];
+    uint32 seed = 11u;
+    int32  level = 2000;
+    uint64 elapsed = 0u;
+    uint64 start;
+    uint32 i;
+
+    for(i = 0u; i < 20000u; i++)
+    {
+        fill(values, floatsPerPacket, &seed, &level);
+        start = HalShim_MonotonicNs();
+        payloadCodec_encodeDeltaVarint((const uint8 *)values, 4u * floatsPerPacket, out, sizeof(out));
+        elapsed += HalShim_MonotonicNs() - start;
+    }
+    return (double)elapsed / 20000u;
+}
+
+static void _bench(const char * name, fillFunction fill, uint16 floatsPerPacket)
+{
+    double rawBytes;
+    double codedBytes;
+    double raw = _samplesPerSec(fill, floatsPerPacket, 0u, &rawBytes);
+    double coded = _samplesPerSec(fill, floatsPerPacket, 1u << PAYLOAD_CODEC_DELTA_VARINT, &codedBytes);
+
+    printf("%-14s %6u %9.0f %9.0f %10.0f %10.0f %6.2fx %9.0f\n", name, (unsigned)floatsPerPacket,
+        rawBytes, codedBytes, raw, coded, coded / raw, _encodeNs(fill, floatsPerPacket));
+}
+
+int main(void)
+{
+    printf("%-14s %6s %9s %9s %10s %10s %7s %9s\n", "payload", "floats", "raw B/pk", "coded B/pk",
+        "raw fl/s", "coded fl/s", "gain", "encode ns");
+    _bench("adc volts",     _fillAdc, 16u);
+    _bench("adc volts",     _fillAdc, 64u);
+    _bench("accel xyz",     _fillAccelerations, 15u);
+    _bench("accel xyz",     _fillAccelerations, 63u);
+    return 0;
+}
+
+/* [] END OF FILE */
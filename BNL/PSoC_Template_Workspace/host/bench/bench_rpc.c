@@ -0,0 +1,93 @@
+/*******************************************************************************
+* File Name: bench_rpc.c
+*
+* Description:
+*  Time for the host to read N parameters (a 12 byte result each, like three
+*  floats of PGA settings) with RX_NEXT_IS_RPC, stop-and-wait against
+*  pipelined with up to 8 requests in flight. Simulated target time, with a
+*  host turnaround of BENCH_HOST_TURNAROUND_NS (USB serial latency plus the
+*  Python parser) before the host reacts to a response. The host refills
+*  its window once per round trip, which understates pipelining a little.
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+#include "rpc.h"
+
+#include <stdio.h>
+
+#define BENCH_METHOD_GET           (uint8)0x30
+#define BENCH_HOST_TURNAROUND_NS   2000000u
+
+static uint8 _get(const uint8 * arguments, uint16 numArguments, uint8 * result, uint16 * numResult)
+{
+    uint8 i;
+    (void)arguments;
+    (void)numArguments;
+    for(i = 0u; i < 12u; i++)
+    {
+        result[i] = i;
+    }
+    *numResult = 12u;
+    return RPC_OK;
+}
+
+static double _readMs(uint32 baud, uint16 numReads, uint8 window)
+{
+    uint8  bytes[8u * 7u];
+    uint16 numBytes;
+    uint16 sent = 0u;
+    uint8  i;
+
+    packetQueue_flush();
+    HalShim_Reset();
+    HalShim_SetUartBaud(baud);
+    HalShim_BindUartRxIsr(rxRing_putFromUart);
+    rxRing_reset();
+    rxParser_reset();
+    while(flowControl_takeCredit()) { }
+    rpc_register(BENCH_METHOD_GET, _get);
+    while(sent < numReads)
+    {
+        flowControl_grant(window);
+        numBytes = 0u;
+        for(i = 0u; i < window && sent < numReads; i++, sent++)
+        {
+            /* RX_NEXT_IS_RPC, length 4, id, method, the parameter index */
+            bytes[numBytes++] = RX_NEXT_IS_RPC;
+            bytes[numBytes++] = 4u;
+            bytes[numBytes++] = 0u;
+            bytes[numBytes++] = (uint8)sent;
+            bytes[numBytes++] = (uint8)(sent >> 8);
+            bytes[numBytes++] = BENCH_METHOD_GET;
+            bytes[numBytes++] = (uint8)sent;
+        }
+        HalShim_ReceiveBytes(bytes, numBytes);      /* the window goes out back to back */
+        rxParser_poll();
+        packetQueue_flush();
+        HalShim_AdvanceNs(BENCH_HOST_TURNAROUND_NS); /* the host refills once per round trip */
+    }
+    return HalShim_GetTimeNs() * 1e-6;
+}
+
+static void _bench(uint32 baud, uint16 numReads)
+{
+    double stopAndWait = _readMs(baud, numReads, 1u);
+    double pipelined   = _readMs(baud, numReads, 8u);
+
+    printf("%8u %6u %17.1f %13.1f %7.1fx\n", (unsigned)baud, (unsigned)numReads,
+        stopAndWait, pipelined, stopAndWait / pipelined);
+}
+
+int main(void)
+{
+    printf("    baud  reads  stop-and-wait ms  pipelined ms  speedup\n");
+    _bench(230400u, 32u);
+    _bench(230400u, 256u);
+    _bench(921600u, 32u);
+    _bench(921600u, 256u);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,275 @@
+/*******************************************************************************
+* File Name: bench_rx_parser.c
+*
+* Description:
+*  Commands parsed per second by rxParser_poll() for the traffic the host
+*  actually sends: single characters typed one at a time, bursts of
+*  RX_NEXT_IS_FLAG_AND_FLOAT, credits interleaved with commands, batched
+*  command frames, pipelined RPC requests and a noisy line. Bytes arrive in
+*  bursts (a USB-serial frame) and the main loop polls every few bytes, as
+*  isr_rx or uart_rx_dma.c would leave them. Host CPU time of rxRing_write,
+*  rxParser_poll and rxCommand_pop only; sending the answers is not timed.
+*  A batch entry counts as one command. Headroom is how many 921600 baud
+*  links of the same traffic the parser would keep up with, at host speed.
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+#include "command_table.h"
+#include "rpc.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_STREAM_BYTES  65536u
+#define BENCH_REPEATS       20u
+#define BENCH_LINK_BYTES_PER_SEC (921600.0 / HAL_SHIM_BITS_PER_BYTE)
+
+typedef struct
+{
+    uint8  bytes[BENCH_STREAM_BYTES];
+    uint32 numBytes;
+    uint32 numCommands;
+} benchStream;
+
+typedef void (*benchBuilder)(benchStream * stream);
+
+static benchStream _stream;
+static uint32      _random = 12345u;
+
+static uint32 _next(void)
+{
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random;
+}
+
+static uint8 _room(const benchStream * stream, uint32 numBytes)
+{
+    return stream->numBytes + numBytes <= BENCH_STREAM_BYTES;
+}
+
+static void _append(benchStream * stream, const uint8 * bytes, uint32 numBytes)
+{
+    memcpy(&stream->bytes[stream->numBytes], bytes, numBytes);
+    stream->numBytes += numBytes;
+}
+
+static void _char(benchStream * stream)
+{
+    uint8 command[2] = {RX_NEXT_IS_CHAR, 0u};
+
+    command[1] = (uint8)('a' + _next() % 26u);
+    _append(stream, command, sizeof(command));
+    stream->numCommands++;
+}
+
+static void _flagAndFloat(benchStream * stream)
+{
+    uint8 command[6] = {RX_NEXT_IS_FLAG_AND_FLOAT, RX_FLAG_SET_MODE_1};
+    float value = (float)(_next() % 1000u) * 0.01f;
+
+    memcpy(&command[2], &value, 4u);
+    _append(stream, command, sizeof(command));
+    stream->numCommands++;
+}
+
+static void _buildChars(benchStream * stream)
+{
+    while(_room(stream, 2u))
+    {
+        _char(stream);
+    }
+}
+
+static void _buildFloats(benchStream * stream)
+{
+    while(_room(stream, 6u))
+    {
+        _flagAndFloat(stream);
+    }
+}
+
+static void _buildCredited(benchStream * stream)
+{
+    static const uint8 credit[3] = {RX_NEXT_IS_CREDIT, 8u, 0u};
+    uint32 i;
+
+    while(_room(stream, 3u + 8u * 6u))
+    {
+        _append(stream, credit, sizeof(credit));
+        stream->numCommands++;
+        for(i = 0u; i < 8u; i++)
+        {
+            (i & 1u) ? _char(stream) : _flagAndFloat(stream);
+        }
+    }
+}
+
+static void _buildBatches(benchStream * stream)
+{
+    /* 20 entries of flag, COMMAND_VALUE_FLOAT32, value: 1 + 20 * 6 byte frames */
+    uint8  frame[3u + 1u + 20u * 6u];
+    uint16 frameBytes = 1u + 20u * 6u;
+    uint8  frameId = 0u;
+    uint32 i;
+
+    frame[0] = RX_NEXT_IS_BATCH;
+    frame[1] = (uint8)frameBytes;
+    frame[2] = (uint8)(frameBytes >> 8);
+    while(_room(stream, sizeof(frame)))
+    {
+        frame[3] = frameId++;
+        for(i = 0u; i < 20u; i++)
+        {
+            frame[4u + 6u * i] = (uint8)i;
+            frame[5u + 6u * i] = COMMAND_VALUE_FLOAT32;
+            memset(&frame[6u + 6u * i], (int)i, 4u);
+        }
+        _append(stream, frame, sizeof(frame));
+        stream->numCommands += 20u;
+    }
+}
+
+static void _buildRpc(benchStream * stream)
+{
+    /* RPC_METHOD_SET of one uint16 setting, the host keeps several in flight */
+    uint8  request[3u + 3u + 4u] = {RX_NEXT_IS_RPC, 7u, 0u, 0u, 0u, RPC_METHOD_SET, 1u, COMMAND_VALUE_UINT16, 0u, 0u};
+    uint16 id = 0u;
+
+    while(_room(stream, sizeof(request)))
+    {
+        request[3] = (uint8)id;
+        request[4] = (uint8)(id >> 8);
+        request[8] = (uint8)_next();
+        id++;
+        _append(stream, request, sizeof(request));
+        stream->numCommands++;
+    }
+}
+
+static void _buildNoisy(benchStream * stream)
+{
+    /* one byte in ten is line noise that has to be skipped */
+    uint8 junk;
+
+    while(_room(stream, 7u))
+    {
+        if(0u == _next() % 10u)
+        {
+            junk = (uint8)(0x20u + _next() % 0x60u);
+            _append(stream, &junk, 1u);
+        }
+        (_next() & 1u) ? _char(stream) : _flagAndFloat(stream);
+    }
+}
+
+static uint8 _setUint(uint8 flag, const commandValue * value)
+{
+    (void)flag;
+    (void)value;
+    return COMMAND_OK;
+}
+
+static void _setup(void)
+{
+    uint16 flag;
+
+    packetQueue_flush();
+    HalShim_Reset();
+    rxRing_reset();
+    rxParser_reset();
+    while(flowControl_takeCredit()) { }
+    commandTable_clear();
+    for(flag = 0u; flag < 32u; flag++)
+    {
+        commandTable_register((uint8)flag, _setUint);
+    }
+    rpc_init();
+}
+
+static double _commandsPerSec(const benchStream * stream, uint16 burstBytes, uint16 bytesPerPoll, double * bytesPerSec)
+{
+    rxCommand command;
+    uint64 elapsed = 0u;
+    uint64 start;
+    uint32 offset;
+    uint32 end;
+    uint32 piece;
+    uint32 repeat;
+    uint16 left;
+
+    _setup();
+    for(repeat = 0u; repeat < BENCH_REPEATS; repeat++)
+    {
+        for(offset = 0u; offset < stream->numBytes; offset = end)
+        {
+            end = offset + burstBytes;
+            if(end > stream->numBytes)
+            {
+                end = stream->numBytes;
+            }
+            start = HalShim_MonotonicNs();
+            while(offset < end)
+            {
+                piece = (end - offset < bytesPerPoll) ? (end - offset) : bytesPerPoll;
+                rxRing_write(&stream->bytes[offset], (uint16)piece);
+                offset += piece;
+                do
+                {
+                    /* the main loop keeps polling while a full command queue holds bytes back */
+                    left = rxRing_getAvailable();
+                    rxParser_poll();
+                    while(rxCommand_pop(&command))
+                    {
+                    }
+                } while(rxRing_getAvailable() != 0u && rxRing_getAvailable() != left);
+            }
+            elapsed += HalShim_MonotonicNs() - start;
+            packetQueue_drain(); /* answers to batches and RPCs, not timed */
+            HalShim_ClearTx();
+        }
+    }
+    /* whatever a full packet queue held back, then check nothing was lost */
+    packetQueue_drain();
+    rxParser_poll();
+    if(rxRing_getAvailable() != 0u || rxRing_getOverrunCount() != 0u)
+    {
+        printf("  parser fell behind: %u bytes left, %u dropped\n",
+            (unsigned)rxRing_getAvailable(), (unsigned)rxRing_getOverrunCount());
+    }
+    *bytesPerSec = (double)stream->numBytes * BENCH_REPEATS / (elapsed * 1e-9);
+    return (double)stream->numCommands * BENCH_REPEATS / (elapsed * 1e-9);
+}
+
+static void _bench(const char * name, benchBuilder build, uint16 burstBytes, uint16 bytesPerPoll)
+{
+    double commandsPerSec;
+    double bytesPerSec;
+
+    _stream.numBytes = 0u;
+    _stream.numCommands = 0u;
+    build(&_stream);
+    commandsPerSec = _commandsPerSec(&_stream, burstBytes, bytesPerPoll, &bytesPerSec);
+    printf("%-28s %5u %5u %12.0f %10.1f %9.0fx\n", name, (unsigned)burstBytes, (unsigned)bytesPerPoll,
+        commandsPerSec, bytesPerSec * 1e-6, bytesPerSec / BENCH_LINK_BYTES_PER_SEC);
+}
+
+int main(void)
+{
+    printf("traffic                      burst  poll   commands/s       MB/s  headroom\n");
+    _bench("typed chars, every byte",    _buildChars,    2u,   1u);
+    _bench("chars, 64 byte bursts",      _buildChars,    64u,  64u);
+    _bench("flag+float, every byte",     _buildFloats,   64u,  1u);
+    _bench("flag+float, 16 byte polls",  _buildFloats,   64u,  16u);
+    _bench("flag+float, 64 byte bursts", _buildFloats,   64u,  64u);
+    _bench("credit + 8 commands",        _buildCredited, 64u,  16u);
+    _bench("batch frames, 20 entries",   _buildBatches,  250u, 64u);
+    _bench("pipelined RPC set",          _buildRpc,      64u,  16u);
+    _bench("noisy line",                 _buildNoisy,    64u,  16u);
+    return 0;
+}
+
+/* [] END OF FILE */
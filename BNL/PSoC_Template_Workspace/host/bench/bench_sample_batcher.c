@@ -0,0 +1,83 @@
+/*******************************************************************************
+* File Name: bench_sample_batcher.c
+*
+* Description:
+*  Highest sustained sample rate over the UART for one packet per sample
+*  (paced constructAndSendPacket as today, and unpaced as with host credits)
+*  against MESSAGE_TYPE_SAMPLE_BATCH frames, for a single float (ADC voltage),
+*  three floats and three int16 (LIS2DH axes). Simulated target time with the
+*  blocking PutChar UART model: the producer runs as fast as the link drains.
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "sample_batcher.h"
+#include "timebase.h"
+
+#include <stdio.h>
+
+#define BENCH_SAMPLES 20000u
+
+typedef enum
+{
+    BENCH_PACED,
+    BENCH_UNPACED,
+    BENCH_BATCHED
+} benchMode;
+
+static double _samplesPerSec(uint32 baud, benchMode mode, uint8 format, uint8 valuesPerSample)
+{
+    sampleBatcher batcher;
+    uint8  sample[12] = {0};
+    uint16 sampleBytes = valuesPerSample * ((format == SAMPLE_FORMAT_INT16) ? 2u : 4u);
+    uint32 i;
+
+    packetQueue_flush();
+    HalShim_Reset();
+    HalShim_SetUartBaud(baud);
+    sampleBatcher_init(&batcher, 0u, format, valuesPerSample, 0u, TIMEBASE_WIRE_HZ / 100u);
+    for(i = 0u; i < BENCH_SAMPLES; i++)
+    {
+        switch(mode)
+        {
+            case BENCH_PACED:
+                constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sampleBytes, sample);
+                break;
+            case BENCH_UNPACED:
+                queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sampleBytes, sample);
+                break;
+            default:
+                sampleBatcher_addNow(&batcher, sample);
+                break;
+        }
+        packetQueue_drain();
+        if(mode == BENCH_BATCHED)
+        {
+            HalShim_AdvanceNs(1000u); /* ADC conversion / I2C read, at least 1 us between samples */
+        }
+    }
+    sampleBatcher_flush(&batcher);
+    packetQueue_flush();
+    return BENCH_SAMPLES / (HalShim_GetTimeNs() * 1e-9);
+}
+
+static void _bench(uint32 baud, const char * name, uint8 format, uint8 valuesPerSample)
+{
+    printf("%8u %-10s %12.0f %12.0f %12.0f\n", (unsigned)baud, name,
+        _samplesPerSec(baud, BENCH_PACED, format, valuesPerSample),
+        _samplesPerSec(baud, BENCH_UNPACED, format, valuesPerSample),
+        _samplesPerSec(baud, BENCH_BATCHED, format, valuesPerSample));
+}
+
+int main(void)
+{
+    printf("    baud  sample     paced smp/s unpaced smp/s batched smp/s\n");
+    _bench(230400u, "1 float",   SAMPLE_FORMAT_FLOAT32, 1u);
+    _bench(230400u, "3 float",   SAMPLE_FORMAT_FLOAT32, 3u);
+    _bench(230400u, "3 int16",   SAMPLE_FORMAT_INT16,   3u);
+    _bench(921600u, "1 float",   SAMPLE_FORMAT_FLOAT32, 1u);
+    _bench(921600u, "3 int16",   SAMPLE_FORMAT_INT16,   3u);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,392 @@
+/*******************************************************************************
+* File Name: bench_suite.c
+*
+* Description:
+*  Regression benchmark for the user modules, one line per operation:
+*
+*    host ns    real x86-64 time per operation, best of BENCH_REPEATS runs.
+*               Compare against an earlier build on the same machine.
+*    target us  simulated PSoC time per operation: UART bytes at 230400 baud,
+*               CyDelay pacing and I2C bus time. Blank where the work is pure
+*               computation the shim cannot time (eig_decomp, parsing).
+*
+*  Run with a filter argument to only run operations whose name contains it.
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "project.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+#include "eig.h"
+#include "eig_q31.h"
+#include "eig_packed.h"
+#include "eig_tracker.h"
+#include "mahalanobis.h"
+#include "lis2dh_manager.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_REPEATS 5u
+
+extern uint8 rxReadChar;
+extern float rxReadFloat;
+
+typedef void (*benchSetup)(void);
+typedef void (*benchOp)(void);
+
+static float _packetPayload[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+
+static float _sigma[MAT_SIZE][MAT_SIZE];
+static float _eigInit[PRINCIPLE_COMPONENTS][MAT_SIZE];
+static float _lambda[PRINCIPLE_COMPONENTS];
+static float _phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+static float _eigWarm[PRINCIPLE_COMPONENTS][MAT_SIZE];
+static float _rqiX[MAT_SIZE];
+static float _sigmaPacked[EIG_PACKED_SIZE];
+static eig_workspace _eigWorkspace;
+static eig_tracker _eigTracker;
+static mahalanobis_tracker _mahalanobis;
+static float _trackerSample[MAT_SIZE];
+static int32 _sigmaQ31[MAT_SIZE][MAT_SIZE];
+static int32 _eigInitQ31[PRINCIPLE_COMPONENTS][MAT_SIZE];
+static int32 _lambdaQ31[PRINCIPLE_COMPONENTS];
+static int32 _phiQ31[PRINCIPLE_COMPONENTS][MAT_SIZE];
+
+static uint8 _rxCommand[6];
+static uint8 _rxCommandBytes;
+
+/*******************************************************************************
+* Operations
+*******************************************************************************/
+static void _setupPacket(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+}
+
+static void _sendPacket(void)
+{
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(_packetPayload), _packetPayload);
+}
+
+static void _queueAndDrainPacket(void)
+{
+    queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(_packetPayload), _packetPayload);
+    packetQueue_drain();
+}
+
+static void _setupEig(void)
+{
+    uint8 i, j;
+
+    /* covariance of a decaying spectrum, roughly what the FBG channels give */
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            _sigma[i][j] = 1.0f / (1.0f + (float)((i > j) ? i - j : j - i)) + ((i == j) ? 0.5f : 0.0f);
+        }
+    }
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            _eigInit[i][j] = 1.0f + 0.01f * (float)((i * 7u + j * 3u) % 11u);
+        }
+    }
+}
+
+static void _eigPowerAndRayleigh(void)
+{
+    eig_decomp(_lambda, _phi, _sigma, _eigInit, 10u, 3u);
+}
+
+static void _eigPowerOnly(void)
+{
+    eig_decomp(_lambda, _phi, _sigma, _eigInit, 30u, 0u);
+}
+
+static void _eigTolerance(void)
+{
+    /* at most eig_decomp_p30_r0 plus 3 Rayleigh iterations, stops on the residual */
+    (void)eig_decomp_tol(_lambda, _phi, _sigma, _eigInit, 30u, 3u, 1e-4f, 0);
+}
+
+static void _setupEigWarm(void)
+{
+    _setupEig();
+    (void)eig_decomp_tol(_lambda, _eigWarm, _sigma, _eigInit, 60u, 5u, 1e-6f, 0);
+}
+
+static void _eigToleranceWarm(void)
+{
+    /* started from the previous answer, as a caller tracking a slow drift would */
+    (void)eig_decomp_tol(_lambda, _phi, _sigma, _eigWarm, 30u, 3u, 1e-4f, 0);
+}
+
+static void _setupEigPacked(void)
+{
+    _setupEig();
+    eig_pack(_sigma, _sigmaPacked);
+}
+
+static void _eigPackedPowerAndRayleigh(void)
+{
+    eig_decomp_packed(_lambda, _phi, _sigmaPacked, _eigInit, 10u, 3u, &_eigWorkspace);
+}
+
+static void _eigPackedPowerOnly(void)
+{
+    eig_decomp_packed(_lambda, _phi, _sigmaPacked, _eigInit, 30u, 0u, &_eigWorkspace);
+}
+
+static void _nextTrackerSample(void)
+{
+    static uint32 seed = 1u;
+    uint8 i;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        _trackerSample[i] = (float)((seed >> 8) & 0xFFFFu) / 65536.0f * (1.0f + (float)(i % 4u));
+    }
+}
+
+static void _setupEigTracker(void)
+{
+    uint16 s;
+
+    _setupEig();
+    eig_tracker_init(&_eigTracker, 0.01f, 1u, _eigInit);
+    for(s = 0u; s < 500u; s++)
+    {
+        _nextTrackerSample();
+        eig_tracker_add(&_eigTracker, _trackerSample);
+        (void)eig_tracker_update(&_eigTracker);
+    }
+}
+
+static void _eigTrackerAdd(void)
+{
+    _nextTrackerSample();
+    eig_tracker_add(&_eigTracker, _trackerSample);
+}
+
+static void _eigTrackerAddAndUpdate(void)
+{
+    _nextTrackerSample();
+    eig_tracker_add(&_eigTracker, _trackerSample);
+    (void)eig_tracker_update(&_eigTracker);
+}
+
+static void _setupMahalanobis(void)
+{
+    uint16 s;
+
+    _setupEig();
+    mahalanobis_init(&_mahalanobis, 0.01f, 0.1f, 0u);
+    for(s = 0u; s < 500u; s++)
+    {
+        _nextTrackerSample();
+        (void)mahalanobis_add(&_mahalanobis, _trackerSample);
+    }
+}
+
+static void _mahalanobisAdd(void)
+{
+    /* score and Sherman-Morrison update, what each sample costs */
+    _nextTrackerSample();
+    (void)mahalanobis_add(&_mahalanobis, _trackerSample);
+}
+
+static void _mahalanobisRefactor(void)
+{
+    (void)mahalanobis_refactor(&_mahalanobis);
+}
+
+static void _invertMatrix(void)
+{
+    /* the from-scratch refresh it replaces; invert_matrix() destroys its input */
+    static float copy[MAT_SIZE][MAT_SIZE];
+    static float inverse[MAT_SIZE][MAT_SIZE];
+
+    memcpy(copy, _sigma, sizeof(copy));
+    invert_matrix(copy, inverse);
+}
+
+static void _setupEigQ31(void)
+{
+    uint8 i, j;
+
+    _setupEig();
+    (void)eig_q31_from_float(_sigma, _sigmaQ31);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            _eigInitQ31[i][j] = (int32)(_eigInit[i][j] * 536870912.0f); /* Q29 is fine, it gets normalized */
+        }
+    }
+}
+
+static void _eigQ31(void)
+{
+    eig_decomp_q31(_lambdaQ31, _phiQ31, _sigmaQ31, _eigInitQ31, 30u, 0u);
+}
+
+static void _eigSubspace(void)
+{
+    eig_decomp_subspace(_lambda, _phi, _sigma, _eigInit, 10u, 3u);
+}
+
+static void _eigSubspacePowerOnly(void)
+{
+    eig_decomp_subspace(_lambda, _phi, _sigma, _eigInit, 30u, 0u);
+}
+
+static void _eigAllQl(void)
+{
+    static float vectors[MAT_SIZE][MAT_SIZE];
+    float values[MAT_SIZE];
+
+    eig_decomp_all(values, vectors, _sigma);
+}
+
+static void _rqiStepGaussJordan(void)
+{
+    /* one Rayleigh iteration solve as eig.c did it before EIG_RQI_LU_SOLVE */
+    static float shifted[MAT_SIZE][MAT_SIZE];
+    static float inverse[MAT_SIZE][MAT_SIZE];
+    uint8 i, j;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            shifted[i][j] = _sigma[i][j] - ((i == j) ? 2.5f : 0.0f);
+        }
+    }
+    invert_matrix(shifted, inverse);
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        _rqiX[i] = dot(inverse[i], _eigInit[0]);
+    }
+}
+
+static void _rqiStepLu(void)
+{
+    shifted_solve(_sigma, 2.5f, _eigInit[0], _rqiX);
+}
+
+static void _setupRxFloat(void)
+{
+    float value = 2.5f;
+
+    _rxCommand[0] = RX_NEXT_IS_FLAG_AND_FLOAT;
+    _rxCommand[1] = 'a';
+    memcpy(&_rxCommand[2], &value, 4);
+    _rxCommandBytes = 6u;
+    HalShim_Reset();
+}
+
+static void _setupRxChar(void)
+{
+    _rxCommand[0] = RX_NEXT_IS_CHAR;
+    _rxCommand[1] = 'b';
+    _rxCommandBytes = 2u;
+    HalShim_Reset();
+}
+
+static void _parseRxCommand(void)
+{
+    /* what isr_rx leaves behind, then what the main loop does with it */
+    rxRing_write(_rxCommand, _rxCommandBytes);
+    parseRxBuffer();
+}
+
+static void _setupLis2dh(void)
+{
+    HalShim_Reset();
+    lis2dh_init();
+}
+
+static void _readLis2dh(void)
+{
+    int16_t raw[3];
+    lis2dh_getRawOutputs(raw);
+}
+
+/*******************************************************************************
+* Harness
+*******************************************************************************/
+static void _run(const char * filter, const char * name, uint32 iterations, benchSetup setup, benchOp op, uint8 showTarget)
+{
+    uint64 bestHostNs = ~(uint64)0u;
+    uint64 targetNs   = 0u;
+    uint64 start;
+    uint64 elapsed;
+    uint32 repeat;
+    uint32 i;
+
+    if((NULL != filter) && (NULL == strstr(name, filter)))
+    {
+        return;
+    }
+    for(repeat = 0u; repeat < BENCH_REPEATS; repeat++)
+    {
+        setup();
+        start    = HalShim_MonotonicNs();
+        targetNs = HalShim_GetTimeNs();
+        for(i = 0u; i < iterations; i++)
+        {
+            op();
+        }
+        elapsed  = HalShim_MonotonicNs() - start;
+        targetNs = HalShim_GetTimeNs() - targetNs;
+        if(elapsed < bestHostNs)
+        {
+            bestHostNs = elapsed;
+        }
+    }
+    if(showTarget)
+    {
+        printf("%-34s %12.1f %12.1f\n", name, (double)bestHostNs / iterations, (double)targetNs / iterations / 1e3);
+    }
+    else
+    {
+        printf("%-34s %12.1f %12s\n", name, (double)bestHostNs / iterations, "");
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const char * filter = (argc > 1) ? argv[1] : NULL;
+
+    printf("%-34s %12s %12s\n", "operation", "host ns", "target us");
+    _run(filter, "packet_send_paced_16B",        20000u, _setupPacket, _sendPacket, 1u);
+    _run(filter, "packet_queue_drain_16B",      100000u, _setupPacket, _queueAndDrainPacket, 1u);
+    _run(filter, "eig_decomp_p10_r3",               50u, _setupEig, _eigPowerAndRayleigh, 0u);
+    _run(filter, "eig_decomp_p30_r0",              500u, _setupEig, _eigPowerOnly, 0u);
+    _run(filter, "eig_decomp_tol_1e-4",            500u, _setupEig, _eigTolerance, 0u);
+    _run(filter, "eig_decomp_tol_1e-4_warm",      2000u, _setupEigWarm, _eigToleranceWarm, 0u);
+    _run(filter, "eig_packed_p10_r3",              200u, _setupEigPacked, _eigPackedPowerAndRayleigh, 0u);
+    _run(filter, "eig_packed_p30_r0",              500u, _setupEigPacked, _eigPackedPowerOnly, 0u);
+    _run(filter, "eig_tracker_add",              20000u, _setupEigTracker, _eigTrackerAdd, 0u);
+    _run(filter, "eig_tracker_add_update_p1",     5000u, _setupEigTracker, _eigTrackerAddAndUpdate, 0u);
+    _run(filter, "mahalanobis_add",              20000u, _setupMahalanobis, _mahalanobisAdd, 0u);
+    _run(filter, "mahalanobis_refactor",          2000u, _setupMahalanobis, _mahalanobisRefactor, 0u);
+    _run(filter, "invert_matrix",                 2000u, _setupEig, _invertMatrix, 0u);
+    _run(filter, "eig_decomp_q31_p30_r0",          500u, _setupEigQ31, _eigQ31, 0u);
+    _run(filter, "eig_subspace_p10_r3",            200u, _setupEig, _eigSubspace, 0u);
+    _run(filter, "eig_subspace_p30_r0",            200u, _setupEig, _eigSubspacePowerOnly, 0u);
+    _run(filter, "eig_decomp_all_ql",              200u, _setupEig, _eigAllQl, 0u);
+    _run(filter, "eig_rqi_step_gauss_jordan",      500u, _setupEig, _rqiStepGaussJordan, 0u);
+    _run(filter, "eig_rqi_step_lu",                500u, _setupEig, _rqiStepLu, 0u);
+    _run(filter, "rx_parse_flag_and_float",    1000000u, _setupRxFloat, _parseRxCommand, 0u);
+    _run(filter, "rx_parse_char",              1000000u, _setupRxChar, _parseRxCommand, 0u);
+    _run(filter, "lis2dh_read_xyz",              10000u, _setupLis2dh, _readLis2dh, 1u);
+    return 0;
+}
+
+/* [] END OF FILE */
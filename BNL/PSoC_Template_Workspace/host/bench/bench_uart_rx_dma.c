@@ -0,0 +1,139 @@
+/*******************************************************************************
+* File Name: bench_uart_rx_dma.c
+*
+* Description:
+*  CPU wake-ups needed to receive a bulk upload (e.g. a calibration table),
+*  per-byte isr_rx against the uart_rx_dma.c circular DMA buffer. The upload
+*  is sent back to back in bursts with a pause between them, the main loop
+*  reads the receive ring every 64 byte times and uartRxDma_poll() runs from
+*  the 10 kHz SysTimers tick.
+*
+*  "isr_rx" runs the receive half of the isr_rx merge region (status read,
+*  GetChar, rxRing_put) for every byte; "dma" counts the nrq interrupts at
+*  each half buffer plus the uartRxDma_poll() calls that found an ended burst
+*  (the SysTimers tick itself runs either way and is not counted).
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "uart_rx_dma.h"
+#include "isr_rx_helper.h"
+#include "SysTimers.h"
+
+#include <stdio.h>
+
+#define BENCH_CHUNK_BYTES 64u
+#define BENCH_PAUSE_NS    5000000u
+#define BENCH_TICK_NS     (1000000000u / SysTimers_TICKS_PER_SECOND)
+
+static uint32 _interrupts;
+
+static void _isrRx(void)
+{
+    _interrupts++;
+    rxRing_putFromUart();
+}
+
+static void _isrRxDma(void)
+{
+    _interrupts++;
+    uartRxDma_isr();
+}
+
+static uint32 _timer(uint8 useDma, uint32 * lastTick)
+{
+    //uartRxDma_poll() once per SysTimers tick that went by
+    uint32 tick = SysTimers_GetSysTickValue();
+    uint32 wakes = 0u;
+    for(; useDma && (*lastTick != tick); (*lastTick)++)
+    {
+        wakes += uartRxDma_poll();
+    }
+    *lastTick = tick;
+    return wakes;
+}
+
+static void _pause(uint8 useDma, uint32 * lastTick, uint32 * wakes)
+{
+    uint32 t;
+    for(t = 0u; t < BENCH_PAUSE_NS; t += BENCH_TICK_NS)
+    {
+        HalShim_AdvanceNs(BENCH_TICK_NS);
+        *wakes += _timer(useDma, lastTick);
+    }
+}
+
+static uint32 _upload(uint8 useDma, uint32 baud, uint32 totalBytes, uint32 burstBytes, uint32 * wakes)
+{
+    static uint8 data[BENCH_CHUNK_BYTES];
+    uint8  sink[RX_SOFTWARE_BUFFER_LENGTH];
+    uint32 received = 0u;
+    uint32 sent = 0u;
+    uint32 lastTick = 0u;
+    uint32 i;
+
+    HalShim_Reset();
+    HalShim_SetUartBaud(baud);
+    rxRing_reset();
+    if(useDma)
+    {
+        uartRxDma_init();
+        CyDmaMock_SetNrqHandler(uartRxDma_getChannel(), _isrRxDma);
+        HalShim_BindUartRxDrq(uartRxDma_getChannel());
+        _pause(1u, &lastTick, wakes);
+        rxRing_reset();
+        uartRxDma_resetStats();
+    }
+    else
+    {
+        HalShim_BindUartRxIsr(_isrRx);
+    }
+    _interrupts = 0u;
+    *wakes = 0u;
+    for(i = 0u; i < BENCH_CHUNK_BYTES; i++)
+    {
+        data[i] = (uint8)i;
+    }
+
+    while(sent < totalBytes)
+    {
+        for(i = 0u; i < BENCH_CHUNK_BYTES; i++)
+        {
+            HalShim_ReceiveBytes(&data[i], 1u);
+            *wakes += _timer(useDma, &lastTick);
+        }
+        sent += BENCH_CHUNK_BYTES;
+        received += rxRing_read(sink, sizeof(sink));
+        if((sent % burstBytes) == 0u)
+        {
+            _pause(useDma, &lastTick, wakes);
+            received += rxRing_read(sink, sizeof(sink));
+        }
+    }
+    *wakes += _interrupts;
+    return received;
+}
+
+static void _bench(uint32 baud, uint32 totalBytes, uint32 burstBytes)
+{
+    uint32 byteWakes;
+    uint32 dmaWakes;
+    uint32 byteReceived = _upload(0u, baud, totalBytes, burstBytes, &byteWakes);
+    uint32 dmaReceived  = _upload(1u, baud, totalBytes, burstBytes, &dmaWakes);
+
+    printf("%8u %7u %7u %12.1f %12.1f %8.0fx %s\n", (unsigned)baud, (unsigned)totalBytes, (unsigned)burstBytes,
+        byteWakes * 1024.0 / totalBytes, dmaWakes * 1024.0 / totalBytes, (double)byteWakes / dmaWakes,
+        ((byteReceived == totalBytes) && (dmaReceived == totalBytes)) ? "" : "LOST BYTES");
+}
+
+int main(void)
+{
+    printf("    baud   bytes   burst isr_rx wk/KB    dma wk/KB    ratio\n");
+    _bench(230400u, 4096u, 4096u);
+    _bench(230400u, 4096u, 576u);
+    _bench(230400u, 4096u, 64u);
+    _bench(921600u, 65536u, 65536u);
+    _bench(921600u, 65536u, 960u);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,82 @@
+/*******************************************************************************
+* File Name: bench_uart_tx_ring.c
+*
+* Description:
+*  How long the main loop is held up sending bursts of packets, built once
+*  against the blocking UART_1_PutChar backend and once against the software
+*  TX ring (ENABLE_UART_TX_RING). Each round queues a burst of 64 byte payload
+*  packets and then does 150 ms of other work, at 230400 baud, which is
+*  enough time for the wire to carry a burst of 32.
+*
+*  "stall" is simulated target time spent inside queuePacket/packetQueue_drain
+*  per packet; "host ns" is real x86-64 CPU time for the same calls; "dropped"
+*  counts packets that found the 8 slot packet queue full.
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "MessageHandler.h"
+
+#include <stdio.h>
+
+#define BENCH_ROUNDS   50u
+#define BENCH_WORK_NS  150000000u
+
+static void _benchBurst(uint8 burst)
+{
+    uint8  payload[64] = {0};
+    uint64 stallNs = 0u;
+    uint64 hostNs  = 0u;
+    uint64 start;
+    uint64 hostStart;
+    uint32 round;
+    uint8  i;
+
+    HalShim_Reset();
+#if (ENABLE_UART_TX_RING)
+    HalShim_SetBlockingUart(0u);
+    uartTxRing_init();
+    HalShim_BindUartTxIsr(uartTxRing_isr);
+#endif
+    packetQueue_resetStats();
+    for(round = 0u; round < BENCH_ROUNDS; round++)
+    {
+        start     = HalShim_GetTimeNs();
+        hostStart = HalShim_MonotonicNs();
+        for(i = 0u; i < burst; i++)
+        {
+            queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(payload), payload);
+            packetQueue_drain();
+        }
+        hostNs  += HalShim_MonotonicNs() - hostStart;
+        stallNs += HalShim_GetTimeNs() - start;
+        HalShim_AdvanceNs(BENCH_WORK_NS);
+    }
+    packetQueue_flush();
+#if (ENABLE_UART_TX_RING)
+    uartTxRing_waitIdle();
+    printf("  %3u packets %10.1f %10.1f %8u   %5u B peak %4u full\n", (unsigned)burst,
+        stallNs / 1000.0 / ((double)BENCH_ROUNDS * burst), (double)hostNs / ((double)BENCH_ROUNDS * burst),
+        (unsigned)packetQueue_getDropCount(), (unsigned)uartTxRing_takeHighWater(), (unsigned)uartTxRing_getOverflowCount());
+#else
+    printf("  %3u packets %10.1f %10.1f %8u\n", (unsigned)burst,
+        stallNs / 1000.0 / ((double)BENCH_ROUNDS * burst), (double)hostNs / ((double)BENCH_ROUNDS * burst),
+        (unsigned)packetQueue_getDropCount());
+#endif
+}
+
+int main(void)
+{
+#if (ENABLE_UART_TX_RING)
+    printf("software TX ring, %u bytes\n", (unsigned)UART_TX_RING_BYTES);
+#else
+    printf("blocking UART_1_PutChar\n");
+#endif
+    printf("  burst       stall us/pkt  host ns/pkt  dropped\n");
+    _benchBurst(1u);
+    _benchBurst(8u);
+    _benchBurst(16u);
+    _benchBurst(32u);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,563 @@
+/*******************************************************************************
+* File Name: fuzz_rx_parser.c
+*
+* Description:
+*  Fuzz driver for the isr_rx_helper.c receive ring and command parser, built
+*  with ASan and UBSan so any out of bounds access aborts. One input is a
+*  byte stream from the host: byte 0 seeds how it is cut into chunks, how
+*  many application commands are popped and when the packet queue is
+*  drained between rxParser_poll() calls, the rest arrives on the UART and
+*  goes into the ring through the isr_rx handler.
+*  Besides the sanitizers every input checks that
+*
+*   - ring, command queue and packet queue never report more than they hold,
+*   - no byte is dropped and the parser always consumes the whole stream,
+*   - the RX_NEXT_IS_CHAR / RX_NEXT_IS_FLAG_AND_FLOAT commands popped are
+*     exactly those of a one pass reference parse of the whole stream, so
+*     where the chunks are cut does not matter,
+*   - every batch status and RPC response leaves as one well formed packet.
+*
+*  Built with clang (HOST_LIBFUZZER) this is a libFuzzer target. gcc has no
+*  libFuzzer, so without it main() below runs its own loop: the firmware is
+*  compiled with -fsanitize-coverage=trace-pc, inputs that reach new edges
+*  are kept and mutated further. Options follow libFuzzer's spelling:
+*
+*    fuzz_rx_parser [-runs=N] [-seed=N] [file ...]   files are replayed once
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+#include "command_table.h"
+#include "rpc.h"
+#include "payload_codec.h"
+#include "log_deferred.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_MAX_INPUT_BYTES   4096u
+#define FUZZ_MAX_COMMANDS      FUZZ_MAX_INPUT_BYTES
+#define FUZZ_METHOD_FULL       (uint8)0x20 // answers with RPC_MAX_RESULT_BYTES
+#define FUZZ_SERVICE_LIMIT     1000u       // rxParser_poll() calls to make room before calling it a livelock
+
+#define FUZZ_ASSERT(cond)                                                        \
+    do {                                                                         \
+        if(!(cond))                                                              \
+        {                                                                        \
+            fprintf(stderr, "%s:%d: FUZZ_ASSERT failed: %s\n", __FILE__, __LINE__, #cond); \
+            _saveInput();                                                        \
+            abort();                                                             \
+        }                                                                        \
+    } while(0)
+
+typedef struct
+{
+    uint8  value;
+    uint32 argumentBits;
+} fuzzCommand;
+
+static const uint8 * _input;
+static size_t        _inputBytes;
+static fuzzCommand   _expected[FUZZ_MAX_COMMANDS];
+static uint32        _numExpected;
+static uint32        _numPopped;
+static uint32        _expectedPackets;
+static uint32        _random;
+
+static void _saveInput(void)
+{
+    FILE * file = fopen("crash-rx-parser.bin", "wb");
+
+    if(NULL != file)
+    {
+        fwrite(_input, 1u, _inputBytes, file);
+        fclose(file);
+        fprintf(stderr, "input written to crash-rx-parser.bin (%u bytes)\n", (unsigned)_inputBytes);
+    }
+}
+
+static uint32 _next(void)
+{
+    /* xorshift32, the schedule must only depend on the input */
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random;
+}
+
+static uint8 _fuzzHandler(uint8 flag, const commandValue * value)
+{
+    if(value->type == COMMAND_VALUE_NONE)
+    {
+        return COMMAND_OK;
+    }
+    return (flag & 1u) ? COMMAND_ERR_RANGE : COMMAND_OK;
+}
+
+static uint8 _fullMethod(const uint8 * arguments, uint16 numArguments, uint8 * result, uint16 * numResult)
+{
+    memset(result, numArguments ? arguments[0] : 0u, RPC_MAX_RESULT_BYTES);
+    *numResult = RPC_MAX_RESULT_BYTES;
+    return RPC_OK;
+}
+
+static void _reset(void)
+{
+    uint16 flag;
+
+    packetQueue_flush();
+    HalShim_Reset();
+    HalShim_BindUartRxIsr(rxRing_putFromUart);
+    rxRing_reset();
+    rxParser_reset();
+    while(flowControl_takeCredit()) { }
+    flowControl_setStatsPeriod(0u);
+    payloadCodec_setAccepted(0u);
+    logDeferred_setDictionary(0u);
+    commandTable_clear();
+    for(flag = 0u; flag < 16u; flag++)
+    {
+        commandTable_register((uint8)flag, _fuzzHandler);
+    }
+    rpc_init();
+    rpc_register(FUZZ_METHOD_FULL, _fullMethod);
+}
+
+static uint8 _argumentBytes(uint8 command)
+{
+    /* wire format from MessageHandler.h, deliberately not shared with the parser */
+    switch(command)
+    {
+        case RX_NEXT_IS_CHAR:           return 1u;
+        case RX_NEXT_IS_FLAG_AND_FLOAT: return 5u;
+        case RX_NEXT_IS_CODEC:          return 1u;
+        case RX_NEXT_IS_CREDIT:
+        case RX_NEXT_IS_LINK_STATS:
+        case RX_NEXT_IS_LOG_DICTIONARY:
+        case RX_NEXT_IS_BATCH:
+        case RX_NEXT_IS_RPC:            return 2u;
+        default:                        return 0u;
+    }
+}
+
+static void _referenceParse(const uint8 * stream, size_t numBytes)
+{
+    /* every complete application command and every answered frame, in one pass */
+    size_t i = 0u;
+    uint8  command;
+    uint8  needed;
+    uint16 frameBytes;
+
+    _numExpected = 0u;
+    _expectedPackets = 0u;
+    while(i < numBytes)
+    {
+        command = stream[i++];
+        needed  = _argumentBytes(command);
+        if(0u == needed)
+        {
+            continue;
+        }
+        if(i + needed > numBytes)
+        {
+            return;
+        }
+        if(RX_NEXT_IS_BATCH == command || RX_NEXT_IS_RPC == command)
+        {
+            frameBytes = (uint16)(stream[i] | (stream[i + 1u] << 8));
+            i += 2u;
+            if(frameBytes <= RX_BATCH_MAX_BYTES && i + frameBytes <= numBytes)
+            {
+                if((RX_NEXT_IS_BATCH == command && frameBytes >= 1u) ||
+                   (RX_NEXT_IS_RPC == command && frameBytes >= RPC_REQUEST_HEAD_BYTES))
+                {
+                    _expectedPackets++;
+                }
+            }
+            i += frameBytes;
+            continue;
+        }
+        if(RX_NEXT_IS_CHAR == command || RX_NEXT_IS_FLAG_AND_FLOAT == command)
+        {
+            _expected[_numExpected].value = stream[i];
+            _expected[_numExpected].argumentBits = 0u;
+            if(RX_NEXT_IS_FLAG_AND_FLOAT == command)
+            {
+                memcpy(&_expected[_numExpected].argumentBits, &stream[i + 1u], 4u);
+            }
+            _numExpected++;
+        }
+        i += needed;
+    }
+}
+
+static void _service(uint8 everything)
+{
+    /* one main loop pass: parse, take some (or all) commands, maybe drain */
+    rxCommand command;
+    uint32    argumentBits;
+    uint8     numPop;
+
+    rxParser_poll();
+    FUZZ_ASSERT(rxRing_getAvailable() <= RX_SOFTWARE_BUFFER_LENGTH);
+    FUZZ_ASSERT(rxCommand_getPending() <= RX_COMMAND_QUEUE_LENGTH);
+    FUZZ_ASSERT(packetQueue_getPending() <= PACKET_QUEUE_NUM_SLOTS);
+
+    numPop = everything ? RX_COMMAND_QUEUE_LENGTH : (uint8)(_next() % (RX_COMMAND_QUEUE_LENGTH + 1u));
+    while(numPop-- > 0u && rxCommand_pop(&command))
+    {
+        FUZZ_ASSERT(_numPopped < _numExpected);
+        memcpy(&argumentBits, &command.argument, 4u);
+        FUZZ_ASSERT(_expected[_numPopped].value == command.value);
+        FUZZ_ASSERT(_expected[_numPopped].argumentBits == argumentBits);
+        _numPopped++;
+    }
+    if(everything || 0u == (_next() & 3u))
+    {
+        packetQueue_drain();
+    }
+}
+
+static void _checkPackets(void)
+{
+    /* the transmitted bytes tile exactly into packets, one per answered frame plus logs */
+    const uint8 * tx = HalShim_GetTxBytes();
+    uint32 start = 0u;
+    uint32 numPackets = 0u;
+    uint16 payloadBytes;
+
+    while(start + PACKET_HEAD_BYTES <= HalShim_GetTxCount())
+    {
+        if(MESSAGE_TYPE_COMMAND_STATUS == tx[start + 4u] || MESSAGE_TYPE_RPC_RESPONSE == tx[start + 4u])
+        {
+            numPackets++;
+        }
+        else
+        {
+            /* RX_NEXT_IS_LOG_DICTIONARY logs whether the dictionary matched,
+               nothing is sent per received byte */
+            FUZZ_ASSERT(MESSAGE_TYPE_LOG == tx[start + 4u]);
+            FUZZ_ASSERT(MESSAGE_FLAG_CHAR_RECIEVED != tx[start + 5u]);
+        }
+        payloadBytes = (uint16)(tx[start + 6u] | (tx[start + 7u] << 8));
+        FUZZ_ASSERT(payloadBytes <= PACKET_MAX_PAYLOAD_BYTES);
+        start += PACKET_HEAD_BYTES + payloadBytes + PACKET_TAIL_BYTES;
+    }
+    FUZZ_ASSERT(start == HalShim_GetTxCount());
+    FUZZ_ASSERT(numPackets == _expectedPackets);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+{
+    size_t offset = 1u;
+    uint16 chunk;
+    uint32 rounds;
+
+    if(size < 1u || size > FUZZ_MAX_INPUT_BYTES)
+    {
+        return 0;
+    }
+    _input      = data;
+    _inputBytes = size;
+    _random     = 0x9E3779B9u ^ ((uint32)data[0] << 8) ^ (uint32)size;
+    _numPopped  = 0u;
+    _referenceParse(&data[1], size - 1u);
+    _reset();
+
+    while(offset < size)
+    {
+        /* mostly UART sized bursts, sometimes up to a full ring */
+        chunk = (_next() & 7u) ? (uint16)(1u + _next() % 48u) : (uint16)(1u + _next() % RX_SOFTWARE_BUFFER_LENGTH);
+        if(chunk > size - offset)
+        {
+            chunk = (uint16)(size - offset);
+        }
+        for(rounds = 0u; rxRing_getFree() < chunk; rounds++)
+        {
+            FUZZ_ASSERT(rounds < FUZZ_SERVICE_LIMIT);
+            _service(1u);
+        }
+        HalShim_ReceiveBytes(&data[offset], chunk); /* through isr_rx, byte by byte */
+        offset += chunk;
+        _service(0u);
+    }
+    for(rounds = 0u; rxRing_getAvailable() > 0u || rxCommand_getPending() > 0u || !packetQueue_isIdle(); rounds++)
+    {
+        FUZZ_ASSERT(rounds < FUZZ_SERVICE_LIMIT);
+        _service(1u);
+    }
+    _service(1u);
+
+    FUZZ_ASSERT(0u == rxRing_getOverrunCount());
+    FUZZ_ASSERT(_numPopped == _numExpected);
+    _checkPackets();
+    return 0;
+}
+
+#if !defined(HOST_LIBFUZZER)
+
+#include <sanitizer/common_interface_defs.h>
+
+#define FUZZ_DEFAULT_RUNS      20000u
+#define FUZZ_CORPUS_ENTRIES    512u
+#define FUZZ_COVERAGE_BYTES    65536u
+#define FUZZ_COVERAGE_MASK     (FUZZ_COVERAGE_BYTES - 1u)
+
+typedef struct
+{
+    uint8  bytes[FUZZ_MAX_INPUT_BYTES];
+    uint16 numBytes;
+} fuzzInput;
+
+static fuzzInput _corpus[FUZZ_CORPUS_ENTRIES];
+static uint32    _corpusEntries;
+static uint8     _runEdges[FUZZ_COVERAGE_BYTES];
+static uint8     _allEdges[FUZZ_COVERAGE_BYTES];
+static uintptr_t _previousPc;
+static uint32    _mutator;
+
+void __sanitizer_cov_trace_pc(void)
+{
+    /* called by every basic block of the -fsanitize-coverage=trace-pc firmware */
+    uintptr_t pc = (uintptr_t)__builtin_return_address(0);
+
+    _runEdges[(pc ^ _previousPc) & FUZZ_COVERAGE_MASK] = 1u;
+    _previousPc = pc >> 1;
+}
+
+static uint32 _mutate32(void)
+{
+    _mutator ^= _mutator << 13;
+    _mutator ^= _mutator >> 17;
+    _mutator ^= _mutator << 5;
+    return _mutator;
+}
+
+static void _addSeed(const uint8 * bytes, uint16 numBytes)
+{
+    if(_corpusEntries < FUZZ_CORPUS_ENTRIES)
+    {
+        memcpy(_corpus[_corpusEntries].bytes, bytes, numBytes);
+        _corpus[_corpusEntries].numBytes = numBytes;
+        _corpusEntries++;
+    }
+}
+
+static void _addSeeds(void)
+{
+    /* byte 0 is the schedule, then one valid command of each kind */
+    static const uint8 charCommand[]  = {0u, RX_NEXT_IS_CHAR, 'a', RX_NEXT_IS_CHAR, 'b'};
+    static const uint8 floatCommand[] = {1u, RX_NEXT_IS_FLAG_AND_FLOAT, RX_FLAG_SET_MODE_1, 0x00, 0x00, 0xC0, 0x3F};
+    static const uint8 linkCommands[] = {2u, RX_NEXT_IS_CREDIT, 4u, 0u, RX_NEXT_IS_LINK_STATS, 0u, 0u,
+                                         RX_NEXT_IS_LOG_DICTIONARY, 0u, 0u, RX_NEXT_IS_CODEC, 3u};
+    static const uint8 batch[]        = {3u, RX_NEXT_IS_BATCH, 13u, 0u, 0x42,
+                                         1u, COMMAND_VALUE_UINT8, 7u,
+                                         2u, COMMAND_VALUE_FLOAT32, 0x00, 0x00, 0x80, 0x3F,
+                                         3u, COMMAND_VALUE_NONE};
+    static const uint8 rpcPing[]      = {4u, RX_NEXT_IS_RPC, 5u, 0u, 0x01, 0x00, RPC_METHOD_PING, 'h', 'i'};
+    static const uint8 rpcSet[]       = {5u, RX_NEXT_IS_RPC, 6u, 0u, 0x02, 0x00, RPC_METHOD_SET, 4u, COMMAND_VALUE_UINT8, 9u,
+                                         RX_NEXT_IS_RPC, 3u, 0u, 0x03, 0x00, FUZZ_METHOD_FULL};
+    static const uint8 oversized[]    = {6u, RX_NEXT_IS_BATCH, (uint8)(RX_BATCH_MAX_BYTES + 1u), 0u, RX_NEXT_IS_CHAR, 'x'};
+    static const uint8 empty[]        = {7u, RX_NEXT_IS_BATCH, 0u, 0u, RX_NEXT_IS_RPC, 2u, 0u, 0u, 0u, 0xFF, 0x00};
+    uint8 longest[4u + RX_BATCH_MAX_BYTES];
+
+    _addSeed(charCommand, sizeof(charCommand));
+    _addSeed(floatCommand, sizeof(floatCommand));
+    _addSeed(linkCommands, sizeof(linkCommands));
+    _addSeed(batch, sizeof(batch));
+    _addSeed(rpcPing, sizeof(rpcPing));
+    _addSeed(rpcSet, sizeof(rpcSet));
+    _addSeed(oversized, sizeof(oversized));
+    _addSeed(empty, sizeof(empty));
+
+    /* the longest frame the parser takes, an RPC ping of RX_BATCH_MAX_BYTES */
+    memset(longest, 'p', sizeof(longest));
+    longest[0] = 8u;
+    longest[1] = RX_NEXT_IS_RPC;
+    longest[2] = (uint8)RX_BATCH_MAX_BYTES;
+    longest[3] = (uint8)(RX_BATCH_MAX_BYTES >> 8);
+    longest[6] = RPC_METHOD_PING;
+    _addSeed(longest, sizeof(longest));
+}
+
+static uint16 _mutate(uint8 * bytes, uint16 numBytes)
+{
+    /* a few stacked edits, biased towards command bytes and length fields */
+    static const uint16 lengths[] = {0u, 1u, 2u, 3u, RX_BATCH_MAX_BYTES, RX_BATCH_MAX_BYTES + 1u,
+                                     RX_SOFTWARE_BUFFER_LENGTH, 0x7FFFu, 0xFFFFu};
+    const fuzzInput * other;
+    uint16 position;
+    uint16 span;
+    uint8  edits = (uint8)(1u + _mutate32() % 4u);
+
+    while(edits-- > 0u)
+    {
+        position = (uint16)(_mutate32() % numBytes);
+        switch(_mutate32() % 7u)
+        {
+            case 0:
+                bytes[position] ^= (uint8)(1u << (_mutate32() & 7u));
+                break;
+            case 1:
+                bytes[position] = (uint8)_mutate32();
+                break;
+            case 2:
+                if(numBytes < FUZZ_MAX_INPUT_BYTES)
+                {
+                    memmove(&bytes[position + 1u], &bytes[position], numBytes - position);
+                    bytes[position] = (uint8)(RX_NEXT_IS_CHAR + _mutate32() % (RX_NEXT_IS_RPC - RX_NEXT_IS_CHAR + 1u));
+                    numBytes++;
+                }
+                break;
+            case 3:
+                span = (uint16)(1u + _mutate32() % 16u);
+                if(position > 0u && span < numBytes - position)
+                {
+                    memmove(&bytes[position], &bytes[position + span], numBytes - position - span);
+                    numBytes -= span;
+                }
+                break;
+            case 4:
+                span = (uint16)(1u + _mutate32() % 64u);
+                if(span > numBytes - position)
+                {
+                    span = numBytes - position;
+                }
+                if(numBytes + span <= FUZZ_MAX_INPUT_BYTES)
+                {
+                    memmove(&bytes[position + span], &bytes[position], numBytes - position);
+                    numBytes += span;
+                }
+                break;
+            case 5:
+                if(position + 2u <= numBytes)
+                {
+                    span = lengths[_mutate32() % (sizeof(lengths) / sizeof(lengths[0]))];
+                    bytes[position]      = (uint8)span;
+                    bytes[position + 1u] = (uint8)(span >> 8);
+                }
+                break;
+            default:
+                other = &_corpus[_mutate32() % _corpusEntries];
+                span  = (uint16)(other->numBytes - 1u);
+                if(position > 0u && position + span <= FUZZ_MAX_INPUT_BYTES)
+                {
+                    memcpy(&bytes[position], &other->bytes[1], span);
+                    if(position + span > numBytes)
+                    {
+                        numBytes = (uint16)(position + span);
+                    }
+                }
+                break;
+        }
+    }
+    return numBytes;
+}
+
+static uint8 _newEdges(void)
+{
+    uint32 i;
+    uint8  found = 0u;
+
+    for(i = 0u; i < FUZZ_COVERAGE_BYTES; i++)
+    {
+        if(_runEdges[i] && !_allEdges[i])
+        {
+            _allEdges[i] = 1u;
+            found = 1u;
+        }
+    }
+    return found;
+}
+
+static uint32 _countEdges(void)
+{
+    uint32 i;
+    uint32 count = 0u;
+
+    for(i = 0u; i < FUZZ_COVERAGE_BYTES; i++)
+    {
+        count += _allEdges[i];
+    }
+    return count;
+}
+
+static int _replay(const char * path)
+{
+    static uint8 bytes[FUZZ_MAX_INPUT_BYTES];
+    size_t numBytes;
+    FILE * file = fopen(path, "rb");
+
+    if(NULL == file)
+    {
+        printf("cannot open %s\n", path);
+        return 1;
+    }
+    numBytes = fread(bytes, 1u, sizeof(bytes), file);
+    fclose(file);
+    LLVMFuzzerTestOneInput(bytes, numBytes);
+    printf("%s: ok (%u bytes)\n", path, (unsigned)numBytes);
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    static fuzzInput candidate;
+    uint32 runs = FUZZ_DEFAULT_RUNS;
+    uint32 run;
+    uint32 i;
+    int    failures = 0;
+
+    _mutator = 1u;
+    __sanitizer_set_death_callback(_saveInput);
+    for(i = 1u; i < (uint32)argc; i++)
+    {
+        if(0 == strncmp(argv[i], "-runs=", 6))
+        {
+            runs = (uint32)strtoul(&argv[i][6], NULL, 10);
+        }
+        else if(0 == strncmp(argv[i], "-seed=", 6))
+        {
+            _mutator = (uint32)strtoul(&argv[i][6], NULL, 10) | 1u;
+        }
+        else
+        {
+            failures += _replay(argv[i]);
+            runs = 0u;
+        }
+    }
+    if(0u == runs)
+    {
+        return failures ? 1 : 0;
+    }
+
+    _addSeeds();
+    for(i = 0u; i < _corpusEntries; i++)
+    {
+        memset(_runEdges, 0, sizeof(_runEdges));
+        LLVMFuzzerTestOneInput(_corpus[i].bytes, _corpus[i].numBytes);
+        _newEdges();
+    }
+    for(run = 0u; run < runs; run++)
+    {
+        candidate = _corpus[_mutate32() % _corpusEntries];
+        candidate.numBytes = _mutate(candidate.bytes, candidate.numBytes);
+        memset(_runEdges, 0, sizeof(_runEdges));
+        _previousPc = 0u;
+        LLVMFuzzerTestOneInput(candidate.bytes, candidate.numBytes);
+        if(_newEdges())
+        {
+            _addSeed(candidate.bytes, candidate.numBytes);
+        }
+    }
+    printf("%u runs, %u inputs kept, %u edges\n", (unsigned)runs, (unsigned)_corpusEntries, (unsigned)_countEdges());
+    return 0;
+}
+
+#endif /* !HOST_LIBFUZZER */
+
+/* [] END OF FILE */
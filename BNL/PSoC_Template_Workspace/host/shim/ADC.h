@@ -0,0 +1,32 @@
+/*******************************************************************************
+* File Name: ADC.h (host shim)
+*
+* Description:
+*  Host stand-in for the generated ADC (12 bit SAR, Vssa to Vdda) component.
+*  Results come from the input set with HalShim_SetAdcVolts() or
+*  HalShim_SetAdcSource() and are quantized like the hardware would.
+*
+*******************************************************************************/
+#if !defined(CY_ADC_SAR_ADC_H)
+#define CY_ADC_SAR_ADC_H
+
+#include "cytypes.h"
+
+#define ADC_DEFAULT_RESOLUTION     (12u)
+#define ADC_SHIM_FULL_SCALE_VOLTS  (5.0f)    /* Vdda on the CY8CKIT-059 */
+
+#define ADC_RETURN_STATUS          (0x01u)
+#define ADC_WAIT_FOR_RESULT        (0x00u)
+
+void    ADC_Start(void);
+void    ADC_Stop(void);
+void    ADC_StartConvert(void);
+void    ADC_StopConvert(void);
+uint8   ADC_IsEndConversion(uint8 retMode);
+int16   ADC_GetResult16(void);
+float32 ADC_CountsTo_Volts(int16 adcCounts);
+
+#endif /* CY_ADC_SAR_ADC_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,99 @@
+/*******************************************************************************
+* File Name: CyDmac.h (host shim)
+*
+* Description:
+*  Mock DMA controller with the same API as the generated CyDmac.h. Channels
+*  and transfer descriptors are modelled in memory; hardware requests (DRQs)
+*  are issued explicitly by the host code through CyDmaMock_Request().
+*
+*  PSoC TDs only hold the low 16 bits of each address. Host pointers do not fit
+*  in that, so modules built with CY_DMA_MOCK set TD addresses through
+*  CyDmaMock_TdSetPointers() instead of CyDmaTdSetAddress().
+*
+*******************************************************************************/
+#if !defined(CY_BOOT_CYDMAC_H)
+#define CY_BOOT_CYDMAC_H
+
+#include "cytypes.h"
+
+#define CY_DMA_MOCK                 (1u)
+
+/* DMA Controller functions. */
+void    CyDmacConfigure(void) ;
+uint8   CyDmacError(void) ;
+void    CyDmacClearError(uint8 error) ;
+
+/* Channel specific functions. */
+uint8    CyDmaChAlloc(void) ;
+cystatus CyDmaChFree(uint8 chHandle) ;
+cystatus CyDmaChEnable(uint8 chHandle, uint8 preserveTds) ;
+cystatus CyDmaChDisable(uint8 chHandle) ;
+cystatus CyDmaClearPendingDrq(uint8 chHandle) ;
+cystatus CyDmaChPriority(uint8 chHandle, uint8 priority) ;
+cystatus CyDmaChSetExtendedAddress(uint8 chHandle, uint16 source, uint16 destination) ;
+cystatus CyDmaChSetInitialTd(uint8 chHandle, uint8 startTd) ;
+cystatus CyDmaChSetRequest(uint8 chHandle, uint8 request) ;
+cystatus CyDmaChGetRequest(uint8 chHandle) ;
+cystatus CyDmaChStatus(uint8 chHandle, uint8 * currentTd, uint8 * state) ;
+cystatus CyDmaChSetConfiguration(uint8 chHandle, uint8 burstCount, uint8 requestPerBurst, uint8 tdDone0,
+                                        uint8 tdDone1, uint8 tdStop) ;
+
+/* Transfer Descriptor functions. */
+uint8    CyDmaTdAllocate(void) ;
+void     CyDmaTdFree(uint8 tdHandle) ;
+uint8    CyDmaTdFreeCount(void) ;
+cystatus CyDmaTdSetConfiguration(uint8 tdHandle, uint16 transferCount, uint8 nextTd, uint8 configuration) ;
+cystatus CyDmaTdGetConfiguration(uint8 tdHandle, uint16 * transferCount, uint8 * nextTd, uint8 * configuration) ;
+cystatus CyDmaTdSetAddress(uint8 tdHandle, uint16 source, uint16 destination) ;
+cystatus CyDmaTdGetAddress(uint8 tdHandle, uint16 * source, uint16 * destination) ;
+
+/* Mock-only functions. */
+void     CyDmaMock_Reset(void);
+cystatus CyDmaMock_TdSetPointers(uint8 tdHandle, const volatile void * source, volatile void * destination);
+volatile uint8 * CyDmaMock_GetWorkingDestination(uint8 chHandle);
+void     CyDmaMock_SetNrqHandler(uint8 chHandle, cyisraddress handler);
+void     CyDmaMock_SetRegisterSink(volatile void * reg, void (*sink)(uint8 value));
+uint32   CyDmaMock_Request(uint8 chHandle, uint32 numRequests);
+uint32   CyDmaMock_RunChain(uint8 chHandle);
+uint32   CyDmaMock_GetTdExecutionCount(uint8 chHandle);
+uint8    CyDmaMock_GetTdTrace(uint8 chHandle, uint8 index);
+
+/***************************************
+* API Constants
+***************************************/
+
+#define CY_DMA_INVALID_CHANNEL      0xFFu   /* Invalid Channel ID */
+#define CY_DMA_INVALID_TD           0xFFu   /* Invalid TD */
+#define CY_DMA_END_CHAIN_TD         0xFFu   /* End of chain TD */
+#define CY_DMA_DISABLE_TD           0xFEu
+
+#define CY_DMA_TD_SIZE              0x08u
+
+#define CY_DMA_TD_SWAP_EN           0x80
+#define CY_DMA_TD_SWAP_SIZE4        0x40
+#define CY_DMA_TD_AUTO_EXEC_NEXT    0x20
+#define CY_DMA_TD_TERMIN_EN         0x10
+#define CY_DMA_TD_TERMOUT1_EN       0x08
+#define CY_DMA_TD_TERMOUT0_EN       0x04
+#define CY_DMA_TD_INC_DST_ADR       0x02
+#define CY_DMA_TD_INC_SRC_ADR       0x01
+
+#define CY_DMA_NUMBEROF_TDS         128u
+#define CY_DMA_NUMBEROF_CHANNELS    ((uint8)(CYDEV_DMA_CHANNELS_AVAILABLE))
+
+/* Action register bits */
+#define CY_DMA_CPU_REQ              ((uint8)(1u << 0u))
+#define CY_DMA_CPU_TERM_TD          ((uint8)(1u << 1u))
+#define CY_DMA_CPU_TERM_CHAIN       ((uint8)(1u << 2u))
+
+/* Basic Status register bits */
+#define CY_DMA_STATUS_CHAIN_ACTIVE  ((uint8)(1u << 0u))
+#define CY_DMA_STATUS_TD_ACTIVE     ((uint8)(1u << 1u))
+
+/* Length of the per-channel TD trace kept by the mock */
+#define CY_DMA_MOCK_TRACE_LENGTH    64u
+
+#endif  /* (CY_BOOT_CYDMAC_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,492 @@
+/*******************************************************************************
+* File Name: CyDmac_mock.c
+*
+* Description:
+*  In-memory model of the PSoC 5LP DMA controller (PHUB) for host builds.
+*
+*  What is modelled:
+*   - channel and TD allocation,
+*   - TD chaining, AUTO_EXEC_NEXT, source/destination increment,
+*   - bursts and requestPerBurst (one request moves a burst, or the whole TD
+*     when requestPerBurst is 0),
+*   - preserveTds (working copy vs. writing the TD back),
+*   - TERMOUT0/TERMOUT1 raising the channel nrq, delivered to a handler,
+*   - CHAIN_ACTIVE / TD_ACTIVE status.
+*
+*  Register sinks let a destination register (e.g. UART_1_TXDATA) forward every
+*  byte written by the DMA to a host function instead of just storing it.
+*
+*******************************************************************************/
+#include "CyDmac.h"
+
+#include <string.h>
+
+#define MOCK_MAX_SINKS      (4u)
+
+typedef struct
+{
+    uint8                   allocated;
+    uint16                  transferCount;
+    uint8                   nextTd;
+    uint8                   configuration;
+    const volatile uint8 *  source;
+    volatile uint8 *        destination;
+} mockTd;
+
+typedef struct
+{
+    uint8                   allocated;
+    uint8                   enabled;
+    uint8                   preserveTds;
+    uint8                   burstCount;
+    uint8                   requestPerBurst;
+    uint8                   initialTd;
+    uint8                   currentTd;
+    uint8                   status;
+    uint16                  remaining;
+    const volatile uint8 *  source;
+    volatile uint8 *        destination;
+    cyisraddress            nrqHandler;
+    uint32                  tdExecutions;
+    uint8                   trace[CY_DMA_MOCK_TRACE_LENGTH];
+} mockChannel;
+
+typedef struct
+{
+    volatile void *         reg;
+    void                    (*sink)(uint8 value);
+} mockSink;
+
+static mockTd      _tds[CY_DMA_NUMBEROF_TDS];
+static mockChannel _channels[CY_DMA_NUMBEROF_CHANNELS];
+static mockSink    _sinks[MOCK_MAX_SINKS];
+static uint8       _dmacError;
+
+static void   _loadTd(mockChannel * ch);
+static uint8  _finishTd(uint8 chHandle);
+static void   _writeByte(volatile uint8 * destination, uint8 value);
+
+/*******************************************************************************
+* Controller
+*******************************************************************************/
+void CyDmacConfigure(void)
+{
+}
+
+uint8 CyDmacError(void)
+{
+    return _dmacError;
+}
+
+void CyDmacClearError(uint8 error)
+{
+    _dmacError &= (uint8)~error;
+}
+
+void CyDmaMock_Reset(void)
+{
+    memset(_tds, 0, sizeof(_tds));
+    memset(_channels, 0, sizeof(_channels));
+    memset(_sinks, 0, sizeof(_sinks));
+    _dmacError = 0u;
+}
+
+/*******************************************************************************
+* Channels
+*******************************************************************************/
+uint8 CyDmaChAlloc(void)
+{
+    uint8 ch;
+    for(ch = 0u; ch < CY_DMA_NUMBEROF_CHANNELS; ch++)
+    {
+        if(!_channels[ch].allocated)
+        {
+            memset(&_channels[ch], 0, sizeof(mockChannel));
+            _channels[ch].allocated   = 1u;
+            _channels[ch].burstCount  = 1u;
+            _channels[ch].initialTd   = CY_DMA_INVALID_TD;
+            _channels[ch].currentTd   = CY_DMA_INVALID_TD;
+            return ch;
+        }
+    }
+    return CY_DMA_INVALID_CHANNEL;
+}
+
+cystatus CyDmaChFree(uint8 chHandle)
+{
+    if(chHandle >= CY_DMA_NUMBEROF_CHANNELS) { return CYRET_BAD_PARAM; }
+    _channels[chHandle].allocated = 0u;
+    return CYRET_SUCCESS;
+}
+
+cystatus CyDmaChEnable(uint8 chHandle, uint8 preserveTds)
+{
+    if(chHandle >= CY_DMA_NUMBEROF_CHANNELS) { return CYRET_BAD_PARAM; }
+    _channels[chHandle].enabled     = 1u;
+    _channels[chHandle].preserveTds = preserveTds;
+    return CYRET_SUCCESS;
+}
+
+cystatus CyDmaChDisable(uint8 chHandle)
+{
+    if(chHandle >= CY_DMA_NUMBEROF_CHANNELS) { return CYRET_BAD_PARAM; }
+    _channels[chHandle].enabled = 0u;
+    _channels[chHandle].status  = 0u;
+    return CYRET_SUCCESS;
+}
+
+cystatus CyDmaClearPendingDrq(uint8 chHandle)
+{
+    return (chHandle < CY_DMA_NUMBEROF_CHANNELS) ? CYRET_SUCCESS : CYRET_BAD_PARAM;
+}
+
+cystatus CyDmaChPriority(uint8 chHandle, uint8 priority)
+{
+    (void)priority;
+    return (chHandle < CY_DMA_NUMBEROF_CHANNELS) ? CYRET_SUCCESS : CYRET_BAD_PARAM;
+}
+
+cystatus CyDmaChSetExtendedAddress(uint8 chHandle, uint16 source, uint16 destination)
+{
+    (void)source;
+    (void)destination;
+    return (chHandle < CY_DMA_NUMBEROF_CHANNELS) ? CYRET_SUCCESS : CYRET_BAD_PARAM;
+}
+
+cystatus CyDmaChSetInitialTd(uint8 chHandle, uint8 startTd)
+{
+    if(chHandle >= CY_DMA_NUMBEROF_CHANNELS) { return CYRET_BAD_PARAM; }
+    _channels[chHandle].initialTd    = startTd;
+    _channels[chHandle].currentTd    = startTd;
+    _channels[chHandle].tdExecutions = 0u;  /* trace covers the chain being started */
+    return CYRET_SUCCESS;
+}
+
+cystatus CyDmaChSetRequest(uint8 chHandle, uint8 request)
+{
+    if(chHandle >= CY_DMA_NUMBEROF_CHANNELS) { return CYRET_BAD_PARAM; }
+    if(0u != (request & (CY_DMA_CPU_TERM_CHAIN | CY_DMA_CPU_TERM_TD)))
+    {
+        _channels[chHandle].status = 0u;
+        return CYRET_SUCCESS;
+    }
+    if(0u != (request & CY_DMA_CPU_REQ))
+    {
+        (void)CyDmaMock_Request(chHandle, 1u);
+    }
+    return CYRET_SUCCESS;
+}
+
+cystatus CyDmaChGetRequest(uint8 chHandle)
+{
+    (void)chHandle;
+    return 0u;
+}
+
+cystatus CyDmaChStatus(uint8 chHandle, uint8 * currentTd, uint8 * state)
+{
+    if(chHandle >= CY_DMA_NUMBEROF_CHANNELS) { return CYRET_BAD_PARAM; }
+    if(NULL != currentTd) { *currentTd = _channels[chHandle].currentTd; }
+    if(NULL != state)     { *state     = _channels[chHandle].status; }
+    return CYRET_SUCCESS;
+}
+
+cystatus CyDmaChSetConfiguration(uint8 chHandle, uint8 burstCount, uint8 requestPerBurst, uint8 tdDone0,
+                                        uint8 tdDone1, uint8 tdStop)
+{
+    (void)tdDone0;
+    (void)tdDone1;
+    (void)tdStop;
+    if(chHandle >= CY_DMA_NUMBEROF_CHANNELS) { return CYRET_BAD_PARAM; }
+    _channels[chHandle].burstCount      = (0u == burstCount) ? 1u : burstCount;
+    _channels[chHandle].requestPerBurst = requestPerBurst;
+    return CYRET_SUCCESS;
+}
+
+/*******************************************************************************
+* Transfer descriptors
+*******************************************************************************/
+uint8 CyDmaTdAllocate(void)
+{
+    uint8 td;
+    for(td = 0u; td < CY_DMA_NUMBEROF_TDS; td++)
+    {
+        if(!_tds[td].allocated)
+        {
+            memset(&_tds[td], 0, sizeof(mockTd));
+            _tds[td].allocated = 1u;
+            _tds[td].nextTd    = CY_DMA_END_CHAIN_TD;
+            return td;
+        }
+    }
+    return CY_DMA_INVALID_TD;
+}
+
+void CyDmaTdFree(uint8 tdHandle)
+{
+    if(tdHandle < CY_DMA_NUMBEROF_TDS)
+    {
+        _tds[tdHandle].allocated = 0u;
+    }
+}
+
+uint8 CyDmaTdFreeCount(void)
+{
+    uint8 td;
+    uint8 freeCount = 0u;
+    for(td = 0u; td < CY_DMA_NUMBEROF_TDS; td++)
+    {
+        if(!_tds[td].allocated) { freeCount++; }
+    }
+    return freeCount;
+}
+
+cystatus CyDmaTdSetConfiguration(uint8 tdHandle, uint16 transferCount, uint8 nextTd, uint8 configuration)
+{
+    if(tdHandle >= CY_DMA_NUMBEROF_TDS) { return CYRET_BAD_PARAM; }
+    _tds[tdHandle].transferCount = transferCount & 0x0FFFu;
+    _tds[tdHandle].nextTd        = nextTd;
+    _tds[tdHandle].configuration = configuration;
+    return CYRET_SUCCESS;
+}
+
+cystatus CyDmaTdGetConfiguration(uint8 tdHandle, uint16 * transferCount, uint8 * nextTd, uint8 * configuration)
+{
+    if(tdHandle >= CY_DMA_NUMBEROF_TDS) { return CYRET_BAD_PARAM; }
+    if(NULL != transferCount) { *transferCount = _tds[tdHandle].transferCount; }
+    if(NULL != nextTd)        { *nextTd        = _tds[tdHandle].nextTd; }
+    if(NULL != configuration) { *configuration = _tds[tdHandle].configuration; }
+    return CYRET_SUCCESS;
+}
+
+cystatus CyDmaTdSetAddress(uint8 tdHandle, uint16 source, uint16 destination)
+{
+    /* 16-bit addresses cannot be resolved on the host */
+    (void)tdHandle;
+    (void)source;
+    (void)destination;
+    return CYRET_BAD_PARAM;
+}
+
+cystatus CyDmaTdGetAddress(uint8 tdHandle, uint16 * source, uint16 * destination)
+{
+    if(tdHandle >= CY_DMA_NUMBEROF_TDS) { return CYRET_BAD_PARAM; }
+    if(NULL != source)      { *source      = LO16((uintptr_t)_tds[tdHandle].source); }
+    if(NULL != destination) { *destination = LO16((uintptr_t)_tds[tdHandle].destination); }
+    return CYRET_SUCCESS;
+}
+
+/*******************************************************************************
+* Mock-only API
+*******************************************************************************/
+cystatus CyDmaMock_TdSetPointers(uint8 tdHandle, const volatile void * source, volatile void * destination)
+{
+    if(tdHandle >= CY_DMA_NUMBEROF_TDS) { return CYRET_BAD_PARAM; }
+    _tds[tdHandle].source      = (const volatile uint8 *)source;
+    _tds[tdHandle].destination = (volatile uint8 *)destination;
+    return CYRET_SUCCESS;
+}
+
+/* Where the channel writes its next byte: the working copy of the active TD,
+ * or the start of the TD that will run next. */
+volatile uint8 * CyDmaMock_GetWorkingDestination(uint8 chHandle)
+{
+    mockChannel * ch;
+    if(chHandle >= CY_DMA_NUMBEROF_CHANNELS) { return NULL; }
+    ch = &_channels[chHandle];
+    if(0u != (ch->status & CY_DMA_STATUS_TD_ACTIVE))
+    {
+        return ch->destination;
+    }
+    return (ch->currentTd < CY_DMA_NUMBEROF_TDS) ? _tds[ch->currentTd].destination : NULL;
+}
+
+void CyDmaMock_SetNrqHandler(uint8 chHandle, cyisraddress handler)
+{
+    if(chHandle < CY_DMA_NUMBEROF_CHANNELS)
+    {
+        _channels[chHandle].nrqHandler = handler;
+    }
+}
+
+void CyDmaMock_SetRegisterSink(volatile void * reg, void (*sink)(uint8 value))
+{
+    uint8 i;
+    for(i = 0u; i < MOCK_MAX_SINKS; i++)
+    {
+        if((_sinks[i].reg == reg) || (NULL == _sinks[i].reg))
+        {
+            _sinks[i].reg  = reg;
+            _sinks[i].sink = sink;
+            return;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: CyDmaMock_Request
+********************************************************************************
+*
+* Issues numRequests hardware requests (DRQs) to the channel, exactly as a
+* peripheral would. Returns the number of bytes moved.
+*
+*******************************************************************************/
+uint32 CyDmaMock_Request(uint8 chHandle, uint32 numRequests)
+{
+    mockChannel * ch;
+    uint32 bytesMoved = 0u;
+
+    if(chHandle >= CY_DMA_NUMBEROF_CHANNELS) { return 0u; }
+    ch = &_channels[chHandle];
+
+    while((numRequests > 0u) && ch->enabled)
+    {
+        uint16 burst;
+        uint8  runWholeTd;
+
+        if(0u == (ch->status & CY_DMA_STATUS_CHAIN_ACTIVE))
+        {
+            if(ch->currentTd >= CY_DMA_NUMBEROF_TDS)
+            {
+                break; /* end of chain reached, nothing to run */
+            }
+            ch->status |= CY_DMA_STATUS_CHAIN_ACTIVE;
+            _loadTd(ch);
+        }
+        numRequests--;
+
+        runWholeTd = (0u == ch->requestPerBurst);
+        do
+        {
+            burst = (0u == ch->burstCount) ? 1u : ch->burstCount;
+            while((burst > 0u) && (ch->remaining > 0u))
+            {
+                uint8 configuration = _tds[ch->currentTd].configuration;
+                _writeByte(ch->destination, *ch->source);
+                if(0u != (configuration & CY_DMA_TD_INC_SRC_ADR)) { ch->source++; }
+                if(0u != (configuration & CY_DMA_TD_INC_DST_ADR)) { ch->destination++; }
+                ch->remaining--;
+                burst--;
+                bytesMoved++;
+            }
+
+            if(0u == ch->remaining)
+            {
+                uint8 autoExec = _finishTd(chHandle);
+                if(!autoExec)
+                {
+                    break;
+                }
+            }
+        } while(runWholeTd && (0u != (ch->status & CY_DMA_STATUS_CHAIN_ACTIVE)));
+    }
+    return bytesMoved;
+}
+
+/*******************************************************************************
+* Function Name: CyDmaMock_RunChain
+********************************************************************************
+*
+* Keeps issuing requests until the current chain ends. Returns bytes moved.
+*
+*******************************************************************************/
+uint32 CyDmaMock_RunChain(uint8 chHandle)
+{
+    uint32 bytesMoved = 0u;
+    uint32 moved;
+    if(chHandle >= CY_DMA_NUMBEROF_CHANNELS) { return 0u; }
+    do
+    {
+        moved = CyDmaMock_Request(chHandle, 1u);
+        bytesMoved += moved;
+    } while((0u != moved) && (0u != (_channels[chHandle].status & CY_DMA_STATUS_CHAIN_ACTIVE)));
+    return bytesMoved;
+}
+
+uint32 CyDmaMock_GetTdExecutionCount(uint8 chHandle)
+{
+    return (chHandle < CY_DMA_NUMBEROF_CHANNELS) ? _channels[chHandle].tdExecutions : 0u;
+}
+
+uint8 CyDmaMock_GetTdTrace(uint8 chHandle, uint8 index)
+{
+    if((chHandle >= CY_DMA_NUMBEROF_CHANNELS) || (index >= CY_DMA_MOCK_TRACE_LENGTH))
+    {
+        return CY_DMA_INVALID_TD;
+    }
+    return _channels[chHandle].trace[index];
+}
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+static void _loadTd(mockChannel * ch)
+{
+    mockTd * td = &_tds[ch->currentTd];
+    ch->remaining   = td->transferCount;
+    ch->source      = td->source;
+    ch->destination = td->destination;
+    ch->status     |= CY_DMA_STATUS_TD_ACTIVE;
+    if(ch->tdExecutions < CY_DMA_MOCK_TRACE_LENGTH)
+    {
+        ch->trace[ch->tdExecutions] = ch->currentTd;
+    }
+    ch->tdExecutions++;
+}
+
+/* Completes the active TD, raises nrq if requested and moves to the next TD.
+ * Returns non-zero when the next TD should start without a new request. */
+static uint8 _finishTd(uint8 chHandle)
+{
+    mockChannel * ch = &_channels[chHandle];
+    mockTd * td      = &_tds[ch->currentTd];
+    uint8 next       = td->nextTd;
+    uint8 autoExec   = (0u != (td->configuration & CY_DMA_TD_AUTO_EXEC_NEXT));
+    uint8 raiseNrq   = (0u != (td->configuration & (CY_DMA_TD_TERMOUT0_EN | CY_DMA_TD_TERMOUT1_EN)));
+
+    if(!ch->preserveTds)
+    {
+        td->transferCount = 0u;
+        td->source        = ch->source;
+        td->destination   = ch->destination;
+    }
+    ch->status &= (uint8)~CY_DMA_STATUS_TD_ACTIVE;
+    ch->currentTd = next;
+
+    if(next >= CY_DMA_NUMBEROF_TDS)
+    {
+        ch->status &= (uint8)~CY_DMA_STATUS_CHAIN_ACTIVE;
+        if(CY_DMA_DISABLE_TD == next)
+        {
+            ch->enabled = 0u;
+        }
+        autoExec = 0u;
+    }
+    else
+    {
+        _loadTd(ch);
+    }
+
+    /* nrq is delivered after the channel state is updated, like the real ISR */
+    if(raiseNrq && (NULL != ch->nrqHandler))
+    {
+        ch->nrqHandler();
+    }
+    return autoExec;
+}
+
+static void _writeByte(volatile uint8 * destination, uint8 value)
+{
+    uint8 i;
+    *destination = value;
+    for(i = 0u; i < MOCK_MAX_SINKS; i++)
+    {
+        if((_sinks[i].reg == (volatile void *)destination) && (NULL != _sinks[i].sink))
+        {
+            _sinks[i].sink(value);
+            return;
+        }
+    }
+}
+
+/* [] END OF FILE */
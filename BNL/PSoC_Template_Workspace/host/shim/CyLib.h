@@ -0,0 +1,29 @@
+/*******************************************************************************
+* File Name: CyLib.h (host shim)
+*
+* Description:
+*  Host stand-ins for the CyLib delay and critical section APIs. Delays do not
+*  sleep; they advance the simulated clock kept by hal_shim.c.
+*
+*******************************************************************************/
+#if !defined(CY_BOOT_CYLIB_H)
+#define CY_BOOT_CYLIB_H
+
+#include "cytypes.h"
+
+void  CyDelay(uint32 milliseconds) CYREENTRANT;
+void  CyDelayUs(uint16 microseconds);
+void  CyDelayCycles(uint32 cycles);
+
+uint8 CyEnterCriticalSection(void);
+void  CyExitCriticalSection(uint8 savedIntrStatus);
+
+#define CyGlobalIntEnable           {}
+#define CyGlobalIntDisable          {}
+
+#define BCLK__BUS_CLK__HZ           24000000U
+
+#endif /* (CY_BOOT_CYLIB_H) */
+
+
+/* [] END OF FILE */
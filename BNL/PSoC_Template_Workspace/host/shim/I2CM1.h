@@ -0,0 +1,39 @@
+/*******************************************************************************
+* File Name: I2CM1.h (host shim)
+*
+* Description:
+*  Host stand-in for the generated I2CM1 master component, byte level API only.
+*  hal_shim.c models one slave with a 128 byte register file behind it and
+*  advances the simulated clock by the bus time of every start, byte and stop.
+*
+*******************************************************************************/
+#if !defined(CY_I2C_I2CM1_H)
+#define CY_I2C_I2CM1_H
+
+#include "cytypes.h"
+
+#define I2CM1_DATA_RATE          (100u)   /* kHz, as configured in TopDesign */
+
+#define I2CM1_READ_XFER_MODE     (0x01u)
+#define I2CM1_WRITE_XFER_MODE    (0x00u)
+#define I2CM1_ACK_DATA           (0x01u)
+#define I2CM1_NAK_DATA           (0x00u)
+
+#define I2CM1_MSTR_NO_ERROR          (0x00u)
+#define I2CM1_MSTR_BUS_BUSY          (0x01u)
+#define I2CM1_MSTR_NOT_READY         (0x02u)
+#define I2CM1_MSTR_ERR_LB_NAK        (0x03u)
+
+void  I2CM1_Start(void) ;
+void  I2CM1_Stop(void) ;
+
+uint8 I2CM1_MasterSendStart(uint8 slaveAddress, uint8 R_nW) ;
+uint8 I2CM1_MasterSendRestart(uint8 slaveAddress, uint8 R_nW) ;
+uint8 I2CM1_MasterSendStop(void) ;
+uint8 I2CM1_MasterWriteByte(uint8 theByte) ;
+uint8 I2CM1_MasterReadByte(uint8 acknNak) ;
+
+#endif /* CY_I2C_I2CM1_H */
+
+
+/* [] END OF FILE */
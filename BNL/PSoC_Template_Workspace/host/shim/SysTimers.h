@@ -0,0 +1,24 @@
+/*******************************************************************************
+* File Name: SysTimers.h (host shim)
+*
+* Description:
+*  Host stand-in for the SysTimers community component. The system tick is
+*  derived from the simulated clock in hal_shim.c.
+*
+*******************************************************************************/
+#if !defined(CY_SYSTIMERS_SysTimers_H)
+#define CY_SYSTIMERS_SysTimers_H
+
+#include "cytypes.h"
+
+#define SysTimers_RESOLUTION       10000
+#define SysTimers_TICKS_PER_SECOND 10000
+
+void    SysTimers_Start(void);
+void    SysTimers_Stop(void);
+uint32  SysTimers_GetSysTickValue(void);
+
+#endif
+
+
+//[] END OF FILE
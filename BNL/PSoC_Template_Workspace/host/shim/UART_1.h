@@ -0,0 +1,62 @@
+/*******************************************************************************
+* File Name: UART_1.h (host shim)
+*
+* Description:
+*  Host stand-in for the generated UART_1 component API. Transmitted bytes are
+*  recorded in memory by hal_shim.c together with their simulated send time.
+*
+*******************************************************************************/
+#if !defined(CY_UART_UART_1_H)
+#define CY_UART_UART_1_H
+
+#include "cytypes.h"
+#include "CyLib.h"
+
+#define UART_1_TX_BUFFER_SIZE                 (4u)
+#define UART_1_RX_BUFFER_SIZE                 (4u)
+
+void   UART_1_Start(void) ;
+void   UART_1_Stop(void) ;
+
+uint8  UART_1_ReadRxStatus(void) ;
+uint8  UART_1_GetChar(void) ;
+uint8  UART_1_ReadRxData(void) ;
+uint8  UART_1_GetRxBufferSize(void) ;
+void   UART_1_ClearRxBuffer(void) ;
+
+uint8  UART_1_ReadTxStatus(void) ;
+void   UART_1_WriteTxData(uint8 txDataByte) ;
+void   UART_1_PutChar(uint8 txDataByte) ;
+void   UART_1_PutString(const char8 string[]) ;
+void   UART_1_PutArray(const uint8 string[], uint8 byteCount) ;
+uint8  UART_1_GetTxBufferSize(void) ;
+void   UART_1_ClearTxBuffer(void) ;
+void   UART_1_SetTxInterruptMode(uint8 intSrc) ;
+
+#define UART_1_TX_STS_COMPLETE            (uint8)(0x01u << 0x00u)
+#define UART_1_TX_STS_FIFO_EMPTY          (uint8)(0x01u << 0x01u)
+#define UART_1_TX_STS_FIFO_FULL           (uint8)(0x01u << 0x02u)
+#define UART_1_TX_STS_FIFO_NOT_FULL       (uint8)(0x01u << 0x03u)
+
+#define UART_1_RX_STS_MRKSPC           (uint8)(0x01u << 0x00u)
+#define UART_1_RX_STS_BREAK            (uint8)(0x01u << 0x01u)
+#define UART_1_RX_STS_PAR_ERROR        (uint8)(0x01u << 0x02u)
+#define UART_1_RX_STS_STOP_ERROR       (uint8)(0x01u << 0x03u)
+#define UART_1_RX_STS_OVERRUN          (uint8)(0x01u << 0x04u)
+#define UART_1_RX_STS_FIFO_NOTEMPTY    (uint8)(0x01u << 0x05u)
+#define UART_1_RX_STS_ADDR_MATCH       (uint8)(0x01u << 0x06u)
+#define UART_1_RX_STS_SOFT_BUFF_OVER   (uint8)(0x01u << 0x07u)
+
+/* Data registers are plain memory on the host; hal_shim.c registers them with
+ * the mock DMA controller so DMA writes land in the recorded TX stream. */
+extern reg8 UART_1_txDataRegister;
+extern reg8 UART_1_rxDataRegister;
+#define UART_1_TXDATA_REG          (UART_1_txDataRegister)
+#define UART_1_TXDATA_PTR          (&UART_1_txDataRegister)
+#define UART_1_RXDATA_REG          (UART_1_rxDataRegister)
+#define UART_1_RXDATA_PTR          (&UART_1_rxDataRegister)
+
+#endif /* CY_UART_UART_1_H */
+
+
+/* [] END OF FILE */
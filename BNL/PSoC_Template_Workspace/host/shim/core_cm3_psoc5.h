@@ -0,0 +1,42 @@
+/*******************************************************************************
+* File Name: core_cm3_psoc5.h (host shim)
+*
+* Description:
+*  The two Cortex-M3 debug blocks the user modules touch: CoreDebug DEMCR and
+*  the DWT cycle counter. CYCCNT counts BCLK__BUS_CLK__HZ cycles of simulated
+*  time once both TRCENA and CYCCNTENA are set, and keeps whatever value the
+*  firmware writes to it, like the real counter.
+*
+*******************************************************************************/
+#if !defined(CORE_CM3_PSOC5_H)
+#define CORE_CM3_PSOC5_H
+
+#include "cytypes.h"
+
+typedef struct
+{
+    volatile uint32 CTRL;
+    volatile uint32 CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    volatile uint32 DHCSR;
+    volatile uint32 DCRSR;
+    volatile uint32 DCRDR;
+    volatile uint32 DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk      (0x1UL)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+
+DWT_Type *       HalShim_Dwt(void);
+CoreDebug_Type * HalShim_CoreDebug(void);
+
+#define DWT                         (HalShim_Dwt())
+#define CoreDebug                   (HalShim_CoreDebug())
+
+#endif /* CORE_CM3_PSOC5_H */
+
+
+/* [] END OF FILE */
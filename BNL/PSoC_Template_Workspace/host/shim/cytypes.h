@@ -0,0 +1,90 @@
+/*******************************************************************************
+* File Name: cytypes.h (host shim)
+*
+* Description:
+*  Stand-in for the PSoC Creator generated cytypes.h so the user modules in
+*  PSoC_Template_Project.cydsn can be compiled natively on x86-64 Linux.
+*  Only the types and macros the user modules actually use are provided.
+*  Fixed-width types are used so uint32 stays 4 bytes on a 64-bit host.
+*
+*******************************************************************************/
+#if !defined(CY_BOOT_CYTYPES_H)
+#define CY_BOOT_CYTYPES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CY_HOST_BUILD       (1u)
+
+#define CY_PSOC3            (0u)
+#define CY_PSOC4            (0u)
+#define CY_PSOC5            (1u)
+#define CY_PSOC5LP          (1u)
+
+typedef uint8_t     uint8;
+typedef uint16_t    uint16;
+typedef uint32_t    uint32;
+typedef int8_t      int8;
+typedef int16_t     int16;
+typedef int32_t     int32;
+typedef float       float32;
+typedef double      float64;
+typedef int64_t     int64;
+typedef uint64_t    uint64;
+typedef char        char8;
+
+typedef uint32      cystatus;
+
+#define CYCODE
+#define CYDATA
+#define CYXDATA
+#define CYFAR
+#define CYPDATA
+#define CYREENTRANT
+#define CYPACKED
+#define CYPACKED_ATTR       __attribute__ ((packed))
+#define CYALIGNED(x)        __attribute__ ((aligned(x)))
+
+typedef volatile uint8  CYXDATA reg8;
+typedef volatile uint16 CYXDATA reg16;
+typedef volatile uint32 CYXDATA reg32;
+
+#define CY_ISR(FuncName)        void FuncName (void)
+#define CY_ISR_PROTO(FuncName)  void FuncName (void)
+typedef void (* cyisraddress)(void);
+
+#define CY_GET_REG8(addr)               (*((const reg8 *)(addr)))
+#define CY_SET_REG8(addr, value)        (*((reg8 *)(addr))  = (uint8)(value))
+#define CY_GET_REG16(addr)              (*((const reg16 *)(addr)))
+#define CY_SET_REG16(addr, value)       (*((reg16 *)(addr)) = (uint16)(value))
+#define CY_GET_REG32(addr)              (*((const reg32 *)(addr)))
+#define CY_SET_REG32(addr, value)       (*((reg32 *)(addr)) = (uint32)(value))
+
+#define LO8(x)                  ((uint8) ((x) & 0xFFu))
+#define HI8(x)                  ((uint8) ((uint16)(x) >> 8))
+#define LO16(x)                 ((uint16) ((x) & 0xFFFFu))
+#define HI16(x)                 ((uint16) ((uint32)(x) >> 16))
+
+#define CYRET_SUCCESS           (0x00u)           /* Successful */
+#define CYRET_BAD_PARAM         (0x01u)           /* One or more invalid parameters */
+#define CYRET_INVALID_OBJECT    (0x02u)           /* Invalid object specified */
+#define CYRET_MEMORY            (0x03u)           /* Memory related failure */
+#define CYRET_LOCKED            (0x04u)           /* Resource lock failure */
+#define CYRET_EMPTY             (0x05u)           /* No more objects available */
+#define CYRET_BAD_DATA          (0x06u)           /* Bad data received (CRC or other error check) */
+#define CYRET_STARTED           (0x07u)           /* Operation started, but not necessarily completed yet */
+#define CYRET_FINISHED          (0x08u)           /* Operation completed */
+#define CYRET_CANCELED          (0x09u)           /* Operation canceled */
+#define CYRET_TIMEOUT           (0x10u)           /* Operation timed out */
+#define CYRET_INVALID_STATE     (0x11u)           /* Operation not setup or is in an improper state */
+#define CYRET_UNKNOWN           ((cystatus) 0xFFFFFFFFu)    /* Unknown failure */
+
+/* Stand-ins for the SRAM/peripheral windows used to build DMA addresses */
+#define CYDEV_SRAM_BASE         0x1fff8000u
+#define CYDEV_PERIPH_BASE       0x40004000u
+#define CYDEV_DMA_CHANNELS_AVAILABLE 24u
+
+#endif  /* CY_BOOT_CYTYPES_H */
+
+
+/* [] END OF FILE */
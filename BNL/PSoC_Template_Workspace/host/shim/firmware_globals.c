@@ -0,0 +1,22 @@
+/*******************************************************************************
+* File Name: firmware_globals.c
+*
+* Description:
+*  Globals the user modules expect main.c to define on target.
+*
+*******************************************************************************/
+#include "cytypes.h"
+#include "isr_rx_helper.h"
+#include "eig.h"
+
+uint32 SysTicksMS;
+
+uint8 rxReadChar   = 0;
+float rxReadFloat  = 0.0;
+
+float W1[MAT_SIZE][MAT_SIZE];   /* eig.c workspace matrices */
+float W2[MAT_SIZE][MAT_SIZE];
+float W3[MAT_SIZE][MAT_SIZE];
+int32 W1_q31[MAT_SIZE][MAT_SIZE]; /* eig_q31.c deflation workspace */
+
+/* [] END OF FILE */
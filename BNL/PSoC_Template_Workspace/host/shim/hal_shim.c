@@ -0,0 +1,699 @@
+/*******************************************************************************
+* File Name: hal_shim.c
+*
+* Description:
+*  Host implementation of the CyLib, UART_1 and SysTimers calls used by the
+*  user modules.
+*
+*  Time is simulated: CyDelay/CyDelayUs advance the clock instead of sleeping,
+*  and with the blocking UART model enabled every UART_1_PutChar advances the
+*  clock by one byte time at the configured baud rate, which is what the
+*  firmware's busy-waiting PutChar costs on target. Every byte that reaches
+*  the TX data register, by PutChar or by DMA, is recorded with its time.
+*  The SysTimers tick and the DWT cycle counter both follow the same clock.
+*
+*  With an ISR bound to UART_1 tx_interrupt the TX FIFO is modelled: it holds
+*  UART_1_TX_BUFFER_SIZE bytes, loses one per byte time, and the ISR runs for
+*  as long as FIFO_NOT_FULL is both unmasked and true, like the level
+*  triggered interrupt on target.
+*
+*  I2CM1 talks to one slave with a register file: the first byte written after
+*  a start sets the register pointer, which auto-increments when its MSB is
+*  set, as on the LIS2DH. Every start, byte and stop costs its bus time at
+*  I2CM1_DATA_RATE, since the generated master API busy-waits on target.
+*
+*******************************************************************************/
+#include "hal_shim.h"
+#include "CyLib.h"
+#include "CyDmac.h"
+#include "UART_1.h"
+#include "SysTimers.h"
+#include "core_cm3_psoc5.h"
+#include "I2CM1.h"
+#include "ADC.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+reg8 UART_1_txDataRegister;
+reg8 UART_1_rxDataRegister;
+
+static uint64  _timeNs;
+static uint32  _baud          = HAL_SHIM_DEFAULT_BAUD;
+static uint8   _blockingUart  = 1u;
+static uint8   _txDrqChannel  = CY_DMA_INVALID_CHANNEL;
+static uint64  _txDrqCreditNs;
+static HalShim_Isr _txIsr;
+static uint8   _txIsrActive;
+static uint8   _txFifoLevel;
+static uint8   _txInterruptMode;
+static uint8   _rxDrqChannel  = CY_DMA_INVALID_CHANNEL;
+static HalShim_Isr _rxIsr;
+static uint8   _rxFifo[UART_1_RX_BUFFER_SIZE];
+static uint8   _rxFifoLevel;
+static uint8   _rxStatus;
+static uint32  _rxOverrunCount;
+static uint8 * _txBytes;
+static uint64 * _txTimes;
+static uint32  _txCount;
+static uint32  _txCapacity;
+static DWT_Type       _dwt;
+static CoreDebug_Type _coreDebug;
+static uint64  _dwtSyncedNs;
+static uint8   _i2cAddress    = HAL_SHIM_I2C_DEFAULT_ADDRESS;
+static uint8   _i2cRegisters[HAL_SHIM_I2C_REGISTERS];
+static uint8   _i2cSelected;
+static uint8   _i2cPointer;
+static uint8   _i2cPointerSet;
+static uint8   _i2cAutoIncrement;
+static uint32  _i2cByteCount;
+static float   _adcVolts;
+static HalShim_AdcSource _adcSource;
+static uint32  _adcReadCount;
+
+static void _recordTxByte(uint8 value);
+static void _serviceTxIsr(void);
+static void _serviceRx(void);
+static uint8 _popRxFifo(void);
+
+/*******************************************************************************
+* Shim control
+*******************************************************************************/
+void HalShim_Reset(void)
+{
+    _timeNs       = 0u;
+    _baud         = HAL_SHIM_DEFAULT_BAUD;
+    _blockingUart = 1u;
+    _txDrqChannel = CY_DMA_INVALID_CHANNEL;
+    _txDrqCreditNs = 0u;
+    _txIsr        = NULL;
+    _txIsrActive  = 0u;
+    _txFifoLevel  = 0u;
+    _txInterruptMode = 0u;
+    _rxDrqChannel = CY_DMA_INVALID_CHANNEL;
+    _rxIsr        = NULL;
+    _rxFifoLevel  = 0u;
+    _rxStatus     = 0u;
+    _rxOverrunCount = 0u;
+    _dwt.CYCCNT   = 0u;
+    _dwtSyncedNs  = 0u;
+    _i2cAddress   = HAL_SHIM_I2C_DEFAULT_ADDRESS;
+    memset(_i2cRegisters, 0, sizeof(_i2cRegisters));
+    _i2cSelected  = 0u;
+    _i2cByteCount = 0u;
+    _adcVolts     = 0.0f;
+    _adcSource    = NULL;
+    _adcReadCount = 0u;
+    HalShim_ClearTx();
+    CyDmaMock_SetRegisterSink(UART_1_TXDATA_PTR, _recordTxByte);
+}
+
+uint64 HalShim_GetTimeNs(void)
+{
+    return _timeNs;
+}
+
+/*******************************************************************************
+* Function Name: HalShim_AdvanceNs
+********************************************************************************
+*
+* Moves the simulated clock forward. If a DMA channel is bound to the UART TX
+* DRQ, the UART drains one byte per byte time and the channel receives one
+* request for each byte slot that frees up in the FIFO. If an ISR is bound to
+* tx_interrupt instead, the FIFO loses one byte per byte time and the ISR is
+* given the chance to refill it.
+*
+*******************************************************************************/
+void HalShim_AdvanceNs(uint64 nanoseconds)
+{
+    uint64 byteTimeNs = HalShim_GetByteTimeNs();
+    uint64 endNs      = _timeNs + nanoseconds;
+
+    if(NULL != _txIsr)
+    {
+        _txDrqCreditNs += nanoseconds;
+        while(_txDrqCreditNs >= byteTimeNs)
+        {
+            if(0u == _txFifoLevel)
+            {
+                _txDrqCreditNs = 0u;
+                break;
+            }
+            _txDrqCreditNs -= byteTimeNs;
+            _timeNs = endNs - _txDrqCreditNs;
+            _txFifoLevel--;
+            _serviceTxIsr();
+        }
+        _timeNs = endNs;
+        return;
+    }
+    if(CY_DMA_INVALID_CHANNEL == _txDrqChannel)
+    {
+        _timeNs = endNs;
+        return;
+    }
+
+    _txDrqCreditNs += nanoseconds;
+    while(_txDrqCreditNs >= byteTimeNs)
+    {
+        _txDrqCreditNs -= byteTimeNs;
+        _timeNs = endNs - _txDrqCreditNs;
+        if(0u == CyDmaMock_Request(_txDrqChannel, 1u))
+        {
+            /* nothing queued: an idle UART does not bank byte slots */
+            _txDrqCreditNs = 0u;
+            break;
+        }
+    }
+    _timeNs = endNs;
+}
+
+void HalShim_BindUartTxDrq(uint8 chHandle)
+{
+    _txDrqChannel  = chHandle;
+    _txDrqCreditNs = 0u;
+}
+
+void HalShim_BindUartTxIsr(HalShim_Isr isr)
+{
+    _txIsr         = isr;
+    _txFifoLevel   = 0u;
+    _txDrqCreditNs = 0u;
+    _serviceTxIsr();
+}
+
+uint8 HalShim_GetUartTxInterruptMode(void)
+{
+    return _txInterruptMode;
+}
+
+void HalShim_BindUartRxDrq(uint8 chHandle)
+{
+    _rxDrqChannel = chHandle;
+    _serviceRx();
+}
+
+void HalShim_BindUartRxIsr(HalShim_Isr isr)
+{
+    _rxIsr = isr;
+    _serviceRx();
+}
+
+/*******************************************************************************
+* Function Name: HalShim_ReceiveBytes
+********************************************************************************
+*
+* Puts numBytes on the UART RX line, back to back: each byte arrives one byte
+* time after the previous one and lands in the 4 byte RX FIFO. A DMA channel
+* bound to the RX DRQ gets one request per byte in the FIFO, an ISR bound to
+* rx_interrupt runs while the FIFO is not empty. A byte that finds the FIFO
+* full is lost and counted, as UART_1_RX_STS_OVERRUN.
+*
+*******************************************************************************/
+void HalShim_ReceiveBytes(const uint8 * data, uint32 numBytes)
+{
+    uint32 i;
+
+    for(i = 0u; i < numBytes; i++)
+    {
+        HalShim_AdvanceNs(HalShim_GetByteTimeNs());
+        if(_rxFifoLevel < UART_1_RX_BUFFER_SIZE)
+        {
+            _rxFifo[_rxFifoLevel++] = data[i];
+        }
+        else
+        {
+            _rxStatus |= UART_1_RX_STS_OVERRUN;
+            _rxOverrunCount++;
+        }
+        _serviceRx();
+    }
+}
+
+uint32 HalShim_GetRxOverrunCount(void)
+{
+    return _rxOverrunCount;
+}
+
+uint8 HalShim_GetRxFifoLevel(void)
+{
+    return _rxFifoLevel;
+}
+
+void HalShim_SetUartBaud(uint32 baud)
+{
+    _baud = (0u == baud) ? HAL_SHIM_DEFAULT_BAUD : baud;
+}
+
+void HalShim_SetBlockingUart(uint8 enable)
+{
+    _blockingUart = enable;
+}
+
+uint64 HalShim_GetByteTimeNs(void)
+{
+    return ((uint64)HAL_SHIM_BITS_PER_BYTE * 1000000000u) / _baud;
+}
+
+uint32 HalShim_GetTxCount(void)
+{
+    return _txCount;
+}
+
+const uint8 * HalShim_GetTxBytes(void)
+{
+    return _txBytes;
+}
+
+uint64 HalShim_GetTxTimeNs(uint32 index)
+{
+    return (index < _txCount) ? _txTimes[index] : 0u;
+}
+
+void HalShim_ClearTx(void)
+{
+    _txCount = 0u;
+}
+
+void HalShim_SetI2cAddress(uint8 address)
+{
+    _i2cAddress = address;
+}
+
+void HalShim_SetI2cRegister(uint8 reg, uint8 value)
+{
+    _i2cRegisters[reg % HAL_SHIM_I2C_REGISTERS] = value;
+}
+
+uint8 HalShim_GetI2cRegister(uint8 reg)
+{
+    return _i2cRegisters[reg % HAL_SHIM_I2C_REGISTERS];
+}
+
+uint32 HalShim_GetI2cByteCount(void)
+{
+    return _i2cByteCount;
+}
+
+void HalShim_SetAdcVolts(float volts)
+{
+    _adcVolts  = volts;
+    _adcSource = NULL;
+}
+
+void HalShim_SetAdcSource(HalShim_AdcSource source)
+{
+    _adcSource = source;
+}
+
+uint32 HalShim_GetAdcReadCount(void)
+{
+    return _adcReadCount;
+}
+
+uint64 HalShim_MonotonicNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64)now.tv_sec * 1000000000u) + (uint64)now.tv_nsec;
+}
+
+static void _serviceTxIsr(void)
+{
+    uint8 level;
+
+    /* no nesting: a write made from inside the ISR unmasks it again, which
+     * is picked up by this loop once the running ISR returns */
+    if((NULL == _txIsr) || _txIsrActive)
+    {
+        return;
+    }
+    _txIsrActive = 1u;
+    while((_txInterruptMode & UART_1_TX_STS_FIFO_NOT_FULL) && (_txFifoLevel < UART_1_TX_BUFFER_SIZE))
+    {
+        level = _txFifoLevel;
+        _txIsr();
+        if((level == _txFifoLevel) && (_txInterruptMode & UART_1_TX_STS_FIFO_NOT_FULL))
+        {
+            break; /* an ISR that neither fills nor masks would hang the target too */
+        }
+    }
+    _txIsrActive = 0u;
+}
+
+static void _serviceRx(void)
+{
+    uint8 level;
+
+    if(CY_DMA_INVALID_CHANNEL != _rxDrqChannel)
+    {
+        /* the DRQ stays asserted while the FIFO holds a byte */
+        while(_rxFifoLevel > 0u)
+        {
+            UART_1_rxDataRegister = _rxFifo[0];
+            if(0u == CyDmaMock_Request(_rxDrqChannel, 1u))
+            {
+                break; /* channel stopped: the bytes wait in the FIFO */
+            }
+            (void)_popRxFifo();
+        }
+        return;
+    }
+    while((NULL != _rxIsr) && (_rxFifoLevel > 0u))
+    {
+        level = _rxFifoLevel;
+        _rxIsr();
+        if(level == _rxFifoLevel)
+        {
+            break; /* an ISR that does not read the FIFO */
+        }
+    }
+}
+
+static uint8 _popRxFifo(void)
+{
+    uint8 value = _rxFifo[0];
+    if(0u == _rxFifoLevel)
+    {
+        return UART_1_rxDataRegister;
+    }
+    _rxFifoLevel--;
+    memmove(&_rxFifo[0], &_rxFifo[1], _rxFifoLevel);
+    UART_1_rxDataRegister = value;
+    return value;
+}
+
+static void _recordTxByte(uint8 value)
+{
+    if(_txCount == _txCapacity)
+    {
+        uint32 newCapacity = (0u == _txCapacity) ? 4096u : (_txCapacity * 2u);
+        _txBytes    = (uint8 *)realloc(_txBytes, newCapacity);
+        _txTimes    = (uint64 *)realloc(_txTimes, newCapacity * sizeof(uint64));
+        _txCapacity = newCapacity;
+    }
+    _txBytes[_txCount] = value;
+    _txTimes[_txCount] = _timeNs;
+    _txCount++;
+}
+
+/*******************************************************************************
+* CyLib
+*******************************************************************************/
+void CyDelay(uint32 milliseconds)
+{
+    HalShim_AdvanceNs((uint64)milliseconds * 1000000u);
+}
+
+void CyDelayUs(uint16 microseconds)
+{
+    HalShim_AdvanceNs((uint64)microseconds * 1000u);
+}
+
+void CyDelayCycles(uint32 cycles)
+{
+    HalShim_AdvanceNs(((uint64)cycles * 1000000000u) / BCLK__BUS_CLK__HZ);
+}
+
+uint8 CyEnterCriticalSection(void)
+{
+    return 0u;
+}
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    (void)savedIntrStatus;
+}
+
+/*******************************************************************************
+* UART_1
+*******************************************************************************/
+void UART_1_Start(void)
+{
+}
+
+void UART_1_Stop(void)
+{
+}
+
+uint8 UART_1_ReadRxStatus(void)
+{
+    /* error bits are clear on read, like the status register */
+    uint8 status = (uint8)(_rxStatus | ((_rxFifoLevel > 0u) ? UART_1_RX_STS_FIFO_NOTEMPTY : 0u));
+    _rxStatus = 0u;
+    return status;
+}
+
+uint8 UART_1_GetChar(void)
+{
+    return (_rxFifoLevel > 0u) ? _popRxFifo() : 0u;
+}
+
+uint8 UART_1_ReadRxData(void)
+{
+    return _popRxFifo();
+}
+
+uint8 UART_1_GetRxBufferSize(void)
+{
+    return _rxFifoLevel;
+}
+
+void UART_1_ClearRxBuffer(void)
+{
+    _rxFifoLevel = 0u;
+}
+
+uint8 UART_1_ReadTxStatus(void)
+{
+    if(NULL != _txIsr)
+    {
+        return (uint8)(((_txFifoLevel < UART_1_TX_BUFFER_SIZE) ? UART_1_TX_STS_FIFO_NOT_FULL : UART_1_TX_STS_FIFO_FULL) |
+                       ((0u == _txFifoLevel) ? (UART_1_TX_STS_FIFO_EMPTY | UART_1_TX_STS_COMPLETE) : 0u));
+    }
+    return (uint8)(UART_1_TX_STS_FIFO_EMPTY | UART_1_TX_STS_FIFO_NOT_FULL | UART_1_TX_STS_COMPLETE);
+}
+
+void UART_1_WriteTxData(uint8 txDataByte)
+{
+    UART_1_TXDATA_REG = txDataByte;
+    _recordTxByte(txDataByte);
+    if((NULL != _txIsr) && (_txFifoLevel < UART_1_TX_BUFFER_SIZE))
+    {
+        _txFifoLevel++;
+    }
+}
+
+void UART_1_PutChar(uint8 txDataByte)
+{
+    if(_blockingUart)
+    {
+        HalShim_AdvanceNs(HalShim_GetByteTimeNs());
+    }
+    UART_1_WriteTxData(txDataByte);
+}
+
+void UART_1_PutString(const char8 string[])
+{
+    while(0 != *string)
+    {
+        UART_1_PutChar((uint8)*string++);
+    }
+}
+
+void UART_1_PutArray(const uint8 string[], uint8 byteCount)
+{
+    uint8 i;
+    for(i = 0u; i < byteCount; i++)
+    {
+        UART_1_PutChar(string[i]);
+    }
+}
+
+uint8 UART_1_GetTxBufferSize(void)
+{
+    return 0u;
+}
+
+void UART_1_ClearTxBuffer(void)
+{
+}
+
+void UART_1_SetTxInterruptMode(uint8 intSrc)
+{
+    _txInterruptMode = intSrc;
+    _serviceTxIsr();
+}
+
+/*******************************************************************************
+* SysTimers
+*******************************************************************************/
+void SysTimers_Start(void)
+{
+}
+
+void SysTimers_Stop(void)
+{
+}
+
+uint32 SysTimers_GetSysTickValue(void)
+{
+    return (uint32)(_timeNs / (1000000000u / SysTimers_TICKS_PER_SECOND));
+}
+
+/*******************************************************************************
+* I2CM1
+*******************************************************************************/
+static void _i2cBusBits(uint32 bits)
+{
+    HalShim_AdvanceNs(((uint64)bits * 1000000u) / I2CM1_DATA_RATE);
+}
+
+void I2CM1_Start(void)
+{
+}
+
+void I2CM1_Stop(void)
+{
+}
+
+uint8 I2CM1_MasterSendStart(uint8 slaveAddress, uint8 R_nW)
+{
+    _i2cBusBits(1u + 9u);
+    _i2cByteCount++;
+    _i2cSelected = (slaveAddress == _i2cAddress);
+    if(I2CM1_WRITE_XFER_MODE == R_nW)
+    {
+        _i2cPointerSet = 0u;
+    }
+    return _i2cSelected ? I2CM1_MSTR_NO_ERROR : I2CM1_MSTR_ERR_LB_NAK;
+}
+
+uint8 I2CM1_MasterSendRestart(uint8 slaveAddress, uint8 R_nW)
+{
+    return I2CM1_MasterSendStart(slaveAddress, R_nW);
+}
+
+uint8 I2CM1_MasterSendStop(void)
+{
+    _i2cBusBits(1u);
+    _i2cSelected = 0u;
+    return I2CM1_MSTR_NO_ERROR;
+}
+
+uint8 I2CM1_MasterWriteByte(uint8 theByte)
+{
+    _i2cBusBits(9u);
+    _i2cByteCount++;
+    if(!_i2cSelected)
+    {
+        return I2CM1_MSTR_ERR_LB_NAK;
+    }
+    if(!_i2cPointerSet)
+    {
+        _i2cPointer       = theByte & 0x7Fu;
+        _i2cAutoIncrement = theByte & 0x80u;
+        _i2cPointerSet    = 1u;
+    }
+    else
+    {
+        _i2cRegisters[_i2cPointer] = theByte;
+        if(_i2cAutoIncrement)
+        {
+            _i2cPointer = (_i2cPointer + 1u) % HAL_SHIM_I2C_REGISTERS;
+        }
+    }
+    return I2CM1_MSTR_NO_ERROR;
+}
+
+uint8 I2CM1_MasterReadByte(uint8 acknNak)
+{
+    uint8 value;
+
+    (void)acknNak;
+    _i2cBusBits(9u);
+    _i2cByteCount++;
+    if(!_i2cSelected)
+    {
+        return 0xFFu;   /* nobody drives SDA */
+    }
+    value = _i2cRegisters[_i2cPointer];
+    if(_i2cAutoIncrement)
+    {
+        _i2cPointer = (_i2cPointer + 1u) % HAL_SHIM_I2C_REGISTERS;
+    }
+    return value;
+}
+
+/*******************************************************************************
+* ADC
+*******************************************************************************/
+#define ADC_SHIM_MAX_COUNTS ((1 << ADC_DEFAULT_RESOLUTION) - 1)
+
+void ADC_Start(void)
+{
+}
+
+void ADC_Stop(void)
+{
+}
+
+void ADC_StartConvert(void)
+{
+}
+
+void ADC_StopConvert(void)
+{
+}
+
+uint8 ADC_IsEndConversion(uint8 retMode)
+{
+    (void)retMode;
+    return 1u;  /* free running: a result is always there */
+}
+
+int16 ADC_GetResult16(void)
+{
+    float volts = (NULL != _adcSource) ? _adcSource(_timeNs) : _adcVolts;
+    float counts = volts * (ADC_SHIM_MAX_COUNTS + 1) / ADC_SHIM_FULL_SCALE_VOLTS + 0.5f;
+
+    _adcReadCount++;
+    if(counts < 0.0f)
+    {
+        return 0;
+    }
+    return (counts > ADC_SHIM_MAX_COUNTS) ? (int16)ADC_SHIM_MAX_COUNTS : (int16)counts;
+}
+
+float32 ADC_CountsTo_Volts(int16 adcCounts)
+{
+    return ((float32)adcCounts * ADC_SHIM_FULL_SCALE_VOLTS) / (ADC_SHIM_MAX_COUNTS + 1);
+}
+
+/*******************************************************************************
+* Cortex-M3 DWT cycle counter
+*******************************************************************************/
+static uint64 _cyclesAt(uint64 timeNs)
+{
+    return (timeNs * (BCLK__BUS_CLK__HZ / 1000000u)) / 1000u;
+}
+
+DWT_Type * HalShim_Dwt(void)
+{
+    /* bring CYCCNT up to the simulated clock on every access */
+    if((0u != (_coreDebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk)) &&
+       (0u != (_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk)))
+    {
+        _dwt.CYCCNT += (uint32)(_cyclesAt(_timeNs) - _cyclesAt(_dwtSyncedNs));
+    }
+    _dwtSyncedNs = _timeNs;
+    return &_dwt;
+}
+
+CoreDebug_Type * HalShim_CoreDebug(void)
+{
+    return &_coreDebug;
+}
+
+/* [] END OF FILE */
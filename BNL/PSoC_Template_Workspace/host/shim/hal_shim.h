@@ -0,0 +1,60 @@
+/*******************************************************************************
+* File Name: hal_shim.h
+*
+* Description:
+*  Host-only controls for the HAL shim: a simulated clock, a model of the
+*  UART wire time and its TX and RX FIFOs, an in-memory record of every
+*  transmitted byte, the I2C slave behind I2CM1 and the voltage at the ADC
+*  input.
+*
+*******************************************************************************/
+#if !defined(HAL_SHIM_H)
+#define HAL_SHIM_H
+
+#include "cytypes.h"
+
+#define HAL_SHIM_DEFAULT_BAUD   (230400u)
+#define HAL_SHIM_BITS_PER_BYTE  (10u)   /* 8N1 */
+#define HAL_SHIM_I2C_DEFAULT_ADDRESS (0x0Cu) /* LIS2DH_LOW_ADDRESS in i2c_service.c */
+#define HAL_SHIM_I2C_REGISTERS  (128u)
+
+typedef float (*HalShim_AdcSource)(uint64 timeNs);
+typedef void  (*HalShim_Isr)(void);
+
+void          HalShim_Reset(void);
+
+uint64        HalShim_GetTimeNs(void);
+void          HalShim_AdvanceNs(uint64 nanoseconds);
+
+void          HalShim_BindUartTxDrq(uint8 chHandle);
+void          HalShim_BindUartTxIsr(HalShim_Isr isr);
+uint8         HalShim_GetUartTxInterruptMode(void);
+void          HalShim_BindUartRxDrq(uint8 chHandle);
+void          HalShim_BindUartRxIsr(HalShim_Isr isr);
+void          HalShim_ReceiveBytes(const uint8 * data, uint32 numBytes);
+uint32        HalShim_GetRxOverrunCount(void);
+uint8         HalShim_GetRxFifoLevel(void);
+void          HalShim_SetUartBaud(uint32 baud);
+void          HalShim_SetBlockingUart(uint8 enable);
+uint64        HalShim_GetByteTimeNs(void);
+
+uint32        HalShim_GetTxCount(void);
+const uint8 * HalShim_GetTxBytes(void);
+uint64        HalShim_GetTxTimeNs(uint32 index);
+void          HalShim_ClearTx(void);
+
+void          HalShim_SetI2cAddress(uint8 address);
+void          HalShim_SetI2cRegister(uint8 reg, uint8 value);
+uint8         HalShim_GetI2cRegister(uint8 reg);
+uint32        HalShim_GetI2cByteCount(void);
+
+void          HalShim_SetAdcVolts(float volts);
+void          HalShim_SetAdcSource(HalShim_AdcSource source);
+uint32        HalShim_GetAdcReadCount(void);
+
+uint64        HalShim_MonotonicNs(void);
+
+#endif /* HAL_SHIM_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,18 @@
+/*******************************************************************************
+* File Name: project.h (host shim)
+*
+* Description:
+*  Pulls in the host stand-ins for every component the user modules touch.
+*
+*******************************************************************************/
+#include "cytypes.h"
+#include "CyLib.h"
+#include "CyDmac.h"
+#include "UART_1.h"
+#include "SysTimers.h"
+#include "I2CM1.h"
+#include "ADC.h"
+#include "core_cm3_psoc5.h"
+#include "hal_shim.h"
+
+/*[]*/
@@ -0,0 +1,76 @@
+"""
+End to end check of batched command frames: encodes frames with
+BNL/command_batch.py, runs them through the firmware parser with
+test_command_table --run and decodes the status packets that come back.
+
+    python check_command_batch.py <dir of command_batch.py> <test_command_table>
+"""
+import os
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, sys.argv[1])
+import command_batch as cb
+
+FLAG_GAIN, FLAG_OFFSET, FLAG_RESET, FLAG_MISSING = 1, 2, 3, 4
+
+def main():
+    # 90 settings, more than one frame holds: the last gain wins, every
+    # 10th gain is out of range and every 15th setting hits no handler
+    entries = []
+    expected = []
+    for i in range(90):
+        if i % 15 == 14:
+            entries.append((FLAG_MISSING, cb.VALUE_INT32, -i))
+            expected.append(1)
+        elif i % 3 == 0:
+            gain = 150 if i % 10 == 0 else i
+            entries.append((FLAG_GAIN, cb.VALUE_UINT16, gain))
+            expected.append(3 if gain > 100 else 0)
+        elif i % 3 == 1:
+            entries.append((FLAG_OFFSET, cb.VALUE_FLOAT32, i * 0.25))
+            expected.append(0)
+        else:
+            entries.append((FLAG_RESET, cb.VALUE_NONE, None))
+            expected.append(0)
+    batches = cb.splitEntries(entries)
+
+    workDir = tempfile.mkdtemp()
+    framesPath = os.path.join(workDir, 'frames.txt')
+    statusPath = os.path.join(workDir, 'status.txt')
+    with open(framesPath, 'w') as f:
+        for frameId, batch in enumerate(batches):
+            f.write(''.join('%02x' % b for b in cb.encodeFrame(frameId + 10, batch)) + '\n')
+    subprocess.check_call([sys.argv[2], '--run', framesPath, statusPath])
+
+    with open(statusPath, 'r') as f:
+        lines = f.read().split('\n')
+    statuses = [cb.decodeStatus(bytearray.fromhex(line)) for line in lines if line and not line.startswith('gain')]
+    state = [line for line in lines if line.startswith('gain')][0].split()
+
+    failures = 0
+    if [s.frameId for s in statuses] != [i + 10 for i in range(len(batches))]:
+        print('FAILED frame ids %s' % [s.frameId for s in statuses])
+        failures += 1
+    if [code for s in statuses for code in s.statuses] != expected:
+        print('FAILED statuses')
+        failures += 1
+    lastGain = [v for (flag, t, v), code in zip(entries, expected) if flag == FLAG_GAIN and code == 0][-1]
+    lastOffset = [v for flag, t, v in entries if flag == FLAG_OFFSET][-1]
+    numResets = len([1 for flag, t, v in entries if flag == FLAG_RESET])
+    if int(state[1]) != lastGain or float(state[3]) != lastOffset or int(state[5]) != numResets:
+        print('FAILED firmware state %s' % state)
+        failures += 1
+    try:
+        cb.encodeFrame(0, [(FLAG_GAIN, cb.VALUE_INT32, 0)] * 50)
+        print('FAILED oversized frame encoded')
+        failures += 1
+    except ValueError:
+        pass
+    print('%d settings in %d frames, %d failed as expected' % (len(entries), len(batches),
+          sum(len(s.failed()) for s in statuses)))
+    return 1 if failures else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
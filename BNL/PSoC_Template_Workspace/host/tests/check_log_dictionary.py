@@ -0,0 +1,44 @@
+"""
+End to end check of the deferred log: runs test_log_deferred --dump, pulls the
+log_fmt section out of that binary with log_dictionary.py (as it would from the
+firmware .elf) and expands every payload, which must read exactly like the
+vsnprintf output recorded next to it.
+
+    python check_log_dictionary.py <dir of log_dictionary.py> <test_log_deferred>
+"""
+import os
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, sys.argv[1])
+import log_dictionary
+
+def main():
+    binary = sys.argv[2]
+    workDir = tempfile.mkdtemp()
+    dumpPath = os.path.join(workDir, 'dump.txt')
+    dictionaryPath = os.path.join(workDir, 'log_dictionary.json')
+    subprocess.check_call([binary, '--dump', dumpPath])
+
+    section = log_dictionary.readSection(binary)
+    if section is None:
+        print('no log_fmt section in ' + binary)
+        return 1
+    log_dictionary.save(log_dictionary.buildDictionary(section), dictionaryPath)
+    dictionary = log_dictionary.load(dictionaryPath)
+
+    failures = 0
+    with open(dumpPath, 'r') as f:
+        for line in f:
+            hexPayload, expected = line.rstrip('\n').split('\t', 1)
+            expanded = log_dictionary.expand(dictionary, bytearray.fromhex(hexPayload))
+            status = 'ok' if expanded == expected else 'FAILED'
+            if expanded != expected:
+                failures += 1
+            print('%-6s %r -> %r' % (status, expected, expanded))
+    print('%d log formats, CRC 0x%04X' % (len(dictionary['formats']), dictionary['crc']))
+    return 1 if failures else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,49 @@
+"""
+Runs test_timebase --dump and unwraps its 32-bit wire timestamps with
+BNL/packet_time.py: every one must come back as the full count the firmware
+had, across several 23.8 minute wraps. unwrapNear() must place sample batch
+timestamps next to their packet's time on either side of a wrap.
+
+    python check_packet_time.py <dir of packet_time.py> <test_timebase>
+"""
+import os
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, sys.argv[1])
+import packet_time
+
+def main():
+    dumpPath = os.path.join(tempfile.mkdtemp(), 'dump.txt')
+    subprocess.check_call([sys.argv[2], '--dump', dumpPath])
+
+    unwrapper = packet_time.TimestampUnwrapper()
+    failures = 0
+    count = 0
+    with open(dumpPath, 'r') as f:
+        for line in f:
+            wire, full = [int(v) for v in line.split()]
+            if unwrapper.unwrap(wire) != full:
+                failures += 1
+            count += 1
+    print('%d timestamps over %.1f hours, %d wrong' % (count, unwrapper.last / packet_time.PACKET_TIMESTAMP_HZ / 3600.0, failures))
+    return 1 if (failures or _checkUnwrapNear()) else 0
+
+def _checkUnwrapNear():
+    # sample batch timestamps just before the 32-bit wrap in a packet sent just
+    # after it, and the other way round for a packet stamped before its samples
+    failures = 0
+    reference = (3 << 32) + 100
+    if packet_time.unwrapNear((1 << 32) - 200, reference) != (3 << 32) - 200:
+        failures += 1
+    reference = (3 << 32) - 100
+    if packet_time.unwrapNear(50, reference) != (3 << 32) + 50:
+        failures += 1
+    if packet_time.unwrapNear(reference % (1 << 32), reference) != reference:
+        failures += 1
+    print('unwrapNear across the wrap, %d wrong' % failures)
+    return failures
+
+if __name__ == '__main__':
+    sys.exit(main())
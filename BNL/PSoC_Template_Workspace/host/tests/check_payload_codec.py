@@ -0,0 +1,39 @@
+"""
+Runs test_payload_codec --dump and decodes every encoded payload with
+BNL/payload_codec.py: each must come back byte for byte as the original.
+
+    python check_payload_codec.py <dir of payload_codec.py> <test_payload_codec>
+"""
+import binascii
+import os
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, sys.argv[1])
+import payload_codec
+
+def main():
+    dumpPath = os.path.join(tempfile.mkdtemp(), 'dump.txt')
+    subprocess.check_call([sys.argv[2], '--dump', dumpPath])
+
+    decoder = payload_codec.PayloadDecoder()
+    failures = 0
+    count = 0
+    with open(dumpPath, 'r') as f:
+        for line in f:
+            codec, encoded, original = line.split()
+            decoded = decoder.decode(int(codec), bytearray(binascii.unhexlify(encoded)))
+            if decoded != bytearray(binascii.unhexlify(original)):
+                print('FAILED %s payload %d' % (payload_codec.CODEC_NAMES[int(codec)], count))
+                failures += 1
+            count += 1
+
+    if payload_codec.splitMessageType(0x43) != (3, payload_codec.CODEC_DELTA_VARINT):
+        print('FAILED splitMessageType')
+        failures += 1
+    print('%d payloads, %s' % (count, decoder))
+    return 1 if failures else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,81 @@
+"""
+End to end check of the RPC layer: BNL/rpc.py RpcClient keeps requests in
+flight within its window, test_rpc --run answers them through the firmware
+parser, and every response has to find its own call by id.
+
+    python check_rpc.py <dir of rpc.py> <test_rpc>
+"""
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, sys.argv[1])
+import rpc
+
+METHOD_SUM = 0x20
+
+def main():
+    workDir = tempfile.mkdtemp()
+    requestsPath = os.path.join(workDir, 'requests.txt')
+    responsesPath = os.path.join(workDir, 'responses.txt')
+    written = []
+    client = rpc.RpcClient(written.append, maxInFlight = 5, maxInFlightBytes = 120)
+    answered = []
+
+    calls = []
+    for i in range(40):
+        if i % 4 == 0:
+            calls.append(client.call(rpc.METHOD_PING, bytearray([i] * (i % 9)), answered.append))
+        elif i % 4 == 1:
+            calls.append(client.call(METHOD_SUM, bytearray([i, 1, 2]), answered.append))
+        elif i % 4 == 2:
+            calls.append(client.set(1, 1, i * 3, answered.append))
+        else:
+            calls.append(client.call(0x66, b'', answered.append))
+
+    failures = 0
+    rounds = 0
+    while written:
+        # whatever the client let out is one burst on the wire
+        if client.inFlight() > 5:
+            print('FAILED window exceeded: %d in flight' % client.inFlight())
+            failures += 1
+        burst = bytearray().join(bytearray(w) for w in written)
+        del written[:]
+        with open(requestsPath, 'w') as f:
+            f.write(''.join('%02x' % b for b in burst) + '\n')
+        subprocess.check_call([sys.argv[2], '--run', requestsPath, responsesPath])
+        with open(responsesPath, 'r') as f:
+            lines = [line.strip() for line in f if line.strip()]
+        if lines[-1] != 'overruns 0':
+            print('FAILED receive ring %s' % lines[-1])
+            failures += 1
+        for line in reversed(lines[:-1]):      # answers out of order: ids, not order, match them
+            if not client.handleResponse(bytearray.fromhex(line)):
+                print('FAILED response matched no call')
+                failures += 1
+        rounds += 1
+
+    for i, call in enumerate(calls):
+        status, result = call.wait(0)
+        if i % 4 == 0:
+            ok = status == rpc.STATUS_OK and result == bytearray([i] * (i % 9))
+        elif i % 4 == 1:
+            ok = status == rpc.STATUS_OK and struct.unpack('<H', bytes(result))[0] == i + 3
+        elif i % 4 == 2:
+            ok = status == rpc.STATUS_OK and result[0] == (0 if i * 3 <= 100 else 3)
+        else:
+            ok = status == rpc.STATUS_NO_METHOD
+        if not ok:
+            print('FAILED call %d: %s %r' % (i, status, result))
+            failures += 1
+    if len(answered) != len(calls):
+        print('FAILED %d callbacks for %d calls' % (len(answered), len(calls)))
+        failures += 1
+    print('%d calls in %d round trips' % (len(calls), rounds))
+    return 1 if failures else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
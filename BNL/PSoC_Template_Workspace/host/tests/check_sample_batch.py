@@ -0,0 +1,54 @@
+"""
+End to end check of the sample batch frames: runs test_sample_batcher --dump,
+decodes every batch with BNL/sample_batch.py and checks that concatenating
+them gives back exactly the timestamps and values that went in.
+
+    python check_sample_batch.py <dir of sample_batch.py> <test_sample_batcher>
+"""
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, sys.argv[1])
+import sample_batch
+
+def _asFloat32(value):
+    return struct.unpack('<f', struct.pack('<f', value))[0]
+
+def main():
+    dumpPath = os.path.join(tempfile.mkdtemp(), 'dump.txt')
+    subprocess.check_call([sys.argv[2], '--dump', dumpPath])
+
+    ticks = []
+    values = []
+    batches = []
+    with open(dumpPath, 'r') as f:
+        for line in f:
+            kind, rest = line.split(' ', 1)
+            if kind == 'samples':
+                ticks = [int(t) for t in rest.split()]
+            elif kind == 'values':
+                values = [_asFloat32(float(v)) for v in rest.split()]
+            else:
+                batches.append(sample_batch.decode(bytearray.fromhex(rest.strip())))
+
+    decodedTicks = [t for batch in batches for t in batch.ticks]
+    decodedValues = [v for batch in batches for sample in batch.values for v in sample]
+    failures = 0
+    if decodedTicks != ticks:
+        print('FAILED timestamps differ')
+        failures += 1
+    if decodedValues != values:
+        print('FAILED values differ')
+        failures += 1
+    if set(batch.channel for batch in batches) != set([9]):
+        print('FAILED channel')
+        failures += 1
+    print('%d samples in %d batches, %d to %d per batch' % (len(decodedTicks), len(batches),
+          min(len(b.ticks) for b in batches), max(len(b.ticks) for b in batches)))
+    return 1 if failures else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,179 @@
+/*******************************************************************************
+* File Name: eig_fixture.c
+*
+* Description:
+*  Known-spectrum matrices and samples for the eig test programs, see
+*  eig_fixture.h.
+*
+*******************************************************************************/
+#include "eig_fixture.h"
+
+#include <math.h>
+
+float eigFixture_Q[MAT_SIZE][MAT_SIZE];
+float eigFixture_Sigma[MAT_SIZE][MAT_SIZE];
+
+static uint32 _sampleSeed = 1u;
+
+static float _uniform(void)
+{
+    _sampleSeed = _sampleSeed * 1103515245u + 12345u;
+    return (float)((_sampleSeed >> 8) & 0xFFFFu) / 65536.0f;
+}
+
+/* Q = I - 2 v v' / v'v with v from the LCG, returns the LCG state after v */
+uint32 eigFixture_buildQ(uint32 seed)
+{
+    float v[MAT_SIZE];
+    float norm2 = 0.0f;
+    uint8 i, j;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        v[i] = (float)((seed >> 8) & 0xFFFFu) / 65536.0f - 0.5f;
+        norm2 += v[i] * v[i];
+    }
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            eigFixture_Q[i][j] = ((i == j) ? 1.0f : 0.0f) - 2.0f * v[i] * v[j] / norm2;
+        }
+    }
+    return seed;
+}
+
+/* Sigma = Q diag(lambda) Q' on the current Q */
+void eigFixture_applySpectrum(const float lambda[MAT_SIZE])
+{
+    uint8 i, j, k;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            double sum = 0.0;
+            for(k = 0u; k < MAT_SIZE; k++)
+            {
+                sum += (double)eigFixture_Q[i][k] * lambda[k] * eigFixture_Q[j][k];
+            }
+            eigFixture_Sigma[i][j] = (float)sum;
+        }
+    }
+}
+
+void eigFixture_buildSigma(const float lambda[MAT_SIZE], uint32 seed)
+{
+    eigFixture_buildQ(seed);
+    eigFixture_applySpectrum(lambda);
+}
+
+/* 16, 8, 4, ... on the principal components, well separated from the rest */
+void eigFixture_knownSpectrum(float lambdaTrue[MAT_SIZE], uint32 seed)
+{
+    uint8 i;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        lambdaTrue[i] = (i < PRINCIPLE_COMPONENTS) ? (16.0f / (float)(1u << i)) : 0.01f * (MAT_SIZE - i);
+    }
+    eigFixture_buildSigma(lambdaTrue, seed);
+}
+
+void eigFixture_initialGuess(float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE])
+{
+    uint8 i, j;
+
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            Eig_vecs_init[i][j] = 1.0f + 0.01f * (float)((i * 7u + j * 3u) % 11u);
+        }
+    }
+}
+
+/* |cos| of the angle between phi and column of Q */
+float eigFixture_alignment(const float phi[MAT_SIZE], uint8 column)
+{
+    float c = 0.0f;
+    uint8 i;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        c += phi[i] * eigFixture_Q[i][column];
+    }
+    return fabsf(c);
+}
+
+float eigFixture_worstOverlap(float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE])
+{
+    float worst = 0.0f;
+    uint8 i, j;
+
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        for(j = 0u; j < i; j++)
+        {
+            worst = fmaxf(worst, fabsf(dot(Phi[i], Phi[j])));
+        }
+    }
+    return worst;
+}
+
+/* decomp on the known spectrum with seed 99 from the fixed initial guess */
+eigFixtureErrors eigFixture_decompose(eigFixtureDecomp decomp, uint8 p_iter, uint8 r_iter)
+{
+    float lambdaTrue[MAT_SIZE];
+    float lambda[PRINCIPLE_COMPONENTS];
+    float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    eigFixtureErrors errors = {0.0f, 0.0f, 0.0f};
+    uint8 i;
+
+    eigFixture_knownSpectrum(lambdaTrue, 99u);
+    eigFixture_initialGuess(Eig_vecs_init);
+    decomp(lambda, Phi, eigFixture_Sigma, Eig_vecs_init, p_iter, r_iter);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        errors.lambda = fmaxf(errors.lambda, fabsf(lambda[i] - lambdaTrue[i]) / lambdaTrue[i]);
+        errors.alignment = fmaxf(errors.alignment, 1.0f - eigFixture_alignment(Phi[i], i));
+    }
+    errors.overlap = eigFixture_worstOverlap(Phi);
+    return errors;
+}
+
+/* standard deviation of eigFixture_sample() along column k of Q */
+float eigFixture_sigmaAlong(uint8 k)
+{
+    return (k < PRINCIPLE_COMPONENTS) ? sqrtf(16.0f / (float)(1u << k)) : 0.3f;
+}
+
+/* x = offset + Q diag(eigFixture_sigmaAlong) z, z roughly standard normal */
+void eigFixture_sample(float x[MAT_SIZE])
+{
+    float z[MAT_SIZE];
+    uint8 i, k;
+
+    for(k = 0u; k < MAT_SIZE; k++)
+    {
+        z[k] = -6.0f;
+        for(i = 0u; i < 12u; i++)
+        {
+            z[k] += _uniform();
+        }
+        z[k] *= eigFixture_sigmaAlong(k);
+    }
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        x[i] = 5.0f + 0.1f * (float)i;
+        for(k = 0u; k < MAT_SIZE; k++)
+        {
+            x[i] += eigFixture_Q[i][k] * z[k];
+        }
+    }
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,48 @@
+/*******************************************************************************
+* File Name: eig_fixture.h
+*
+* Description:
+*  Matrices shared by the eig test programs: a Householder reflection Q from
+*  the LCG whose columns are the eigenvectors, Sigma = Q diag(lambda) Q', the
+*  known spectrum (16, 8, 4, ... then small ones), the fixed initial guess,
+*  and roughly normal samples spread along Q's columns for the trackers.
+*  eig_fixture.c is linked into each program. It holds no CHECKs, since
+*  host_test.h counts failures per file; the tests judge what it returns.
+*
+*******************************************************************************/
+#if !defined(EIG_FIXTURE_H)
+#define EIG_FIXTURE_H
+
+#include "eig.h"
+
+/* eig_decomp() or an adapter with its signature, e.g. around eig_decomp_packed() */
+typedef void (*eigFixtureDecomp)(float lambda[PRINCIPLE_COMPONENTS], float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE],
+                                 float Sigma[MAT_SIZE][MAT_SIZE], float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE],
+                                 const uint8 p_iter, const uint8 r_iter);
+
+/* worst over the principal components of one decomposition of the known spectrum */
+typedef struct
+{
+    float lambda;       /* |lambda - lambdaTrue| / lambdaTrue */
+    float alignment;    /* 1 - |phi_i . Q[:,i]| */
+    float overlap;      /* |phi_i . phi_j|, i != j */
+} eigFixtureErrors;
+
+extern float eigFixture_Q[MAT_SIZE][MAT_SIZE];      /* from the last eigFixture_buildQ() */
+extern float eigFixture_Sigma[MAT_SIZE][MAT_SIZE];  /* from the last eigFixture_buildSigma() */
+
+uint32 eigFixture_buildQ(uint32 seed);
+void   eigFixture_applySpectrum(const float lambda[MAT_SIZE]);
+void   eigFixture_buildSigma(const float lambda[MAT_SIZE], uint32 seed);
+void   eigFixture_knownSpectrum(float lambdaTrue[MAT_SIZE], uint32 seed);
+void   eigFixture_initialGuess(float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE]);
+float  eigFixture_alignment(const float phi[MAT_SIZE], uint8 column);
+float  eigFixture_worstOverlap(float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE]);
+eigFixtureErrors eigFixture_decompose(eigFixtureDecomp decomp, uint8 p_iter, uint8 r_iter);
+float  eigFixture_sigmaAlong(uint8 k);
+void   eigFixture_sample(float x[MAT_SIZE]);
+
+#endif /* EIG_FIXTURE_H */
+
+
+/* [] END OF FILE */
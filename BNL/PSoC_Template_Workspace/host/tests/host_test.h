@@ -0,0 +1,37 @@
+/*******************************************************************************
+* File Name: host_test.h
+*
+* Description:
+*  Minimal assertion helpers shared by the host test programs. Each test
+*  program returns non-zero from main() if any CHECK failed.
+*
+*******************************************************************************/
+#if !defined(HOST_TEST_H)
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if(!(cond))                                                         \
+        {                                                                   \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            hostTestFailures++;                                             \
+        }                                                                   \
+    } while(0)
+
+#define RUN_TEST(fn)                                                        \
+    do {                                                                    \
+        int before = hostTestFailures;                                      \
+        fn();                                                               \
+        printf("%-48s %s\n", #fn, (before == hostTestFailures) ? "ok" : "FAILED"); \
+    } while(0)
+
+#define TEST_EXIT_CODE()    ((0 == hostTestFailures) ? 0 : 1)
+
+#endif /* HOST_TEST_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,211 @@
+/*******************************************************************************
+* File Name: test_batch_eig.c
+*
+* Description:
+*  batch_eig_decomp() on a batch of known-spectrum matrices against
+*  eig_decomp() one matrix at a time, for every ISA this CPU runs, with a
+*  batch that does not fill the last chunk, a stride past the count and
+*  several threads. Nothing past the count is written. Threads that cannot
+*  be started leave their share to the calling thread. Bad arguments and
+*  ISAs the CPU lacks are refused.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "eig_fixture.h"
+#include "batch_eig.h"
+
+#include <math.h>
+#include <string.h>
+#if defined(__linux__)
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+#if (BATCH_EIG_MAT_SIZE != MAT_SIZE) || (BATCH_EIG_COMPONENTS != PRINCIPLE_COMPONENTS)
+    #error "batch_eig.h sizes must match eig.h"
+#endif
+
+#define TEST_COUNT  37u     /* 2 chunks of 16 and 5, 4 of 8 and 5 */
+#define TEST_STRIDE 40u
+
+static float _sigma[MAT_SIZE * MAT_SIZE * TEST_STRIDE];
+static float _lambda[PRINCIPLE_COMPONENTS * TEST_STRIDE];
+static float _phi[PRINCIPLE_COMPONENTS * MAT_SIZE * TEST_STRIDE];
+static float _init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+
+/* eig_fixture.c's Sigma, a different reflection and a slightly different
+   spectrum per matrix */
+static void _buildBatch(void)
+{
+    float d[MAT_SIZE];
+    uint32 seed = 5u;
+    uint32 m;
+    uint8 i, j;
+
+    for(m = 0u; m < TEST_COUNT; m++)
+    {
+        for(i = 0u; i < MAT_SIZE; i++)
+        {
+            d[i] = (i < PRINCIPLE_COMPONENTS) ? (16.0f + 0.1f * (float)m) / (float)(1u << i) : 0.01f * (MAT_SIZE - i);
+        }
+        seed = eigFixture_buildQ(seed);
+        eigFixture_applySpectrum(d);
+        for(i = 0u; i < MAT_SIZE; i++)
+        {
+            for(j = 0u; j < MAT_SIZE; j++)
+            {
+                _sigma[(i * MAT_SIZE + j) * TEST_STRIDE + m] = eigFixture_Sigma[i][j];
+            }
+        }
+    }
+    eigFixture_initialGuess(_init);
+}
+
+/* worst eigenvalue error and eigenvector misalignment against eig_decomp() */
+static void _compare(uint8 p_iter, uint8 r_iter, float * lambdaError, float * phiError)
+{
+    static float Sigma[MAT_SIZE][MAT_SIZE];
+    float lambda[PRINCIPLE_COMPONENTS];
+    float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float c;
+    uint32 m;
+    uint8 i, j, k;
+
+    *lambdaError = 0.0f;
+    *phiError = 0.0f;
+    for(m = 0u; m < TEST_COUNT; m++)
+    {
+        for(i = 0u; i < MAT_SIZE; i++)
+        {
+            for(j = 0u; j < MAT_SIZE; j++)
+            {
+                Sigma[i][j] = _sigma[(i * MAT_SIZE + j) * TEST_STRIDE + m];
+            }
+        }
+        eig_decomp(lambda, Phi, Sigma, _init, p_iter, r_iter);
+        for(k = 0u; k < PRINCIPLE_COMPONENTS; k++)
+        {
+            *lambdaError = fmaxf(*lambdaError, fabsf(_lambda[k * TEST_STRIDE + m] - lambda[k]) / lambda[k]);
+            c = 0.0f;
+            for(j = 0u; j < MAT_SIZE; j++)
+            {
+                c += _phi[(k * MAT_SIZE + j) * TEST_STRIDE + m] * Phi[k][j];
+            }
+            *phiError = fmaxf(*phiError, 1.0f - fabsf(c));
+        }
+    }
+}
+
+static void _checkIsa(batch_eig_isa isa)
+{
+    float lambdaError, phiError;
+    uint32 m;
+
+    if(!batch_eig_isa_supported(isa))
+    {
+        printf("  %s: not on this CPU, skipped\n", batch_eig_isa_name(isa));
+        return;
+    }
+    memset(_lambda, 0xA5, sizeof(_lambda));
+    memset(_phi, 0xA5, sizeof(_phi));
+    CHECK((int)isa == batch_eig_decomp(_sigma, _lambda, _phi, TEST_COUNT, TEST_STRIDE, _init, 10u, 3u, 3u, isa));
+    _compare(10u, 3u, &lambdaError, &phiError);
+    CHECK(lambdaError < 1e-5f);
+    CHECK(phiError < 1e-5f);
+    printf("  %s p10 r3: worst lambda error %.2g, 1 - |cos| %.2g\n", batch_eig_isa_name(isa),
+        (double)lambdaError, (double)phiError);
+
+    /* the padding lanes stay inside the chunk */
+    for(m = TEST_COUNT; m < TEST_STRIDE; m++)
+    {
+        CHECK(0xA5u == ((const uint8 *)&_lambda[(PRINCIPLE_COMPONENTS - 1u) * TEST_STRIDE + m])[0]);
+        CHECK(0xA5u == ((const uint8 *)&_phi[(PRINCIPLE_COMPONENTS * MAT_SIZE - 1u) * TEST_STRIDE + m])[0]);
+    }
+
+    /* power iterations only, the eigenvalues are not converged yet and must
+       still agree */
+    CHECK((int)isa == batch_eig_decomp(_sigma, _lambda, _phi, TEST_COUNT, TEST_STRIDE, _init, 30u, 0u, 1u, isa));
+    _compare(30u, 0u, &lambdaError, &phiError);
+    CHECK(lambdaError < 1e-4f);
+    CHECK(phiError < 1e-4f);
+}
+
+static void test_scalar(void)
+{
+    _buildBatch();
+    _checkIsa(BATCH_EIG_ISA_SCALAR);
+}
+
+static void test_avx2(void)
+{
+    _checkIsa(BATCH_EIG_ISA_AVX2);
+}
+
+static void test_avx512(void)
+{
+    _checkIsa(BATCH_EIG_ISA_AVX512);
+}
+
+/* an address space limit a couple of MB over what is mapped leaves room
+   for the workspace but not for a thread stack, so std::thread throws */
+static void test_no_threads(void)
+{
+#if defined(__linux__)
+    struct rlimit saved, limited;
+    unsigned long pages = 0u;
+    float lambdaError, phiError;
+    FILE * statm;
+    int isa;
+
+    statm = fopen("/proc/self/statm", "r");
+    CHECK(NULL != statm);
+    if(NULL == statm)
+    {
+        return;
+    }
+    CHECK(1 == fscanf(statm, "%lu", &pages));
+    fclose(statm);
+    CHECK(0 == getrlimit(RLIMIT_AS, &saved));
+    limited = saved;
+    limited.rlim_cur = (rlim_t)pages * (rlim_t)sysconf(_SC_PAGESIZE) + (2u << 20);
+    CHECK(0 == setrlimit(RLIMIT_AS, &limited));
+    isa = batch_eig_decomp(_sigma, _lambda, _phi, TEST_COUNT, TEST_STRIDE, _init, 10u, 3u, 4u, BATCH_EIG_ISA_SCALAR);
+    CHECK(0 == setrlimit(RLIMIT_AS, &saved));
+
+    CHECK((int)BATCH_EIG_ISA_SCALAR == isa);
+    _compare(10u, 3u, &lambdaError, &phiError);
+    CHECK(lambdaError < 1e-5f);
+    CHECK(phiError < 1e-5f);
+#else
+    printf("  needs RLIMIT_AS, skipped\n");
+#endif
+}
+
+static void test_refused(void)
+{
+    int isa;
+
+    CHECK(BATCH_EIG_ERR_ARGS == batch_eig_decomp(_sigma, _lambda, _phi, TEST_STRIDE + 1u, TEST_STRIDE, _init, 10u, 3u, 1u, BATCH_EIG_ISA_AUTO));
+    CHECK(BATCH_EIG_ERR_ARGS == batch_eig_decomp(_sigma, _lambda, _phi, TEST_COUNT, TEST_STRIDE, _init, 0u, 0u, 1u, BATCH_EIG_ISA_AUTO));
+    CHECK(BATCH_EIG_ERR_ARGS == batch_eig_decomp(NULL, _lambda, _phi, TEST_COUNT, TEST_STRIDE, _init, 10u, 3u, 1u, BATCH_EIG_ISA_AUTO));
+    if(!batch_eig_isa_supported(BATCH_EIG_ISA_AVX512))
+    {
+        CHECK(BATCH_EIG_ERR_ISA == batch_eig_decomp(_sigma, _lambda, _phi, TEST_COUNT, TEST_STRIDE, _init, 10u, 3u, 1u, BATCH_EIG_ISA_AVX512));
+    }
+    /* auto runs the widest one there is, empty batches are fine */
+    isa = batch_eig_decomp(_sigma, _lambda, _phi, 0u, TEST_STRIDE, _init, 10u, 3u, 0u, BATCH_EIG_ISA_AUTO);
+    CHECK(isa > (int)BATCH_EIG_ISA_AUTO);
+    CHECK(batch_eig_lanes((batch_eig_isa)isa) == batch_eig_lanes(BATCH_EIG_ISA_AUTO));
+}
+
+int main(void)
+{
+    RUN_TEST(test_scalar);
+    RUN_TEST(test_avx2);
+    RUN_TEST(test_avx512);
+    RUN_TEST(test_no_threads);
+    RUN_TEST(test_refused);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,372 @@
+/*******************************************************************************
+* File Name: test_command_table.c
+*
+* Description:
+*  command_table.c and RX_NEXT_IS_BATCH in the RX parser: table dispatch,
+*  typed values, one status packet per frame, bad types and truncated entries,
+*  frames split across polls and oversized frames skipped, all received
+*  through the isr_rx handler. With
+*  --run <frames> <statuses> it runs hex encoded frames from the host
+*  (check_command_batch.py, BNL/command_batch.py) and writes the status
+*  payloads back as hex.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+#include "command_table.h"
+
+#include <string.h>
+
+#define FLAG_GAIN    (uint8)1   /* uint8, at most 100 */
+#define FLAG_OFFSET  (uint8)2   /* float */
+#define FLAG_RESET   (uint8)3   /* no value */
+#define FLAG_MISSING (uint8)4   /* never registered */
+#define FLAG_FILL    (uint8)5   /* fills the packet queue */
+
+static uint32 _gain;
+static float  _offset;
+static uint32 _resets;
+static uint32 _calls;
+
+static uint8 _setGain(uint8 flag, const commandValue * value)
+{
+    (void)flag;
+    _calls++;
+    if(COMMAND_VALUE_UINT8 != value->type && COMMAND_VALUE_UINT16 != value->type)
+    {
+        return COMMAND_ERR_BAD_TYPE;
+    }
+    if(value->value.asUint > 100u)
+    {
+        return COMMAND_ERR_RANGE;
+    }
+    _gain = value->value.asUint;
+    return COMMAND_OK;
+}
+
+static uint8 _setOffset(uint8 flag, const commandValue * value)
+{
+    (void)flag;
+    _calls++;
+    if(COMMAND_VALUE_FLOAT32 != value->type)
+    {
+        return COMMAND_ERR_BAD_TYPE;
+    }
+    _offset = value->value.asFloat;
+    return COMMAND_OK;
+}
+
+static uint8 _reset(uint8 flag, const commandValue * value)
+{
+    (void)flag;
+    (void)value;
+    _calls++;
+    _resets++;
+    return COMMAND_OK;
+}
+
+static uint8 _fillQueue(uint8 flag, const commandValue * value)
+{
+    /* stands in for interrupts queuing packets while the frame runs */
+    uint8 filler = 0u;
+    (void)flag;
+    (void)value;
+    while(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, 1u, &filler)) { }
+    return COMMAND_OK;
+}
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+    HalShim_BindUartRxIsr(rxRing_putFromUart); /* frames arrive through isr_rx */
+    rxRing_reset();
+    rxParser_reset();
+    commandTable_clear();
+    commandTable_register(FLAG_GAIN, _setGain);
+    commandTable_register(FLAG_OFFSET, _setOffset);
+    commandTable_register(FLAG_RESET, _reset);
+    _gain = 0u;
+    _offset = 0.0f;
+    _resets = 0u;
+    _calls = 0u;
+}
+
+static uint16 _frame(uint8 * out, uint8 frameId, const uint8 * entries, uint16 numBytes)
+{
+    out[0] = RX_NEXT_IS_BATCH;
+    out[1] = (uint8)(numBytes + 1u);
+    out[2] = (uint8)((numBytes + 1u) >> 8);
+    out[3] = frameId;
+    memcpy(&out[4], entries, numBytes);
+    return (uint16)(numBytes + 4u);
+}
+
+/* payload of the index'th status packet on the wire, NULL if there is none */
+static const uint8 * _status(uint32 index, uint16 * numBytes)
+{
+    const uint8 * tx = HalShim_GetTxBytes();
+    uint32 start = 0u;
+    uint16 payloadBytes;
+
+    while(start + PACKET_HEAD_BYTES <= HalShim_GetTxCount())
+    {
+        payloadBytes = (uint16)(tx[start + 6u] | (tx[start + 7u] << 8));
+        if(MESSAGE_TYPE_COMMAND_STATUS == tx[start + 4u] && 0u == index--)
+        {
+            *numBytes = payloadBytes;
+            return &tx[start + PACKET_HEAD_BYTES];
+        }
+        start += PACKET_HEAD_BYTES + payloadBytes + PACKET_TAIL_BYTES;
+    }
+    return NULL;
+}
+
+static void test_table_dispatch(void)
+{
+    commandValue value;
+
+    _setup();
+    value.type = COMMAND_VALUE_UINT8;
+    value.value.asUint = 42u;
+    CHECK(COMMAND_OK == commandTable_dispatch(FLAG_GAIN, &value));
+    CHECK(42u == _gain);
+    CHECK(COMMAND_ERR_NO_HANDLER == commandTable_dispatch(FLAG_MISSING, &value));
+    CHECK(_setGain == commandTable_get(FLAG_GAIN));
+    commandTable_register(FLAG_GAIN, NULL);
+    CHECK(COMMAND_ERR_NO_HANDLER == commandTable_dispatch(FLAG_GAIN, &value));
+}
+
+static void test_batch_one_status(void)
+{
+    float  offset = -2.5f;
+    uint8  entries[] = {FLAG_GAIN, COMMAND_VALUE_UINT8, 7,
+                        FLAG_OFFSET, COMMAND_VALUE_FLOAT32, 0, 0, 0, 0,
+                        FLAG_RESET, COMMAND_VALUE_NONE,
+                        FLAG_MISSING, COMMAND_VALUE_UINT16, 1, 2,
+                        FLAG_GAIN, COMMAND_VALUE_UINT16, 200, 0};
+    uint8  bytes[64];
+    uint16 numBytes;
+    const uint8 * status;
+
+    _setup();
+    memcpy(&entries[5], &offset, 4);
+    numBytes = _frame(bytes, 0x5A, entries, sizeof(entries));
+    HalShim_ReceiveBytes(bytes, numBytes);
+    CHECK(0u == rxParser_poll());               /* run at once, nothing for the application */
+    CHECK(7u == _gain && -2.5f == _offset && 1u == _resets);
+    CHECK(1u == packetQueue_getPending());      /* one status for five entries */
+    packetQueue_drain();
+
+    status = _status(0u, &numBytes);
+    CHECK(NULL != status);
+    if(NULL != status)
+    {
+        CHECK(COMMAND_STATUS_HEAD_BYTES + 5u == numBytes);
+        CHECK(0x5A == status[0] && 5u == status[1] && 2u == status[2]);
+        CHECK(COMMAND_OK == status[3] && COMMAND_OK == status[4] && COMMAND_OK == status[5]);
+        CHECK(COMMAND_ERR_NO_HANDLER == status[6] && COMMAND_ERR_RANGE == status[7]);
+    }
+}
+
+static void test_bad_type_ends_frame(void)
+{
+    uint8  entries[] = {FLAG_GAIN, COMMAND_VALUE_UINT8, 1,
+                        FLAG_GAIN, 0x77, 5,
+                        FLAG_RESET, COMMAND_VALUE_NONE};
+    uint8  bytes[32];
+    uint16 numBytes;
+    const uint8 * status;
+
+    _setup();
+    numBytes = _frame(bytes, 1u, entries, sizeof(entries));
+    HalShim_ReceiveBytes(bytes, numBytes);
+    rxParser_poll();
+    packetQueue_drain();
+    CHECK(0u == _resets);                       /* after the bad entry: not run */
+    status = _status(0u, &numBytes);
+    CHECK(NULL != status && 2u == status[1] && 1u == status[2] && COMMAND_ERR_BAD_TYPE == status[4]);
+}
+
+static void test_truncated_entry(void)
+{
+    uint8  entries[] = {FLAG_RESET, COMMAND_VALUE_NONE, FLAG_OFFSET, COMMAND_VALUE_FLOAT32, 0, 0};
+    uint8  bytes[32];
+    uint16 numBytes;
+    const uint8 * status;
+
+    _setup();
+    numBytes = _frame(bytes, 2u, entries, sizeof(entries));
+    HalShim_ReceiveBytes(bytes, numBytes);
+    rxParser_poll();
+    packetQueue_drain();
+    CHECK(1u == _resets && 1u == _calls);
+    status = _status(0u, &numBytes);
+    CHECK(NULL != status && 2u == status[1] && COMMAND_ERR_TRUNCATED == status[4]);
+}
+
+static void test_frame_split_across_polls(void)
+{
+    uint8  entries[60];
+    uint8  bytes[80];
+    uint16 numBytes;
+    uint16 i;
+
+    _setup();
+    for(i = 0u; i < 20u; i++)
+    {
+        entries[3u * i]      = FLAG_GAIN;
+        entries[3u * i + 1u] = COMMAND_VALUE_UINT8;
+        entries[3u * i + 2u] = (uint8)i;
+    }
+    numBytes = _frame(bytes, 3u, entries, sizeof(entries));
+    for(i = 0u; i < numBytes; i += 7u)
+    {
+        HalShim_ReceiveBytes(&bytes[i], (uint16)((i + 7u > numBytes) ? (uint16)(numBytes - i) : 7u));
+        rxParser_poll();
+        CHECK((i + 7u < numBytes) ? (0u == _calls) : (20u == _calls));
+    }
+    CHECK(19u == _gain);
+    CHECK(1u == packetQueue_getPending());
+}
+
+static void test_oversized_frame_skipped(void)
+{
+    uint8 bytes[RX_BATCH_MAX_BYTES + 10u];
+    uint8 after[] = {RX_NEXT_IS_CHAR, 'z'};
+    rxCommand command;
+    uint16 length = RX_BATCH_MAX_BYTES + 1u;
+
+    _setup();
+    memset(bytes, RX_NEXT_IS_CHAR, sizeof(bytes));  /* looks like commands if not skipped */
+    bytes[0] = RX_NEXT_IS_BATCH;
+    bytes[1] = (uint8)length;
+    bytes[2] = (uint8)(length >> 8);
+    HalShim_ReceiveBytes(bytes, 3u);
+    rxParser_poll();
+    HalShim_ReceiveBytes(&bytes[3], 200u);      /* skipped as it arrives */
+    CHECK(0u == rxParser_poll());
+    HalShim_ReceiveBytes(&bytes[203], length - 200u);
+    HalShim_ReceiveBytes(after, sizeof(after));
+    CHECK(1u == rxParser_poll());
+    CHECK(rxCommand_pop(&command) && 'z' == command.value);
+    CHECK(1u == rxParser_getIgnoredCount());
+    CHECK(0u == packetQueue_getPending());
+}
+
+static void test_full_frame_one_packet(void)
+{
+    /* a longest frame through isr_rx byte by byte: one status, nothing per byte */
+    uint8  entries[RX_BATCH_MAX_BYTES - 1u];
+    uint8  bytes[RX_BATCH_MAX_BYTES + 3u];
+    uint16 numBytes;
+    uint16 i;
+    const uint8 * status;
+
+    _setup();
+    packetQueue_resetStats();
+    for(i = 0u; i + 1u < sizeof(entries); i += 2u)
+    {
+        entries[i]      = FLAG_RESET;
+        entries[i + 1u] = COMMAND_VALUE_NONE;
+    }
+    numBytes = _frame(bytes, 0x42, entries, (uint16)(sizeof(entries) & ~1u));
+    HalShim_ReceiveBytes(bytes, numBytes);
+    CHECK(0u == packetQueue_getPending());      /* the ISR queued nothing */
+    CHECK(0u == rxParser_poll());
+    CHECK(sizeof(entries) / 2u == _resets);
+    CHECK(1u == packetQueue_getPending());
+    CHECK(0u == packetQueue_getDropCount());
+    packetQueue_drain();
+    status = _status(0u, &numBytes);
+    CHECK(NULL != status && 0x42 == status[0] && sizeof(entries) / 2u == status[1] && 0u == status[2]);
+    CHECK(NULL == _status(1u, &numBytes));
+    CHECK(PACKET_HEAD_BYTES + numBytes + PACKET_TAIL_BYTES == HalShim_GetTxCount());
+}
+
+static void test_status_slot_reserved_first(void)
+{
+    uint8  entries[] = {FLAG_FILL, COMMAND_VALUE_NONE, FLAG_GAIN, COMMAND_VALUE_UINT8, 9};
+    uint8  bytes[16];
+    uint16 numBytes;
+    const uint8 * status;
+
+    _setup();
+    commandTable_register(FLAG_FILL, _fillQueue);
+    numBytes = _frame(bytes, 0x33, entries, sizeof(entries));
+    HalShim_ReceiveBytes(bytes, numBytes);
+    CHECK(0u == rxParser_poll());
+    CHECK(9u == _gain);
+    CHECK(PACKET_QUEUE_NUM_SLOTS == packetQueue_getPending());
+    packetQueue_flush();
+    status = _status(0u, &numBytes);
+    CHECK(NULL != status && 0x33 == status[0] && 2u == status[1] && 0u == status[2]);
+}
+
+static uint8 _hexNibble(char c)
+{
+    return (uint8)((c <= '9') ? (c - '0') : ((c | 0x20) - 'a' + 10));
+}
+
+static int _run(const char * inPath, const char * outPath)
+{
+    static char  line[2048];
+    static uint8 bytes[1024];
+    FILE * in  = fopen(inPath, "r");
+    FILE * out = fopen(outPath, "w");
+    const uint8 * status;
+    uint16 numBytes;
+    uint32 index = 0u;
+    size_t i;
+
+    if(NULL == in || NULL == out)
+    {
+        return 1;
+    }
+    _setup();
+    packetQueue_resetStats();
+    while(NULL != fgets(line, sizeof(line), in))
+    {
+        /* one frame per line, RX_NEXT_IS_BATCH and length included */
+        for(i = 0u; 2u * i + 1u < strlen(line) && line[2u * i] != '\n'; i++)
+        {
+            bytes[i] = (uint8)((_hexNibble(line[2u * i]) << 4) | _hexNibble(line[2u * i + 1u]));
+        }
+        HalShim_ReceiveBytes(bytes, (uint16)i);
+        rxParser_poll();
+        packetQueue_drain();
+    }
+    while(NULL != (status = _status(index++, &numBytes)))
+    {
+        for(i = 0u; i < numBytes; i++)
+        {
+            fprintf(out, "%02x", status[i]);
+        }
+        fprintf(out, "\n");
+    }
+    fprintf(out, "gain %u offset %.9g resets %u\n", (unsigned)_gain, _offset, (unsigned)_resets);
+    fclose(in);
+    fclose(out);
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    if(argc > 3 && 0 == strcmp(argv[1], "--run"))
+    {
+        return _run(argv[2], argv[3]);
+    }
+    RUN_TEST(test_table_dispatch);
+    RUN_TEST(test_batch_one_status);
+    RUN_TEST(test_bad_type_ends_frame);
+    RUN_TEST(test_truncated_entry);
+    RUN_TEST(test_frame_split_across_polls);
+    RUN_TEST(test_oversized_frame_skipped);
+    RUN_TEST(test_full_frame_one_packet);
+    RUN_TEST(test_status_slot_reserved_first);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
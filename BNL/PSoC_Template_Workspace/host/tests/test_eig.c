@@ -0,0 +1,425 @@
+/*******************************************************************************
+* File Name: test_eig.c
+*
+* Description:
+*  eig_decomp() on 32 x 32 covariance-like matrices with a known spectrum,
+*  Sigma = Q diag(lambda) Q' with Q a Householder reflection (eig_fixture.c),
+*  Rayleigh iterations run past convergence (the shift lands on the
+*  eigenvalue),
+*  invert_matrix() on a well conditioned matrix, and shifted_solve() against
+*  it and on a matrix Gauss-Jordan without pivoting cannot handle, and
+*  eig_decomp_all() for every eigenpair, eig_decomp_subspace(), and
+*  eig_decomp_tol() stopping on the residual, cold and warm started, and
+*  skipping a zero initial guess. Built three times, as test_eig_ql with
+*  EIG_TRIDIAGONAL_QL and as test_eig_subspace with EIG_SUBSPACE_ITERATION
+*  so eig_decomp() runs on those engines too.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "eig_fixture.h"
+
+#include <math.h>
+#include <string.h>
+
+static void _checkDecomposition(uint8 p_iter, uint8 r_iter, float tolerance)
+{
+    eigFixtureErrors errors = eigFixture_decompose(eig_decomp, p_iter, r_iter);
+
+    CHECK(errors.lambda < tolerance);
+    CHECK(errors.alignment < tolerance);
+    CHECK(errors.overlap < tolerance);
+}
+
+static void test_subspace_iteration(void)
+{
+    float lambdaTrue[MAT_SIZE];
+    float lambda[PRINCIPLE_COMPONENTS];
+    float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    uint8 i;
+
+    eigFixture_knownSpectrum(lambdaTrue, 99u);
+    eigFixture_initialGuess(Eig_vecs_init);
+    eig_decomp_subspace(lambda, Phi, eigFixture_Sigma, Eig_vecs_init, 10u, 3u);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(fabsf(lambda[i] - lambdaTrue[i]) < 1e-4f * lambdaTrue[i]);
+        CHECK(eigFixture_alignment(Phi[i], i) > 1.0f - 1e-5f);
+    }
+    /* the block stays orthonormal, no deflation error to accumulate */
+    CHECK(eigFixture_worstOverlap(Phi) < 1e-5f);
+    printf("  subspace p10 r3: worst |phi_i . phi_j| %.2g\n", (double)eigFixture_worstOverlap(Phi));
+}
+
+static void test_power_iteration_only(void)
+{
+    _checkDecomposition(60u, 0u, 1e-3f);
+}
+
+static void test_power_then_rayleigh(void)
+{
+    _checkDecomposition(10u, 3u, 1e-3f);
+}
+
+static void test_rayleigh_past_convergence(void)
+{
+    /* Sigma - lambda I is singular to working precision on the last iterations */
+    _checkDecomposition(10u, 8u, 1e-3f);
+}
+
+static void test_tolerance_stops_early(void)
+{
+    float lambdaTrue[MAT_SIZE];
+    float lambda[PRINCIPLE_COMPONENTS];
+    float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    eig_stats stats;
+    uint16 total = 0u;
+    uint8 i;
+
+    eigFixture_knownSpectrum(lambdaTrue, 99u);
+    eigFixture_initialGuess(Eig_vecs_init);
+    memset(&stats, 0xA5, sizeof(stats));
+    CHECK(EIG_ALL_CONVERGED == eig_decomp_tol(lambda, Phi, eigFixture_Sigma, Eig_vecs_init, 60u, 5u, 1e-5f, &stats));
+    CHECK(EIG_ALL_CONVERGED == stats.converged);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(fabsf(lambda[i] - lambdaTrue[i]) < 1e-4f * lambdaTrue[i]);
+        CHECK(eigFixture_alignment(Phi[i], i) > 1.0f - 1e-5f);
+        CHECK(stats.iterations[i] > 0u);
+        CHECK(stats.iterations[i] < 65u);       /* stopped before the limit */
+        CHECK(stats.residual[i] < 1e-3f);
+        total += stats.iterations[i];
+    }
+    CHECK(stats.orthogonality < 5e-4f);
+    CHECK(fabsf(stats.orthogonality - eigFixture_worstOverlap(Phi)) < 1e-6f);
+    printf("  cold start, tol 1e-5: %u iterations, worst |phi_i . phi_j| %.2g\n",
+        (unsigned)total, (double)stats.orthogonality);
+
+    /* warm: the answer as the guess needs at most one more iteration each */
+    memcpy(Eig_vecs_init, Phi, sizeof(Phi));
+    CHECK(EIG_ALL_CONVERGED == eig_decomp_tol(lambda, Phi, eigFixture_Sigma, Eig_vecs_init, 60u, 5u, 1e-5f, &stats));
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(stats.iterations[i] <= 1u);
+        CHECK(fabsf(lambda[i] - lambdaTrue[i]) < 1e-4f * lambdaTrue[i]);
+    }
+}
+
+static void test_tolerance_not_reached(void)
+{
+    float lambdaTrue[MAT_SIZE];
+    float lambda[PRINCIPLE_COMPONENTS];
+    float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    eig_stats stats;
+    uint8 i;
+
+    eigFixture_knownSpectrum(lambdaTrue, 99u);
+    eigFixture_initialGuess(Eig_vecs_init);
+    CHECK(0u == eig_decomp_tol(lambda, Phi, eigFixture_Sigma, Eig_vecs_init, 2u, 0u, 1e-5f, &stats));
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(2u == stats.iterations[i]);
+        CHECK(stats.residual[i] > 1e-5f);
+    }
+
+    /* Rayleigh iterations finish what two power iterations started, no stats */
+    CHECK(EIG_ALL_CONVERGED == eig_decomp_tol(lambda, Phi, eigFixture_Sigma, Eig_vecs_init, 2u, 5u, 1e-5f, 0));
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(eigFixture_alignment(Phi[i], i) > 1.0f - 1e-5f);
+    }
+}
+
+/* a zero guess leaves its component unconverged and zero, not NaN */
+static void test_tolerance_zero_guess(void)
+{
+    float lambdaTrue[MAT_SIZE];
+    float lambda[PRINCIPLE_COMPONENTS];
+    float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    eig_stats stats;
+    uint8 converged, i, j;
+
+    eigFixture_knownSpectrum(lambdaTrue, 99u);
+    eigFixture_initialGuess(Eig_vecs_init);
+    memset(Eig_vecs_init[1], 0, sizeof(Eig_vecs_init[1]));
+    converged = eig_decomp_tol(lambda, Phi, eigFixture_Sigma, Eig_vecs_init, 60u, 5u, 1e-5f, &stats);
+    CHECK(0u != (converged & 1u));
+    CHECK(0u == (converged & 2u));
+    CHECK(0u == stats.iterations[1]);
+    CHECK(0.0f == lambda[1]);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(!isnan(lambda[i]));
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            CHECK(!isnan(Phi[i][j]));
+        }
+    }
+    CHECK(eigFixture_alignment(Phi[0], 0u) > 1.0f - 1e-5f);
+}
+
+static float _residual(float A[MAT_SIZE][MAT_SIZE], float shift, const float x[MAT_SIZE], const float b[MAT_SIZE])
+{
+    float worst = 0.0f;
+    float sum;
+    uint8 i, j;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        sum = -shift * x[i] - b[i];
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            sum += A[i][j] * x[j];
+        }
+        if(fabsf(sum) > worst)
+        {
+            worst = fabsf(sum);
+        }
+    }
+    return worst;
+}
+
+static void test_shifted_solve_matches_inverse(void)
+{
+    static float A[MAT_SIZE][MAT_SIZE];
+    static float Ainv[MAT_SIZE][MAT_SIZE];
+    float lambdaTrue[MAT_SIZE];
+    float b[MAT_SIZE];
+    float x[MAT_SIZE];
+    float worst = 0.0f;
+    uint8 i, j;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        lambdaTrue[i] = 1.0f + 0.25f * i;
+        b[i] = (float)((i * 5u) % 7u) - 3.0f;
+    }
+    eigFixture_buildSigma(lambdaTrue, 11u);
+    CHECK(0u == shifted_solve(eigFixture_Sigma, 3.1f, b, x));   /* between two eigenvalues: indefinite */
+    CHECK(_residual(eigFixture_Sigma, 3.1f, x, b) < 1e-4f);
+
+    memcpy(A, eigFixture_Sigma, sizeof(A));
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        A[i][i] -= 3.1f;
+    }
+    invert_matrix(A, Ainv);
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        float sum = 0.0f;
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            sum += Ainv[i][j] * b[j];
+        }
+        if(fabsf(sum - x[i]) > worst)
+        {
+            worst = fabsf(sum - x[i]);
+        }
+    }
+    CHECK(worst < 1e-2f);
+}
+
+static void test_shifted_solve_pivots(void)
+{
+    /* zero diagonal: the first Gauss-Jordan pivot is 0, row exchanges fix it */
+    float b[MAT_SIZE];
+    float x[MAT_SIZE];
+    uint8 i, j;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            eigFixture_Sigma[i][j] = (i + 1u == j || j + 1u == i) ? 1.0f : 0.0f;
+        }
+        b[i] = 1.0f + 0.1f * i;
+    }
+    CHECK(0u == shifted_solve(eigFixture_Sigma, 0.0f, b, x));
+    CHECK(_residual(eigFixture_Sigma, 0.0f, x, b) < 1e-4f);
+}
+
+static void test_shifted_solve_singular(void)
+{
+    /* the shift is exactly an eigenvalue: the pivot is clamped, x points along its eigenvector */
+    float lambdaTrue[MAT_SIZE];
+    float b[MAT_SIZE];
+    float x[MAT_SIZE];
+    float norm = 0.0f;
+    float c = 0.0f;
+    uint8 i;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        lambdaTrue[i] = (i == 5u) ? 2.0f : 4.0f + i;
+        b[i] = 1.0f;
+    }
+    eigFixture_buildSigma(lambdaTrue, 3u);
+    shifted_solve(eigFixture_Sigma, 2.0f, b, x);
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        CHECK(!isnan(x[i]) && !isinf(x[i]));
+        norm += x[i] * x[i];
+        c += x[i] * eigFixture_Q[i][5];
+    }
+    CHECK(fabsf(c) / sqrtf(norm) > 0.999f);
+}
+
+static void _checkAllEigenpairs(const float lambdaTrue[MAT_SIZE], uint32 seed, float tolerance)
+{
+    static float V[MAT_SIZE][MAT_SIZE];
+    float  d[MAT_SIZE];
+    float  sorted[MAT_SIZE];
+    float  worstValue = 0.0f;
+    float  worstOrtho = 0.0f;
+    float  worstResidual = 0.0f;
+    float  scale = 0.0f;
+    uint16 sweeps;
+    uint8  i, j, k;
+
+    eigFixture_buildSigma(lambdaTrue, seed);
+    sweeps = eig_decomp_all(d, V, eigFixture_Sigma);
+    CHECK(EIG_QL_NOT_CONVERGED != sweeps);
+    CHECK(sweeps <= 3u * MAT_SIZE);
+
+    /* the known spectrum, largest first */
+    memcpy(sorted, lambdaTrue, sizeof(sorted));
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = i + 1u; j < MAT_SIZE; j++)
+        {
+            if(sorted[j] > sorted[i])
+            {
+                float t = sorted[i];
+                sorted[i] = sorted[j];
+                sorted[j] = t;
+            }
+        }
+        if(fabsf(sorted[i]) > scale)
+        {
+            scale = fabsf(sorted[i]);
+        }
+    }
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        if(i > 0u)
+        {
+            CHECK(d[i] <= d[i - 1u]);
+        }
+        worstValue = fmaxf(worstValue, fabsf(d[i] - sorted[i]));
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            float vv = 0.0f;
+            float av = 0.0f;
+            for(k = 0u; k < MAT_SIZE; k++)
+            {
+                vv += V[k][i] * V[k][j];
+                av += eigFixture_Sigma[j][k] * V[k][i];
+            }
+            worstOrtho = fmaxf(worstOrtho, fabsf(vv - ((i == j) ? 1.0f : 0.0f)));
+            worstResidual = fmaxf(worstResidual, fabsf(av - d[i] * V[j][i]));
+        }
+    }
+    CHECK(worstValue < tolerance * scale);
+    CHECK(worstOrtho < tolerance);
+    CHECK(worstResidual < tolerance * scale);
+    printf("  %u QL sweeps, eigenvalue error %.2g, orthogonality %.2g\n",
+        (unsigned)sweeps, worstValue / scale, worstOrtho);
+}
+
+static void test_all_eigenpairs(void)
+{
+    float lambdaTrue[MAT_SIZE];
+    uint8 i;
+
+    /* decaying spectrum like the FBG covariance */
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        lambdaTrue[i] = (i < PRINCIPLE_COMPONENTS) ? (16.0f / (float)(1u << i)) : 0.01f * (MAT_SIZE - i);
+    }
+    _checkAllEigenpairs(lambdaTrue, 99u, 1e-4f);
+
+    /* repeated and negative eigenvalues, which deflation cannot separate */
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        lambdaTrue[i] = (i < 8u) ? 3.0f : ((i & 1u) ? -1.5f + 0.1f * i : 0.5f);
+    }
+    _checkAllEigenpairs(lambdaTrue, 5u, 1e-4f);
+}
+
+static void test_all_eigenpairs_diagonal(void)
+{
+    static float V[MAT_SIZE][MAT_SIZE];
+    float d[MAT_SIZE];
+    uint8 i, j;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            eigFixture_Sigma[i][j] = (i == j) ? (float)((i * 7u) % MAT_SIZE) : 0.0f;
+        }
+    }
+    CHECK(0u == eig_decomp_all(d, V, eigFixture_Sigma));          /* nothing to iterate */
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        CHECK(d[i] == (float)(MAT_SIZE - 1u - i));
+        CHECK(1.0f == fabsf(V[(i == 0u) ? 9u : 0u][i]) || V[(i == 0u) ? 9u : 0u][i] == 0.0f);
+    }
+}
+
+static void test_invert_matrix(void)
+{
+    static float A[MAT_SIZE][MAT_SIZE];
+    static float Ainv[MAT_SIZE][MAT_SIZE];
+    float lambdaTrue[MAT_SIZE];
+    float worst = 0.0f;
+    uint8 i, j, k;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        lambdaTrue[i] = 1.0f + 0.25f * i;
+    }
+    eigFixture_buildSigma(lambdaTrue, 7u);
+    memcpy(A, eigFixture_Sigma, sizeof(A));
+    invert_matrix(A, Ainv);                     /* A is reduced to I in place */
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            float sum = 0.0f;
+            for(k = 0u; k < MAT_SIZE; k++)
+            {
+                sum += eigFixture_Sigma[i][k] * Ainv[k][j];
+            }
+            sum -= (i == j) ? 1.0f : 0.0f;
+            if(fabsf(sum) > worst)
+            {
+                worst = fabsf(sum);
+            }
+        }
+    }
+    CHECK(worst < 1e-4f);
+}
+
+int main(void)
+{
+    RUN_TEST(test_power_iteration_only);
+    RUN_TEST(test_power_then_rayleigh);
+    RUN_TEST(test_rayleigh_past_convergence);
+    RUN_TEST(test_subspace_iteration);
+    RUN_TEST(test_tolerance_stops_early);
+    RUN_TEST(test_tolerance_not_reached);
+    RUN_TEST(test_tolerance_zero_guess);
+    RUN_TEST(test_invert_matrix);
+    RUN_TEST(test_shifted_solve_matches_inverse);
+    RUN_TEST(test_shifted_solve_pivots);
+    RUN_TEST(test_shifted_solve_singular);
+    RUN_TEST(test_all_eigenpairs);
+    RUN_TEST(test_all_eigenpairs_diagonal);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
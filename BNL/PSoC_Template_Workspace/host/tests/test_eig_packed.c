@@ -0,0 +1,287 @@
+/*******************************************************************************
+* File Name: test_eig_packed.c
+*
+* Description:
+*  Packed symmetric kernels against the square ones of eig.c (matvec,
+*  Rayleigh quotient, deflation, shifted solve), packed_invert() against the
+*  known spectrum's inverse, eig_decomp_packed() on the
+*  known spectrum of eig_fixture.c and against eig_decomp(), and two
+*  decompositions on their own workspaces with W1, W2 and W3 left
+*  untouched.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "eig_fixture.h"
+#include "eig_packed.h"
+
+#include <math.h>
+#include <string.h>
+
+extern float W1[MAT_SIZE][MAT_SIZE];
+extern float W2[MAT_SIZE][MAT_SIZE];
+extern float W3[MAT_SIZE][MAT_SIZE];
+
+static float Sigma_packed[EIG_PACKED_SIZE];
+
+static void _packKnownSpectrum(float lambdaTrue[MAT_SIZE], uint32 seed)
+{
+    eigFixture_knownSpectrum(lambdaTrue, seed);
+    eig_pack(eigFixture_Sigma, Sigma_packed);
+}
+
+static void test_packed_layout(void)
+{
+    uint8 i, j;
+
+    CHECK(EIG_PACKED_SIZE == 528);
+    CHECK(EIG_PACKED_INDEX(0, 0) == 0);
+    CHECK(EIG_PACKED_INDEX(1, 1) == MAT_SIZE);
+    CHECK(EIG_PACKED_INDEX(MAT_SIZE - 1, MAT_SIZE - 1) == EIG_PACKED_SIZE - 1);
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            eigFixture_Sigma[i][j] = (float)((i < j) ? i * 100u + j : j * 100u + i);
+        }
+    }
+    eig_pack(eigFixture_Sigma, Sigma_packed);
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = i; j < MAT_SIZE; j++)
+        {
+            CHECK(Sigma_packed[EIG_PACKED_INDEX(i, j)] == eigFixture_Sigma[i][j]);
+        }
+    }
+}
+
+static void test_packed_kernels(void)
+{
+    float lambdaTrue[MAT_SIZE];
+    float x[MAT_SIZE], y[MAT_SIZE];
+    float Deflated[EIG_PACKED_SIZE];
+    float worst = 0.0f, rq = 0.0f;
+    uint8 i, j;
+
+    _packKnownSpectrum(lambdaTrue, 7u);
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        x[i] = eigFixture_Q[i][1];
+    }
+    packed_matvec(Sigma_packed, x, y);
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        worst = fmaxf(worst, fabsf(y[i] - dot(eigFixture_Sigma[i], x)));
+    }
+    CHECK(worst < 1e-5f);
+    rq = packed_rayleigh_quotient(Sigma_packed, x);
+    CHECK(fabsf(rq - lambdaTrue[1]) < 1e-5f * lambdaTrue[1]);
+
+    /* deflating Q[:,1] leaves lambdaTrue[1] out, in place as eig_decomp_packed() does */
+    memcpy(Deflated, Sigma_packed, sizeof(Deflated));
+    packed_deflation(Deflated, Deflated, x, lambdaTrue[1]);
+    worst = 0.0f;
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = i; j < MAT_SIZE; j++)
+        {
+            worst = fmaxf(worst, fabsf(Deflated[EIG_PACKED_INDEX(i, j)] - (eigFixture_Sigma[i][j] - lambdaTrue[1] * x[i] * x[j])));
+        }
+    }
+    CHECK(worst < 1e-6f);
+    CHECK(fabsf(packed_rayleigh_quotient(Deflated, x)) < 1e-5f);
+}
+
+static void test_packed_shifted_solve(void)
+{
+    /* shift above the spectrum, negative definite as in Rayleigh iteration */
+    float lambdaTrue[MAT_SIZE];
+    float factor[EIG_PACKED_SIZE];
+    float b[MAT_SIZE], x[MAT_SIZE], xFull[MAT_SIZE];
+    float worst = 0.0f, sum;
+    uint8 i, j;
+
+    _packKnownSpectrum(lambdaTrue, 3u);
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        b[i] = (float)((i * 5u) % 7u) - 3.0f;
+    }
+    CHECK(0u == packed_shifted_solve(Sigma_packed, 17.0f, b, x, factor));
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        sum = -17.0f * x[i];
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            sum += eigFixture_Sigma[i][j] * x[j];
+        }
+        worst = fmaxf(worst, fabsf(sum - b[i]));
+    }
+    CHECK(worst < 1e-4f);
+
+    /* same answer as the pivoted LU of eig.c, also for a shift inside the spectrum */
+    shifted_solve(eigFixture_Sigma, 5.0f, b, xFull);
+    CHECK(0u == packed_shifted_solve(Sigma_packed, 5.0f, b, x, factor));
+    worst = 0.0f;
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        worst = fmaxf(worst, fabsf(x[i] - xFull[i]));
+    }
+    CHECK(worst < 1e-4f);
+
+    /* shift on an eigenvalue, singular to working precision: the solution points along it */
+    (void)packed_shifted_solve(Sigma_packed, 16.0f, b, x, factor);
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        xFull[i] = eigFixture_Q[i][0];
+    }
+    CHECK(fabsf(dot(x, xFull)) > 0.999f * sqrtf(dot(x, x)));
+}
+
+static void test_packed_invert(void)
+{
+    float lambdaTrue[MAT_SIZE];
+    float Sigma_inv[EIG_PACKED_SIZE];
+    float factor[EIG_PACKED_SIZE];
+    float kept[EIG_PACKED_SIZE];
+    double expected, largest = 0.0, worst = 0.0;
+    uint8 i, j, k;
+
+    /* Q diag(1 / lambda) Q', condition number 1600 */
+    _packKnownSpectrum(lambdaTrue, 5u);
+    memcpy(kept, Sigma_packed, sizeof(kept));
+    CHECK(0u == packed_invert(Sigma_packed, Sigma_inv, factor));
+    CHECK(0 == memcmp(kept, Sigma_packed, sizeof(kept)));
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = i; j < MAT_SIZE; j++)
+        {
+            expected = 0.0;
+            for(k = 0u; k < MAT_SIZE; k++)
+            {
+                expected += (double)eigFixture_Q[i][k] * eigFixture_Q[j][k] / lambdaTrue[k];
+            }
+            largest = fmax(largest, fabs(expected));
+            worst = fmax(worst, fabs(expected - Sigma_inv[EIG_PACKED_INDEX(i, j)]));
+        }
+    }
+    CHECK(worst < 1e-4 * largest);
+    printf("  packed_invert: worst error %.2g of the largest element\n", worst / largest);
+}
+
+/* eig_decomp_packed() behind eig_decomp()'s signature, for eig_fixture.c */
+static void _decompPacked(float lambda[PRINCIPLE_COMPONENTS], float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE],
+                          float Sigma[MAT_SIZE][MAT_SIZE], float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE],
+                          const uint8 p_iter, const uint8 r_iter)
+{
+    static eig_workspace workspace;
+
+    eig_pack(Sigma, Sigma_packed);
+    eig_decomp_packed(lambda, Phi, Sigma_packed, Eig_vecs_init, p_iter, r_iter, &workspace);
+}
+
+static void _checkDecomposition(uint8 p_iter, uint8 r_iter, float tolerance)
+{
+    eigFixtureErrors errors = eigFixture_decompose(_decompPacked, p_iter, r_iter);
+
+    CHECK(errors.lambda < tolerance);
+    CHECK(errors.alignment < tolerance);
+}
+
+static void test_power_iteration_only(void)
+{
+    _checkDecomposition(60u, 0u, 1e-3f);
+}
+
+static void test_power_then_rayleigh(void)
+{
+    _checkDecomposition(10u, 3u, 1e-3f);
+}
+
+static void test_rayleigh_past_convergence(void)
+{
+    _checkDecomposition(10u, 8u, 1e-3f);
+}
+
+static void test_matches_eig_decomp(void)
+{
+    static eig_workspace workspace;
+    float lambdaTrue[MAT_SIZE];
+    float init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float lambda[PRINCIPLE_COMPONENTS], lambdaFull[PRINCIPLE_COMPONENTS];
+    float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE], PhiFull[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    uint8 i;
+
+    _packKnownSpectrum(lambdaTrue, 42u);
+    eigFixture_initialGuess(init);
+    eig_decomp(lambdaFull, PhiFull, eigFixture_Sigma, init, 10u, 3u);
+    eigFixture_initialGuess(init);
+    eig_decomp_packed(lambda, Phi, Sigma_packed, init, 10u, 3u, &workspace);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(fabsf(lambda[i] - lambdaFull[i]) < 1e-5f * lambdaFull[i]);
+        CHECK(fabsf(dot(Phi[i], PhiFull[i])) > 1.0f - 1e-5f);
+    }
+}
+
+static void test_two_workspaces(void)
+{
+    /* one workspace each for two channels' matrices, no state shared between them
+       or carried from one run to the next, and none of the eig.c globals used */
+    static eig_workspace adc, accel;
+    static float packedA[EIG_PACKED_SIZE], packedB[EIG_PACKED_SIZE];
+    float lambdaTrue[MAT_SIZE];
+    float init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float lambdaA[PRINCIPLE_COMPONENTS], lambdaB[PRINCIPLE_COMPONENTS], lambdaAgain[PRINCIPLE_COMPONENTS];
+    float PhiA[PRINCIPLE_COMPONENTS][MAT_SIZE], PhiB[PRINCIPLE_COMPONENTS][MAT_SIZE], PhiAgain[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    uint8 i, j;
+
+    _packKnownSpectrum(lambdaTrue, 5u);
+    memcpy(packedA, Sigma_packed, sizeof(packedA));
+    _packKnownSpectrum(lambdaTrue, 6u);
+    memcpy(packedB, Sigma_packed, sizeof(packedB));
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        memset(W1[i], 0xA5, sizeof(W1[i]));
+        memset(W2[i], 0xA5, sizeof(W2[i]));
+        memset(W3[i], 0xA5, sizeof(W3[i]));
+    }
+
+    eigFixture_initialGuess(init);
+    eig_decomp_packed(lambdaA, PhiA, packedA, init, 10u, 3u, &adc);
+    eigFixture_initialGuess(init);
+    eig_decomp_packed(lambdaB, PhiB, packedB, init, 10u, 3u, &accel);
+    eigFixture_initialGuess(init);
+    eig_decomp_packed(lambdaAgain, PhiAgain, packedA, init, 10u, 3u, &accel);
+    CHECK(0 == memcmp(lambdaAgain, lambdaA, sizeof(lambdaA)));
+    CHECK(0 == memcmp(PhiAgain, PhiA, sizeof(PhiA)));
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(fabsf(lambdaB[i] - lambdaTrue[i]) < 1e-3f * lambdaTrue[i]);
+        CHECK(eigFixture_alignment(PhiB[i], i) > 1.0f - 1e-3f);
+    }
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            CHECK(((const uint8 *)&W1[i][j])[0] == 0xA5u);
+            CHECK(((const uint8 *)&W2[i][j])[3] == 0xA5u);
+            CHECK(((const uint8 *)&W3[i][j])[1] == 0xA5u);
+        }
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_packed_layout);
+    RUN_TEST(test_packed_kernels);
+    RUN_TEST(test_packed_shifted_solve);
+    RUN_TEST(test_packed_invert);
+    RUN_TEST(test_power_iteration_only);
+    RUN_TEST(test_power_then_rayleigh);
+    RUN_TEST(test_rayleigh_past_convergence);
+    RUN_TEST(test_matches_eig_decomp);
+    RUN_TEST(test_two_workspaces);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
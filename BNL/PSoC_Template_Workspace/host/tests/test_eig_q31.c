@@ -0,0 +1,166 @@
+/*******************************************************************************
+* File Name: test_eig_q31.c
+*
+* Description:
+*  eig_decomp_q31() against the float reference: the known spectrum of
+*  eig_fixture.c (Sigma = Q diag(lambda) Q'), and the banded covariance of
+*  bench_suite.c run side by side with eig_decomp() for the same number of
+*  power iterations, so the difference is the arithmetic alone. Also the
+*  float to Q31 scaling bound and a zero matrix.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "eig_fixture.h"
+#include "eig_q31.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int32 Sigma_q31[MAT_SIZE][MAT_SIZE];
+
+/* eig_fixture.c's initial guess, and the same scaled by 2^29 */
+static void _initialGuess(float init[PRINCIPLE_COMPONENTS][MAT_SIZE], int32 init_q31[PRINCIPLE_COMPONENTS][MAT_SIZE])
+{
+    uint8 i, j;
+
+    eigFixture_initialGuess(init);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            init_q31[i][j] = (int32)ldexp(init[i][j], 29);
+        }
+    }
+}
+
+/* |cos| of the angle between a Q31 vector and a float one */
+static float _alignment(const int32 phi[MAT_SIZE], const float * ref, uint8 stride)
+{
+    double c = 0.0, n = 0.0;
+    uint8 i;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        c += eig_q31_to_float(phi[i], 0) * ref[i * stride];
+        n += (double)ref[i * stride] * ref[i * stride];
+    }
+    return (float)fabs(c / sqrt(n));
+}
+
+static void test_known_spectrum(void)
+{
+    float lambdaTrue[MAT_SIZE];
+    float init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    int32 init_q31[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    int32 lambda[PRINCIPLE_COMPONENTS];
+    int32 Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float error;
+    int8  exponent;
+    uint8 i;
+
+    eigFixture_knownSpectrum(lambdaTrue, 99u);
+    _initialGuess(init, init_q31);
+    exponent = eig_q31_from_float(eigFixture_Sigma, Sigma_q31);
+    eig_decomp_q31(lambda, Phi, Sigma_q31, init_q31, 60u, 0u);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        error = fabsf(eig_q31_to_float(lambda[i], exponent) - lambdaTrue[i]) / lambdaTrue[i];
+        CHECK(error < 1e-4f);
+        CHECK(_alignment(Phi[i], &eigFixture_Q[0][i], MAT_SIZE) > 1.0f - 1e-5f);
+        printf("  lambda %u: %9.5f, relative error %.2g\n", (unsigned)i,
+            (double)eig_q31_to_float(lambda[i], exponent), (double)error);
+    }
+}
+
+static void test_matches_float_reference(void)
+{
+    /* banded covariance, close eigenvalues so neither run has converged */
+    float init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    int32 init_q31[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float lambdaFloat[PRINCIPLE_COMPONENTS];
+    float PhiFloat[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    int32 lambda[PRINCIPLE_COMPONENTS];
+    int32 Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float worstLambda = 0.0f, worstAngle = 0.0f;
+    int8  exponent;
+    uint8 i, j;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            eigFixture_Sigma[i][j] = 1.0f / (1.0f + (float)abs((int)i - (int)j)) + ((i == j) ? 0.5f : 0.0f);
+        }
+    }
+    _initialGuess(init, init_q31);
+    exponent = eig_q31_from_float(eigFixture_Sigma, Sigma_q31);
+    eig_decomp(lambdaFloat, PhiFloat, eigFixture_Sigma, init, 30u, 0u);
+    eig_decomp_q31(lambda, Phi, Sigma_q31, init_q31, 30u, 0u);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        worstLambda = fmaxf(worstLambda, fabsf(eig_q31_to_float(lambda[i], exponent) - lambdaFloat[i]) / lambdaFloat[i]);
+        worstAngle = fmaxf(worstAngle, 1.0f - _alignment(Phi[i], PhiFloat[i], 1u));
+    }
+    CHECK(worstLambda < 1e-5f);
+    CHECK(worstAngle < 1e-5f);
+    printf("  against float: eigenvalue %.2g, 1 - |cos| %.2g\n", (double)worstLambda, (double)worstAngle);
+}
+
+static void test_scaling_bound(void)
+{
+    int64 row;
+    uint8 i, j;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            eigFixture_Sigma[i][j] = (i == j) ? 100.0f : -3.0f;
+        }
+    }
+    CHECK(eig_q31_from_float(eigFixture_Sigma, Sigma_q31) == 8);
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        row = 0;
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            row += llabs(Sigma_q31[i][j]);
+        }
+        CHECK(row <= Q31_MAX);
+    }
+    CHECK(eig_q31_to_float(Sigma_q31[0][0], 8) == 100.0f);
+    CHECK(eig_q31_to_float(Sigma_q31[0][1], 8) == -3.0f);
+}
+
+static void test_zero_matrix(void)
+{
+    float init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    int32 init_q31[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    int32 lambda[PRINCIPLE_COMPONENTS];
+    int32 Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    uint8 i;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        memset(Sigma_q31[i], 0, sizeof(Sigma_q31[i]));
+    }
+    _initialGuess(init, init_q31);
+    eig_decomp_q31(lambda, Phi, Sigma_q31, init_q31, 10u, 3u);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(lambda[i] == 0);
+        CHECK(fabsf(eig_q31_to_float(dot_q31(Phi[i], Phi[i]), 0) - 1.0f) < 1e-6f);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_known_spectrum);
+    RUN_TEST(test_matches_float_reference);
+    RUN_TEST(test_scaling_bound);
+    RUN_TEST(test_zero_matrix);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,121 @@
+/*******************************************************************************
+* File Name: test_eig_telemetry.c
+*
+* Description:
+*  eig_stats_pack() payload layout and the MESSAGE_FLAG_EIG_STATS packet on
+*  the wire, from hand-made stats and from an eig_decomp_tol() run.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "eig_telemetry.h"
+
+#include <math.h>
+#include <string.h>
+
+static float Sigma[MAT_SIZE][MAT_SIZE];
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+}
+
+static void _fill(eig_stats * stats)
+{
+    uint8 i;
+
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        stats->iterations[i] = (uint16)(10u + i);
+        stats->residual[i] = 1e-6f * (float)(i + 1u);
+        stats->cycles[i] = (uint32)(i + 1u) * 250u * TIMEBASE_CYCLES_PER_US;
+    }
+    stats->orthogonality = 3e-7f;
+    stats->converged = 0x0Bu;
+}
+
+static void test_pack_layout(void)
+{
+    eig_stats stats;
+    float payload[EIG_STATS_FLOATS];
+    uint8 i;
+
+    _fill(&stats);
+    eig_stats_pack(&stats, payload);
+    CHECK(11.0f == payload[0]);
+    CHECK(3e-7f == payload[1]);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK((float)(10u + i) == payload[2u + 3u * i]);
+        CHECK(stats.residual[i] == payload[3u + 3u * i]);
+        CHECK(fabsf(250.0f * (float)(i + 1u) - payload[4u + 3u * i]) < 1e-3f);
+    }
+}
+
+static void test_packet_on_the_wire(void)
+{
+    eig_stats stats;
+    float expected[EIG_STATS_FLOATS];
+    float payload[EIG_STATS_FLOATS];
+    const uint8 * packet;
+
+    _setup();
+    _fill(&stats);
+    CHECK(PACKET_OK == eig_stats_send(&stats));
+    CHECK((PACKET_HEAD_BYTES + sizeof(payload) + PACKET_TAIL_BYTES) == HalShim_GetTxCount());
+    packet = HalShim_GetTxBytes();
+    CHECK(MESSAGE_TYPE_BINARY_FLOAT == packet[4]);
+    CHECK(MESSAGE_FLAG_EIG_STATS == packet[5]);
+    memcpy(payload, &packet[PACKET_HEAD_BYTES], sizeof(payload));
+    eig_stats_pack(&stats, expected);
+    CHECK(0 == memcmp(expected, payload, sizeof(payload)));
+}
+
+static void test_decomposition_stats(void)
+{
+    float lambda[PRINCIPLE_COMPONENTS];
+    float Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float Eig_vecs_init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float payload[EIG_STATS_FLOATS];
+    eig_stats stats;
+    uint8 i, j;
+
+    /* diagonal, largest first: the unit vectors are the components */
+    memset(Sigma, 0, sizeof(Sigma));
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        Sigma[i][i] = 8.0f / (float)(1u + i);
+    }
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            Eig_vecs_init[i][j] = (i == j) ? 1.0f : 0.01f;
+        }
+    }
+    _setup();
+    CHECK(EIG_ALL_CONVERGED == eig_decomp_tol(lambda, Phi, Sigma, Eig_vecs_init, 40u, 3u, 1e-5f, &stats));
+    CHECK(PACKET_OK == eig_stats_send(&stats));
+    memcpy(payload, &HalShim_GetTxBytes()[PACKET_HEAD_BYTES], sizeof(payload));
+    CHECK((float)EIG_ALL_CONVERGED == payload[0]);
+    CHECK(payload[1] < 1e-4f);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(fabsf(lambda[i] - 8.0f / (float)(1u + i)) < 1e-4f);
+        CHECK(payload[2u + 3u * i] >= 1.0f);
+        CHECK(payload[3u + 3u * i] < 1e-3f);
+        CHECK(payload[4u + 3u * i] >= 0.0f);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_pack_layout);
+    RUN_TEST(test_packet_on_the_wire);
+    RUN_TEST(test_decomposition_stats);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,267 @@
+/*******************************************************************************
+* File Name: test_eig_tracker.c
+*
+* Description:
+*  eig_tracker covariance against two-pass batch covariances (sliding window,
+*  and the equal-weight start of exponential forgetting) and against the
+*  forgetting recursion in double, then tracking: samples drawn from a known
+*  spectrum whose eigenvectors turn halfway through, one warm-started power
+*  iteration per sample, checked against eig_decomp_all() of the tracker's
+*  own covariance and against a cold start with the same iteration count.
+*  A tracker without iterations never updates.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "eig_fixture.h"
+#include "eig_tracker.h"
+
+#include <math.h>
+#include <string.h>
+
+#define TEST_SAMPLES 400u
+
+static eig_tracker _tracker;
+static float _samples[TEST_SAMPLES][MAT_SIZE];
+
+/* worst difference between the tracker's covariance and the population
+   covariance of samples [first, first + count), relative to its largest element */
+static float _batchError(uint32 first, uint32 count)
+{
+    double mean[MAT_SIZE] = {0};
+    double cov, largest = 0.0, worst = 0.0;
+    uint32 s;
+    uint8 i, j;
+
+    for(s = first; s < first + count; s++)
+    {
+        for(i = 0u; i < MAT_SIZE; i++)
+        {
+            mean[i] += _samples[s][i] / (double)count;
+        }
+    }
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = i; j < MAT_SIZE; j++)
+        {
+            cov = 0.0;
+            for(s = first; s < first + count; s++)
+            {
+                cov += (_samples[s][i] - mean[i]) * (_samples[s][j] - mean[j]) / (double)count;
+            }
+            largest = fmax(largest, fabs(cov));
+            worst = fmax(worst, fabs(cov - _tracker.Sigma[EIG_PACKED_INDEX(i, j)] / _tracker.weight));
+        }
+    }
+    return (float)(worst / largest);
+}
+
+static void _unpack(float Sigma[MAT_SIZE][MAT_SIZE])
+{
+    uint8 i, j;
+
+    for(i = 0u; i < MAT_SIZE; i++)
+    {
+        for(j = i; j < MAT_SIZE; j++)
+        {
+            Sigma[i][j] = _tracker.Sigma[EIG_PACKED_INDEX(i, j)] / _tracker.weight;
+            Sigma[j][i] = Sigma[i][j];
+        }
+    }
+}
+
+static void test_sliding_window(void)
+{
+    float init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    uint32 s;
+
+    eigFixture_buildQ(11u);
+    for(s = 0u; s < TEST_SAMPLES; s++)
+    {
+        eigFixture_sample(_samples[s]);
+    }
+    eigFixture_initialGuess(init);
+    eig_tracker_init(&_tracker, 0.0f, 1u, init);
+    for(s = 0u; s < TEST_SAMPLES; s++)
+    {
+        eig_tracker_add(&_tracker, _samples[s]);
+        if(s >= 64u)
+        {
+            eig_tracker_remove(&_tracker, _samples[s - 64u]);
+        }
+        if(s == 40u)
+        {
+            CHECK(_batchError(0u, 41u) < 1e-5f); /* still filling */
+        }
+    }
+    CHECK(_tracker.count == 64u);
+    CHECK(_batchError(TEST_SAMPLES - 64u, 64u) < 1e-4f);
+    printf("  window of 64 after %u samples: relative error %.2g\n", TEST_SAMPLES, (double)_batchError(TEST_SAMPLES - 64u, 64u));
+
+    /* emptied, then the next sample starts from scratch */
+    for(s = TEST_SAMPLES - 64u; s < TEST_SAMPLES; s++)
+    {
+        eig_tracker_remove(&_tracker, _samples[s]);
+    }
+    CHECK(_tracker.count == 0u);
+    CHECK(_tracker.Sigma[0] == 0.0f);
+}
+
+static void test_exponential_forgetting(void)
+{
+    const float forget = 0.02f;
+    float init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    double mean[MAT_SIZE] = {0};
+    static double reference[EIG_PACKED_SIZE];
+    double a, d[MAT_SIZE], largest = 0.0, worst = 0.0;
+    uint32 s;
+    uint16 n;
+    uint8 i, j;
+
+    eigFixture_initialGuess(init);
+    eig_tracker_init(&_tracker, forget, 1u, init);
+    memset(reference, 0, sizeof(reference));
+    for(s = 0u; s < TEST_SAMPLES; s++)
+    {
+        eig_tracker_add(&_tracker, _samples[s]);
+        if(s == 30u)
+        {
+            /* fewer than 1 / forget samples: every one counts the same */
+            CHECK(_batchError(0u, 31u) < 1e-5f);
+        }
+        a = fmax(forget, 1.0 / (double)(s + 1u));
+        for(i = 0u; i < MAT_SIZE; i++)
+        {
+            d[i] = _samples[s][i] - mean[i];
+            mean[i] += a * d[i];
+        }
+        for(i = 0u, n = 0u; i < MAT_SIZE; i++)
+        {
+            for(j = i; j < MAT_SIZE; j++, n++)
+            {
+                reference[n] = (1.0 - a) * (reference[n] + a * d[i] * d[j]);
+            }
+        }
+    }
+    for(n = 0u; n < EIG_PACKED_SIZE; n++)
+    {
+        largest = fmax(largest, fabs(reference[n]));
+        worst = fmax(worst, fabs(reference[n] - _tracker.Sigma[n]));
+    }
+    CHECK(_tracker.weight == 1.0f);
+    CHECK(worst < 1e-5 * largest);
+}
+
+static void test_tracks_principal_axes(void)
+{
+    float init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float sample[MAT_SIZE];
+    static float Sigma[MAT_SIZE][MAT_SIZE];
+    static float V[MAT_SIZE][MAT_SIZE];
+    float d[MAT_SIZE];
+    float lambda[PRINCIPLE_COMPONENTS], Phi[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float warm = 1.0f, cold = 1.0f, truth = 1.0f, c;
+    uint32 s;
+    uint8 i, j;
+
+    /* about 200 samples of memory, the axes turn after 3000 */
+    eigFixture_initialGuess(init);
+    eig_tracker_init(&_tracker, 0.005f, 1u, init);
+    eigFixture_buildQ(21u);
+    for(s = 0u; s < 6000u; s++)
+    {
+        if(s == 3000u)
+        {
+            eigFixture_buildQ(22u);
+        }
+        eigFixture_sample(sample);
+        eig_tracker_add(&_tracker, sample);
+        (void)eig_tracker_update(&_tracker);
+    }
+
+    /* against an exact decomposition of the covariance it has */
+    _unpack(Sigma);
+    (void)eig_decomp_all(d, V, Sigma);
+    eigFixture_initialGuess(init);
+    eig_decomp(lambda, Phi, Sigma, init, 1u, 0u);
+    for(i = 0u; i < PRINCIPLE_COMPONENTS; i++)
+    {
+        CHECK(fabsf(_tracker.lambda[i] - d[i]) < 1e-2f * d[i]);
+        c = 0.0f;
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            c += _tracker.Phi[i][j] * V[j][i];
+        }
+        warm = fminf(warm, fabsf(c));
+        c = 0.0f;
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            c += Phi[i][j] * V[j][i];
+        }
+        cold = fminf(cold, fabsf(c));
+        c = 0.0f;
+        for(j = 0u; j < MAT_SIZE; j++)
+        {
+            c += _tracker.Phi[i][j] * eigFixture_Q[j][i];
+        }
+        truth = fminf(truth, fabsf(c));
+    }
+    CHECK(warm > 0.999f);
+    CHECK(warm > cold);
+    CHECK(truth > 0.95f);
+    printf("  worst |cos| after the turn: warm start %.5f, cold start %.5f, true axes %.4f\n",
+        (double)warm, (double)cold, (double)truth);
+}
+
+static void test_too_few_samples(void)
+{
+    float init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    uint8 s;
+
+    eigFixture_initialGuess(init);
+    eig_tracker_init(&_tracker, 0.01f, 2u, init);
+    for(s = 0u; s < PRINCIPLE_COMPONENTS; s++)
+    {
+        eig_tracker_add(&_tracker, _samples[s]);
+        CHECK(0u == eig_tracker_update(&_tracker));
+    }
+    CHECK(0 == memcmp(_tracker.Phi, init, sizeof(init)));
+    eig_tracker_add(&_tracker, _samples[s]);
+    CHECK(1u == eig_tracker_update(&_tracker));
+    CHECK(!isnan(_tracker.Phi[PRINCIPLE_COMPONENTS - 1][0]));
+}
+
+/* no iterations: nothing is updated, lambda is not divided by the weight
+   over and over */
+static void test_no_iterations(void)
+{
+    float init[PRINCIPLE_COMPONENTS][MAT_SIZE];
+    float lambda[PRINCIPLE_COMPONENTS];
+    uint32 s;
+
+    eigFixture_initialGuess(init);
+    eig_tracker_init(&_tracker, 0.0f, 1u, init);
+    for(s = 0u; s < 64u; s++)
+    {
+        eig_tracker_add(&_tracker, _samples[s]);
+    }
+    CHECK(1u == eig_tracker_update(&_tracker));
+    memcpy(lambda, _tracker.lambda, sizeof(lambda));
+    _tracker.p_iter = 0u;
+    for(s = 0u; s < 3u; s++)
+    {
+        CHECK(0u == eig_tracker_update(&_tracker));
+    }
+    CHECK(0 == memcmp(_tracker.lambda, lambda, sizeof(lambda)));
+}
+
+int main(void)
+{
+    RUN_TEST(test_sliding_window);
+    RUN_TEST(test_exponential_forgetting);
+    RUN_TEST(test_tracks_principal_axes);
+    RUN_TEST(test_too_few_samples);
+    RUN_TEST(test_no_iterations);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,150 @@
+/*******************************************************************************
+* File Name: test_flow_control.c
+*
+* Description:
+*  Credit grants arriving over RX, back-to-back sending while credits last,
+*  fallback to the fixed UART_PACKET_DELAY_MS pacing when they run out, and
+*  the link statistics packet.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+#include "flow_control.h"
+
+#include <math.h>
+#include <string.h>
+
+#define PACKET_BYTES (PACKET_HEAD_BYTES + 4u + PACKET_TAIL_BYTES)
+
+extern uint8 rxReadChar;
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    while(flowControl_takeCredit()) { }
+    flowControl_setStatsPeriod(0u);
+    HalShim_Reset();
+    rxRing_reset();
+}
+
+static void _receive(uint8 command, uint16 value)
+{
+    /* what the isr_rx merge region does for each byte from the host */
+    uint8 bytes[3];
+
+    bytes[0] = command;
+    bytes[1] = LO8(value);
+    bytes[2] = HI8(value);
+    rxRing_write(bytes, 3u);
+    parseRxBuffer();
+}
+
+static uint64 _sendOne(void)
+{
+    uint32 value = 0x11223344u;
+    uint64 start = HalShim_GetTimeNs();
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, 4, &value);
+    return HalShim_GetTimeNs() - start;
+}
+
+static void test_no_credit_is_paced(void)
+{
+    uint64 wireNs;
+
+    _setup();
+    wireNs = PACKET_BYTES * HalShim_GetByteTimeNs();
+    CHECK(_sendOne() >= wireNs + 1000000u);     /* legacy 1 ms pacing */
+    CHECK(PACKET_BYTES == HalShim_GetTxCount());
+}
+
+static void test_credits_send_back_to_back(void)
+{
+    uint64 wireNs;
+    uint8  i;
+
+    _setup();
+    _receive(RX_NEXT_IS_CREDIT, 3u);
+    CHECK(RX_NO_PACKETES == rxReadChar);        /* not passed up to the application */
+    CHECK(3u == flowControl_getCredits());
+
+    wireNs = PACKET_BYTES * HalShim_GetByteTimeNs();
+    for(i = 0u; i < 3u; i++)
+    {
+        CHECK(wireNs == _sendOne());            /* nothing but the bytes themselves */
+    }
+    CHECK(0u == flowControl_getCredits());
+    CHECK(_sendOne() >= wireNs + 1000000u);     /* out of credits: paced again */
+    CHECK(4u * PACKET_BYTES == HalShim_GetTxCount());
+}
+
+static void test_credits_capped(void)
+{
+    _setup();
+    _receive(RX_NEXT_IS_CREDIT, 1000u);
+    _receive(RX_NEXT_IS_CREDIT, 1000u);
+    CHECK(FLOW_CONTROL_MAX_CREDITS == flowControl_getCredits());
+}
+
+static void test_log_message_uses_credit(void)
+{
+    uint64 start;
+
+    _setup();
+    _receive(RX_NEXT_IS_CREDIT, 1u);
+    start = HalShim_GetTimeNs();
+    sendLogMessage("ok");
+    CHECK((PACKET_HEAD_BYTES + 2u + PACKET_TAIL_BYTES) * HalShim_GetByteTimeNs() == HalShim_GetTimeNs() - start);
+    CHECK(0u == flowControl_getCredits());
+}
+
+static void test_link_stats(void)
+{
+    float stats[FLOW_CONTROL_STATS_FLOATS];
+    const uint8 * packet;
+    uint32 i;
+
+    _setup();
+    _receive(RX_NEXT_IS_LINK_STATS, 100u);
+    _receive(RX_NEXT_IS_CREDIT, 50u);
+    for(i = 0u; i < 60u; i++)
+    {
+        _sendOne();
+    }
+    HalShim_AdvanceNs(100000000u - (HalShim_GetTimeNs() % 100000000u)); /* finish the 100 ms window */
+    HalShim_ClearTx();
+    flowControl_poll();
+
+    CHECK((PACKET_HEAD_BYTES + sizeof(stats) + PACKET_TAIL_BYTES) == HalShim_GetTxCount());
+    packet = HalShim_GetTxBytes();
+    CHECK(MESSAGE_TYPE_BINARY_FLOAT == packet[4]);
+    CHECK(MESSAGE_FLAG_LINK_STATS == packet[5]);
+    memcpy(stats, &packet[PACKET_HEAD_BYTES], sizeof(stats));
+    CHECK(stats[0] > 0.0f);
+    CHECK(fabsf(stats[0] - 600.0f) < 0.1f);     /* 60 packets in 100 ms */
+    CHECK(fabsf(stats[1] - 600.0f * PACKET_BYTES) < 1.0f);
+    CHECK(0.0f == stats[2]);                    /* credits used up */
+    CHECK(10.0f == stats[3]);                   /* the last 10 packets were paced */
+
+    /* nothing more until the next window */
+    HalShim_ClearTx();
+    flowControl_poll();
+    CHECK(0u == HalShim_GetTxCount());
+    _receive(RX_NEXT_IS_LINK_STATS, 0u);
+    HalShim_AdvanceNs(200000000u);
+    flowControl_poll();
+    CHECK(0u == HalShim_GetTxCount());
+}
+
+int main(void)
+{
+    RUN_TEST(test_no_credit_is_paced);
+    RUN_TEST(test_credits_send_back_to_back);
+    RUN_TEST(test_credits_capped);
+    RUN_TEST(test_log_message_uses_credit);
+    RUN_TEST(test_link_stats);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,217 @@
+/*******************************************************************************
+* File Name: test_log_deferred.c
+*
+* Description:
+*  LOG_MESSAGE() before and after the host hands over a matching dictionary
+*  CRC: ASCII fallback, format IDs resolving to the log_fmt section, argument
+*  packing and truncation. With --dump <file> it also writes each deferred
+*  payload next to what vsnprintf makes of the same call, which
+*  check_log_dictionary.py expands with log_dictionary.py and compares.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+#include "log_deferred.h"
+
+#include <stdint.h>
+#include <string.h>
+
+
+extern const char __start_log_fmt[];
+
+static void _setup(uint8 deferred)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+    rxRing_reset();
+    logDeferred_setDictionary(deferred ? logDeferred_getDictionaryCrc() : 0u);
+    HalShim_ClearTx();
+}
+
+static void _receive(uint8 command, uint16 value)
+{
+    uint8 bytes[3];
+
+    bytes[0] = command;
+    bytes[1] = LO8(value);
+    bytes[2] = HI8(value);
+    rxRing_write(bytes, 3u);
+    parseRxBuffer();
+}
+
+static uint16 _payloadBytes(void)
+{
+    return (uint16)(HalShim_GetTxBytes()[6] | (HalShim_GetTxBytes()[7] << 8));
+}
+
+static const uint8 * _payload(void)
+{
+    return &HalShim_GetTxBytes()[PACKET_HEAD_BYTES];
+}
+
+static void test_ascii_until_dictionary(void)
+{
+    _setup(0u);
+    CHECK(!logDeferred_isEnabled());
+    LOG_MESSAGE("x=%d", 42);
+    CHECK(MESSAGE_TYPE_LOG == HalShim_GetTxBytes()[4]);
+    CHECK(4u == _payloadBytes());
+    CHECK(0 == memcmp(_payload(), "x=42", 4));
+}
+
+static void test_dictionary_over_rx(void)
+{
+    uint16 crc;
+
+    _setup(0u);
+    crc = logDeferred_getDictionaryCrc();
+    _receive(RX_NEXT_IS_LOG_DICTIONARY, (uint16)(crc + 1u));
+    CHECK(!logDeferred_isEnabled());
+    CHECK(MESSAGE_TYPE_LOG == HalShim_GetTxBytes()[4]);   /* tells the host why */
+
+    _receive(RX_NEXT_IS_LOG_DICTIONARY, crc);
+    CHECK(logDeferred_isEnabled());
+    _receive(RX_NEXT_IS_LOG_DICTIONARY, 0u);
+    CHECK(!logDeferred_isEnabled());
+}
+
+static void test_format_id_and_arguments(void)
+{
+    const uint8 * payload;
+    uint16 formatId;
+    int32  signedValue;
+    uint32 unsignedValue;
+    float  aFloat;
+
+    _setup(1u);
+    LOG_MESSAGE("a=%d b=%u s=%s f=%f c=%c", -3, 7u, "hi", 1.5, 'Z');
+    CHECK(MESSAGE_TYPE_LOG_DEFERRED == HalShim_GetTxBytes()[4]);
+    CHECK((2u + 4u + 4u + 3u + 4u + 1u) == _payloadBytes());
+    payload = _payload();
+    formatId = (uint16)(payload[0] | (payload[1] << 8));
+    CHECK(0 == strcmp(&__start_log_fmt[formatId], "a=%d b=%u s=%s f=%f c=%c"));
+    memcpy(&signedValue, &payload[2], 4);
+    memcpy(&unsignedValue, &payload[6], 4);
+    memcpy(&aFloat, &payload[13], 4);
+    CHECK(-3 == signedValue);
+    CHECK(7u == unsignedValue);
+    CHECK(0 == memcmp(&payload[10], "hi", 3));
+    CHECK(1.5f == aFloat);
+    CHECK('Z' == payload[17]);
+    CHECK(0xB6 == HalShim_GetTxBytes()[HalShim_GetTxCount() - 1u]);
+}
+
+static void test_call_sites_get_distinct_ids(void)
+{
+    uint16 firstId;
+
+    _setup(1u);
+    LOG_MESSAGE("same text");
+    firstId = (uint16)(_payload()[0] | (_payload()[1] << 8));
+    HalShim_ClearTx();
+    LOG_MESSAGE("same text");
+    CHECK(firstId != (uint16)(_payload()[0] | (_payload()[1] << 8)));
+    CHECK(2u == _payloadBytes());
+}
+
+static void test_wide_and_star_arguments(void)
+{
+    uint64 wide;
+    int32  width;
+
+    _setup(1u);
+    LOG_MESSAGE("%*d %llx %%", 6, 12, 0x1122334455667788ull);
+    CHECK((2u + 4u + 4u + 8u) == _payloadBytes());
+    memcpy(&width, &_payload()[2], 4);
+    memcpy(&wide, &_payload()[10], 8);
+    CHECK(6 == width);
+    CHECK(0x1122334455667788ull == wide);
+}
+
+static void test_long_string_truncated(void)
+{
+    static char longString[PACKET_MAX_PAYLOAD_BYTES + 50u];
+
+    _setup(1u);
+    memset(longString, 'q', sizeof(longString) - 1u);
+    LOG_MESSAGE("%s %d", longString, 5);
+    CHECK(PACKET_MAX_PAYLOAD_BYTES == _payloadBytes());
+    CHECK(0 == _payload()[PACKET_MAX_PAYLOAD_BYTES - 1u]);   /* still terminated, %d left off */
+}
+
+static void test_deferred_is_smaller(void)
+{
+    uint32 asciiBytes;
+
+    _setup(0u);
+    LOG_MESSAGE("ADC channel %u: %f V, gain %d, status %s", 3u, 1.25, 16, "ok");
+    asciiBytes = HalShim_GetTxCount();
+    _setup(1u);
+    LOG_MESSAGE("ADC channel %u: %f V, gain %d, status %s", 3u, 1.25, 16, "ok");
+    printf("  %u bytes on the wire as ASCII, %u deferred\n", (unsigned)asciiBytes, (unsigned)HalShim_GetTxCount());
+    CHECK(HalShim_GetTxCount() < asciiBytes);
+}
+
+#define DUMP_CASE(file, format, ...)                                        \
+    do {                                                                    \
+        char expected[LOG_MESSAGE_MAX_BYTES];                               \
+        HalShim_ClearTx();                                                  \
+        LOG_MESSAGE(format, __VA_ARGS__);                                   \
+        snprintf(expected, sizeof(expected), format, __VA_ARGS__);          \
+        _dumpPacket(file, expected);                                        \
+    } while(0)
+
+static void _dumpPacket(FILE * file, const char * expected)
+{
+    uint16 i;
+
+    for(i = 0u; i < _payloadBytes(); i++)
+    {
+        fprintf(file, "%02x", _payload()[i]);
+    }
+    fprintf(file, "\t%s\n", expected);
+}
+
+static int _dump(const char * path)
+{
+    FILE * file = fopen(path, "w");
+
+    if(NULL == file)
+    {
+        return 1;
+    }
+    _setup(1u);
+    DUMP_CASE(file, "Hello World: %i", 7);
+    DUMP_CASE(file, "a=%d b=%u s=%s f=%f c=%c", -3, 7u, "hi", 1.5, 'Z');
+    DUMP_CASE(file, "%-6s|%6s|%.2s", "ab", "cd", "efgh");
+    DUMP_CASE(file, "%x %X %o %#x %08x", 0xBEEFu, 0xBEEFu, 8u, 255u, 0x1234u);
+    DUMP_CASE(file, "%d %u %x", -1, 0xFFFFFFFFu, -1);
+    DUMP_CASE(file, "%hhx %hd %hu", 0x1FF, 70000, 70000);
+    DUMP_CASE(file, "%ld %lu %lld %llu", -5L, 5UL, -1234567890123LL, 1234567890123ULL);
+    DUMP_CASE(file, "%.3f %e %g %E %G", 3.25, 0.5, 100.0, -2.0, 0.125);
+    DUMP_CASE(file, "%*d|%-*d|%.*f", 5, 42, 4, 7, 2, 1.75);
+    DUMP_CASE(file, "100%% %s %5.1f", "done", 99.5);
+    DUMP_CASE(file, "%+d % d %05d", 3, 3, -3);
+    fclose(file);
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    if(argc > 2 && 0 == strcmp(argv[1], "--dump"))
+    {
+        return _dump(argv[2]);
+    }
+    RUN_TEST(test_ascii_until_dictionary);
+    RUN_TEST(test_dictionary_over_rx);
+    RUN_TEST(test_format_id_and_arguments);
+    RUN_TEST(test_call_sites_get_distinct_ids);
+    RUN_TEST(test_wide_and_star_arguments);
+    RUN_TEST(test_long_string_truncated);
+    RUN_TEST(test_deferred_is_smaller);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
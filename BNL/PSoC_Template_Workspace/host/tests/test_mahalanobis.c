@@ -0,0 +1,162 @@
+/*******************************************************************************
+* File Name: test_mahalanobis.c
+*
+* Description:
+*  mahalanobis_tracker inverse covariance after Sherman-Morrison updates
+*  against packed_invert() of its own covariance, with and without periodic
+*  refactoring over a long run, scores of Gaussian samples (mean
+*  MAT_SIZE) and of steps along quiet and loud axes, and the empty tracker.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "eig_fixture.h"
+#include "mahalanobis.h"
+
+#include <math.h>
+#include <string.h>
+
+static mahalanobis_tracker _tracker;
+static mahalanobis_tracker _refactored;
+/* worst difference between a tracker's Sigma_inv and a fresh inverse of its
+   Sigma, relative to the largest element */
+static float _drift(mahalanobis_tracker * tracker)
+{
+    static float reference[EIG_PACKED_SIZE];
+    static float factor[EIG_PACKED_SIZE];
+    float largest = 0.0f, worst = 0.0f;
+    uint16 n;
+
+    (void)packed_invert(tracker->Sigma, reference, factor);
+    for(n = 0u; n < EIG_PACKED_SIZE; n++)
+    {
+        largest = fmaxf(largest, fabsf(reference[n]));
+        worst = fmaxf(worst, fabsf(reference[n] - tracker->Sigma_inv[n]));
+    }
+    return worst / largest;
+}
+
+static void test_empty_tracker(void)
+{
+    float x[MAT_SIZE];
+    uint8 j;
+
+    eigFixture_buildQ(7u);
+    eigFixture_sample(x);
+    mahalanobis_init(&_tracker, 0.01f, 0.1f, 0u);
+    CHECK(0.0f == mahalanobis_score(&_tracker, x));
+    CHECK(0.0f == mahalanobis_add(&_tracker, x));
+    for(j = 0u; j < MAT_SIZE; j++)
+    {
+        CHECK(x[j] == _tracker.mean[j]);
+    }
+    CHECK(10.0f == _tracker.Sigma_inv[0]);      /* still the prior */
+    CHECK(mahalanobis_add(&_tracker, x) == 0.0f);   /* same sample again, no distance */
+}
+
+static void test_matches_full_inverse(void)
+{
+    float x[MAT_SIZE];
+    float d[MAT_SIZE], u[MAT_SIZE];
+    static float reference[EIG_PACKED_SIZE];
+    static float factor[EIG_PACKED_SIZE];
+    float expected;
+    uint16 s;
+    uint8 j;
+
+    /* every sample weighs the same, no refactoring: all Sherman-Morrison */
+    eigFixture_buildQ(11u);
+    mahalanobis_init(&_tracker, 0.0f, 0.1f, 0u);
+    for(s = 0u; s < 500u; s++)
+    {
+        eigFixture_sample(x);
+        (void)mahalanobis_add(&_tracker, x);
+    }
+    CHECK(_tracker.weight == 500.0f);
+    CHECK(_drift(&_tracker) < 1e-3f);
+    printf("  500 updates: Sigma_inv off by %.2g of its largest element\n", (double)_drift(&_tracker));
+
+    /* the score is the one the full inverse gives */
+    eigFixture_sample(x);
+    (void)packed_invert(_tracker.Sigma, reference, factor);
+    for(j = 0u; j < MAT_SIZE; j++)
+    {
+        d[j] = x[j] - _tracker.mean[j];
+    }
+    packed_matvec(reference, d, u);
+    expected = _tracker.weight * dot(d, u);
+    CHECK(fabsf(mahalanobis_score(&_tracker, x) - expected) < 1e-3f * expected);
+    CHECK(fabsf(mahalanobis_add(&_tracker, x) - expected) < 1e-3f * expected);
+}
+
+static void test_refactor_bounds_drift(void)
+{
+    float x[MAT_SIZE];
+    uint16 s;
+
+    /* equal weights: every update shrinks the correction, rounding adds up */
+    eigFixture_buildQ(13u);
+    mahalanobis_init(&_tracker, 0.0f, 0.1f, 0u);
+    mahalanobis_init(&_refactored, 0.0f, 0.1f, 64u);
+    for(s = 0u; s < 20000u; s++)
+    {
+        eigFixture_sample(x);
+        (void)mahalanobis_add(&_tracker, x);
+        (void)mahalanobis_add(&_refactored, x);
+    }
+    CHECK(_refactored.since_refactor == (20000u - 1u) % 64u);  /* the first sample only sets the mean */
+    CHECK(_drift(&_refactored) < 1e-5f);
+    CHECK(4.0f * _drift(&_refactored) < _drift(&_tracker));
+    printf("  20000 updates: drift %.2g, refactored every 64: %.2g\n",
+        (double)_drift(&_tracker), (double)_drift(&_refactored));
+}
+
+static void test_scores(void)
+{
+    float x[MAT_SIZE];
+    double total = 0.0;
+    float quiet, loud;
+    uint16 s;
+    uint8 j;
+
+    eigFixture_buildQ(17u);
+    mahalanobis_init(&_tracker, 0.002f, 0.01f, 128u);
+    for(s = 0u; s < 3000u; s++)
+    {
+        eigFixture_sample(x);
+        (void)mahalanobis_add(&_tracker, x);
+    }
+    /* Gaussian samples: chi-squared with MAT_SIZE degrees of freedom */
+    for(s = 0u; s < 2000u; s++)
+    {
+        eigFixture_sample(x);
+        total += mahalanobis_add(&_tracker, x);
+    }
+    CHECK(fabs(total / 2000.0 - MAT_SIZE) < 0.15 * MAT_SIZE);
+    printf("  mean score of 2000 samples: %.1f (MAT_SIZE %u)\n", total / 2000.0, MAT_SIZE);
+
+    /* the same 3.0 step, along the quietest and the loudest axis */
+    for(j = 0u; j < MAT_SIZE; j++)
+    {
+        x[j] = _tracker.mean[j] + 3.0f * eigFixture_Q[j][MAT_SIZE - 1];
+    }
+    quiet = mahalanobis_score(&_tracker, x);
+    for(j = 0u; j < MAT_SIZE; j++)
+    {
+        x[j] = _tracker.mean[j] + 3.0f * eigFixture_Q[j][0];
+    }
+    loud = mahalanobis_score(&_tracker, x);
+    CHECK(quiet > 50.0f);                       /* (3.0 / 0.3)^2 = 100 */
+    CHECK(loud < 2.0f);                         /* (3.0 / 4)^2 = 0.56 */
+    printf("  3.0 step: quiet axis %.1f, loud axis %.2f\n", (double)quiet, (double)loud);
+}
+
+int main(void)
+{
+    RUN_TEST(test_empty_tracker);
+    RUN_TEST(test_matches_full_inverse);
+    RUN_TEST(test_refactor_bounds_drift);
+    RUN_TEST(test_scores);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,153 @@
+/*******************************************************************************
+* File Name: test_packet_integrity.c
+*
+* Description:
+*  Packet tail: sequence numbers in wire order across the queued and direct
+*  send paths, and the CRC over header, timestamp, payload and sequence.
+*  Built once per PACKET_CRC_BITS setting.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "crc.h"
+
+#include <string.h>
+
+#define MAX_PACKETS 16
+
+static uint32 _packetStart[MAX_PACKETS];
+static uint32 _numPackets;
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+    flowControl_grant(100u);
+}
+
+static uint32 _packetLength(const uint8 * packet)
+{
+    uint16 length = (uint16)(packet[6] | (packet[7] << 8));
+    if(MESSAGE_TYPE_FLAG == packet[4])
+    {
+        length = 0u;
+    }
+    return PACKET_HEAD_BYTES + length + PACKET_TAIL_BYTES;
+}
+
+static void _splitWire(void)
+{
+    /* the decoder's job: walk the byte stream packet by packet */
+    const uint8 * wire = HalShim_GetTxBytes();
+    uint32 offset = 0u;
+
+    _numPackets = 0u;
+    while(offset < HalShim_GetTxCount() && _numPackets < MAX_PACKETS)
+    {
+        _packetStart[_numPackets++] = offset;
+        offset += _packetLength(&wire[offset]);
+    }
+    CHECK(offset == HalShim_GetTxCount());
+}
+
+static uint8 _verify(const uint8 * packet, uint16 * sequence)
+{
+    uint32 length = _packetLength(packet);
+    const uint8 * tail = &packet[length - PACKET_TAIL_BYTES];
+    uint32 expected = 0u;
+    uint32 actual = 0u;
+    uint8  i;
+
+#if (PACKET_CRC_BITS == 32)
+    expected = CRC32_FINAL(crc32_update(CRC32_INIT, &packet[4], (uint16)(length - 4u - PACKET_TAIL_BYTES + PACKET_SEQUENCE_BYTES)));
+#else
+    expected = crc16_update(CRC16_INIT, &packet[4], (uint16)(length - 4u - PACKET_TAIL_BYTES + PACKET_SEQUENCE_BYTES));
+#endif
+    for(i = 0u; i < PACKET_CRC_BYTES; i++)
+    {
+        actual |= (uint32)tail[PACKET_SEQUENCE_BYTES + i] << (8u * i);
+    }
+    *sequence = (uint16)(tail[0] | (tail[1] << 8));
+    return (expected == actual) && (0xB6 == tail[PACKET_TAIL_BYTES - 4u]) && (0xB6 == tail[PACKET_TAIL_BYTES - 1u]);
+}
+
+static void test_crc_check_values(void)
+{
+    const uint8 check[9] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+    CHECK(0x29B1u == crc16_update(CRC16_INIT, check, 9u));
+    CHECK(0xCBF43926u == CRC32_FINAL(crc32_update(CRC32_INIT, check, 9u)));
+    /* fed in pieces gives the same answer */
+    CHECK(0x29B1u == crc16_update(crc16_update(CRC16_INIT, check, 4u), &check[4], 5u));
+    CHECK(0xCBF43926u == CRC32_FINAL(crc32_update(crc32_update(CRC32_INIT, check, 4u), &check[4], 5u)));
+}
+
+static void test_tail_on_every_path(void)
+{
+    static uint8 big[PACKET_MAX_PAYLOAD_BYTES + 40u];
+    float  samples[3] = {0.5f, -1.0f, 3.25f};
+    uint32 value = 7u;
+    uint16 sequence;
+    uint16 firstSequence = 0u;
+    uint32 i;
+
+    _setup();
+    for(i = 0u; i < sizeof(big); i++) { big[i] = (uint8)(i * 7u); }
+
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(samples), samples);
+    constructAndSendPacket(MESSAGE_TYPE_FLAG, MESSAGE_FLAG_CHAR_PARSED, 4, &value);
+    sendLogMessage("seq test %d", 3);
+    queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, 4, &value); /* left queued ... */
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(big), big); /* ... flushed ahead of this one */
+
+    _splitWire();
+    CHECK(5u == _numPackets);
+    for(i = 0u; i < _numPackets; i++)
+    {
+        CHECK(_verify(&HalShim_GetTxBytes()[_packetStart[i]], &sequence));
+        if(0u == i)
+        {
+            firstSequence = sequence;
+        }
+        CHECK((uint16)(firstSequence + i) == sequence); /* consecutive, in wire order */
+    }
+    CHECK(PACKET_HEAD_BYTES + sizeof(big) + PACKET_TAIL_BYTES == HalShim_GetTxCount() - _packetStart[4]);
+}
+
+static void test_corruption_detected(void)
+{
+    float  samples[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    uint8  copy[PACKET_HEAD_BYTES + sizeof(samples) + PACKET_TAIL_BYTES];
+    uint16 sequence;
+    uint32 bit;
+
+    _setup();
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(samples), samples);
+    CHECK(sizeof(copy) == HalShim_GetTxCount());
+    memcpy(copy, HalShim_GetTxBytes(), sizeof(copy));
+    CHECK(_verify(copy, &sequence));
+
+    /* every single bit flip in the covered bytes is caught */
+    for(bit = 4u * 8u; bit < (sizeof(copy) - PACKET_TAIL_BYTES + PACKET_SEQUENCE_BYTES) * 8u; bit++)
+    {
+        if(bit >= 6u * 8u && bit < 8u * 8u)
+        {
+            continue; /* length field: changes where the decoder looks for the tail */
+        }
+        copy[bit / 8u] ^= (uint8)(1u << (bit % 8u));
+        CHECK(!_verify(copy, &sequence));
+        copy[bit / 8u] ^= (uint8)(1u << (bit % 8u));
+    }
+}
+
+int main(void)
+{
+    printf("PACKET_CRC_BITS = %d\n", PACKET_CRC_BITS);
+    RUN_TEST(test_crc_check_values);
+    RUN_TEST(test_tail_on_every_path);
+    RUN_TEST(test_corruption_detected);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
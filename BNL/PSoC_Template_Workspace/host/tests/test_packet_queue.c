@@ -0,0 +1,247 @@
+/*******************************************************************************
+* File Name: test_packet_queue.c
+*
+* Description:
+*  packet_queue.c on the blocking PutChar path: reservation order, a packet
+*  queued by an "ISR" while the main loop is half way through its own, drop
+*  and high-water accounting, and concurrent producers on real threads.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "packet_queue.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#define STRESS_PRODUCERS    4
+#define STRESS_PACKETS      5000u
+#define STRESS_PACKET_BYTES (PACKET_HEAD_BYTES + 8u + PACKET_TAIL_BYTES)
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+    HalShim_SetBlockingUart(0u);
+    packetQueue_resetStats();
+}
+
+static uint32 _payloadOf(uint32 packetIndex, uint32 payloadBytes)
+{
+    /* payloads start right after the 12 byte head of each fixed size packet */
+    uint32 value;
+    memcpy(&value, &HalShim_GetTxBytes()[packetIndex * (PACKET_HEAD_BYTES + payloadBytes + PACKET_TAIL_BYTES) + PACKET_HEAD_BYTES], sizeof(value));
+    return value;
+}
+
+static void test_wire_format(void)
+{
+    float payload[2] = {1.0f, -2.5f};
+    const uint8 * wire;
+
+    _setup();
+    CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(payload), payload));
+    CHECK(0u == HalShim_GetTxCount());          /* queuing never touches the UART */
+    CHECK(1u == packetQueue_getPending());
+    payload[0] = 7.0f;                          /* the slot holds its own copy */
+
+    packetQueue_drain();
+    CHECK(packetQueue_isIdle());
+    CHECK((PACKET_HEAD_BYTES + sizeof(payload) + PACKET_TAIL_BYTES) == HalShim_GetTxCount());
+    wire = HalShim_GetTxBytes();
+    CHECK(0xA5 == wire[0] && 0xA5 == wire[3]);
+    CHECK(MESSAGE_TYPE_BINARY_FLOAT == wire[4]);
+    CHECK(sizeof(payload) == (wire[6] | (wire[7] << 8)));
+    CHECK(1.0f == *(const float *)&wire[12]);
+    CHECK(0xB6 == wire[HalShim_GetTxCount() - 4u] && 0xB6 == wire[HalShim_GetTxCount() - 1u]);
+}
+
+static void test_flag_has_no_payload(void)
+{
+    uint32 value = 0x12345678u;
+
+    _setup();
+    constructAndSendPacket(MESSAGE_TYPE_FLAG, MESSAGE_FLAG_CHAR_PARSED, 4, &value);
+    CHECK((PACKET_HEAD_BYTES + PACKET_TAIL_BYTES) == HalShim_GetTxCount());
+    CHECK(4 == HalShim_GetTxBytes()[6]);        /* header still reports the length */
+    CHECK(0xB6 == HalShim_GetTxBytes()[HalShim_GetTxCount() - 1u]);
+}
+
+static void test_isr_preempts_main_loop(void)
+{
+    packetQueueSlot * mainSlot;
+    uint32 isrValue = 0xBBBBBBBBu;
+    uint32 mainValue = 0xAAAAAAAAu;
+
+    _setup();
+    /* main loop reserves a slot and is interrupted before it commits */
+    mainSlot = packetQueue_reserve();
+    CHECK(NULL != mainSlot);
+    memset(mainSlot->data, 0xA5, PACKET_HEAD_BYTES);
+    memcpy(&mainSlot->data[PACKET_HEAD_BYTES], &mainValue, 2);
+
+    /* the ISR queues a complete packet and tries to drain */
+    CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_LOG, MESSAGE_FLAG_CHAR_RECIEVED, 4, &isrValue));
+    packetQueue_drain();
+    CHECK(0u == HalShim_GetTxCount());          /* blocked behind the uncommitted main slot */
+
+    /* main loop finishes its packet */
+    memcpy(&mainSlot->data[PACKET_HEAD_BYTES + 2], &((uint8 *)&mainValue)[2], 2);
+    memset(&mainSlot->data[PACKET_HEAD_BYTES + 4], 0xB6, PACKET_TAIL_BYTES);
+    mainSlot->numBytes = PACKET_HEAD_BYTES + 4u + PACKET_TAIL_BYTES;
+    packetQueue_commit(mainSlot);
+    packetQueue_drain();
+
+    CHECK(2u * (PACKET_HEAD_BYTES + 4u + PACKET_TAIL_BYTES) == HalShim_GetTxCount());
+    CHECK(mainValue == _payloadOf(0, 4));       /* reservation order, neither packet torn */
+    CHECK(isrValue == _payloadOf(1, 4));
+}
+
+static void test_drop_and_high_water(void)
+{
+    uint32 i;
+    uint32 queued = 0u;
+
+    _setup();
+    for(i = 0u; i < PACKET_QUEUE_NUM_SLOTS + 3u; i++)
+    {
+        if(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, 4, &i))
+        {
+            queued++;
+        }
+    }
+    CHECK(PACKET_QUEUE_NUM_SLOTS == queued);
+    CHECK(3u == packetQueue_getDropCount());
+    CHECK(PACKET_QUEUE_NUM_SLOTS == packetQueue_getHighWater());
+
+    packetQueue_drain();
+    for(i = 0u; i < PACKET_QUEUE_NUM_SLOTS; i++)
+    {
+        CHECK(i == _payloadOf(i, 4));           /* the overflow was dropped, not the backlog */
+    }
+    CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, 4, &i));
+    CHECK(PACKET_ERR_TOO_LONG == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, PACKET_MAX_PAYLOAD_BYTES + 1u, &i));
+    CHECK(PACKET_QUEUE_NUM_SLOTS == packetQueue_getHighWater());
+}
+
+static void test_log_message_in_slot(void)
+{
+    _setup();
+    sendLogMessage("x=%d", 42);
+    CHECK((PACKET_HEAD_BYTES + 4u + PACKET_TAIL_BYTES) == HalShim_GetTxCount());
+    CHECK(4 == HalShim_GetTxBytes()[6]);
+    CHECK(0 == memcmp(&HalShim_GetTxBytes()[12], "x=42", 4));
+    CHECK(0xB6 == HalShim_GetTxBytes()[HalShim_GetTxCount() - 4u] && 0xB6 == HalShim_GetTxBytes()[HalShim_GetTxCount() - 1u]);
+}
+
+static void test_oversize_packet_sent_direct(void)
+{
+    static uint8 big[PACKET_MAX_PAYLOAD_BYTES + 100u];
+    uint32 first = 0x01020304u;
+
+    _setup();
+    memset(big, 0x5A, sizeof(big));
+    CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, 4, &first));
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(big), big);
+    CHECK(first == _payloadOf(0, 4));           /* queued packet went out first */
+    CHECK((2u * (PACKET_HEAD_BYTES + PACKET_TAIL_BYTES) + 4u + sizeof(big)) == HalShim_GetTxCount());
+    CHECK(0x5A == HalShim_GetTxBytes()[2u * PACKET_HEAD_BYTES + 4u + PACKET_TAIL_BYTES]);
+}
+
+static volatile int _stressDone;
+
+static void * _producer(void * arg)
+{
+    uint32 payload[2];
+    uint32 sequence;
+
+    payload[0] = (uint32)(intptr_t)arg;
+    for(sequence = 0u; sequence < STRESS_PACKETS; sequence++)
+    {
+        payload[1] = sequence;
+        queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(payload), payload);
+        if(0u == (sequence & 15u))
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void * _consumer(void * arg)
+{
+    (void)arg;
+    while(!_stressDone)
+    {
+        packetQueue_drain();
+    }
+    packetQueue_drain();
+    return NULL;
+}
+
+static void test_concurrent_producers(void)
+{
+    pthread_t producers[STRESS_PRODUCERS];
+    pthread_t consumer;
+    int32  lastSequence[STRESS_PRODUCERS];
+    uint32 received = 0u;
+    uint32 packet;
+    uint32 producer;
+    uint32 sequence;
+    const uint8 * wire;
+    int i;
+
+    _setup();
+    _stressDone = 0;
+    pthread_create(&consumer, NULL, _consumer, NULL);
+    for(i = 0; i < STRESS_PRODUCERS; i++)
+    {
+        lastSequence[i] = -1;
+        pthread_create(&producers[i], NULL, _producer, (void *)(intptr_t)i);
+    }
+    for(i = 0; i < STRESS_PRODUCERS; i++)
+    {
+        pthread_join(producers[i], NULL);
+    }
+    _stressDone = 1;
+    pthread_join(consumer, NULL);
+
+    CHECK(packetQueue_isIdle());
+    CHECK(0u == (HalShim_GetTxCount() % STRESS_PACKET_BYTES));
+    wire = HalShim_GetTxBytes();
+    for(packet = 0u; packet < HalShim_GetTxCount() / STRESS_PACKET_BYTES; packet++)
+    {
+        const uint8 * p = &wire[packet * STRESS_PACKET_BYTES];
+        CHECK(0xA5 == p[0] && 0xB6 == p[STRESS_PACKET_BYTES - 1u]);
+        memcpy(&producer, &p[PACKET_HEAD_BYTES], 4);
+        memcpy(&sequence, &p[PACKET_HEAD_BYTES + 4u], 4);
+        if(producer >= STRESS_PRODUCERS)
+        {
+            CHECK(producer < STRESS_PRODUCERS);
+            break;
+        }
+        /* per producer order survives, drops only leave gaps */
+        CHECK((int32)sequence > lastSequence[producer]);
+        lastSequence[producer] = (int32)sequence;
+        received++;
+    }
+    CHECK((received + packetQueue_getDropCount()) == STRESS_PRODUCERS * STRESS_PACKETS);
+    printf("  %u packets received, %u dropped, high water %u of %u slots\n",
+           (unsigned)received, (unsigned)packetQueue_getDropCount(),
+           (unsigned)packetQueue_getHighWater(), (unsigned)PACKET_QUEUE_NUM_SLOTS);
+}
+
+int main(void)
+{
+    RUN_TEST(test_wire_format);
+    RUN_TEST(test_flag_has_no_payload);
+    RUN_TEST(test_isr_preempts_main_loop);
+    RUN_TEST(test_drop_and_high_water);
+    RUN_TEST(test_log_message_in_slot);
+    RUN_TEST(test_oversize_packet_sent_direct);
+    RUN_TEST(test_concurrent_producers);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,314 @@
+/*******************************************************************************
+* File Name: test_payload_codec.c
+*
+* Description:
+*  payload_codec.c: lossless round trips of both codecs on sensor-like float
+*  streams and log text, fallback to the raw payload when compressing does
+*  not pay, rejection of malformed input, and the negotiated path through
+*  constructAndSendPacket()/sendLogMessage() with the codec in the header,
+*  while queuePacket() from interrupts stays uncompressed. With
+*  --dump <file> it writes encoded payloads next to the originals for
+*  check_payload_codec.py to decode with BNL/payload_codec.py.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+#include "crc.h"
+
+#include <string.h>
+
+#define NUM_FLOATS 64u
+
+
+static uint8 _encoded[PACKET_MAX_PAYLOAD_BYTES];
+static uint8 _decoded[PACKET_MAX_PAYLOAD_BYTES];
+
+static uint32 _lcg(uint32 * seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 8;
+}
+
+static void _adcVolts(float * volts, uint16 count, uint32 seed)
+{
+    /* 12 bit counts around mid scale drifting slowly, +-3 counts of noise */
+    uint16 i;
+    for(i = 0u; i < count; i++)
+    {
+        int32 counts = 2000 + (int32)(i / 8u) + (int32)(_lcg(&seed) % 7u) - 3;
+        volts[i] = (float)counts * 5.0f / 4096.0f;
+    }
+}
+
+static void _accelerations(float * xyz, uint16 samples, uint32 seed)
+{
+    /* lis2dh_getAccelerationOutputs(): integer valued floats, x y z interleaved */
+    uint16 i;
+    for(i = 0u; i < samples; i++)
+    {
+        xyz[3u * i]      = (float)(120 + (int32)(_lcg(&seed) % 9u) - 4);
+        xyz[3u * i + 1u] = (float)(-340 + (int32)(_lcg(&seed) % 9u) - 4);
+        xyz[3u * i + 2u] = (float)(16384 + (int32)(_lcg(&seed) % 9u) - 4);
+    }
+}
+
+static uint8 _roundTrip(uint8 codec, const void * in, uint16 numBytes, uint16 encodedBytes)
+{
+    uint16 decodedBytes = payloadCodec_decode(codec, _encoded, encodedBytes, _decoded, sizeof(_decoded));
+    return (decodedBytes == numBytes) && (0 == memcmp(in, _decoded, numBytes));
+}
+
+static void test_delta_adc_stream(void)
+{
+    float  volts[NUM_FLOATS];
+    uint16 n;
+
+    _adcVolts(volts, NUM_FLOATS, 1u);
+    n = payloadCodec_encodeDeltaVarint((const uint8 *)volts, sizeof(volts), _encoded, sizeof(volts) - 1u);
+    CHECK(n > 0u && _roundTrip(PAYLOAD_CODEC_DELTA_VARINT, volts, sizeof(volts), n));
+    printf("  ADC volts:       %u -> %u bytes (%.2fx)\n", (unsigned)sizeof(volts), (unsigned)n, (double)sizeof(volts) / n);
+    CHECK(n * 3u < sizeof(volts));
+}
+
+static void test_delta_interleaved_accelerations(void)
+{
+    float  xyz[3u * 20u];
+    uint16 n;
+
+    _accelerations(xyz, 20u, 2u);
+    n = payloadCodec_encodeDeltaVarint((const uint8 *)xyz, sizeof(xyz), _encoded, sizeof(xyz) - 1u);
+    CHECK(n > 0u && _roundTrip(PAYLOAD_CODEC_DELTA_VARINT, xyz, sizeof(xyz), n));
+    CHECK(2u == (_encoded[0] >> 5));            /* stride 3 picked */
+    printf("  accelerations:   %u -> %u bytes (%.2fx)\n", (unsigned)sizeof(xyz), (unsigned)n, (double)sizeof(xyz) / n);
+    CHECK(n * 2u < sizeof(xyz));
+}
+
+static void test_delta_edge_values(void)
+{
+    float  values[8] = {-1.5f, -1.25f, 0.0f, -0.0f, 3.0e38f, -3.0e38f, 1.0e-40f, 7.0f};
+    uint32 same[6] = {0xDEADBEEFu, 0xDEADBEEFu, 0xDEADBEEFu, 0xDEADBEEFu, 0xDEADBEEFu, 0xDEADBEEFu};
+    uint16 n;
+
+    n = payloadCodec_encodeDeltaVarint((const uint8 *)values, sizeof(values), _encoded, sizeof(_encoded));
+    CHECK(n > 0u && _roundTrip(PAYLOAD_CODEC_DELTA_VARINT, values, sizeof(values), n));
+    n = payloadCodec_encodeDeltaVarint((const uint8 *)same, sizeof(same), _encoded, sizeof(_encoded));
+    CHECK(1u + 4u + 5u == n && _roundTrip(PAYLOAD_CODEC_DELTA_VARINT, same, sizeof(same), n));
+    CHECK(0u == payloadCodec_encodeDeltaVarint((const uint8 *)same, 6u, _encoded, sizeof(_encoded)));  /* not whole words */
+    CHECK(0u == payloadCodec_encodeDeltaVarint((const uint8 *)same, 4u, _encoded, sizeof(_encoded)));  /* one word */
+}
+
+static void test_incompressible_falls_back(void)
+{
+    uint32 noise[NUM_FLOATS];
+    uint8  codec;
+    uint32 seed = 3u;
+    uint16 i;
+
+    for(i = 0u; i < NUM_FLOATS; i++)
+    {
+        noise[i] = _lcg(&seed) ^ (_lcg(&seed) << 16);
+    }
+    payloadCodec_setAccepted(0xFFu);
+    CHECK(sizeof(noise) == payloadCodec_encode(MESSAGE_TYPE_BINARY_FLOAT, noise, sizeof(noise), _encoded, &codec));
+    CHECK(PAYLOAD_CODEC_NONE == codec && 0 == memcmp(noise, _encoded, sizeof(noise)));
+    CHECK(sizeof(noise) == payloadCodec_encode(MESSAGE_TYPE_LOG, noise, sizeof(noise), _encoded, &codec));
+    CHECK(PAYLOAD_CODEC_NONE == codec);
+    payloadCodec_setAccepted(0u);
+}
+
+static void test_lz_text(void)
+{
+    const char * text = "lis2dh x=120 y=-340 z=16384 | lis2dh x=121 y=-339 z=16383 | lis2dh x=119 y=-341 z=16385";
+    const char * run  = "..........................................................";
+    uint16 n;
+
+    n = payloadCodec_encodeLz((const uint8 *)text, (uint16)strlen(text), _encoded, (uint16)strlen(text) - 1u);
+    CHECK(n > 0u && _roundTrip(PAYLOAD_CODEC_LZ, text, (uint16)strlen(text), n));
+    printf("  log text:        %u -> %u bytes (%.2fx)\n", (unsigned)strlen(text), (unsigned)n, (double)strlen(text) / n);
+    n = payloadCodec_encodeLz((const uint8 *)run, (uint16)strlen(run), _encoded, sizeof(_encoded));
+    CHECK(n > 0u && n < 8u && _roundTrip(PAYLOAD_CODEC_LZ, run, (uint16)strlen(run), n));   /* overlapping match */
+    CHECK(0u == payloadCodec_encodeLz((const uint8 *)"abcdefgh", 8u, _encoded, 7u));
+}
+
+static void test_malformed_input(void)
+{
+    const uint8 badOffset[3] = {0x01u, 0x05u, 0x00u};            /* match before any output */
+    const uint8 truncatedVarint[6] = {0x00u, 1u, 2u, 3u, 4u, 0x80u};
+    const uint8 longVarint[11] = {0x00u, 1u, 2u, 3u, 4u, 0x80u, 0x80u, 0x80u, 0x80u, 0x80u, 0x01u};
+
+    CHECK(0xFFFFu == payloadCodec_decode(PAYLOAD_CODEC_LZ, badOffset, 3u, _decoded, sizeof(_decoded)));
+    CHECK(0xFFFFu == payloadCodec_decode(PAYLOAD_CODEC_DELTA_VARINT, truncatedVarint, 6u, _decoded, sizeof(_decoded)));
+    CHECK(0xFFFFu == payloadCodec_decode(PAYLOAD_CODEC_DELTA_VARINT, longVarint, 11u, _decoded, sizeof(_decoded)));
+    CHECK(0xFFFFu == payloadCodec_decode(3u, badOffset, 3u, _decoded, sizeof(_decoded)));
+}
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+    rxRing_reset();
+    payloadCodec_setAccepted(0u);
+    flowControl_grant(100u);
+}
+
+static void _receiveCodecs(uint8 mask)
+{
+    uint8 bytes[2];
+
+    bytes[0] = RX_NEXT_IS_CODEC;
+    bytes[1] = mask;
+    rxRing_write(bytes, 2u);
+    parseRxBuffer();
+}
+
+static uint8 _crcOk(const uint8 * packet)
+{
+    uint16 length = (uint16)(packet[6] | (packet[7] << 8));
+    uint16 covered = (uint16)(PACKET_HEAD_BYTES - 4u + length + PACKET_SEQUENCE_BYTES);
+    const uint8 * crc = &packet[PACKET_HEAD_BYTES + length + PACKET_SEQUENCE_BYTES];
+    uint32 actual = 0u;
+    uint8  i;
+
+    for(i = 0u; i < PACKET_CRC_BYTES; i++)
+    {
+        actual |= (uint32)crc[i] << (8u * i);
+    }
+#if (PACKET_CRC_BITS == 32)
+    return CRC32_FINAL(crc32_update(CRC32_INIT, &packet[4], covered)) == actual;
+#else
+    return crc16_update(CRC16_INIT, &packet[4], covered) == actual;
+#endif
+}
+
+static void test_negotiated_packets(void)
+{
+    float volts[NUM_FLOATS];
+    const uint8 * wire;
+    uint16 length;
+
+    _setup();
+    _adcVolts(volts, NUM_FLOATS, 4u);
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(volts), volts);
+    CHECK(MESSAGE_TYPE_BINARY_FLOAT == HalShim_GetTxBytes()[4]);   /* host has not asked */
+
+    _receiveCodecs((1u << PAYLOAD_CODEC_DELTA_VARINT) | (1u << PAYLOAD_CODEC_LZ));
+    CHECK(0x06u == payloadCodec_getAccepted());
+    HalShim_ClearTx();
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(volts), volts);
+    wire = HalShim_GetTxBytes();
+    length = (uint16)(wire[6] | (wire[7] << 8));
+    CHECK((MESSAGE_TYPE_BINARY_FLOAT | (PAYLOAD_CODEC_DELTA_VARINT << PAYLOAD_CODEC_SHIFT)) == wire[4]);
+    CHECK(HalShim_GetTxCount() == PACKET_HEAD_BYTES + length + PACKET_TAIL_BYTES);
+    CHECK(_crcOk(wire));
+    CHECK(sizeof(volts) == payloadCodec_decode(PAYLOAD_CODEC_DELTA_VARINT, &wire[PACKET_HEAD_BYTES], length, _decoded, sizeof(_decoded)));
+    CHECK(0 == memcmp(volts, _decoded, sizeof(volts)));
+
+    HalShim_ClearTx();
+    sendLogMessage("%s %s %s %s", "scan complete,", "scan complete,", "scan complete,", "scan complete");
+    wire = HalShim_GetTxBytes();
+    length = (uint16)(wire[6] | (wire[7] << 8));
+    CHECK((MESSAGE_TYPE_LOG | (PAYLOAD_CODEC_LZ << PAYLOAD_CODEC_SHIFT)) == wire[4]);
+    CHECK(_crcOk(wire));
+    CHECK(58u == payloadCodec_decode(PAYLOAD_CODEC_LZ, &wire[PACKET_HEAD_BYTES], length, _decoded, sizeof(_decoded)));
+    CHECK(0 == memcmp("scan complete, scan complete, scan complete, scan complete", _decoded, 58u));
+
+    HalShim_ClearTx();
+    sendLogMessage("ok");                        /* too short to gain, goes out as it is */
+    CHECK(MESSAGE_TYPE_LOG == HalShim_GetTxBytes()[4]);
+
+    HalShim_ClearTx();
+    constructAndSendPacket(MESSAGE_TYPE_FLAG, MESSAGE_FLAG_CHAR_PARSED, 4u, volts);
+    CHECK(MESSAGE_TYPE_FLAG == HalShim_GetTxBytes()[4]);
+    CHECK(4u == HalShim_GetTxBytes()[6]);        /* flags keep their header as before */
+
+    HalShim_ClearTx();
+    CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(volts), volts));
+    packetQueue_drain();
+    wire = HalShim_GetTxBytes();
+    CHECK(MESSAGE_TYPE_BINARY_FLOAT == wire[4]); /* interrupt path, never compressed */
+    CHECK(sizeof(volts) == (uint16)(wire[6] | (wire[7] << 8)));
+    CHECK(0 == memcmp(volts, &wire[PACKET_HEAD_BYTES], sizeof(volts)));
+    CHECK(_crcOk(wire));
+
+    _receiveCodecs(0u);
+    HalShim_ClearTx();
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(volts), volts);
+    CHECK(MESSAGE_TYPE_BINARY_FLOAT == HalShim_GetTxBytes()[4]);
+}
+
+static void _dumpOne(FILE * file, uint8 codec, const void * in, uint16 numBytes, uint16 encodedBytes)
+{
+    uint16 i;
+
+    fprintf(file, "%u ", (unsigned)codec);
+    for(i = 0u; i < encodedBytes; i++)
+    {
+        fprintf(file, "%02x", _encoded[i]);
+    }
+    fprintf(file, " ");
+    for(i = 0u; i < numBytes; i++)
+    {
+        fprintf(file, "%02x", ((const uint8 *)in)[i]);
+    }
+    fprintf(file, "\n");
+}
+
+static int _dump(const char * path)
+{
+    FILE * file = fopen(path, "w");
+    float  values[NUM_FLOATS];
+    char   text[200];
+    uint32 seed;
+    uint16 n;
+    uint16 i;
+
+    if(NULL == file)
+    {
+        return 1;
+    }
+    for(seed = 1u; seed <= 20u; seed++)
+    {
+        _adcVolts(values, NUM_FLOATS, seed);
+        if(seed % 2u)
+        {
+            values[seed] = -values[seed] * 1.0e6f;   /* sign and exponent jumps */
+        }
+        n = payloadCodec_encodeDeltaVarint((const uint8 *)values, sizeof(values), _encoded, sizeof(_encoded));
+        _dumpOne(file, PAYLOAD_CODEC_DELTA_VARINT, values, sizeof(values), n);
+
+        _accelerations(values, 21u, seed);
+        n = payloadCodec_encodeDeltaVarint((const uint8 *)values, 3u * 21u * 4u, _encoded, sizeof(_encoded));
+        _dumpOne(file, PAYLOAD_CODEC_DELTA_VARINT, values, 3u * 21u * 4u, n);
+
+        n = 0u;
+        for(i = 0u; i < seed; i++)
+        {
+            n += (uint16)snprintf(&text[n], sizeof(text) - n, "ch%u=%u ", (unsigned)(i % 4u), (unsigned)(seed * 7u + i % 3u));
+        }
+        i = n;
+        n = payloadCodec_encodeLz((const uint8 *)text, i, _encoded, sizeof(_encoded));
+        _dumpOne(file, PAYLOAD_CODEC_LZ, text, i, n);
+    }
+    fclose(file);
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    if(argc > 2 && 0 == strcmp(argv[1], "--dump"))
+    {
+        return _dump(argv[2]);
+    }
+    RUN_TEST(test_delta_adc_stream);
+    RUN_TEST(test_delta_interleaved_accelerations);
+    RUN_TEST(test_delta_edge_values);
+    RUN_TEST(test_incompressible_falls_back);
+    RUN_TEST(test_lz_text);
+    RUN_TEST(test_malformed_input);
+    RUN_TEST(test_negotiated_packets);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,349 @@
+/*******************************************************************************
+* File Name: test_rpc.c
+*
+* Description:
+*  rpc.c and RX_NEXT_IS_RPC in the RX parser: ids and status in responses,
+*  many requests in flight answered in order, methods registered at init,
+*  RPC_METHOD_SET through the command table, and requests held back until the
+*  answer's packet queue slot is reserved, before the method runs. With --run
+*  <requests> <responses> it answers hex encoded requests from the host
+*  (check_rpc.py, BNL/rpc.py) and writes the response payloads back as hex.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+#include "command_table.h"
+#include "rpc.h"
+
+#include <string.h>
+
+#define METHOD_SUM   (uint8)0x20   /* uint8 values in, uint16 sum out */
+#define METHOD_HUGE  (uint8)0x21   /* claims more result than fits */
+#define METHOD_FILL  (uint8)0x22   /* fills the packet queue */
+
+static uint8 _sum(const uint8 * arguments, uint16 numArguments, uint8 * result, uint16 * numResult)
+{
+    uint16 sum = 0u;
+    uint16 i;
+
+    if(0u == numArguments)
+    {
+        return RPC_ERR_BAD_ARGUMENTS;
+    }
+    for(i = 0u; i < numArguments; i++)
+    {
+        sum += arguments[i];
+    }
+    result[0] = (uint8)sum;
+    result[1] = (uint8)(sum >> 8);
+    *numResult = 2u;
+    return RPC_OK;
+}
+
+static uint8 _huge(const uint8 * arguments, uint16 numArguments, uint8 * result, uint16 * numResult)
+{
+    (void)arguments;
+    (void)numArguments;
+    (void)result;
+    *numResult = RPC_MAX_RESULT_BYTES + 1u;
+    return RPC_OK;
+}
+
+static uint8 _fill(const uint8 * arguments, uint16 numArguments, uint8 * result, uint16 * numResult)
+{
+    /* stands in for interrupts queuing packets while the method runs */
+    uint8 filler = 0u;
+    (void)arguments;
+    (void)numArguments;
+    while(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, 1u, &filler)) { }
+    result[0] = 0x5a;
+    *numResult = 1u;
+    return RPC_OK;
+}
+
+static uint8 _setGain(uint8 flag, const commandValue * value)
+{
+    (void)flag;
+    return (value->value.asUint <= 100u) ? COMMAND_OK : COMMAND_ERR_RANGE;
+}
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+    HalShim_BindUartRxIsr(rxRing_putFromUart); /* requests arrive through isr_rx */
+    rxRing_reset();
+    rxParser_reset();
+    rpc_init();
+    rpc_register(METHOD_SUM, _sum);
+    rpc_register(METHOD_HUGE, _huge);
+    rpc_register(METHOD_FILL, _fill);
+    commandTable_clear();
+    commandTable_register(1u, _setGain);
+}
+
+static uint16 _request(uint8 * out, uint16 requestId, uint8 method, const uint8 * arguments, uint16 numArguments)
+{
+    uint16 length = RPC_REQUEST_HEAD_BYTES + numArguments;
+
+    out[0] = RX_NEXT_IS_RPC;
+    out[1] = (uint8)length;
+    out[2] = (uint8)(length >> 8);
+    out[3] = (uint8)requestId;
+    out[4] = (uint8)(requestId >> 8);
+    out[5] = method;
+    memcpy(&out[6], arguments, numArguments);
+    return (uint16)(length + 3u);
+}
+
+/* payload of the index'th response on the wire, NULL if there is none */
+static const uint8 * _response(uint32 index, uint16 * numBytes)
+{
+    const uint8 * tx = HalShim_GetTxBytes();
+    uint32 start = 0u;
+    uint16 payloadBytes;
+
+    while(start + PACKET_HEAD_BYTES <= HalShim_GetTxCount())
+    {
+        payloadBytes = (uint16)(tx[start + 6u] | (tx[start + 7u] << 8));
+        if(MESSAGE_TYPE_RPC_RESPONSE == tx[start + 4u] && 0u == index--)
+        {
+            *numBytes = payloadBytes;
+            return &tx[start + PACKET_HEAD_BYTES];
+        }
+        start += PACKET_HEAD_BYTES + payloadBytes + PACKET_TAIL_BYTES;
+    }
+    return NULL;
+}
+
+static void test_ping_echoes_id_and_arguments(void)
+{
+    uint8  bytes[32];
+    uint16 numBytes;
+    const uint8 * response;
+
+    _setup();
+    numBytes = _request(bytes, 0x1234u, RPC_METHOD_PING, (const uint8 *)"hello", 5u);
+    HalShim_ReceiveBytes(bytes, numBytes);
+    CHECK(0u == rxParser_poll());
+    packetQueue_drain();
+    response = _response(0u, &numBytes);
+    CHECK(NULL != response);
+    if(NULL != response)
+    {
+        CHECK(RPC_RESPONSE_HEAD_BYTES + 5u == numBytes);
+        CHECK(0x34 == response[0] && 0x12 == response[1] && RPC_METHOD_PING == response[2] && RPC_OK == response[3]);
+        CHECK(0 == memcmp(&response[4], "hello", 5u));
+    }
+}
+
+static void test_pipelined_requests(void)
+{
+    uint8  bytes[128];
+    uint8  arguments[3];
+    uint16 numBytes = 0u;
+    uint16 responseBytes;
+    const uint8 * response;
+    uint16 i;
+
+    _setup();
+    for(i = 0u; i < 6u; i++)
+    {
+        arguments[0] = (uint8)i;
+        arguments[1] = 100u;
+        arguments[2] = 200u;
+        numBytes += _request(&bytes[numBytes], (uint16)(500u + i), METHOD_SUM, arguments, 3u);
+    }
+    HalShim_ReceiveBytes(bytes, numBytes);          /* all sent before any answer */
+    rxParser_poll();
+    packetQueue_drain();
+    for(i = 0u; i < 6u; i++)
+    {
+        response = _response(i, &responseBytes);
+        CHECK(NULL != response);
+        if(NULL != response)
+        {
+            CHECK(500u + i == (uint16)(response[0] | (response[1] << 8)));
+            CHECK(RPC_OK == response[3] && 6u == responseBytes);
+            CHECK(300u + i == (uint16)(response[4] | (response[5] << 8)));
+        }
+    }
+}
+
+static void test_errors(void)
+{
+    uint8  bytes[32];
+    uint16 numBytes;
+    const uint8 * response;
+
+    _setup();
+    numBytes  = _request(bytes, 1u, 0x77u, NULL, 0u);
+    numBytes += _request(&bytes[numBytes], 2u, METHOD_SUM, NULL, 0u);
+    numBytes += _request(&bytes[numBytes], 3u, METHOD_HUGE, NULL, 0u);
+    HalShim_ReceiveBytes(bytes, numBytes);
+    rxParser_poll();
+    packetQueue_drain();
+    response = _response(0u, &numBytes);
+    CHECK(NULL != response && RPC_ERR_NO_METHOD == response[3] && RPC_RESPONSE_HEAD_BYTES == numBytes);
+    response = _response(1u, &numBytes);
+    CHECK(NULL != response && RPC_ERR_BAD_ARGUMENTS == response[3]);
+    response = _response(2u, &numBytes);
+    CHECK(NULL != response && RPC_ERR_FAILED == response[3] && RPC_RESPONSE_HEAD_BYTES == numBytes);
+
+    /* shorter than a request head: nothing to answer to */
+    _setup();
+    bytes[0] = RX_NEXT_IS_RPC;
+    bytes[1] = 2u;
+    bytes[2] = 0u;
+    HalShim_ReceiveBytes(bytes, 5u);
+    rxParser_poll();
+    packetQueue_drain();
+    CHECK(0u == packetQueue_getPending());
+    CHECK(0u == HalShim_GetTxCount());
+}
+
+static void test_set_uses_command_table(void)
+{
+    uint8  bytes[32];
+    uint8  entry[3] = {1u, COMMAND_VALUE_UINT8, 150u};
+    uint16 numBytes;
+    const uint8 * response;
+
+    _setup();
+    numBytes = _request(bytes, 9u, RPC_METHOD_SET, entry, sizeof(entry));
+    entry[2] = 50u;
+    numBytes += _request(&bytes[numBytes], 10u, RPC_METHOD_SET, entry, sizeof(entry));
+    HalShim_ReceiveBytes(bytes, numBytes);
+    rxParser_poll();
+    packetQueue_drain();
+    response = _response(0u, &numBytes);
+    CHECK(NULL != response && RPC_OK == response[3] && COMMAND_ERR_RANGE == response[4]);
+    response = _response(1u, &numBytes);
+    CHECK(NULL != response && RPC_OK == response[3] && COMMAND_OK == response[4]);
+}
+
+static void test_waits_for_response_slot(void)
+{
+    uint8  bytes[32];
+    uint8  filler = 0u;
+    uint16 numBytes;
+    uint16 i;
+
+    _setup();
+    for(i = 0u; i < PACKET_QUEUE_NUM_SLOTS; i++)
+    {
+        CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, 1u, &filler));
+    }
+    numBytes = _request(bytes, 77u, RPC_METHOD_PING, NULL, 0u);
+    bytes[numBytes++] = RX_NEXT_IS_CHAR;            /* behind the request, must stay behind it */
+    bytes[numBytes++] = 'k';
+    HalShim_ReceiveBytes(bytes, numBytes);
+    rxParser_poll();
+    CHECK(0u == rxCommand_getPending());
+    CHECK(2u == rxRing_getAvailable());             /* request parsed, held back */
+    CHECK(0u == packetQueue_getDropCount());
+    packetQueue_drain();
+    CHECK(1u == rxParser_poll());
+    CHECK(1u == packetQueue_getPending());
+    packetQueue_drain();
+    CHECK(NULL != _response(0u, &numBytes));
+}
+
+static void test_response_slot_reserved_first(void)
+{
+    uint8  bytes[32];
+    uint16 numBytes;
+    const uint8 * response;
+
+    _setup();
+    numBytes = _request(bytes, 0x4242u, METHOD_FILL, NULL, 0u);
+    HalShim_ReceiveBytes(bytes, numBytes);
+    CHECK(0u == rxParser_poll());
+    CHECK(PACKET_QUEUE_NUM_SLOTS == packetQueue_getPending());
+    packetQueue_flush();
+    response = _response(0u, &numBytes);
+    CHECK(NULL != response);
+    if(NULL != response)
+    {
+        CHECK(RPC_RESPONSE_HEAD_BYTES + 1u == numBytes);
+        CHECK(0x42 == response[0] && 0x42 == response[1] && METHOD_FILL == response[2] && RPC_OK == response[3]);
+        CHECK(0x5a == response[4]);
+    }
+}
+
+static uint8 _hexNibble(char c)
+{
+    return (uint8)((c <= '9') ? (c - '0') : ((c | 0x20) - 'a' + 10));
+}
+
+static int _run(const char * inPath, const char * outPath)
+{
+    static char  line[4096];
+    static uint8 bytes[2048];
+    FILE * in  = fopen(inPath, "r");
+    FILE * out = fopen(outPath, "w");
+    const uint8 * response;
+    uint16 numBytes;
+    uint32 index = 0u;
+    size_t numIn = 0u;
+    size_t offset = 0u;
+    size_t i;
+
+    if(NULL == in || NULL == out)
+    {
+        return 1;
+    }
+    _setup();
+    while(NULL != fgets(line, sizeof(line), in))
+    {
+        for(i = 0u; 2u * i + 1u < strlen(line) && line[2u * i] != '\n'; i++)
+        {
+            bytes[numIn++] = (uint8)((_hexNibble(line[2u * i]) << 4) | _hexNibble(line[2u * i + 1u]));
+        }
+    }
+    /* the host's bytes arrive as they would over the wire: the main loop
+     * parses and drains between ring fills */
+    while(offset < numIn || rxRing_getAvailable() > 0u)
+    {
+        numBytes = rxRing_getFree();
+        if(numBytes > numIn - offset)
+        {
+            numBytes = (uint16)(numIn - offset);
+        }
+        HalShim_ReceiveBytes(&bytes[offset], numBytes);
+        offset += numBytes;
+        rxParser_poll();
+        packetQueue_drain();
+    }
+    while(NULL != (response = _response(index++, &numBytes)))
+    {
+        for(i = 0u; i < numBytes; i++)
+        {
+            fprintf(out, "%02x", response[i]);
+        }
+        fprintf(out, "\n");
+    }
+    fprintf(out, "overruns %u\n", (unsigned)rxRing_getOverrunCount());
+    fclose(in);
+    fclose(out);
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    if(argc > 3 && 0 == strcmp(argv[1], "--run"))
+    {
+        return _run(argv[2], argv[3]);
+    }
+    RUN_TEST(test_ping_echoes_id_and_arguments);
+    RUN_TEST(test_pipelined_requests);
+    RUN_TEST(test_errors);
+    RUN_TEST(test_set_uses_command_table);
+    RUN_TEST(test_waits_for_response_slot);
+    RUN_TEST(test_response_slot_reserved_first);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,313 @@
+/*******************************************************************************
+* File Name: test_rx_ring.c
+*
+* Description:
+*  The isr_rx_helper.c receive ring: bulk peek and consume across the wrap,
+*  overrun counting, commands that straddle the end of the buffer (the old
+*  rxbuf[rxReadIndex-1] bug), a burst of host commands bigger than the old
+*  32 byte rxbuf, and a producer thread standing in for isr_rx. Then the
+*  command parser: partial commands resume on the next call without waiting,
+*  the command queue, backpressure when it is full, and resync on junk.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "isr_rx_helper.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#define STRESS_BYTES 300000u
+
+extern uint8 rxReadChar;
+extern float rxReadFloat;
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+    rxRing_reset();
+    rxParser_reset();
+    while(flowControl_takeCredit()) { }
+}
+
+static void test_peek_and_consume_across_wrap(void)
+{
+    uint8  in[20];
+    uint8  out[20];
+    uint16 i;
+
+    _setup();
+    for(i = 0u; i < RX_SOFTWARE_BUFFER_LENGTH - 7u; i++)
+    {
+        rxRing_put((uint8)i);
+    }
+    rxRing_consume(RX_SOFTWARE_BUFFER_LENGTH - 7u);
+    for(i = 0u; i < sizeof(in); i++)
+    {
+        in[i] = (uint8)(100u + i);
+    }
+    CHECK(sizeof(in) == rxRing_write(in, sizeof(in)));      /* 7 bytes to the end, 13 from the start */
+    CHECK(sizeof(in) == rxRing_getAvailable());
+
+    memset(out, 0, sizeof(out));
+    CHECK(10u == rxRing_peek(out, 5u, 10u));
+    CHECK(0 == memcmp(out, &in[5], 10u));
+    CHECK(sizeof(in) == rxRing_getAvailable());             /* peek consumes nothing */
+    CHECK(5u == rxRing_peek(out, 15u, 10u));                /* clipped to what is there */
+    CHECK(0u == rxRing_peek(out, 20u, 1u));
+
+    CHECK(sizeof(in) == rxRing_read(out, sizeof(out)));
+    CHECK(0 == memcmp(out, in, sizeof(in)));
+    CHECK(0u == rxRing_getAvailable());
+    rxRing_consume(5u);                                      /* nothing left to consume */
+    CHECK(0u == rxRing_getAvailable());
+}
+
+static void test_overrun_is_counted(void)
+{
+    uint8  block[RX_SOFTWARE_BUFFER_LENGTH];
+    uint8  out;
+    uint16 i;
+
+    _setup();
+    for(i = 0u; i < sizeof(block); i++)
+    {
+        block[i] = (uint8)i;
+    }
+    CHECK(RX_SOFTWARE_BUFFER_LENGTH - 10u == rxRing_write(block, RX_SOFTWARE_BUFFER_LENGTH - 10u));
+    CHECK(10u == rxRing_write(block, 25u));
+    CHECK(15u == rxRing_getOverrunCount());
+    CHECK(0u == rxRing_put(0xEEu));
+    CHECK(16u == rxRing_getOverrunCount());
+    CHECK(RX_SOFTWARE_BUFFER_LENGTH == rxRing_getAvailable());
+
+    /* oldest bytes are kept, the new ones were dropped */
+    rxRing_read(&out, 1u);
+    CHECK(0u == out);
+    CHECK(1u == rxRing_put(0x42u));
+    rxRing_reset();
+    CHECK(0u == rxRing_getAvailable() && 0u == rxRing_getOverrunCount());
+
+    /* counted from the reset on, the ISR's own count is never written back */
+    CHECK(RX_SOFTWARE_BUFFER_LENGTH == rxRing_write(block, RX_SOFTWARE_BUFFER_LENGTH));
+    CHECK(0u == rxRing_put(0xEEu));
+    CHECK(1u == rxRing_getOverrunCount());
+}
+
+static void test_command_straddles_wrap(void)
+{
+    uint8  command[6] = {RX_NEXT_IS_FLAG_AND_FLOAT, 'z', 0, 0, 0, 0};
+    float  value = -12.5f;
+    uint8  byte = 0u;
+    uint16 shift;
+
+    /* one byte further each time: every split of the command over the end */
+    _setup();
+    memcpy(&command[2], &value, 4);
+    for(shift = 0u; shift < RX_SOFTWARE_BUFFER_LENGTH; shift++)
+    {
+        rxRing_put(byte);
+        rxRing_consume(1u);
+        rxRing_write(command, sizeof(command));
+        parseRxBuffer();
+        CHECK('z' == rxReadChar);
+        CHECK(value == rxReadFloat);
+        CHECK(0u == rxRing_getAvailable());
+    }
+}
+
+static void test_command_burst(void)
+{
+    uint8  burst[3u * 60u];
+    uint16 i;
+    uint8  round;
+
+    /* 60 credit commands in one go: 180 bytes, the old rxbuf held 32 */
+    _setup();
+    for(i = 0u; i < 60u; i++)
+    {
+        burst[3u * i]      = RX_NEXT_IS_CREDIT;
+        burst[3u * i + 1u] = (uint8)(i % 5u + 1u);
+        burst[3u * i + 2u] = 0u;
+    }
+    for(round = 0u; round < 3u; round++)
+    {
+        CHECK(sizeof(burst) == rxRing_write(burst, sizeof(burst)));
+        while(rxRing_getAvailable() > 0u)
+        {
+            parseRxBuffer();
+        }
+        CHECK(180u * (round + 1u) == flowControl_getCredits());
+    }
+    CHECK(0u == rxRing_getOverrunCount());
+}
+
+static volatile int _producerDone;
+
+static void * _producer(void * arg)
+{
+    uint32 sent = 0u;
+    uint8  chunk[37];
+    uint16 numBytes;
+    uint16 i;
+
+    (void)arg;
+    while(sent < STRESS_BYTES)
+    {
+        numBytes = (uint16)(1u + sent % sizeof(chunk));
+        if(numBytes > STRESS_BYTES - sent)
+        {
+            numBytes = (uint16)(STRESS_BYTES - sent);
+        }
+        for(i = 0u; i < numBytes; i++)
+        {
+            chunk[i] = (uint8)((sent + i) * 7u);
+        }
+        if(1u == numBytes % 2u)
+        {
+            /* byte at a time, like isr_rx */
+            for(i = 0u; i < numBytes; i++)
+            {
+                while(RX_SOFTWARE_BUFFER_LENGTH == rxRing_getAvailable())
+                {
+                    sched_yield();
+                }
+                CHECK(1u == rxRing_put(chunk[i]));
+            }
+        }
+        else
+        {
+            i = 0u;
+            while(i < numBytes)
+            {
+                uint16 room = RX_SOFTWARE_BUFFER_LENGTH - rxRing_getAvailable();
+                uint16 n = (uint16)(numBytes - i) < room ? (uint16)(numBytes - i) : room;
+                if(0u == n)
+                {
+                    sched_yield();
+                }
+                i += rxRing_write(&chunk[i], n);
+            }
+        }
+        sent += numBytes;
+    }
+    _producerDone = 1;
+    return NULL;
+}
+
+static void test_threaded_producer(void)
+{
+    pthread_t thread;
+    uint8  buffer[64];
+    uint32 received = 0u;
+    uint32 errors = 0u;
+    uint16 numBytes;
+    uint16 i;
+
+    _setup();
+    _producerDone = 0;
+    CHECK(0 == pthread_create(&thread, NULL, _producer, NULL));
+    while(received < STRESS_BYTES)
+    {
+        numBytes = (uint16)(1u + received % sizeof(buffer));
+        numBytes = rxRing_peek(buffer, 0u, numBytes);
+        if(0u == numBytes)
+        {
+            sched_yield();
+        }
+        for(i = 0u; i < numBytes; i++)
+        {
+            errors += (buffer[i] != (uint8)((received + i) * 7u));
+        }
+        rxRing_consume(numBytes);
+        received += numBytes;
+    }
+    pthread_join(thread, NULL);
+    CHECK(_producerDone);
+    CHECK(0u == errors);
+    CHECK(0u == rxRing_getAvailable());
+    CHECK(0u == rxRing_getOverrunCount());
+}
+
+static void test_partial_command_does_not_wait(void)
+{
+    uint8 command[6] = {RX_NEXT_IS_FLAG_AND_FLOAT, 'q', 0, 0, 0, 0};
+    float value = 3.25f;
+    uint8 i;
+
+    _setup();
+    memcpy(&command[2], &value, 4);
+    for(i = 0u; i < sizeof(command) - 1u; i++)
+    {
+        /* one byte per main loop pass, the host is slow */
+        rxRing_put(command[i]);
+        parseRxBuffer();
+        CHECK(RX_NO_PACKETES == rxReadChar);
+    }
+    CHECK(0u == HalShim_GetTimeNs());               /* no CyDelayUs spin */
+    CHECK(0u == packetQueue_getPending());          /* and no log flood */
+    rxRing_put(command[5]);
+    parseRxBuffer();
+    CHECK('q' == rxReadChar);
+    CHECK(value == rxReadFloat);
+}
+
+static void test_commands_are_queued(void)
+{
+    uint8     bytes[] = {RX_NEXT_IS_CHAR, 'a', RX_NEXT_IS_CREDIT, 3, 0, 0xEE, RX_NEXT_IS_CHAR, 'b',
+                         RX_NEXT_IS_FLAG_AND_FLOAT, 200, 0, 0, 0x80, 0x3F};
+    rxCommand command;
+
+    _setup();
+    rxRing_write(bytes, sizeof(bytes));
+    CHECK(3u == rxParser_poll());
+    CHECK(3u == rxCommand_getPending());
+    CHECK(3u == flowControl_getCredits());          /* link level, not queued */
+    CHECK(1u == rxParser_getIgnoredCount());        /* 0xEE */
+    CHECK(rxCommand_pop(&command) && 'a' == command.value && 0.0f == command.argument);
+    CHECK(rxCommand_pop(&command) && 'b' == command.value);
+    CHECK(rxCommand_pop(&command) && 200u == command.value && 1.0f == command.argument);
+    CHECK(!rxCommand_pop(&command));
+}
+
+static void test_full_queue_leaves_bytes_in_ring(void)
+{
+    uint8  bytes[2u * (RX_COMMAND_QUEUE_LENGTH + 3u)];
+    uint16 i;
+
+    _setup();
+    for(i = 0u; i < RX_COMMAND_QUEUE_LENGTH + 3u; i++)
+    {
+        bytes[2u * i]      = RX_NEXT_IS_CHAR;
+        bytes[2u * i + 1u] = (uint8)('A' + i);
+    }
+    rxRing_write(bytes, sizeof(bytes));
+    CHECK(RX_COMMAND_QUEUE_LENGTH == rxParser_poll());
+    CHECK(6u == rxRing_getAvailable());
+    for(i = 0u; i < RX_COMMAND_QUEUE_LENGTH + 3u; i++)
+    {
+        /* the handleRx() loop in main.c */
+        parseRxBuffer();
+        CHECK((uint8)('A' + i) == rxReadChar);
+    }
+    parseRxBuffer();
+    CHECK(RX_NO_PACKETES == rxReadChar);
+}
+
+int main(void)
+{
+    RUN_TEST(test_peek_and_consume_across_wrap);
+    RUN_TEST(test_overrun_is_counted);
+    RUN_TEST(test_command_straddles_wrap);
+    RUN_TEST(test_command_burst);
+    RUN_TEST(test_threaded_producer);
+    RUN_TEST(test_partial_command_does_not_wait);
+    RUN_TEST(test_commands_are_queued);
+    RUN_TEST(test_full_queue_leaves_bytes_in_ring);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
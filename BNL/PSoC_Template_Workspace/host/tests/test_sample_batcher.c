@@ -0,0 +1,246 @@
+/*******************************************************************************
+* File Name: test_sample_batcher.c
+*
+* Description:
+*  sample_batcher.c: payload layout, size, age and gap flushes, clamping of
+*  maxSamples to one packet, and a full packet queue. With --dump <file> it
+*  writes batches next to the samples that went in, for check_sample_batch.py
+*  to decode with BNL/sample_batch.py.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "sample_batcher.h"
+
+#include <string.h>
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+    packetQueue_resetStats();
+}
+
+static const uint8 * _payload(uint32 packetStart)
+{
+    return &HalShim_GetTxBytes()[packetStart + PACKET_HEAD_BYTES];
+}
+
+static uint16 _delta(uint32 packetStart, uint8 sample)
+{
+    const uint8 * deltas = &_payload(packetStart)[SAMPLE_BATCH_HEAD_BYTES];
+    return (uint16)(deltas[2u * sample] | (deltas[2u * sample + 1u] << 8));
+}
+
+static uint16 _payloadBytes(uint32 packetStart)
+{
+    return (uint16)(HalShim_GetTxBytes()[packetStart + 6u] | (HalShim_GetTxBytes()[packetStart + 7u] << 8));
+}
+
+static void test_size_flush_layout(void)
+{
+    sampleBatcher batcher;
+    const uint8 * payload;
+    float  value;
+    float  decoded;
+    uint32 baseTicks;
+    uint8  i;
+
+    _setup();
+    sampleBatcher_init(&batcher, 7u, SAMPLE_FORMAT_FLOAT32, 1u, 4u, 0u);
+    for(i = 0u; i < 4u; i++)
+    {
+        value = 0.5f * i;
+        CHECK(PACKET_OK == sampleBatcher_add(&batcher, 1000u + 3u * i, &value));
+    }
+    CHECK(1u == packetQueue_getPending());      /* queued on the 4th sample, not sent */
+    CHECK(0u == HalShim_GetTxCount());
+    packetQueue_drain();
+
+    CHECK(MESSAGE_TYPE_SAMPLE_BATCH == HalShim_GetTxBytes()[4]);
+    CHECK((SAMPLE_BATCH_HEAD_BYTES + 4u * 2u + 4u * 4u) == _payloadBytes(0u));
+    payload = _payload(0u);
+    CHECK(7u == payload[0] && SAMPLE_FORMAT_FLOAT32 == payload[1] && 1u == payload[2] && 4u == payload[3]);
+    memcpy(&baseTicks, &payload[4], 4);
+    CHECK(1000u == baseTicks);
+    CHECK(0u == _delta(0u, 0u) && 3u == _delta(0u, 1u) && 3u == _delta(0u, 2u) && 3u == _delta(0u, 3u));
+    memcpy(&decoded, &payload[16 + 3 * 4], 4);
+    CHECK(1.5f == decoded);
+}
+
+static void test_age_flush(void)
+{
+    sampleBatcher batcher;
+    int16 xyz[3] = {1, -2, 3};
+
+    _setup();
+    sampleBatcher_init(&batcher, 1u, SAMPLE_FORMAT_INT16, 3u, 0u, 100u);
+    CHECK(30u == batcher.maxSamples);           /* clamped to one packet */
+    sampleBatcher_add(&batcher, 50u, xyz);
+    sampleBatcher_add(&batcher, 60u, xyz);
+    CHECK(PACKET_OK == sampleBatcher_poll(&batcher, 149u));
+    CHECK(0u == packetQueue_getPending());
+    CHECK(PACKET_OK == sampleBatcher_poll(&batcher, 150u));
+    CHECK(1u == packetQueue_getPending());
+    CHECK(0u == batcher.count);
+
+    /* age is also checked when the next sample arrives */
+    sampleBatcher_add(&batcher, 200u, xyz);
+    sampleBatcher_add(&batcher, 300u, xyz);
+    CHECK(2u == packetQueue_getPending());
+    CHECK(1u == batcher.count);
+    packetQueue_drain();
+    CHECK(2u == _payload(0u)[3]);
+}
+
+static void test_gap_splits_batch(void)
+{
+    sampleBatcher batcher;
+    float  value = 1.0f;
+    uint32 baseTicks;
+    uint32 secondPacket;
+
+    _setup();
+    sampleBatcher_init(&batcher, 2u, SAMPLE_FORMAT_FLOAT32, 1u, 10u, 0u);
+    sampleBatcher_add(&batcher, 10u, &value);
+    sampleBatcher_add(&batcher, 10u + SAMPLE_BATCH_MAX_DELTA_TICKS, &value);
+    sampleBatcher_add(&batcher, 10u + 2u * SAMPLE_BATCH_MAX_DELTA_TICKS + 1u, &value);
+    sampleBatcher_flush(&batcher);
+    packetQueue_drain();
+
+    CHECK(2u == _payload(0u)[3]);
+    CHECK(SAMPLE_BATCH_MAX_DELTA_TICKS == _delta(0u, 1u));
+    secondPacket = PACKET_HEAD_BYTES + _payloadBytes(0u) + PACKET_TAIL_BYTES;
+    CHECK(1u == _payload(secondPacket)[3]);
+    memcpy(&baseTicks, &_payload(secondPacket)[4], 4);
+    CHECK(10u + 2u * SAMPLE_BATCH_MAX_DELTA_TICKS + 1u == baseTicks);
+}
+
+static void test_queue_full_drops_batch(void)
+{
+    sampleBatcher batcher;
+    float  value = 1.0f;
+    uint32 i;
+
+    _setup();
+    sampleBatcher_init(&batcher, 3u, SAMPLE_FORMAT_FLOAT32, 1u, 1u, 0u);
+    for(i = 0u; i < PACKET_QUEUE_NUM_SLOTS; i++)
+    {
+        CHECK(PACKET_OK == sampleBatcher_add(&batcher, i, &value));
+    }
+    CHECK(PACKET_ERR_QUEUE_FULL == sampleBatcher_add(&batcher, i, &value));
+    CHECK(1u == batcher.droppedSamples);
+    CHECK(0u == batcher.count);
+}
+
+static void test_sample_too_big(void)
+{
+    sampleBatcher batcher;
+    float values[80];
+
+    _setup();
+    sampleBatcher_init(&batcher, 4u, SAMPLE_FORMAT_FLOAT32, 80u, 0u, 0u);
+    CHECK(0u == batcher.maxSamples);
+    CHECK(PACKET_ERR_TOO_LONG == sampleBatcher_add(&batcher, 0u, values));
+    CHECK(0u == packetQueue_getPending());
+}
+
+static void test_overhead(void)
+{
+    sampleBatcher batcher;
+    float  value = 0.0f;
+    uint32 i;
+
+    _setup();
+    sampleBatcher_init(&batcher, 0u, SAMPLE_FORMAT_FLOAT32, 1u, 0u, 0u);
+    for(i = 0u; i < batcher.maxSamples; i++)
+    {
+        sampleBatcher_add(&batcher, i, &value);
+    }
+    packetQueue_drain();
+    printf("  %u floats in %u bytes, %.1f bytes per sample (%u unbatched)\n",
+        (unsigned)i, (unsigned)HalShim_GetTxCount(), (double)HalShim_GetTxCount() / i,
+        (unsigned)(PACKET_HEAD_BYTES + 4u + PACKET_TAIL_BYTES));
+    CHECK(HalShim_GetTxCount() < 7u * i);
+}
+
+static void _dumpBatches(FILE * file, const uint32 * ticks, const float * values, uint32 numSamples, uint8 valuesPerSample)
+{
+    uint32 start = 0u;
+    uint32 i;
+    uint16 payloadBytes;
+
+    /* every sample that went in, then every batch that came out */
+    fprintf(file, "samples");
+    for(i = 0u; i < numSamples; i++)
+    {
+        fprintf(file, " %u", (unsigned)ticks[i]);
+    }
+    fprintf(file, "\nvalues");
+    for(i = 0u; i < numSamples * valuesPerSample; i++)
+    {
+        fprintf(file, " %.9g", values[i]);
+    }
+    fprintf(file, "\n");
+    while(start < HalShim_GetTxCount())
+    {
+        payloadBytes = _payloadBytes(start);
+        fprintf(file, "batch ");
+        for(i = 0u; i < payloadBytes; i++)
+        {
+            fprintf(file, "%02x", _payload(start)[i]);
+        }
+        fprintf(file, "\n");
+        start += PACKET_HEAD_BYTES + payloadBytes + PACKET_TAIL_BYTES;
+    }
+}
+
+static int _dump(const char * path)
+{
+    static uint32 ticks[300];
+    static float  values[300 * 3];
+    sampleBatcher batcher;
+    uint32 t = 0xFFFFF000u;      /* base timestamps wrap partway through */
+    uint32 i;
+    FILE * file = fopen(path, "w");
+
+    if(NULL == file)
+    {
+        return 1;
+    }
+    _setup();
+    sampleBatcher_init(&batcher, 9u, SAMPLE_FORMAT_FLOAT32, 3u, 0u, 500u);
+    for(i = 0u; i < 300u; i++)
+    {
+        t += (i % 7u == 0u) ? 1u : (i % 50u == 0u ? 70000u : 2u);  /* include a gap and an age flush */
+        ticks[i] = t;
+        values[3u * i]      = 0.001f * i;
+        values[3u * i + 1u] = -1.0f * i;
+        values[3u * i + 2u] = 1.0e6f / (i + 1u);
+        sampleBatcher_add(&batcher, t, &values[3u * i]);
+        packetQueue_drain();
+    }
+    sampleBatcher_flush(&batcher);
+    packetQueue_drain();
+    _dumpBatches(file, ticks, values, 300u, 3u);
+    fclose(file);
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    if(argc > 2 && 0 == strcmp(argv[1], "--dump"))
+    {
+        return _dump(argv[2]);
+    }
+    RUN_TEST(test_size_flush_layout);
+    RUN_TEST(test_age_flush);
+    RUN_TEST(test_gap_splits_batch);
+    RUN_TEST(test_queue_full_drops_batch);
+    RUN_TEST(test_sample_too_big);
+    RUN_TEST(test_overhead);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,95 @@
+/*******************************************************************************
+* File Name: test_sensors.c
+*
+* Description:
+*  i2c_service.c and lis2dh_manager.c against the I2CM1 slave model in the
+*  shim, and the ADC stand-in readAndAverageADC() in main.c relies on.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "project.h"
+#include "i2c_service.h"
+#include "lis2dh_manager.h"
+
+#define I2C_BIT_NS  (1000000u / I2CM1_DATA_RATE)
+
+static void test_write_and_read_register(void)
+{
+    uint64 start;
+
+    HalShim_Reset();
+    i2cWriteReg(LIS2DH_CTRL_REG1, 0x57u);
+    CHECK(0x57u == HalShim_GetI2cRegister(LIS2DH_CTRL_REG1));
+
+    HalShim_SetI2cRegister(LIS2DH_WHO_AM_I_REG, 0x33u);
+    start = HalShim_GetTimeNs();
+    CHECK(0x33u == i2cReadReg(LIS2DH_WHO_AM_I_REG));
+    /* start + address, register, restart + address, data, stop */
+    CHECK((10u + 9u + 10u + 9u + 1u) * I2C_BIT_NS == HalShim_GetTimeNs() - start);
+    CHECK(3u + 4u == HalShim_GetI2cByteCount());
+}
+
+static void test_no_slave_reads_ones(void)
+{
+    HalShim_Reset();
+    HalShim_SetI2cAddress(0x19u);
+    HalShim_SetI2cRegister(LIS2DH_WHO_AM_I_REG, 0x33u);
+    CHECK(0xFFu == i2cReadReg(LIS2DH_WHO_AM_I_REG));
+    i2cWriteReg(LIS2DH_CTRL_REG1, 0x57u);
+    CHECK(0u == HalShim_GetI2cRegister(LIS2DH_CTRL_REG1));
+}
+
+static void test_lis2dh_init(void)
+{
+    HalShim_Reset();
+    HalShim_SetI2cRegister(LIS2DH_CTRL_REG3, 0xFFu);
+    lis2dh_init();
+    CHECK(0x00u == HalShim_GetI2cRegister(LIS2DH_CTRL_REG3));
+    CHECK(0x00u == HalShim_GetI2cRegister(LIS2DH_CTRL_REG2));
+    CHECK(0x40u == HalShim_GetI2cRegister(LIS2DH_CTRL_REG5));   /* block data update */
+    CHECK(HalShim_GetTimeNs() >= 50000000u);
+}
+
+static void test_lis2dh_outputs(void)
+{
+    int16_t raw[3];
+    float   accelerations[3];
+
+    HalShim_Reset();
+    HalShim_SetI2cRegister(LIS2DH_OUT_X_L, 0x34u);
+    HalShim_SetI2cRegister(LIS2DH_OUT_X_H, 0x12u);
+    HalShim_SetI2cRegister(LIS2DH_OUT_Y_L, 0x00u);
+    HalShim_SetI2cRegister(LIS2DH_OUT_Y_H, 0x80u);
+    HalShim_SetI2cRegister(LIS2DH_OUT_Z_L, 0xFFu);
+    HalShim_SetI2cRegister(LIS2DH_OUT_Z_H, 0xFFu);
+    lis2dh_getRawOutputs(raw);
+    CHECK(0x1234 == raw[0] && -32768 == raw[1] && -1 == raw[2]);
+    lis2dh_getAccelerationOutputs(accelerations);
+    CHECK(4660.0f == accelerations[0] && -32768.0f == accelerations[1] && -1.0f == accelerations[2]);
+}
+
+static void test_adc(void)
+{
+    HalShim_Reset();
+    HalShim_SetAdcVolts(1.25f);
+    CHECK(1024 == ADC_GetResult16());
+    CHECK(1.25f == ADC_CountsTo_Volts(ADC_GetResult16()));
+    HalShim_SetAdcVolts(7.0f);
+    CHECK(4095 == ADC_GetResult16());
+    HalShim_SetAdcVolts(-1.0f);
+    CHECK(0 == ADC_GetResult16());
+    CHECK(4u == HalShim_GetAdcReadCount());
+}
+
+int main(void)
+{
+    RUN_TEST(test_write_and_read_register);
+    RUN_TEST(test_no_slave_reads_ones);
+    RUN_TEST(test_lis2dh_init);
+    RUN_TEST(test_lis2dh_outputs);
+    RUN_TEST(test_adc);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,161 @@
+/*******************************************************************************
+* File Name: test_timebase.c
+*
+* Description:
+*  timebase.c against the simulated clock: DWT set up by timebase_init(),
+*  cycle exact 64-bit time across cycle counter and tick counter wraps, and
+*  the wire timestamp in every packet head. With --dump <file> it writes
+*  wire timestamps next to the full 64-bit value for check_packet_time.py.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+#include "timebase.h"
+#include "core_cm3_psoc5.h"
+
+#include <string.h>
+
+#define NS_PER_SEC 1000000000ull
+
+static void _setup(void)
+{
+    packetQueue_flush();
+    HalShim_Reset();
+    timebase_init();
+}
+
+static uint64 _expectedCycles(uint64 sinceNs)
+{
+    return (sinceNs * (TIMEBASE_HZ / 1000000u)) / 1000u;
+}
+
+static void test_init_enables_cycle_counter(void)
+{
+    _setup();
+    CHECK(0u != (CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk));
+    CHECK(0u != (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk));
+    CHECK(timebase_hasCycleCounter());
+    CHECK(0u == timebase_getCycles());
+}
+
+static void test_cycle_resolution(void)
+{
+    uint32 start;
+
+    _setup();
+    HalShim_AdvanceNs(1234567u);
+    CHECK(_expectedCycles(1234567u) == timebase_getCycles());
+    start = timebase_getCycles32();
+    CyDelayUs(10);
+    CHECK(10u * TIMEBASE_CYCLES_PER_US == timebase_getCycles32() - start);
+}
+
+static void test_cycle_counter_wraps_unobserved(void)
+{
+    uint64 elapsedNs = 500u * NS_PER_SEC + 777u;  /* almost three CYCCNT wraps without a call */
+
+    _setup();
+    HalShim_AdvanceNs(elapsedNs);
+    CHECK(_expectedCycles(elapsedNs) == timebase_getCycles());
+    CHECK(timebase_getCycles() > 0xFFFFFFFFull);
+}
+
+static void test_tick_counter_wrap(void)
+{
+    uint64 elapsedNs = 0u;
+    uint64 previous = 0u;
+    uint64 now;
+    uint8  day;
+
+    /* the 10 kHz tick wraps after 4.97 days */
+    _setup();
+    for(day = 0u; day < 6u; day++)
+    {
+        HalShim_AdvanceNs(86400u * NS_PER_SEC + 13u);
+        elapsedNs += 86400u * NS_PER_SEC + 13u;
+        now = timebase_getCycles();
+        CHECK(now > previous);
+        CHECK(_expectedCycles(elapsedNs) == now);
+        previous = now;
+    }
+}
+
+static void test_monotonic_small_steps(void)
+{
+    uint64 previous = 0u;
+    uint64 now;
+    uint32 seed = 12345u;
+    uint32 i;
+    uint8  ok = 1u;
+
+    _setup();
+    for(i = 0u; i < 200000u; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        HalShim_AdvanceNs((seed >> 16) % 5000u);
+        now = timebase_getCycles();
+        if(now < previous)
+        {
+            ok = 0u;
+        }
+        previous = now;
+    }
+    CHECK(ok);
+}
+
+static void test_packet_head_timestamp(void)
+{
+    uint32 value = 1u;
+    uint32 wire;
+
+    _setup();
+    HalShim_AdvanceNs(200u * NS_PER_SEC);
+    queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, 4, &value);
+    packetQueue_drain();
+    memcpy(&wire, &HalShim_GetTxBytes()[8], 4);
+    CHECK((uint32)(_expectedCycles(200u * NS_PER_SEC) >> TIMEBASE_WIRE_SHIFT) == wire);
+    CHECK(3000000u == TIMEBASE_WIRE_HZ);       /* PACKET_TIMESTAMP_HZ in packet_time.py */
+}
+
+static int _dump(const char * path)
+{
+    FILE * file = fopen(path, "w");
+    uint32 seed = 777u;
+    uint64 cycles;
+    uint32 i;
+
+    if(NULL == file)
+    {
+        return 1;
+    }
+    _setup();
+    /* a packet every 0 to 10 minutes for a few days, several wire wraps */
+    for(i = 0u; i < 2000u; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        HalShim_AdvanceNs(((uint64)((seed >> 8) % 600000u)) * 1000000u);
+        cycles = timebase_getCycles();
+        fprintf(file, "%u %llu\n", (unsigned)(uint32)(cycles >> TIMEBASE_WIRE_SHIFT),
+            (unsigned long long)(cycles >> TIMEBASE_WIRE_SHIFT));
+    }
+    fclose(file);
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    if(argc > 2 && 0 == strcmp(argv[1], "--dump"))
+    {
+        return _dump(argv[2]);
+    }
+    RUN_TEST(test_init_enables_cycle_counter);
+    RUN_TEST(test_cycle_resolution);
+    RUN_TEST(test_cycle_counter_wraps_unobserved);
+    RUN_TEST(test_tick_counter_wrap);
+    RUN_TEST(test_monotonic_small_steps);
+    RUN_TEST(test_packet_head_timestamp);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
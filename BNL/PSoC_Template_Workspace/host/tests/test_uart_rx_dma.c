@@ -0,0 +1,164 @@
+/*******************************************************************************
+* File Name: test_uart_rx_dma.c
+*
+* Description:
+*  uart_rx_dma.c against the mock DMA controller and the shim's RX FIFO:
+*  bursts are handed to the receive ring only when a half buffer fills or the
+*  line goes idle, in order across buffer wraps, without losing bytes when the
+*  ring is full, and the command parser works unchanged on top.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "uart_rx_dma.h"
+#include "isr_rx_helper.h"
+#include "MessageHandler.h"
+
+#include <string.h>
+
+#define IDLE_NS 1000000u /* well past UART_RX_DMA_IDLE_TICKS */
+#define TIMER_NS 100000u  /* uartRxDma_poll() from a 10 kHz timer */
+
+static uint8 _quiet(void)
+{
+    /* the line stays idle while the timer keeps polling, returns the wakes */
+    uint8  woke = 0u;
+    uint32 t;
+    for(t = 0u; t < IDLE_NS; t += TIMER_NS)
+    {
+        HalShim_AdvanceNs(TIMER_NS);
+        woke += uartRxDma_poll();
+    }
+    return woke;
+}
+
+static void _setup(void)
+{
+    HalShim_Reset();
+    CHECK(UART_RX_DMA_OK == uartRxDma_init());
+    CyDmaMock_SetNrqHandler(uartRxDma_getChannel(), uartRxDma_isr);
+    HalShim_BindUartRxDrq(uartRxDma_getChannel());
+    (void)_quiet();                 /* whatever the last test left */
+    rxRing_reset();
+    rxParser_reset();
+    uartRxDma_resetStats();
+}
+
+static void _pattern(uint8 * data, uint32 numBytes, uint8 seed)
+{
+    uint32 i;
+    for(i = 0u; i < numBytes; i++)
+    {
+        data[i] = (uint8)(seed + i * 7u + (i >> 8));
+    }
+}
+
+static void test_burst_waits_for_idle(void)
+{
+    uint8 sent[10];
+    uint8 got[10];
+
+    _setup();
+    _pattern(sent, sizeof(sent), 1u);
+    HalShim_ReceiveBytes(sent, sizeof(sent));
+    CHECK(0u == HalShim_GetRxFifoLevel());      /* the DMA emptied the FIFO */
+    CHECK(0u == uartRxDma_poll());              /* line just went quiet */
+    CHECK(0u == rxRing_getAvailable());
+    CHECK(1u == _quiet());
+    CHECK(sizeof(sent) == rxRing_read(got, sizeof(got)));
+    CHECK(0 == memcmp(sent, got, sizeof(sent)));
+    CHECK(1u == uartRxDma_getWakeCount());
+    CHECK(0u == uartRxDma_poll());              /* nothing new */
+}
+
+static void test_no_wake_mid_burst(void)
+{
+    uint8  sent[200];
+    uint32 i;
+    uint8  woke = 0u;
+
+    _setup();
+    _pattern(sent, sizeof(sent), 2u);
+    for(i = 0u; i < sizeof(sent); i++)
+    {
+        HalShim_ReceiveBytes(&sent[i], 1u);
+        woke |= uartRxDma_poll();               /* polled every byte time */
+    }
+    CHECK(0u == woke);
+    CHECK(0u == rxRing_getAvailable());
+    CHECK(1u == _quiet());
+    CHECK(sizeof(sent) == rxRing_getAvailable());
+    CHECK(1u == uartRxDma_getWakeCount());
+}
+
+static void test_long_burst_wraps_in_order(void)
+{
+    static uint8 sent[3000];
+    static uint8 got[3000];
+    uint32 received = 0u;
+    uint32 i;
+
+    _setup();
+    _pattern(sent, sizeof(sent), 3u);
+    for(i = 0u; i < sizeof(sent); i += 100u)
+    {
+        HalShim_ReceiveBytes(&sent[i], 100u);
+        received += rxRing_read(&got[received], (uint16)(sizeof(got) - received)); /* main loop */
+    }
+    (void)_quiet();
+    received += rxRing_read(&got[received], (uint16)(sizeof(got) - received));
+
+    CHECK(sizeof(sent) == received);
+    CHECK(0 == memcmp(sent, got, sizeof(sent)));
+    CHECK(0u == rxRing_getOverrunCount());
+    CHECK(0u == HalShim_GetRxOverrunCount());
+    CHECK(uartRxDma_getWakeCount() <= sizeof(sent) / UART_RX_DMA_HALF_BYTES + 2u);
+    printf("  %u bytes, %u wakes\n", (unsigned)sizeof(sent), (unsigned)uartRxDma_getWakeCount());
+}
+
+static void test_full_ring_keeps_bytes(void)
+{
+    uint8 sent[400];
+    uint8 got[400];
+    uint16 received;
+
+    _setup();
+    _pattern(sent, sizeof(sent), 4u);
+    HalShim_ReceiveBytes(sent, sizeof(sent));   /* nobody reads the ring meanwhile */
+    (void)_quiet();
+    CHECK(RX_SOFTWARE_BUFFER_LENGTH == rxRing_getAvailable());
+    received = rxRing_read(got, sizeof(got));
+    CHECK(1u == _quiet());                      /* the rest waited in the DMA buffer */
+    received += rxRing_read(&got[received], (uint16)(sizeof(got) - received));
+    CHECK(sizeof(sent) == received);
+    CHECK(0 == memcmp(sent, got, sizeof(sent)));
+    CHECK(0u == rxRing_getOverrunCount());
+}
+
+static void test_commands_through_dma(void)
+{
+    uint8     bytes[] = {RX_NEXT_IS_CHAR, 'q', RX_NEXT_IS_FLAG_AND_FLOAT, 7, 0, 0, 0x20, 0x41};
+    rxCommand command;
+
+    _setup();
+    HalShim_ReceiveBytes(bytes, 5u);            /* command split over two bursts */
+    (void)_quiet();
+    CHECK(1u == rxParser_poll());
+    HalShim_ReceiveBytes(&bytes[5], sizeof(bytes) - 5u);
+    (void)_quiet();
+    CHECK(1u == rxParser_poll());
+    CHECK(rxCommand_pop(&command) && 'q' == command.value);
+    CHECK(rxCommand_pop(&command) && 7u == command.value && 10.0f == command.argument);
+}
+
+int main(void)
+{
+    RUN_TEST(test_burst_waits_for_idle);
+    RUN_TEST(test_no_wake_mid_burst);
+    RUN_TEST(test_long_burst_wraps_in_order);
+    RUN_TEST(test_full_ring_keeps_bytes);
+    RUN_TEST(test_commands_through_dma);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
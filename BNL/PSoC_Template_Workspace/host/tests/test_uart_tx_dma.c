@@ -0,0 +1,306 @@
+/*******************************************************************************
+* File Name: test_uart_tx_dma.c
+*
+* Description:
+*  Descriptor chaining and completion ordering of uart_tx_dma.c against the
+*  mock DMA controller, plus the MessageHandler wire format on the DMA path
+*  and a queued packet waiting behind an async direct send, or while the
+*  queue is held for one. Before uartTxDma_init(), and for packets the
+*  engine refuses, MessageHandler falls back to UART_1_PutChar instead of
+*  losing them.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "uart_tx_dma.h"
+#include "MessageHandler.h"
+
+#include <string.h>
+
+#define MAX_EVENTS 16
+
+static int  _events[MAX_EVENTS];
+static int  _numEvents;
+static int  _busyInCallback;
+
+static void _setup(void)
+{
+    HalShim_Reset();
+    HalShim_SetBlockingUart(0u);
+    _numEvents = 0;
+    CHECK(UART_TX_DMA_OK == uartTxDma_init());
+    CyDmaMock_SetNrqHandler(uartTxDma_getChannel(), uartTxDma_isr);
+    while(uartTxDma_isBusy())
+    {
+        CyDmaMock_RunChain(uartTxDma_getChannel()); /* finish whatever the last test left */
+    }
+    HalShim_ClearTx();
+    _numEvents = 0;
+}
+
+static void _recordCompletion(void * context)
+{
+    _busyInCallback = uartTxDma_isBusy();
+    if(_numEvents < MAX_EVENTS)
+    {
+        /* the completion must come after every byte is on the wire */
+        _events[_numEvents++] = (int)(intptr_t)context * 100000 + (int)HalShim_GetTxCount();
+    }
+}
+
+static void test_before_init(void)
+{
+    /* runs first: no channel yet, packets still leave byte by byte */
+    float sample = 1.5f;
+    static float block[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    const uint32 queuedBytes = PACKET_HEAD_BYTES + sizeof(sample) + PACKET_TAIL_BYTES;
+    const uint32 directBytes = PACKET_HEAD_BYTES + sizeof(block) + PACKET_TAIL_BYTES;
+
+    HalShim_Reset();
+    HalShim_SetBlockingUart(0u);
+    _numEvents = 0;
+    CHECK(CY_DMA_INVALID_CHANNEL == uartTxDma_getChannel());
+    CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(sample), &sample));
+    packetQueue_flush();
+    CHECK(queuedBytes == HalShim_GetTxCount());
+    CHECK(0 == memcmp(&HalShim_GetTxBytes()[PACKET_HEAD_BYTES], &sample, sizeof(sample)));
+
+    CHECK(UART_TX_DMA_OK == constructAndSendPacketAsync(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(block), block, _recordCompletion, (void *)1));
+    CHECK(1 == _numEvents && 100000 + (int)(queuedBytes + directBytes) == _events[0]);
+    CHECK(0 == memcmp(&HalShim_GetTxBytes()[queuedBytes + PACKET_HEAD_BYTES], block, sizeof(block)));
+}
+
+static void test_chain_order(void)
+{
+    uint8 head[3] = {1, 2, 3};
+    uint8 body[5] = {4, 5, 6, 7, 8};
+    uint8 tail[2] = {9, 10};
+    uartTxDmaSegment segments[3] = { {head, 3}, {body, 5}, {tail, 2} };
+    uint8 channel;
+    uint8 i;
+
+    _setup();
+    channel = uartTxDma_getChannel();
+    CHECK(UART_TX_DMA_OK == uartTxDma_send(segments, 3, _recordCompletion, (void *)1));
+    CHECK(uartTxDma_isBusy());
+    CHECK(0u == HalShim_GetTxCount());          /* nothing is sent from the CPU */
+
+    CHECK(10u == CyDmaMock_RunChain(channel));
+    CHECK(!uartTxDma_isBusy());
+    CHECK(10u == HalShim_GetTxCount());
+    for(i = 0u; i < 10u; i++)
+    {
+        CHECK(HalShim_GetTxBytes()[i] == (uint8)(i + 1u));
+    }
+
+    /* header, payload, tail TDs executed in order, each exactly once */
+    CHECK(3u == CyDmaMock_GetTdExecutionCount(channel));
+    CHECK(CyDmaMock_GetTdTrace(channel, 0) != CyDmaMock_GetTdTrace(channel, 1));
+    CHECK(CyDmaMock_GetTdTrace(channel, 1) != CyDmaMock_GetTdTrace(channel, 2));
+
+    CHECK(1 == _numEvents);
+    CHECK(100010 == _events[0]);
+    CHECK(0 == _busyInCallback);
+}
+
+static void test_payload_not_copied(void)
+{
+    uint8 payload[4] = {0x11, 0x22, 0x33, 0x44};
+    uartTxDmaSegment segment = { payload, 4 };
+
+    _setup();
+    CHECK(UART_TX_DMA_OK == uartTxDma_send(&segment, 1, NULL, NULL));
+    CyDmaMock_Request(uartTxDma_getChannel(), 2u);
+    payload[2] = 0x99;                          /* DMA reads caller memory live */
+    CyDmaMock_RunChain(uartTxDma_getChannel());
+    CHECK(0x99 == HalShim_GetTxBytes()[2]);
+}
+
+static void test_long_segment_split(void)
+{
+    static uint8 big[UART_TX_DMA_MAX_TD_BYTES + 10u];
+    uartTxDmaSegment segment = { big, sizeof(big) };
+    uint32 i;
+
+    _setup();
+    for(i = 0u; i < sizeof(big); i++) { big[i] = (uint8)i; }
+    CHECK(UART_TX_DMA_OK == uartTxDma_send(&segment, 1, _recordCompletion, (void *)2));
+    CHECK(sizeof(big) == CyDmaMock_RunChain(uartTxDma_getChannel()));
+    CHECK(2u == CyDmaMock_GetTdExecutionCount(uartTxDma_getChannel()));
+    CHECK(0 == memcmp(big, HalShim_GetTxBytes(), sizeof(big)));
+    CHECK(1 == _numEvents);
+}
+
+static void test_busy_rejected(void)
+{
+    uint8 data[4] = {0};
+    uartTxDmaSegment segment = { data, 4 };
+
+    _setup();
+    CHECK(UART_TX_DMA_OK == uartTxDma_send(&segment, 1, NULL, NULL));
+    CHECK(UART_TX_DMA_ERR_BUSY == uartTxDma_send(&segment, 1, NULL, NULL));
+    CyDmaMock_RunChain(uartTxDma_getChannel());
+    CHECK(UART_TX_DMA_OK == uartTxDma_send(&segment, 1, NULL, NULL));
+}
+
+static uint8 _second[2] = {0xBB, 0xBC};
+
+static void _chainNext(void * context)
+{
+    uartTxDmaSegment segment = { _second, 2 };
+    _recordCompletion(context);
+    if(1 == (intptr_t)context)
+    {
+        CHECK(UART_TX_DMA_OK == uartTxDma_send(&segment, 1, _chainNext, (void *)2));
+    }
+}
+
+static void test_send_from_callback(void)
+{
+    uint8 first[3] = {0xAA, 0xAB, 0xAC};
+    uartTxDmaSegment segment = { first, 3 };
+
+    _setup();
+    CHECK(UART_TX_DMA_OK == uartTxDma_send(&segment, 1, _chainNext, (void *)1));
+    CyDmaMock_RunChain(uartTxDma_getChannel());
+    CyDmaMock_RunChain(uartTxDma_getChannel());
+    CHECK(2 == _numEvents);
+    CHECK(100003 == _events[0]);
+    CHECK(200005 == _events[1]);
+    CHECK(0xBC == HalShim_GetTxBytes()[4]);
+}
+
+static void test_message_handler_packet(void)
+{
+    float payload[2] = {1.0f, -2.5f};
+    const uint8 * wire;
+
+    _setup();
+    HalShim_BindUartTxDrq(uartTxDma_getChannel());
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(payload), payload);
+    packetQueue_flush();
+
+    CHECK((PACKET_HEAD_BYTES + sizeof(payload) + PACKET_TAIL_BYTES) == HalShim_GetTxCount());
+    wire = HalShim_GetTxBytes();
+    CHECK(0xA5 == wire[0] && 0xA5 == wire[3]);
+    CHECK(MESSAGE_TYPE_BINARY_FLOAT == wire[4]);
+    CHECK(MESSAGE_FLAG_NO_FLAG == wire[5]);
+    CHECK(sizeof(payload) == (wire[6] | (wire[7] << 8)));
+    CHECK(0 == memcmp(&wire[12], payload, sizeof(payload)));
+    CHECK(0xB6 == wire[HalShim_GetTxCount() - 4u] && 0xB6 == wire[HalShim_GetTxCount() - 1u]);
+}
+
+static void test_log_message_returns_early(void)
+{
+    uint64 start;
+    uint64 stall;
+
+    _setup();
+    HalShim_BindUartTxDrq(uartTxDma_getChannel());
+    flowControl_grant(1u);                      /* otherwise paced at UART_PACKET_DELAY_MS */
+    start = HalShim_GetTimeNs();
+    sendLogMessage("%s", "0123456789012345678901234567890123456789");
+    stall = HalShim_GetTimeNs() - start;
+    CHECK(0u == stall);                         /* returns while the packet is on the wire */
+    CHECK(uartTxDma_isBusy());
+
+    packetQueue_flush();
+    CHECK((PACKET_HEAD_BYTES + 40u + PACKET_TAIL_BYTES) == HalShim_GetTxCount());
+    CHECK('0' == HalShim_GetTxBytes()[12]);
+}
+
+static uint16 _sequenceOf(const uint8 * packet, uint32 numBytes)
+{
+    const uint8 * tail = packet + numBytes - PACKET_TAIL_BYTES;
+    return (uint16)(tail[0] | (tail[1] << 8));
+}
+
+static void test_queue_waits_for_direct_send(void)
+{
+    static float block[8] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f};
+    float sample = 9.0f;
+    const uint32 directBytes = PACKET_HEAD_BYTES + sizeof(block) + PACKET_TAIL_BYTES;
+    const uint32 queuedBytes = PACKET_HEAD_BYTES + sizeof(sample) + PACKET_TAIL_BYTES;
+    const uint8 * wire;
+
+    /* DRQ left unbound: the direct transfer owns the engine until its chain is run */
+    _setup();
+    CHECK(UART_TX_DMA_OK == constructAndSendPacketAsync(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(block), block, NULL, NULL));
+    CHECK(uartTxDma_isBusy());
+
+    /* the queue must leave the slot alone instead of spinning on a busy engine */
+    CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(sample), &sample));
+    packetQueue_drain();
+    CHECK(1u == packetQueue_getPending());
+
+    /* the direct completion drains the queue, which then goes out next */
+    CyDmaMock_RunChain(uartTxDma_getChannel());
+    CHECK(uartTxDma_isBusy());
+    CyDmaMock_RunChain(uartTxDma_getChannel());
+    CHECK(packetQueue_isIdle());
+
+    CHECK(directBytes + queuedBytes == HalShim_GetTxCount());
+    wire = HalShim_GetTxBytes();
+    CHECK(0 == memcmp(&wire[directBytes + PACKET_HEAD_BYTES], &sample, sizeof(sample)));
+    CHECK((uint16)(_sequenceOf(wire, directBytes) + 1u) == _sequenceOf(wire + directBytes, queuedBytes));
+}
+
+static void test_held_queue_leaves_engine_free(void)
+{
+    float sample = 3.0f;
+    const uartTxDmaSegment segment = { (const uint8 *)"direct", 6u };
+
+    /* what _startDirectDma() relies on: once held, a drain from an ISR does
+       not start a slot, so the direct send finds the engine free */
+    _setup();
+    packetQueue_hold(1u);
+    CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(sample), &sample));
+    packetQueue_drain();
+    CHECK(!uartTxDma_isBusy());
+    CHECK(1u == packetQueue_getPending());
+    CHECK(UART_TX_DMA_OK == uartTxDma_send(&segment, 1, NULL, NULL));
+    CyDmaMock_RunChain(uartTxDma_getChannel());
+
+    packetQueue_hold(0u);
+    packetQueue_drain();
+    CyDmaMock_RunChain(uartTxDma_getChannel());
+    CHECK(packetQueue_isIdle());
+    CHECK(6u + PACKET_HEAD_BYTES + sizeof(sample) + PACKET_TAIL_BYTES == HalShim_GetTxCount());
+    CHECK(0 == memcmp("direct", HalShim_GetTxBytes(), 6u));
+}
+
+static void test_too_long_falls_back(void)
+{
+    /* more descriptors than the engine owns: sent byte by byte instead of lost */
+    static uint8 big[UART_TX_DMA_MAX_TD_BYTES * 6u + 1u];
+    const uint32 directBytes = PACKET_HEAD_BYTES + sizeof(big) + PACKET_TAIL_BYTES;
+
+    _setup();
+    HalShim_BindUartTxDrq(uartTxDma_getChannel());
+    big[0] = 0x11;
+    big[sizeof(big) - 1u] = 0x22;
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(big), big);
+    CHECK(!uartTxDma_isBusy());
+    CHECK(directBytes == HalShim_GetTxCount());
+    CHECK(0x11 == HalShim_GetTxBytes()[PACKET_HEAD_BYTES]);
+    CHECK(0x22 == HalShim_GetTxBytes()[PACKET_HEAD_BYTES + sizeof(big) - 1u]);
+    CHECK(0xB6 == HalShim_GetTxBytes()[directBytes - 1u]);
+}
+
+int main(void)
+{
+    RUN_TEST(test_before_init);
+    RUN_TEST(test_chain_order);
+    RUN_TEST(test_payload_not_copied);
+    RUN_TEST(test_long_segment_split);
+    RUN_TEST(test_busy_rejected);
+    RUN_TEST(test_send_from_callback);
+    RUN_TEST(test_message_handler_packet);
+    RUN_TEST(test_log_message_returns_early);
+    RUN_TEST(test_queue_waits_for_direct_send);
+    RUN_TEST(test_held_queue_leaves_engine_free);
+    RUN_TEST(test_too_long_falls_back);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,268 @@
+/*******************************************************************************
+* File Name: test_uart_tx_ring.c
+*
+* Description:
+*  uart_tx_ring.c against the shim's TX FIFO model: bytes leave in order at
+*  the baud rate across the ring wrap, writes are all or nothing, the FIFO
+*  interrupt is masked once the ring is empty, and MessageHandler packets
+*  queue without the main loop waiting for the wire. A packet from an ISR
+*  waits out a direct packet longer than the ring.
+*
+*******************************************************************************/
+#include "host_test.h"
+#include "hal_shim.h"
+#include "MessageHandler.h"
+
+#include <string.h>
+
+static void _setup(void)
+{
+    HalShim_Reset();
+    HalShim_SetBlockingUart(0u);
+    packetQueue_flush();
+    uartTxRing_init();
+    HalShim_BindUartTxIsr(uartTxRing_isr);
+    HalShim_ClearTx();
+    packetQueue_resetStats();
+}
+
+static void _runUntilIdle(void)
+{
+    while(!uartTxRing_isIdle())
+    {
+        HalShim_AdvanceNs(HalShim_GetByteTimeNs());
+    }
+}
+
+/* sequence numbers of every well formed packet on the wire, -1 if malformed */
+static int _countPackets(uint16 * sequences, int maxPackets)
+{
+    const uint8 * tx = HalShim_GetTxBytes();
+    uint32 pos = 0u;
+    uint16 payloadBytes;
+    int    numPackets = 0;
+
+    while(pos < HalShim_GetTxCount())
+    {
+        if(pos + PACKET_HEAD_BYTES > HalShim_GetTxCount() || 0xA5 != tx[pos] || 0xA5 != tx[pos + 3u])
+        {
+            return -1;
+        }
+        payloadBytes = (uint16)(tx[pos + 6u] | (tx[pos + 7u] << 8));
+        pos += PACKET_HEAD_BYTES + payloadBytes;
+        if(pos + PACKET_TAIL_BYTES > HalShim_GetTxCount() || 0xB6 != tx[pos + PACKET_TAIL_BYTES - 1u])
+        {
+            return -1;
+        }
+        if(numPackets < maxPackets)
+        {
+            sequences[numPackets] = (uint16)(tx[pos] | (tx[pos + 1u] << 8));
+        }
+        numPackets++;
+        pos += PACKET_TAIL_BYTES;
+    }
+    return numPackets;
+}
+
+static void test_bytes_leave_at_baud(void)
+{
+    uint8  data[100];
+    uint64 byteTimeNs;
+    uint32 i;
+
+    _setup();
+    for(i = 0u; i < sizeof(data); i++)
+    {
+        data[i] = (uint8)(i * 7u);
+    }
+    CHECK(UART_TX_RING_OK == uartTxRing_write(data, sizeof(data)));
+    CHECK(UART_1_TX_BUFFER_SIZE == HalShim_GetTxCount());   /* the ISR fills the FIFO right away */
+    CHECK(UART_1_TX_STS_FIFO_NOT_FULL == HalShim_GetUartTxInterruptMode());
+    CHECK(0u == HalShim_GetTimeNs());                       /* and the writer did not wait */
+
+    byteTimeNs = HalShim_GetByteTimeNs();
+    HalShim_AdvanceNs(10u * byteTimeNs);
+    CHECK(UART_1_TX_BUFFER_SIZE + 10u == HalShim_GetTxCount());
+    _runUntilIdle();
+    CHECK(sizeof(data) == HalShim_GetTxCount());
+    CHECK(0 == memcmp(data, HalShim_GetTxBytes(), sizeof(data)));
+    CHECK(0u == HalShim_GetUartTxInterruptMode());          /* masked once empty */
+    CHECK(HalShim_GetTxTimeNs(99u) - HalShim_GetTxTimeNs(4u) == 95u * byteTimeNs);
+}
+
+static void test_wrap_keeps_order(void)
+{
+    static uint8 sent[20000];
+    uint8  chunk[300];
+    uint32 total = 0u;
+    uint16 numBytes;
+    uint32 i;
+
+    _setup();
+    while(total + sizeof(chunk) < sizeof(sent))
+    {
+        numBytes = (uint16)(1u + (total * 13u) % sizeof(chunk));
+        for(i = 0u; i < numBytes; i++)
+        {
+            chunk[i] = (uint8)((total + i) * 31u + 5u);
+        }
+        while(UART_TX_RING_ERR_FULL == uartTxRing_write(chunk, numBytes))
+        {
+            HalShim_AdvanceNs(50u * HalShim_GetByteTimeNs());
+        }
+        memcpy(&sent[total], chunk, numBytes);
+        total += numBytes;
+    }
+    _runUntilIdle();
+    CHECK(total == HalShim_GetTxCount());
+    CHECK(0 == memcmp(sent, HalShim_GetTxBytes(), total));
+    CHECK(uartTxRing_getOverflowCount() > 0u);
+    CHECK(UART_TX_RING_BYTES >= uartTxRing_takeHighWater());
+}
+
+static void test_write_is_all_or_nothing(void)
+{
+    static uint8 data[UART_TX_RING_BYTES + 1u];
+    uartTxDmaSegment segments[2] = { {data, 10u}, {data, UART_TX_RING_BYTES - 20u} };
+    uint16 used;
+
+    _setup();
+    CHECK(UART_TX_RING_ERR_TOO_LONG == uartTxRing_write(data, UART_TX_RING_BYTES + 1u));
+    CHECK(UART_TX_RING_OK == uartTxRing_writeSegments(segments, 2));
+    used = uartTxRing_getUsed();
+    CHECK(UART_TX_RING_BYTES - 10u - UART_1_TX_BUFFER_SIZE == used);
+    CHECK(UART_TX_RING_ERR_FULL == uartTxRing_write(data, uartTxRing_getFree() + 1u));
+    CHECK(used == uartTxRing_getUsed());                   /* nothing partial went in */
+    CHECK(1u == uartTxRing_getOverflowCount());
+    CHECK(UART_TX_RING_OK == uartTxRing_write(data, uartTxRing_getFree()));
+    CHECK(0u == uartTxRing_getFree());
+    CHECK(UART_TX_RING_BYTES == uartTxRing_takeHighWater());
+    _runUntilIdle();
+    CHECK(UART_TX_RING_BYTES == uartTxRing_takeHighWater()); /* full at the last call */
+    CHECK(0u == uartTxRing_takeHighWater());
+}
+
+static void test_packets_do_not_wait_for_wire(void)
+{
+    float  values[16] = {0};
+    uint16 sequences[64];
+    int    numPackets;
+    int    i;
+
+    _setup();
+    for(i = 0; i < 30; i++)
+    {
+        values[0] = (float)i;
+        CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(values), values));
+        packetQueue_drain();
+    }
+    /* 30 packets of 82 bytes do not fit a 2 KB ring: the rest waits in the queue */
+    CHECK(0u == HalShim_GetTimeNs());
+    CHECK(packetQueue_getPending() > 0u);
+    CHECK(0u == packetQueue_getDropCount());
+
+    /* the TX interrupt pulls them in as the ring empties, no drain call needed */
+    while(!packetQueue_isIdle() || !uartTxRing_isIdle())
+    {
+        HalShim_AdvanceNs(100u * HalShim_GetByteTimeNs());
+    }
+    numPackets = _countPackets(sequences, 64);
+    CHECK(30 == numPackets);
+    for(i = 1; i < numPackets && i < 64; i++)
+    {
+        CHECK((uint16)(sequences[i - 1] + 1u) == sequences[i]);
+    }
+}
+
+static void test_direct_packet_bigger_than_ring(void)
+{
+    static uint8 payload[3000];
+    uint16 sequences[4];
+    uint32 i;
+
+    _setup();
+    for(i = 0u; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8)(i ^ 0x5Au);
+    }
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(payload), payload);
+    _runUntilIdle();
+    CHECK(1 == _countPackets(sequences, 4));
+    CHECK(0 == memcmp(payload, &HalShim_GetTxBytes()[PACKET_HEAD_BYTES], sizeof(payload)));
+}
+
+static uint32 _isrCalls;
+
+/* the TX interrupt of test_isr_packet_waits_for_direct(), which queues a
+   packet of its own partway through */
+static void _queuingTxIsr(void)
+{
+    float value = 1.0f;
+
+    uartTxRing_isr();
+    if(1000u == ++_isrCalls)
+    {
+        CHECK(PACKET_OK == queuePacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(value), &value));
+    }
+}
+
+static void test_isr_packet_waits_for_direct(void)
+{
+    static uint8 payload[3000];
+    uint16 sequences[4];
+    uint32 i;
+
+    _setup();
+    HalShim_BindUartTxIsr(_queuingTxIsr);
+    _isrCalls = 0u;
+    /* a byte time of 2 ns empties the ring between two polls of the writer,
+       so its ISR drains the queue while the direct packet is half written */
+    HalShim_SetUartBaud(4000000000u);
+    for(i = 0u; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8)(i * 3u + 1u);
+    }
+    constructAndSendPacket(MESSAGE_TYPE_BINARY_FLOAT, MESSAGE_FLAG_NO_FLAG, sizeof(payload), payload);
+    _runUntilIdle();
+    HalShim_SetUartBaud(0u);
+
+    CHECK(_isrCalls > 1000u);
+    CHECK(2 == _countPackets(sequences, 4));
+    CHECK(0 == memcmp(payload, &HalShim_GetTxBytes()[PACKET_HEAD_BYTES], sizeof(payload)));
+    CHECK((uint16)(sequences[0] + 1u) == sequences[1]);
+    CHECK(packetQueue_isIdle());
+}
+
+static void test_link_stats_report_ring(void)
+{
+    float  stats[FLOW_CONTROL_STATS_FLOATS];
+    uint8  data[500] = {0};
+
+    _setup();
+    uartTxRing_write(data, sizeof(data));
+    flowControl_setStatsPeriod(1u);
+    HalShim_AdvanceNs(1000000u);                      /* ~22 bytes leave in 1 ms at 230400 */
+    flowControl_poll();
+    _runUntilIdle();
+    flowControl_setStatsPeriod(0u);
+
+    CHECK(HalShim_GetTxCount() == sizeof(data) + PACKET_HEAD_BYTES + sizeof(stats) + PACKET_TAIL_BYTES);
+    memcpy(stats, &HalShim_GetTxBytes()[sizeof(data) + PACKET_HEAD_BYTES], sizeof(stats));
+    CHECK(stats[5] > 400.0f && stats[5] < 500.0f);     /* still in the ring when reported */
+    CHECK(500.0f == stats[6]);
+    CHECK(0.0f == stats[7]);
+}
+
+int main(void)
+{
+    RUN_TEST(test_bytes_leave_at_baud);
+    RUN_TEST(test_wrap_keeps_order);
+    RUN_TEST(test_write_is_all_or_nothing);
+    RUN_TEST(test_packets_do_not_wait_for_wire);
+    RUN_TEST(test_direct_packet_bigger_than_ring);
+    RUN_TEST(test_isr_packet_waits_for_direct);
+    RUN_TEST(test_link_stats_report_ring);
+    return TEST_EXIT_CODE();
+}
+
+/* [] END OF FILE */
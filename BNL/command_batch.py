@@ -0,0 +1,85 @@
+"""
+Host side of RX_NEXT_IS_BATCH / MESSAGE_TYPE_COMMAND_STATUS (command_table.h
+on the PSoC).
+
+encodeFrame() packs many (flag, value type, value) settings into one batched
+command frame, ready to write to the serial port; decodeStatus() turns the
+status packet the PSoC sends back for it into a CommandStatus. Works under
+Python 2 (LOD.py) and Python 3.
+"""
+import struct
+
+RX_NEXT_IS_BATCH   = 0x0C
+RX_BATCH_MAX_BYTES = 250 # must match RX_BATCH_MAX_BYTES in isr_rx_helper.h
+
+VALUE_NONE    = 0
+VALUE_UINT8   = 1
+VALUE_UINT16  = 2
+VALUE_INT32   = 3
+VALUE_FLOAT32 = 4
+VALUE_FORMATS = {VALUE_NONE: '', VALUE_UINT8: '<B', VALUE_UINT16: '<H',
+                 VALUE_INT32: '<i', VALUE_FLOAT32: '<f'}
+
+STATUS_TEXT = {0: 'ok',
+               1: 'no handler',
+               2: 'bad type',
+               3: 'out of range',
+               4: 'truncated'}
+STATUS_HEAD_BYTES = 3
+
+class CommandStatus(object):
+    def __init__(self, frameId, statuses):
+        self.frameId = frameId
+        self.statuses = statuses   # one status code per entry the PSoC ran, in frame order
+
+    def failed(self):
+        """ (entry index, status text) of every entry that did not return ok """
+        return [(i, STATUS_TEXT.get(s, 'status %d' % s)) for i, s in enumerate(self.statuses) if s != 0]
+
+def encodeEntries(entries):
+    """ entries: iterable of (flag, value type, value), value ignored for VALUE_NONE """
+    out = bytearray()
+    for flag, valueType, value in entries:
+        if valueType not in VALUE_FORMATS:
+            raise ValueError('unknown value type %d' % valueType)
+        out += struct.pack('<BB', flag, valueType)
+        if valueType != VALUE_NONE:
+            out += struct.pack(VALUE_FORMATS[valueType], value)
+    return out
+
+def encodeFrame(frameId, entries):
+    """ RX_NEXT_IS_BATCH, length and frame; ValueError if it does not fit one frame """
+    frame = bytearray([frameId & 0xFF]) + encodeEntries(entries)
+    if len(frame) > RX_BATCH_MAX_BYTES:
+        raise ValueError('batch of %d bytes, at most %d fit in a frame' % (len(frame), RX_BATCH_MAX_BYTES))
+    return bytearray([RX_NEXT_IS_BATCH]) + bytearray(struct.pack('<H', len(frame))) + frame
+
+def splitEntries(entries):
+    """ entries cut into lists that each fit one frame """
+    batches = []
+    current = []
+    currentBytes = 1
+    for entry in entries:
+        entryBytes = len(encodeEntries([entry]))
+        if current and currentBytes + entryBytes > RX_BATCH_MAX_BYTES:
+            batches.append(current)
+            current = []
+            currentBytes = 1
+        current.append(entry)
+        currentBytes += entryBytes
+    if current:
+        batches.append(current)
+    return batches
+
+def decodeStatus(payload):
+    """ CommandStatus from one MESSAGE_TYPE_COMMAND_STATUS payload, ValueError if malformed """
+    payload = bytearray(payload)
+    if len(payload) < STATUS_HEAD_BYTES:
+        raise ValueError('command status shorter than its head')
+    frameId, numEntries, numFailed = payload[0], payload[1], payload[2]
+    statuses = list(payload[STATUS_HEAD_BYTES:])
+    if len(statuses) != numEntries:
+        raise ValueError('command status length does not match its head')
+    if numFailed != sum(1 for s in statuses if s != 0):
+        raise ValueError('command status failure count does not match')
+    return CommandStatus(frameId, statuses)
@@ -0,0 +1,202 @@
+"""
+Host side of the PSoC deferred log (log_deferred.h).
+
+LOG_MESSAGE() call sites keep their format strings in the firmware's log_fmt
+section and send only the string's offset in that section plus the raw
+argument bytes (MESSAGE_TYPE_LOG_DEFERRED). This module pulls the section out
+of the firmware .elf into a dictionary file and expands those packets back
+into the text sendLogMessage() would have produced.
+
+    python log_dictionary.py PSoC_Template_Project.elf [log_dictionary.json]
+
+LOD.py loads the dictionary file at start up and hands its CRC to the PSoC,
+which only switches to deferred logs when it matches its own build.
+Works under Python 2 (LOD.py) and Python 3.
+"""
+import binascii
+import json
+import struct
+import sys
+
+LOG_FORMAT_SECTION      = 'log_fmt'
+DEFAULT_DICTIONARY_FILE = 'log_dictionary.json'
+FORMAT_ID_BYTES         = 2
+
+_FLAGS       = '-+ #0'
+_SIGNED      = 'di'
+_UNSIGNED    = 'uoxX'
+_FLOATS      = 'fFeEgGaA'
+_LENGTH_MASK = {'hh': 0xFF, 'h': 0xFFFF}
+_WIDE        = ('ll', 'j')   # 8 bytes on the wire, everything else integral is 4
+
+def _toText(raw):
+    return raw if str is bytes else raw.decode('latin-1')
+
+def readSection(elfPath, sectionName = LOG_FORMAT_SECTION):
+    """ Contents of one section of an ELF32/ELF64 file, either byte order. None if absent. """
+    with open(elfPath, 'rb') as f:
+        elf = f.read()
+    if elf[:4] != b'\x7fELF':
+        raise ValueError(elfPath + ' is not an ELF file')
+    is64 = bytearray(elf)[4] == 2
+    endian = '<' if bytearray(elf)[5] == 1 else '>'
+    if is64:
+        shoff, = struct.unpack_from(endian + 'Q', elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', elf, 0x3A)
+        headerFormat = endian + 'IIQQQQIIQQ'
+    else:
+        shoff, = struct.unpack_from(endian + 'I', elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', elf, 0x2E)
+        headerFormat = endian + 'IIIIIIIIII'
+    sections = [struct.unpack_from(headerFormat, elf, shoff + i * shentsize) for i in range(shnum)]
+    names = sections[shstrndx]
+    namesOffset = names[4]
+    for section in sections:
+        nameStart = namesOffset + section[0]
+        name = elf[nameStart:elf.index(b'\0', nameStart)]
+        if _toText(name) == sectionName:
+            return elf[section[4]:section[4] + section[5]]
+    return None
+
+def sectionCrc(section):
+    """ CRC-16/CCITT-FALSE of the section, matches logDeferred_getDictionaryCrc() """
+    return binascii.crc_hqx(section, 0xFFFF)
+
+def buildDictionary(section):
+    """ {format ID: format string}, the ID being the offset of the string in the section """
+    formats = {}
+    start = 0
+    while start < len(section):
+        end = section.index(b'\0', start)
+        if end > start:
+            formats[start] = _toText(section[start:end])
+        start = end + 1
+    return {'crc': sectionCrc(section), 'formats': formats}
+
+def save(dictionary, path):
+    with open(path, 'w') as f:
+        json.dump({'crc': dictionary['crc'],
+                   'formats': dict((str(k), v) for k, v in dictionary['formats'].items())},
+                  f, indent = 1, sort_keys = True)
+
+def load(path):
+    with open(path, 'r') as f:
+        raw = json.load(f)
+    return {'crc': int(raw['crc']), 'formats': dict((int(k), v) for k, v in raw['formats'].items())}
+
+def _conversions(fmt):
+    """ Yields (literal text, spec, length modifier, conversion) in format order, like _packArgs() """
+    i = 0
+    literal = ''
+    while i < len(fmt):
+        if fmt[i] != '%':
+            literal += fmt[i]
+            i += 1
+            continue
+        start = i
+        i += 1
+        while i < len(fmt) and fmt[i] in _FLAGS:
+            i += 1
+        while i < len(fmt) and (fmt[i].isdigit() or fmt[i] in '.*'):
+            i += 1
+        length = ''
+        for modifier in ('hh', 'h', 'll', 'l', 'z', 't', 'j', 'L'):
+            if fmt.startswith(modifier, i):
+                length = modifier
+                i += len(modifier)
+                break
+        if i >= len(fmt):
+            break
+        conversion = fmt[i]
+        i += 1
+        yield literal, fmt[start:i], length, conversion
+        literal = ''
+    yield literal, None, None, None
+
+class _Reader(object):
+    def __init__(self, payload):
+        self.payload = payload
+        self.offset = 0
+
+    def take(self, code):
+        size = struct.calcsize(code)
+        if self.offset + size > len(self.payload):
+            raise IndexError
+        value, = struct.unpack_from('<' + code, self.payload, self.offset)
+        self.offset += size
+        return value
+
+    def takeString(self):
+        end = self.payload.index(b'\0', self.offset)
+        value = _toText(self.payload[self.offset:end])
+        self.offset = end + 1
+        return value
+
+def expand(dictionary, payload):
+    """ Text of one MESSAGE_TYPE_LOG_DEFERRED payload """
+    if len(payload) < FORMAT_ID_BYTES:
+        return '<short deferred log>'
+    formatId, = struct.unpack_from('<H', payload, 0)
+    fmt = dictionary['formats'].get(formatId)
+    if fmt is None:
+        return '<unknown log format id %d>' % formatId
+    reader = _Reader(payload[FORMAT_ID_BYTES:])
+    text = ''
+    for literal, spec, length, conversion in _conversions(fmt):
+        text += literal
+        if spec is None:
+            break
+        try:
+            text += _formatOne(reader, spec, length, conversion)
+        except (IndexError, ValueError):
+            text += '<missing>'
+    return text
+
+def _formatOne(reader, spec, length, conversion):
+    #C spec -> Python % spec: no length modifiers, '*' filled in from the payload
+    pySpec = spec.replace(length, '', 1) if length else spec
+    while '*' in pySpec:
+        pySpec = pySpec.replace('*', str(reader.take('i')), 1)
+    if conversion == '%':
+        return '%'
+    if conversion == 'n':
+        return ''
+    if conversion in _SIGNED or conversion in _UNSIGNED:
+        wide = length in _WIDE
+        if conversion in _SIGNED:
+            value = reader.take('q' if wide else 'i')
+            if length in _LENGTH_MASK:
+                mask = _LENGTH_MASK[length]
+                value &= mask
+                if value > mask >> 1:
+                    value -= mask + 1
+        else:
+            value = reader.take('Q' if wide else 'I') & _LENGTH_MASK.get(length, 0xFFFFFFFFFFFFFFFF)
+        if conversion in 'iu':
+            pySpec = pySpec[:-1] + 'd'
+        return pySpec % value
+    if conversion in _FLOATS:
+        value = reader.take('f')
+        if conversion in 'aA':
+            return float(value).hex() if conversion == 'a' else float(value).hex().upper()
+        return pySpec % value
+    if conversion == 'c':
+        return pySpec.replace('c', 's') % chr(reader.take('B'))
+    if conversion == 's':
+        return pySpec % reader.takeString()
+    if conversion == 'p':
+        return '0x%x' % reader.take('I')
+    raise ValueError('unsupported conversion %' + conversion)
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print('usage: python log_dictionary.py firmware.elf [' + DEFAULT_DICTIONARY_FILE + ']')
+        sys.exit(1)
+    section = readSection(sys.argv[1])
+    if section is None:
+        print('no ' + LOG_FORMAT_SECTION + ' section in ' + sys.argv[1])
+        sys.exit(1)
+    dictionary = buildDictionary(section)
+    outPath = sys.argv[2] if len(sys.argv) > 2 else DEFAULT_DICTIONARY_FILE
+    save(dictionary, outPath)
+    print('%d log formats, CRC 0x%04X -> %s' % (len(dictionary['formats']), dictionary['crc'], outPath))
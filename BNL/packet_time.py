@@ -0,0 +1,41 @@
+"""
+Unwraps the 32-bit packet head timestamp of the PSoC (timebase.h) into a
+monotonic count. The PSoC sends the low 32 bits of its 64-bit time in
+PACKET_TIMESTAMP_HZ units, which wraps every 2**32 / 3 MHz = 23.8 minutes;
+as long as packets arrive at least once per half wrap the full count is
+recovered. Packets queued from interrupts can leave slightly out of time
+order, a step back is taken as such and not as a wrap. Sample batches
+(sample_batch.py) are stamped on the same clock, unwrapNear() places them
+next to the unwrapped time of the packet that carried them.
+Works under Python 2 (LOD.py) and Python 3.
+"""
+
+PACKET_TIMESTAMP_HZ = 3000000.0 # TIMEBASE_WIRE_HZ in timebase.h: BCLK (24 MHz) >> TIMEBASE_WIRE_SHIFT (3)
+
+_WRAP      = 1 << 32
+_HALF_WRAP = 1 << 31
+
+class TimestampUnwrapper(object):
+    def __init__(self):
+        self.last = None      # newest unwrapped count seen
+
+    def unwrap(self, wireTimestamp):
+        """ Unwrapped count for one packet, in PACKET_TIMESTAMP_HZ units """
+        if self.last is None:
+            self.last = wireTimestamp
+            return wireTimestamp
+        step = (wireTimestamp - self.last) % _WRAP
+        if step >= _HALF_WRAP:
+            return self.last + step - _WRAP   # older than the newest one, keep the newest
+        self.last = self.last + step
+        return self.last
+
+    def unwrapSec(self, wireTimestamp):
+        return self.unwrap(wireTimestamp) / PACKET_TIMESTAMP_HZ
+
+def unwrapNear(wireTimestamp, reference):
+    """ Unwrapped count of wireTimestamp closest to reference (an unwrapped count) """
+    step = (wireTimestamp - reference) % _WRAP
+    if step >= _HALF_WRAP:
+        step -= _WRAP
+    return reference + step
@@ -0,0 +1,108 @@
+"""
+Host side of the PSoC payload codecs (payload_codec.h).
+
+Once LOD.py has sent TX_NEXT_IS_CODEC with the mask of codecs below, the PSoC
+compresses BINARY_FLOAT and LOG payloads whenever that makes them smaller and
+puts the codec in the top two bits of the message type byte. splitMessageType()
+separates the two, PayloadDecoder.decode() restores the payload and keeps a
+running count of wire bytes against decoded bytes for each codec.
+Works under Python 2 (LOD.py) and Python 3.
+"""
+import struct
+
+CODEC_NONE         = 0
+CODEC_DELTA_VARINT = 1   # zig-zag delta + varint of float32 bit patterns
+CODEC_LZ           = 2   # LZSS, one payload at a time
+
+CODEC_SHIFT     = 6
+TYPE_MASK       = 0x3F
+ACCEPTED_CODECS = (1 << CODEC_DELTA_VARINT) | (1 << CODEC_LZ)
+LZ_MIN_MATCH    = 3
+
+CODEC_NAMES = {CODEC_NONE: 'none', CODEC_DELTA_VARINT: 'delta-varint', CODEC_LZ: 'lz'}
+
+def splitMessageType(typeByte):
+    """ (messageType, codec) from the header's message type byte """
+    return typeByte & TYPE_MASK, typeByte >> CODEC_SHIFT
+
+def _decodeDeltaVarint(data):
+    if len(data) < 1:
+        raise ValueError('empty delta-varint payload')
+    stride = (data[0] >> 5) + 1
+    shift = data[0] & 0x1F
+    if len(data) < 1 + 4 * stride:
+        raise ValueError('delta-varint payload shorter than its first words')
+    words = list(struct.unpack_from('<%dL' % stride, data, 1))
+    pos = 1 + 4 * stride
+    while pos < len(data):
+        value = 0
+        bitPos = 0
+        while True:
+            if pos >= len(data) or bitPos > 28:
+                raise ValueError('truncated varint')
+            byte = data[pos]
+            pos += 1
+            value |= (byte & 0x7F) << bitPos
+            bitPos += 7
+            if not byte & 0x80:
+                break
+        delta = (value >> 1) ^ -(value & 1)
+        words.append((words[-stride] + (delta << shift)) & 0xFFFFFFFF)
+    return bytearray(struct.pack('<%dL' % len(words), *words))
+
+def _decodeLz(data):
+    out = bytearray()
+    pos = 0
+    control = 0
+    item = 8
+    while pos < len(data):
+        if item == 8:
+            control = data[pos]
+            pos += 1
+            item = 0
+            continue
+        if control & (1 << item):
+            if pos + 2 > len(data):
+                raise ValueError('truncated LZ match')
+            offset = data[pos] + 1
+            length = data[pos + 1] + LZ_MIN_MATCH
+            pos += 2
+            if offset > len(out):
+                raise ValueError('LZ match before the start of the payload')
+            for _ in range(length):
+                out.append(out[-offset])   # one at a time: matches may overlap
+        else:
+            out.append(data[pos])
+            pos += 1
+        item += 1
+    return out
+
+_DECODERS = {CODEC_NONE: bytearray, CODEC_DELTA_VARINT: _decodeDeltaVarint, CODEC_LZ: _decodeLz}
+
+def decode(codec, payload):
+    """ Original payload bytes (bytearray), ValueError if malformed or the codec is unknown """
+    if codec not in _DECODERS:
+        raise ValueError('unknown payload codec %d' % codec)
+    return _DECODERS[codec](bytearray(payload))
+
+class PayloadDecoder(object):
+    """ decode() plus per codec totals, for the link report """
+    def __init__(self):
+        self.wireBytes = dict((codec, 0) for codec in CODEC_NAMES)
+        self.decodedBytes = dict((codec, 0) for codec in CODEC_NAMES)
+
+    def decode(self, codec, payload):
+        decoded = decode(codec, payload)
+        self.wireBytes[codec] += len(payload)
+        self.decodedBytes[codec] += len(decoded)
+        return decoded
+
+    def ratio(self, codec = None):
+        """ decoded / wire bytes, for one codec or all payloads """
+        codecs = CODEC_NAMES.keys() if codec is None else [codec]
+        wire = sum(self.wireBytes[c] for c in codecs)
+        return sum(self.decodedBytes[c] for c in codecs) / float(wire) if wire else 1.0
+
+    def __str__(self):
+        return 'payloads %.2fx: ' % self.ratio() + ', '.join('%s %.2fx' % (CODEC_NAMES[c], self.ratio(c))
+                                                        for c in sorted(CODEC_NAMES) if self.wireBytes[c])
@@ -0,0 +1,153 @@
+"""
+Host side of RX_NEXT_IS_RPC / MESSAGE_TYPE_RPC_RESPONSE (rpc.h on the PSoC).
+
+RpcClient numbers every request, writes it without waiting for earlier ones
+and matches each response to its request by id, so many calls can be in
+flight at once. It keeps at most maxInFlight requests and maxInFlightBytes of
+request bytes outstanding, so the PSoC's 256 byte receive ring never
+overflows; further calls wait in order until responses make room. Works under
+Python 2 (LOD.py) and Python 3.
+
+    client = RpcClient(serialPort.write)
+    call = client.call(METHOD_PING, b'abc')   # returns at once
+    ...
+    client.handleResponse(payload)            # from the packet parser thread
+    status, result = call.wait(1.0)
+"""
+import struct
+import threading
+import time
+
+RX_NEXT_IS_RPC       = 0x0D
+RX_BATCH_MAX_BYTES   = 250 # longest frame, must match isr_rx_helper.h
+REQUEST_HEAD_BYTES   = 3
+RESPONSE_HEAD_BYTES  = 4
+
+METHOD_PING = 0
+METHOD_SET  = 1
+
+STATUS_OK            = 0
+STATUS_NO_METHOD     = 1
+STATUS_BAD_ARGUMENTS = 2
+STATUS_FAILED        = 3
+STATUS_TIMEOUT       = -1 # host side only: no response in time
+STATUS_TEXT = {STATUS_OK: 'ok', STATUS_NO_METHOD: 'no method', STATUS_BAD_ARGUMENTS: 'bad arguments',
+               STATUS_FAILED: 'failed', STATUS_TIMEOUT: 'timeout'}
+
+def encodeRequest(requestId, method, arguments = b''):
+    frame = bytearray(struct.pack('<HB', requestId & 0xFFFF, method)) + bytearray(arguments)
+    if len(frame) > RX_BATCH_MAX_BYTES:
+        raise ValueError('request of %d bytes, at most %d fit in a frame' % (len(frame), RX_BATCH_MAX_BYTES))
+    return bytearray([RX_NEXT_IS_RPC]) + bytearray(struct.pack('<H', len(frame))) + frame
+
+def decodeResponse(payload):
+    """ (request id, method, status, result bytearray), ValueError if malformed """
+    payload = bytearray(payload)
+    if len(payload) < RESPONSE_HEAD_BYTES:
+        raise ValueError('rpc response shorter than its head')
+    requestId, method, status = struct.unpack_from('<HBB', payload, 0)
+    return requestId, method, status, payload[RESPONSE_HEAD_BYTES:]
+
+class RpcCall(object):
+    def __init__(self, requestId, method, request, callback):
+        self.requestId = requestId
+        self.method = method
+        self.request = request     # bytes on the wire
+        self.callback = callback   # callback(call) once answered, from the parser thread
+        self.status = None
+        self.result = None
+        self.sentSec = None
+        self.answeredSec = None
+        self._done = threading.Event()
+
+    def done(self):
+        return self._done.is_set()
+
+    def wait(self, timeoutSec = None):
+        """ (status, result); STATUS_TIMEOUT and None if not answered in time """
+        if not self._done.wait(timeoutSec):
+            return STATUS_TIMEOUT, None
+        return self.status, self.result
+
+    def _finish(self, status, result):
+        self.status = status
+        self.result = result
+        self.answeredSec = time.time()
+        self._done.set()
+        if self.callback is not None:
+            self.callback(self)
+
+class RpcClient(object):
+    def __init__(self, write, maxInFlight = 8, maxInFlightBytes = 192):
+        self._write = write            # write(bytes), e.g. a serial port write under its lock
+        self.maxInFlight = maxInFlight
+        self.maxInFlightBytes = maxInFlightBytes
+        self._lock = threading.Lock()
+        self._nextId = 0
+        self._inFlight = {}            # request id -> RpcCall
+        self._inFlightBytes = 0
+        self._waiting = []             # calls not sent yet, in order
+
+    def call(self, method, arguments = b'', callback = None):
+        """ sends (or queues) one request and returns its RpcCall without waiting """
+        with self._lock:
+            requestId = self._nextId
+            self._nextId = (self._nextId + 1) & 0xFFFF
+            rpcCall = RpcCall(requestId, method, encodeRequest(requestId, method, arguments), callback)
+            self._waiting.append(rpcCall)
+            toSend = self._takeSendable()
+        self._send(toSend)
+        return rpcCall
+
+    def set(self, flag, valueType, value, callback = None):
+        """ RPC_METHOD_SET: one command_batch entry, result[0] is its command status """
+        import command_batch
+        return self.call(METHOD_SET, command_batch.encodeEntries([(flag, valueType, value)]), callback)
+
+    def handleResponse(self, payload):
+        """ MESSAGE_TYPE_RPC_RESPONSE payload; False if it matched no request in flight """
+        requestId, method, status, result = decodeResponse(payload)
+        with self._lock:
+            rpcCall = self._inFlight.pop(requestId, None)
+            if rpcCall is not None:
+                self._inFlightBytes -= len(rpcCall.request)
+            toSend = self._takeSendable()
+        self._send(toSend)
+        if rpcCall is None or rpcCall.method != method:
+            return False
+        rpcCall._finish(status, result)
+        return True
+
+    def expire(self, timeoutSec):
+        """ gives up on requests sent more than timeoutSec ago, e.g. lost to a bad CRC """
+        now = time.time()
+        with self._lock:
+            expired = [c for c in self._inFlight.values() if now - c.sentSec > timeoutSec]
+            for rpcCall in expired:
+                del self._inFlight[rpcCall.requestId]
+                self._inFlightBytes -= len(rpcCall.request)
+            toSend = self._takeSendable()
+        self._send(toSend)
+        for rpcCall in expired:
+            rpcCall._finish(STATUS_TIMEOUT, None)
+        return len(expired)
+
+    def inFlight(self):
+        with self._lock:
+            return len(self._inFlight)
+
+    def _takeSendable(self):
+        #with self._lock held: moves waiting calls in flight while the window has room
+        toSend = []
+        while self._waiting and len(self._inFlight) < self.maxInFlight and \
+              (not self._inFlight or self._inFlightBytes + len(self._waiting[0].request) <= self.maxInFlightBytes):
+            rpcCall = self._waiting.pop(0)
+            rpcCall.sentSec = time.time()
+            self._inFlight[rpcCall.requestId] = rpcCall
+            self._inFlightBytes += len(rpcCall.request)
+            toSend.append(rpcCall)
+        return toSend
+
+    def _send(self, calls):
+        if calls:
+            self._write(bytes(bytearray().join(c.request for c in calls)))
@@ -0,0 +1,88 @@
+"""
+Host side of MESSAGE_TYPE_SAMPLE_BATCH (sample_batcher.h on the PSoC).
+
+decode() turns one packet payload into its channel, per-sample timestamps and
+values; SampleStreams appends the batches of every channel into contiguous
+arrays. Timestamps are the 32-bit packet timestamps of timebase.h, see
+packet_time.py. Works under Python 2 (LOD.py) and Python 3, numpy is only needed for
+SampleStreams.
+"""
+import struct
+
+import packet_time
+
+SAMPLE_BATCH_TICKS_PER_SECOND = packet_time.PACKET_TIMESTAMP_HZ # TIMEBASE_WIRE_HZ on the PSoC
+SAMPLE_BATCH_HEAD_BYTES       = 8
+SAMPLE_BATCH_DELTA_BYTES      = 2
+SAMPLE_FORMATS                = {0: ('f', 4),  # SAMPLE_FORMAT_FLOAT32
+                                 1: ('h', 2)}  # SAMPLE_FORMAT_INT16
+
+class SampleBatch(object):
+    def __init__(self, channel, sampleFormat, valuesPerSample, ticks, values):
+        self.channel = channel
+        self.sampleFormat = sampleFormat
+        self.valuesPerSample = valuesPerSample
+        self.ticks = ticks     # 32-bit wire timestamp of each sample
+        self.values = values   # one tuple of valuesPerSample values per sample
+
+    def timesSec(self, packetTimeSec = None):
+        """ Sample times in seconds, unwrapped next to packetTimeSec (its packet's unwrapped time) if given """
+        if packetTimeSec is None:
+            return [t / SAMPLE_BATCH_TICKS_PER_SECOND for t in self.ticks]
+        reference = int(round(packetTimeSec * SAMPLE_BATCH_TICKS_PER_SECOND))
+        return [packet_time.unwrapNear(t, reference) / SAMPLE_BATCH_TICKS_PER_SECOND for t in self.ticks]
+
+def decode(payload):
+    """ SampleBatch from one MESSAGE_TYPE_SAMPLE_BATCH payload, ValueError if malformed """
+    payload = bytearray(payload)
+    if len(payload) < SAMPLE_BATCH_HEAD_BYTES:
+        raise ValueError('sample batch shorter than its head')
+    channel, sampleFormat, valuesPerSample, count, baseTicks = struct.unpack_from('<BBBBL', payload, 0)
+    if sampleFormat not in SAMPLE_FORMATS:
+        raise ValueError('unknown sample format %d' % sampleFormat)
+    code, valueBytes = SAMPLE_FORMATS[sampleFormat]
+    if len(payload) != SAMPLE_BATCH_HEAD_BYTES + count * (SAMPLE_BATCH_DELTA_BYTES + valuesPerSample * valueBytes):
+        raise ValueError('sample batch length does not match its head')
+
+    ticks = []
+    t = baseTicks
+    for delta in struct.unpack_from('<%dH' % count, payload, SAMPLE_BATCH_HEAD_BYTES):
+        t = (t + delta) & 0xFFFFFFFF
+        ticks.append(t)
+    flat = struct.unpack_from('<%d%s' % (count * valuesPerSample, code), payload,
+                              SAMPLE_BATCH_HEAD_BYTES + count * SAMPLE_BATCH_DELTA_BYTES)
+    values = [flat[i * valuesPerSample:(i + 1) * valuesPerSample] for i in range(count)]
+    return SampleBatch(channel, sampleFormat, valuesPerSample, ticks, values)
+
+class SampleStreams(object):
+    """ Per channel: timesSec(channel) is (N,), values(channel) is (N, valuesPerSample) """
+    def __init__(self):
+        self._times = {}
+        self._values = {}
+
+    def add(self, batch, timesSec = None):
+        """ timesSec: the batch's sample times if not batch.timesSec(), e.g. batch.timesSec(packetTimeSec) """
+        import numpy as np
+        if timesSec is None:
+            timesSec = batch.timesSec()
+        self._times.setdefault(batch.channel, []).append(np.array(timesSec))
+        self._values.setdefault(batch.channel, []).append(np.array(batch.values, dtype = float))
+
+    def channels(self):
+        return sorted(self._times.keys())
+
+    def timesSec(self, channel):
+        return self._join(self._times, channel)
+
+    def values(self, channel):
+        return self._join(self._values, channel)
+
+    def _join(self, chunks, channel):
+        #concatenate once, keep the result as the single chunk for the next call
+        import numpy as np
+        parts = chunks.get(channel, [])
+        if len(parts) == 0:
+            return np.zeros(0)
+        if len(parts) > 1:
+            chunks[channel] = [np.concatenate(parts)]
+        return chunks[channel][0]